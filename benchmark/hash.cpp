@@ -44,6 +44,39 @@ void hash_benchmarking() {
    };
    benchmarking("sha256 (" + std::to_string(large_message.length()) + " bytes)", sha256_large_msg);
 
+   // merkle node shaped inputs: two concatenated digests, hashed one at a time vs. through the multi-buffer batch
+   constexpr size_t num_pairs = 1024;
+   std::vector<char> pairs;
+   pairs.reserve(num_pairs * 64);
+   while (pairs.size() < num_pairs * 64) {
+      pairs.insert(pairs.end(), small_message.begin(), small_message.end());
+   }
+   std::vector<fc::sha256> digests(num_pairs);
+
+   auto sha256_pairs_single = [&]() {
+      for (size_t i = 0; i < num_pairs; ++i) {
+         digests[i] = fc::sha256::hash(pairs.data() + i * 64, 64);
+      }
+   };
+   benchmarking("sha256 (" + std::to_string(num_pairs) + " x 64 bytes)", sha256_pairs_single);
+
+   auto sha256_pairs_batch = [&]() {
+      fc::sha256::hash_64_byte_batch(pairs.data(), num_pairs, digests.data());
+   };
+   benchmarking("sha256 batch (" + std::to_string(num_pairs) + " x 64 bytes)", sha256_pairs_batch);
+
+   // all levels of a merkle tree over num_pairs * 2 leaves, the way chain::merkle() hashes them
+   auto sha256_merkle_batch = [&]() {
+      std::vector<fc::sha256> level(num_pairs * 2);
+      std::vector<fc::sha256> next;
+      while (level.size() > 1) {
+         next.resize(level.size() / 2);
+         fc::sha256::hash_64_byte_batch(level.front().data(), next.size(), next.data());
+         level.swap(next);
+      }
+   };
+   benchmarking("sha256 batch merkle (" + std::to_string(num_pairs * 2) + " leaves)", sha256_merkle_batch);
+
    auto sha512_small_msg = [&]() {
       fc::sha512::hash(small_message);
    };
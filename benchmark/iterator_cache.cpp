@@ -0,0 +1,117 @@
+#include <eosio/chain/contract_table_context.hpp>
+#include <eosio/chain/contract_table_objects.hpp>
+
+#include <chainbase/chainbase.hpp>
+#include <fc/filesystem.hpp>
+
+#include <benchmark.hpp>
+
+#include <map>
+#include <string>
+
+namespace benchmark {
+
+namespace {
+
+using eosio::chain::table_id_object;
+using eosio::chain::key_value_object;
+
+// the iterator_cache bookkeeping before the flat storage: node based maps allocated for every action
+struct map_iterator_cache {
+   std::map<table_id_object::id_type, std::pair<const table_id_object*, int>> table_cache;
+   std::vector<const table_id_object*>                                       end_iterator_to_table;
+   std::vector<const key_value_object*>                                      iterator_to_object;
+   std::map<const key_value_object*, int>                                    object_to_iterator;
+
+   map_iterator_cache() {
+      end_iterator_to_table.reserve(8);
+      iterator_to_object.reserve(32);
+   }
+
+   int cache_table(const table_id_object& tobj) {
+      auto itr = table_cache.find(tobj.id);
+      if (itr != table_cache.end())
+         return itr->second.second;
+      int ei = -(int)end_iterator_to_table.size() - 2;
+      end_iterator_to_table.push_back(&tobj);
+      table_cache.emplace(tobj.id, std::make_pair(&tobj, ei));
+      return ei;
+   }
+   int add(const key_value_object& obj) {
+      auto itr = object_to_iterator.find(&obj);
+      if (itr != object_to_iterator.end())
+         return itr->second;
+      iterator_to_object.push_back(&obj);
+      object_to_iterator[&obj] = iterator_to_object.size() - 1;
+      return iterator_to_object.size() - 1;
+   }
+   void remove(int iterator) {
+      const key_value_object* obj = iterator_to_object[iterator];
+      if (!obj) return;
+      iterator_to_object[iterator] = nullptr;
+      object_to_iterator.erase(obj);
+   }
+};
+
+using flat_iterator_cache =
+   eosio::chain::contract_table_context_base<eosio::chain::contract_tables>::iterator_cache<key_value_object>;
+
+// one action in the style of test_api_db: store rows into a few tables, look them up again, walk every table with
+// next and erase half of the rows
+template<typename Cache>
+void run_action(const std::vector<const table_id_object*>& tables, const std::vector<const key_value_object*>& rows) {
+   Cache cache;
+   for (const key_value_object* r : rows) {
+      cache.cache_table(*tables[r->primary_key % tables.size()]);
+      cache.add(*r);
+   }
+   for (const key_value_object* r : rows) {
+      cache.cache_table(*tables[r->primary_key % tables.size()]);
+      cache.add(*r);
+   }
+   for (size_t t = 0; t < tables.size(); ++t) {
+      cache.cache_table(*tables[t]);
+      for (size_t i = t; i < rows.size(); i += tables.size())
+         cache.add(*rows[i]);
+   }
+   for (size_t i = 0; i < rows.size(); i += 2)
+      cache.remove(cache.add(*rows[i]));
+}
+
+} // namespace
+
+void iterator_cache_benchmarking() {
+   constexpr size_t num_tables = 4;
+   fc::temp_directory dir;
+   chainbase::database db(dir.path(), chainbase::database::read_write, 64 * 1024 * 1024);
+   db.add_index<eosio::chain::table_id_multi_index>();
+   db.add_index<eosio::chain::key_value_index>();
+
+   std::vector<const table_id_object*> tables;
+   for (size_t t = 0; t < num_tables; ++t) {
+      tables.push_back(&db.create<table_id_object>([&](table_id_object& o) {
+         o.code  = eosio::chain::name("bench");
+         o.scope = eosio::chain::name(t);
+         o.table = eosio::chain::name("rows");
+      }));
+   }
+
+   std::vector<const key_value_object*> all_rows;
+   for (size_t num_rows : {8, 64, 512}) {
+      while (all_rows.size() < num_rows) {
+         const uint64_t pk = all_rows.size();
+         all_rows.push_back(&db.create<key_value_object>([&](key_value_object& o) {
+            o.t_id        = tables[pk % num_tables]->id;
+            o.primary_key = pk;
+         }));
+      }
+      const std::vector<const key_value_object*> rows(all_rows.begin(), all_rows.begin() + num_rows);
+
+      benchmarking("std::map iterator_cache (" + std::to_string(num_rows) + " rows)",
+                   [&]() { run_action<map_iterator_cache>(tables, rows); });
+      benchmarking("flat iterator_cache (" + std::to_string(num_rows) + " rows)",
+                   [&]() { run_action<flat_iterator_cache>(tables, rows); });
+   }
+}
+
+} // benchmark
@@ -4,8 +4,13 @@
 #include <eosio/chain/log_catalog.hpp>
 #include <eosio/chain/log_data_base.hpp>
 #include <eosio/chain/log_index.hpp>
+#include <eosio/chain/log_mapped_file.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <fc/bitutil.hpp>
 #include <fc/io/raw.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
 #include <mutex>
 
 #if defined(__BYTE_ORDER__)
@@ -26,8 +31,12 @@ namespace eosio { namespace chain {
 
    namespace detail {
       constexpr uint32_t pruned_version_flag = 1 << 31;
+      /// every block entry is individually compressed, see compress_block_entry()
+      constexpr uint32_t compressed_version_flag = 1 << 30;
    }
 
+   namespace bio = boost::iostreams;
+
    // copy up to n bytes from src to dest
    void copy_file_content(fc::cfile& src, fc::cfile& dest, uint64_t n) {
       // calculate the number of bytes remaining in the src file can be copied
@@ -54,8 +63,9 @@ namespace eosio { namespace chain {
       uint32_t                                   first_block_num = 0;
       std::variant<genesis_state, chain_id_type> chain_context;
 
-      uint32_t version() const { return ver & ~detail::pruned_version_flag; }
+      uint32_t version() const { return ver & ~(detail::pruned_version_flag | detail::compressed_version_flag); }
       bool     is_currently_pruned() const { return ver & detail::pruned_version_flag; }
+      bool     is_compressed() const { return ver & detail::compressed_version_flag; }
 
       chain_id_type chain_id() const {
          return std::visit(overloaded{ [](const chain_id_type& id) { return id; },
@@ -172,10 +182,63 @@ namespace eosio { namespace chain {
          std::exception_ptr inner;
       };
 
+      /// Leading bytes of a packed block kept uncompressed in a compressed block log entry (timestamp, producer,
+      /// confirmed and previous) so that the block number can be read from the entry without decompressing it.
+      constexpr size_t compressed_entry_header_size = 46;
+
+      /// A compressed block log entry is the first compressed_entry_header_size bytes of the packed block, the size of
+      /// the compressed remainder as uint32_t and the remainder of the packed block compressed with zlib. Like an
+      /// uncompressed entry it is followed by its position in the file, so entries stay randomly accessible through
+      /// the index and walkable through the trailing positions.
+      std::vector<char> compress_block_entry(const char* packed_block, size_t size) {
+         EOS_ASSERT(size > compressed_entry_header_size, block_log_exception, "packed block is too small");
+         std::vector<char> entry(packed_block, packed_block + compressed_entry_header_size);
+         entry.resize(compressed_entry_header_size + sizeof(uint32_t));
+         {
+            bio::filtering_ostream comp;
+            comp.push(bio::zlib_compressor(bio::zlib::default_compression));
+            comp.push(bio::back_inserter(entry));
+            bio::write(comp, packed_block + compressed_entry_header_size, size - compressed_entry_header_size);
+            bio::close(comp);
+         }
+         const uint32_t compressed_size = entry.size() - compressed_entry_header_size - sizeof(uint32_t);
+         memcpy(entry.data() + compressed_entry_header_size, &compressed_size, sizeof(compressed_size));
+         return entry;
+      }
+
+      /// @returns the packed block of the compressed entry read from ds
       template <typename Stream>
-      signed_block_ptr read_block(Stream&& ds, uint32_t expect_block_num = 0) {
+      std::vector<char> decompress_block_entry(Stream& ds) {
+         std::vector<char> packed_block(compressed_entry_header_size);
+         ds.read(packed_block.data(), packed_block.size());
+         uint32_t compressed_size = 0;
+         ds.read(reinterpret_cast<char*>(&compressed_size), sizeof(compressed_size));
+         std::vector<char> compressed(compressed_size);
+         ds.read(compressed.data(), compressed.size());
+
+         bio::filtering_ostream decomp;
+         decomp.push(bio::zlib_decompressor());
+         decomp.push(bio::back_inserter(packed_block));
+         bio::write(decomp, compressed.data(), compressed.size());
+         bio::close(decomp);
+         return packed_block;
+      }
+
+      template <typename Stream, typename T>
+      void unpack_block_entry(Stream& ds, T& block_or_header, bool compressed) {
+         if (compressed) {
+            auto                        packed_block = decompress_block_entry(ds);
+            fc::datastream<const char*> pds(packed_block.data(), packed_block.size());
+            fc::raw::unpack(pds, block_or_header);
+         } else {
+            fc::raw::unpack(ds, block_or_header);
+         }
+      }
+
+      template <typename Stream>
+      signed_block_ptr read_block(Stream&& ds, uint32_t expect_block_num = 0, bool compressed = false) {
          auto block = std::make_shared<signed_block>();
-         fc::raw::unpack(ds, *block);
+         unpack_block_entry(ds, *block, compressed);
          if (expect_block_num != 0) {
             EOS_ASSERT(!!block && block->block_num() == expect_block_num, block_log_exception,
                        "Wrong block was read from block log.");
@@ -185,9 +248,9 @@ namespace eosio { namespace chain {
       }
 
       template <typename Stream>
-      signed_block_header read_block_header(Stream&& ds, uint32_t expect_block_num) {
+      signed_block_header read_block_header(Stream&& ds, uint32_t expect_block_num, bool compressed = false) {
          signed_block_header bh;
-         fc::raw::unpack(ds, bh);
+         unpack_block_entry(ds, bh, compressed);
 
          EOS_ASSERT(bh.block_num() == expect_block_num, block_log_exception,
                     "Wrong block header was read from block log.",
@@ -201,6 +264,7 @@ namespace eosio { namespace chain {
          block_log_preamble preamble;
          uint64_t           first_block_pos = 0;
          std::size_t        size_ = 0;
+         log_mapped_file    mapped;
 
        public:
          block_log_data() = default;
@@ -208,6 +272,7 @@ namespace eosio { namespace chain {
          uint64_t first_block_position() const { return first_block_pos; }
 
          const block_log_preamble& get_preamble() const { return preamble; }
+         fc::path                  get_file_path() const { return file.get_file_path(); }
 
          void open(const fc::path& path) {
             if (file.is_open())
@@ -218,6 +283,7 @@ namespace eosio { namespace chain {
             first_block_pos = file.tellp();
             file.seek_end(0);
             size_ = file.tellp();
+            mapped.set_file_path(path);
          }
 
          uint64_t size() const { return size_; }
@@ -227,6 +293,7 @@ namespace eosio { namespace chain {
          uint32_t      number_of_blocks();
          chain_id_type chain_id() { return preamble.chain_id(); }
          bool          is_currently_pruned() const { return preamble.is_currently_pruned(); }
+         bool          is_compressed() const { return preamble.is_compressed(); }
          uint64_t      end_of_block_position() const { return is_currently_pruned() ? size() - sizeof(uint32_t) : size(); }
 
          std::optional<genesis_state> get_genesis_state() {
@@ -257,6 +324,18 @@ namespace eosio { namespace chain {
             return file;
          }
 
+         /// zero-copy view of the file starting at pos, empty if the file cannot be mapped
+         std::optional<fc::datastream<const char*>> mapped_stream_at(uint64_t pos) {
+            if (pos >= size() || !mapped.map_to(size()))
+               return {};
+            return mapped.stream_at(pos);
+         }
+
+         void advise_sequential(uint64_t pos) {
+            if (mapped.map_to(size()))
+               mapped.advise_sequential(pos, size() - pos);
+         }
+
          uint64_t remaining() const { return size() - file.tellp(); }
          /**
           *  Validate a block log entry WITHOUT deserializing the entire block data.
@@ -280,7 +359,7 @@ namespace eosio { namespace chain {
             uint64_t pos = file.tellp();
 
             try {
-               fc::raw::unpack(file, entry);
+               unpack_block_entry(file, entry, is_compressed());
             } catch (...) { throw bad_block_exception{ std::current_exception() }; }
 
             const block_header& header = entry;
@@ -314,7 +393,7 @@ namespace eosio { namespace chain {
          std::tuple<uint64_t, uint32_t, std::string>
          full_validate_blocks(uint32_t last_block_num, const fc::path& blocks_dir, fc::time_point now);
 
-         void construct_index(const fc::path& index_file_path);
+         void construct_index(const fc::path& index_file_path, uint32_t num_threads = 1);
       };
 
       using block_log_index = eosio::chain::log_index<block_log_exception>;
@@ -390,22 +469,149 @@ namespace eosio { namespace chain {
          bool done() const { return current_position <= first_block_pos; }
       };
 
-      void adjust_block_positions(index_writer& index, fc::datastream<fc::cfile>& block_file,
-                                  uint64_t first_block_position, int64_t offset) {
-
-         block_file.seek_end(0);
-         // walk along the block position of each block entry and add its value by offset
-         auto iter = reverse_block_position_iterator{ block_file, first_block_position, block_file.tellp() };
-         while (!iter.done()) { index.write(iter.add_value_then_advance(offset)); }
-      }
-
       uint32_t block_log_data::number_of_blocks() {
          const uint32_t num_blocks =
                first_block_position() == end_of_block_position() ? 0 : last_block_num() - first_block_num() + 1;
          return num_blocks;
       }
 
-      void block_log_data::construct_index(const fc::path& index_file_path) {
+      /// Read only view of the block entries of a non-pruned blocks.log which can be shared between threads
+      class block_entries_view {
+         log_mapped_file log;
+         uint64_t        first_block_pos;
+         uint64_t        end_pos;
+         uint32_t        first_num;
+         uint32_t        last_num;
+
+         // the block number is in the leading bytes of an entry, uncompressed in both formats
+         static constexpr uint64_t block_num_end_offset = 18;
+         static constexpr uint64_t min_entry_size       = block_num_end_offset + sizeof(uint64_t);
+
+       public:
+         explicit block_entries_view(block_log_data& log_data)
+             : first_block_pos(log_data.first_block_position()), end_pos(log_data.end_of_block_position()),
+               first_num(log_data.first_block_num()), last_num(log_data.last_block_num()) {
+            EOS_ASSERT(!log_data.is_currently_pruned(), block_log_exception, "block log is pruned");
+            log.set_file_path(log_data.get_file_path());
+            EOS_ASSERT(log.map_to(log_data.size()), block_log_exception, "unable to map ${file}",
+                       ("file", log_data.get_file_path().generic_string()));
+         }
+
+         uint64_t begin() const { return first_block_pos; }
+         uint64_t end() const { return end_pos; }
+         uint32_t first_block_num() const { return first_num; }
+         uint32_t last_block_num() const { return last_num; }
+         const log_mapped_file& file() const { return log; }
+
+         uint32_t block_num_at(uint64_t pos) const {
+            return fc::endian_reverse_u32(log.read_at<uint32_t>(pos + 14)) + 1;
+         }
+
+         /// position of the entry ending at entry_end, read from its trailing position
+         uint64_t entry_pos(uint64_t entry_end) const { return log.read_at<uint64_t>(entry_end - sizeof(uint64_t)); }
+
+         bool is_linked_entry(uint64_t pos, uint64_t entry_end) const {
+            return pos >= first_block_pos && pos + min_entry_size <= entry_end;
+         }
+
+         /// Whether an entry ends at entry_end: its trailing position must point at an entry which is preceded by the
+         /// entry of the previous block and followed by the entry of the next block.
+         bool is_entry_end(uint64_t entry_end) const {
+            if (entry_end < first_block_pos + min_entry_size || entry_end > end_pos)
+               return false;
+            const uint64_t pos = entry_pos(entry_end);
+            if (!is_linked_entry(pos, entry_end))
+               return false;
+            const uint32_t num = block_num_at(pos);
+            if (num < first_num || num > last_num)
+               return false;
+            if (entry_end == end_pos) {
+               if (num != last_num)
+                  return false;
+            } else if (entry_end + block_num_end_offset > end_pos || block_num_at(entry_end) != num + 1) {
+               return false;
+            }
+            if (pos == first_block_pos)
+               return num == first_num;
+            if (pos < first_block_pos + min_entry_size)
+               return false;
+            const uint64_t prev_pos = entry_pos(pos);
+            return is_linked_entry(prev_pos, pos) && block_num_at(prev_pos) == num - 1;
+         }
+
+         /// end of the first block entry ending at or after pos
+         uint64_t next_entry_end(uint64_t pos) const {
+            for (pos = std::max(pos, first_block_pos + min_entry_size); pos < end_pos; ++pos) {
+               if (is_entry_end(pos))
+                  return pos;
+            }
+            return end_pos;
+         }
+      };
+
+      /// Build the index of a non-pruned log on num_threads threads: the log is split into chunks at entry boundaries
+      /// found independently for each chunk, then the entries of every chunk are walked backwards through their
+      /// trailing positions. A walk has to end exactly at the boundary of the previous chunk with consecutive block
+      /// numbers, so the result is validated the same way as the sequential walk.
+      void construct_index_parallel(block_log_data& log_data, const fc::path& index_file_path, uint32_t num_threads) {
+         const block_entries_view entries(log_data);
+         const uint32_t           num_blocks = entries.last_block_num() - entries.first_block_num() + 1;
+
+         named_thread_pool<struct blkidx> thread_pool;
+         thread_pool.start(num_threads, {});
+
+         const uint32_t        num_chunks = std::min(num_threads * 4, num_blocks);
+         const uint64_t        chunk_size = (entries.end() - entries.begin()) / num_chunks;
+         std::vector<uint64_t> boundaries(num_chunks + 1);
+         {
+            std::vector<std::future<uint64_t>> found;
+            for (uint32_t i = 1; i < num_chunks; ++i) {
+               found.emplace_back(post_async_task(thread_pool.get_executor(), [&entries, from = entries.begin() + i * chunk_size]() {
+                  return entries.next_entry_end(from);
+               }));
+            }
+            boundaries.front() = entries.begin();
+            for (uint32_t i = 1; i < num_chunks; ++i)
+               boundaries[i] = found[i - 1].get();
+            boundaries.back() = entries.end();
+         }
+
+         {
+            fc::cfile index_file;
+            index_file.set_file_path(index_file_path);
+            index_file.open(fc::cfile::truncate_rw_mode);
+         }
+         fc::resize_file(index_file_path, num_blocks * sizeof(uint64_t));
+         boost::interprocess::file_mapping  index_mapping(index_file_path.generic_string().c_str(), boost::interprocess::read_write);
+         boost::interprocess::mapped_region index_region(index_mapping, boost::interprocess::read_write);
+         uint64_t* const                    index = static_cast<uint64_t*>(index_region.get_address());
+
+         std::vector<std::future<void>> walked;
+         for (uint32_t i = 0; i < num_chunks; ++i) {
+            const uint64_t chunk_begin = boundaries[i], chunk_end = boundaries[i + 1];
+            if (chunk_begin == chunk_end)
+               continue; // adjacent chunks found the same boundary
+            walked.emplace_back(post_async_task(thread_pool.get_executor(), [&entries, index, chunk_begin, chunk_end]() {
+               uint64_t entry_end = chunk_end;
+               uint32_t num       = entry_end == entries.end() ? entries.last_block_num() + 1 : entries.block_num_at(entry_end);
+               while (entry_end > chunk_begin) {
+                  const uint64_t pos = entries.entry_pos(entry_end);
+                  EOS_ASSERT(num > entries.first_block_num() && entries.is_linked_entry(pos, entry_end) &&
+                                   pos >= chunk_begin && entries.block_num_at(pos) == num - 1,
+                             block_log_exception, "Block log entry ending at ${e} does not link back to block ${n}",
+                             ("e", entry_end)("n", num - 1));
+                  --num;
+                  index[num - entries.first_block_num()] = pos;
+                  entry_end = pos;
+               }
+            }));
+         }
+         for (auto& f : walked)
+            f.get();
+         index_region.flush();
+      }
+
+      void block_log_data::construct_index(const fc::path& index_file_path, uint32_t num_threads) {
          std::string index_file_name = index_file_path.generic_string();
          ilog("Will write new blocks.index file ${file}", ("file", index_file_name));
 
@@ -420,6 +626,19 @@ namespace eosio { namespace chain {
          ilog("first block= ${first}         last block= ${last}",
               ("first", this->first_block_num())("last", (this->last_block_num())));
 
+         if (num_threads > 1 && !is_currently_pruned()) {
+            try {
+               construct_index_parallel(*this, index_file_path, num_threads);
+               return;
+            } catch (const fc::exception& e) {
+               wlog("Unable to construct index in parallel, falling back to sequential construction: ${e}",
+                    ("e", e.to_detail_string()));
+            } catch (const std::exception& e) {
+               wlog("Unable to construct index in parallel, falling back to sequential construction: ${e}",
+                    ("e", e.what()));
+            }
+         }
+
          index_writer index(index_file_path, num_blocks);
          uint32_t     blocks_remaining = this->num_blocks();
 
@@ -476,6 +695,7 @@ namespace eosio { namespace chain {
 
          virtual signed_block_ptr                   read_block_by_num(uint32_t block_num)        = 0;
          virtual std::optional<signed_block_header> read_block_header_by_num(uint32_t block_num) = 0;
+         virtual void advise_sequential_read(uint32_t start_block_num, uint32_t end_block_num) {}
 
          virtual uint32_t version() const = 0;
 
@@ -523,6 +743,10 @@ namespace eosio { namespace chain {
       struct basic_block_log : block_log_impl {
          fc::datastream<fc::cfile> block_file;
          fc::datastream<fc::cfile> index_file;
+         // read path: blocks are read straight out of the page cache through these mappings, the cfiles above are
+         // only used for writing. A mapping must be closed before the bytes it covers are rewritten or truncated.
+         log_mapped_file           block_map;
+         log_mapped_file           index_map;
          block_log_preamble        preamble;
          bool                      genesis_written_to_block_log = false;
 
@@ -559,6 +783,12 @@ namespace eosio { namespace chain {
          virtual void             post_append(uint64_t pos) {}
          virtual signed_block_ptr retry_read_block_by_num(uint32_t block_num) { return {}; }
          virtual std::optional<signed_block_header> retry_read_block_header_by_num(uint32_t block_num) { return {}; }
+         virtual void retry_advise_sequential_read(uint32_t start_block_num, uint32_t end_block_num) {}
+
+         void close_mappings() {
+            block_map.close();
+            index_map.close();
+         }
 
          void append(const signed_block_ptr& b, const block_id_type& id,
                      const std::vector<char>& packed_block) override {
@@ -569,15 +799,23 @@ namespace eosio { namespace chain {
                block_file.seek_end(0);
                index_file.seek_end(0);
                // if pruned log, rewind over count trailer if any block is already present
-               if (preamble.is_currently_pruned() && head)
+               if (preamble.is_currently_pruned() && head) {
                   block_file.skip(-sizeof(uint32_t));
+                  // the new block overwrites the mapped trailer and extends past the end of the mapping
+                  block_map.close();
+               }
                uint64_t pos = block_file.tellp();
 
                EOS_ASSERT(index_file.tellp() == sizeof(uint64_t) * (b->block_num() - preamble.first_block_num),
                           block_log_append_fail, "Append to index file occuring at wrong position.",
                           ("position", (uint64_t)index_file.tellp())(
                                 "expected", (b->block_num() - preamble.first_block_num) * sizeof(uint64_t)));
-               block_file.write(packed_block.data(), packed_block.size());
+               if (preamble.is_compressed()) {
+                  auto entry = compress_block_entry(packed_block.data(), packed_block.size());
+                  block_file.write(entry.data(), entry.size());
+               } else {
+                  block_file.write(packed_block.data(), packed_block.size());
+               }
                block_file.write((char*)&pos, sizeof(pos));
                index_file.write((char*)&pos, sizeof(pos));
                index_file.flush();
@@ -593,18 +831,31 @@ namespace eosio { namespace chain {
             if (!(head && block_num <= block_header::num_from_id(head_id) &&
                   block_num >= working_block_file_first_block_num()))
                return block_log::npos;
-            index_file.seek(sizeof(uint64_t) * (block_num - index_first_block_num()));
+            const uint64_t index_pos = sizeof(uint64_t) * (block_num - index_first_block_num());
+            if (index_map.map_to(index_pos + sizeof(uint64_t)))
+               return index_map.read_at<uint64_t>(index_pos);
+            index_file.seek(index_pos);
             uint64_t pos;
             index_file.read((char*)&pos, sizeof(pos));
             return pos;
          }
 
+         /// appended blocks are always flushed before the mutex is released, so once the mapping covers the start of
+         /// an entry it covers the whole entry
+         std::optional<fc::datastream<const char*>> mapped_block_stream(uint64_t pos) {
+            if (!block_map.map_to(pos + 1))
+               return {};
+            return block_map.stream_at(pos);
+         }
+
          signed_block_ptr read_block_by_num(uint32_t block_num) final {
             try {
                uint64_t pos = get_block_pos(block_num);
                if (pos != block_log::npos) {
+                  if (auto ds = mapped_block_stream(pos))
+                     return read_block(*ds, block_num, preamble.is_compressed());
                   block_file.seek(pos);
-                  return read_block(block_file, block_num);
+                  return read_block(block_file, block_num, preamble.is_compressed());
                }
                return retry_read_block_by_num(block_num);
             }
@@ -615,14 +866,34 @@ namespace eosio { namespace chain {
             try {
                uint64_t pos = get_block_pos(block_num);
                if (pos != block_log::npos) {
+                  if (auto ds = mapped_block_stream(pos))
+                     return read_block_header(*ds, block_num, preamble.is_compressed());
                   block_file.seek(pos);
-                  return read_block_header(block_file, block_num);
+                  return read_block_header(block_file, block_num, preamble.is_compressed());
                }
                return retry_read_block_header_by_num(block_num);
             }
             FC_LOG_AND_RETHROW()
          }
 
+         void advise_sequential_read(uint32_t start_block_num, uint32_t end_block_num) final {
+            if (!head)
+               return;
+            end_block_num = std::min(end_block_num, block_header::num_from_id(head_id));
+            if (start_block_num > end_block_num)
+               return;
+            const uint64_t start_pos = get_block_pos(start_block_num);
+            if (start_pos == block_log::npos) {
+               retry_advise_sequential_read(start_block_num, end_block_num);
+               return;
+            }
+            if (!block_map.map_to(start_pos + 1))
+               return;
+            const uint64_t end_pos =
+                  end_block_num < block_header::num_from_id(head_id) ? get_block_pos(end_block_num + 1) : block_map.size();
+            block_map.advise_sequential(start_pos, end_pos - start_pos);
+         }
+
          void open(const fc::path& data_dir) {
 
             if (!fc::is_directory(data_dir))
@@ -698,6 +969,8 @@ namespace eosio { namespace chain {
                block_file.open(fc::cfile::update_rw_mode);
             if (!index_file.is_open())
                index_file.open(fc::cfile::update_rw_mode);
+            block_map.set_file_path(block_file.get_file_path());
+            index_map.set_file_path(index_file.get_file_path());
             if (log_size && !head)
                update_head(read_head());
          }
@@ -711,8 +984,9 @@ namespace eosio { namespace chain {
 
          void reset(uint32_t first_bnum, std::variant<genesis_state, chain_id_type>&& chain_context, uint32_t version) {
 
+            close_mappings();
             block_file.open(fc::cfile::truncate_rw_mode);
-            preamble.ver             = version | (preamble.ver & pruned_version_flag);
+            preamble.ver             = version | (preamble.ver & (pruned_version_flag | compressed_version_flag));
             preamble.first_block_num = first_bnum;
             preamble.chain_context   = std::move(chain_context);
             preamble.write_to(block_file);
@@ -751,7 +1025,7 @@ namespace eosio { namespace chain {
             auto pos = read_head_position();
             if (pos != block_log::npos) {
                block_file.seek(pos);
-               return read_block(block_file, 0);
+               return read_block(block_file, 0, preamble.is_compressed());
             } else {
                return {};
             }
@@ -785,6 +1059,7 @@ namespace eosio { namespace chain {
          }
 
          void vacuum(uint64_t first_block_num, uint64_t index_first_block_num) {
+            close_mappings();
             // go ahead and write a new valid header now. if the vacuum fails midway, at least this means maybe the
             //  block recovery can get through some blocks.
             size_t copy_to_pos = convert_existing_header_to_vacuumed(first_block_num);
@@ -850,6 +1125,8 @@ namespace eosio { namespace chain {
                }
             }
             fc::resize_file(index_file.get_file_path(), num_blocks_in_log * sizeof(uint64_t));
+            // get_block_pos() above may have mapped the index before it was shrunk
+            close_mappings();
 
             preamble.first_block_num = first_block_num;
          }
@@ -921,7 +1198,7 @@ namespace eosio { namespace chain {
 
             try {
                signed_block entry;
-               fc::raw::unpack(ds, entry);
+               unpack_block_entry(ds, entry, log_data.is_compressed());
                if (entry.block_num() != expected_block_num) {
                   return false;
                }
@@ -990,6 +1267,7 @@ namespace eosio { namespace chain {
 
             block_file.close();
             index_file.close();
+            close_mappings();
 
             catalog.add(preamble.first_block_num, this->head->block_num(), block_file.get_file_path().parent_path(),
                         "blocks");
@@ -1004,7 +1282,7 @@ namespace eosio { namespace chain {
             block_file.set_file_path(block_file_path);
             index_file.set_file_path(index_file_path);
 
-            preamble.ver             = block_log::max_supported_version;
+            preamble.ver             = block_log::max_supported_version | (preamble.ver & compressed_version_flag);
             preamble.chain_context   = preamble.chain_id();
             preamble.first_block_num = this->head->block_num() + 1;
             preamble.write_to(block_file);
@@ -1023,17 +1301,29 @@ namespace eosio { namespace chain {
          }
 
          signed_block_ptr retry_read_block_by_num(uint32_t block_num) final {
-            auto ds = catalog.ro_stream_for_block(block_num);
-            if (ds)
-               return read_block(*ds, block_num);
-            return {};
+            auto pos = catalog.get_block_position(block_num);
+            if (!pos)
+               return {};
+            const bool compressed = catalog.log_data.is_compressed();
+            if (auto ds = catalog.log_data.mapped_stream_at(*pos))
+               return read_block(*ds, block_num, compressed);
+            return read_block(catalog.log_data.ro_stream_at(*pos), block_num, compressed);
          }
 
          std::optional<signed_block_header> retry_read_block_header_by_num(uint32_t block_num) final {
-            auto ds = catalog.ro_stream_for_block(block_num);
-            if (ds)
-               return read_block_header(*ds, block_num);
-            return {};
+            auto pos = catalog.get_block_position(block_num);
+            if (!pos)
+               return {};
+            const bool compressed = catalog.log_data.is_compressed();
+            if (auto ds = catalog.log_data.mapped_stream_at(*pos))
+               return read_block_header(*ds, block_num, compressed);
+            return read_block_header(catalog.log_data.ro_stream_at(*pos), block_num, compressed);
+         }
+
+         // only the retained file holding start_block_num is advised, the next one is advised when reading reaches it
+         void retry_advise_sequential_read(uint32_t start_block_num, uint32_t end_block_num) final {
+            if (auto pos = catalog.get_block_position(start_block_num))
+               catalog.log_data.advise_sequential(*pos);
          }
 
          void reset(const chain_id_type& chain_id, uint32_t first_block_num) final {
@@ -1073,6 +1363,8 @@ namespace eosio { namespace chain {
          uint32_t working_block_file_first_block_num() final { return first_block_number; }
 
          void transform_block_log() final {
+            EOS_ASSERT(!preamble.is_compressed(), block_log_exception,
+                       "${file} is a compressed block log which cannot be pruned", ("file", block_file.get_file_path()));
             // convert from  non-pruned block log to pruned if necessary
             if (!preamble.is_currently_pruned()) {
                block_file.open(fc::cfile::update_rw_mode);
@@ -1232,6 +1524,11 @@ namespace eosio { namespace chain {
       return my->read_block_header_by_num(block_num);
    }
 
+   void block_log::advise_sequential_read(uint32_t start_block_num, uint32_t end_block_num) const {
+      std::lock_guard g(my->mtx);
+      my->advise_sequential_read(start_block_num, end_block_num);
+   }
+
    block_id_type block_log::read_block_id_by_num(uint32_t block_num) const {
       // read_block_header_by_num acquires mutex
       auto bh = read_block_header_by_num(block_num);
@@ -1265,13 +1562,14 @@ namespace eosio { namespace chain {
    }
 
    // static
-   void block_log::construct_index(const fc::path& block_file_name, const fc::path& index_file_name) {
+   void block_log::construct_index(const fc::path& block_file_name, const fc::path& index_file_name,
+                                   uint32_t num_threads) {
 
       ilog("Will read existing blocks.log file ${file}", ("file", block_file_name.generic_string()));
       ilog("Will write new blocks.index file ${file}", ("file", index_file_name.generic_string()));
 
       block_log_data log_data(block_file_name);
-      log_data.construct_index(index_file_name);
+      log_data.construct_index(index_file_name, num_threads);
    }
 
    std::tuple<uint64_t, uint32_t, std::string>
@@ -1452,52 +1750,170 @@ namespace eosio { namespace chain {
       return detail::is_pruned_log_and_mask_version(version);
    }
 
-   void extract_blocklog_i(block_log_bundle& log_bundle, const fc::path& new_block_filename, const fc::path& new_index_filename,
-                           uint32_t first_block_num, uint32_t num_blocks) {
+   namespace {
+      /// Read only access to the block entries of a non-pruned blocks.log through its blocks.index, which can be
+      /// shared between threads: the index is mapped and every reader opens the log file on its own.
+      struct block_entries_source {
+         fc::path           log_path;
+         log_mapped_file    index;
+         block_log_preamble preamble;
+         uint64_t           end_pos    = 0;
+         uint32_t           num_blocks = 0;
+
+         explicit block_entries_source(block_log_bundle& bundle)
+             : log_path(bundle.block_file_name), preamble(bundle.log_data.get_preamble()),
+               end_pos(bundle.log_data.end_of_block_position()), num_blocks(bundle.log_index.num_blocks()) {
+            index.set_file_path(bundle.index_file_name);
+            EOS_ASSERT(num_blocks == 0 || index.map_to(uint64_t(num_blocks) * sizeof(uint64_t)), block_log_exception,
+                       "unable to map ${file}", ("file", bundle.index_file_name.generic_string()));
+         }
+
+         uint32_t first_block_num() const { return preamble.first_block_num; }
 
-      auto position_for_block = [&log_bundle](uint64_t block_num) {
-         uint64_t block_order = block_num - log_bundle.log_data.first_block_num();
-         if (block_order < static_cast<uint64_t>(log_bundle.log_index.num_blocks()))
-            return log_bundle.log_index.nth_block_position(block_order);
-         return log_bundle.log_data.size();
+         /// position of the n-th entry of the log, the end of the entries for n == num_blocks
+         uint64_t position(uint32_t n) const {
+            return n < num_blocks ? index.read_at<uint64_t>(uint64_t(n) * sizeof(uint64_t)) : end_pos;
+         }
       };
 
-      first_block_num = std::max(first_block_num, log_bundle.log_data.first_block_num());
-      num_blocks      = std::min(num_blocks, log_bundle.log_data.num_blocks());
+      /// the n-th to (n + count - 1)-th entries of a source log
+      struct entries_segment {
+         const block_entries_source* src;
+         uint32_t                    first;
+         uint32_t                    count;
+      };
 
-      const auto     num_blocks_to_skip   = first_block_num - log_bundle.log_data.first_block_num();
-      const uint64_t first_kept_block_pos = position_for_block(first_block_num);
-      const uint64_t nbytes_to_trim =
-            num_blocks_to_skip == 0 ? 0 : first_kept_block_pos - block_log_preamble::nbytes_with_chain_id;
-      const uint64_t last_block_num      = first_block_num + num_blocks;
-      const uint64_t last_block_pos      = position_for_block(last_block_num);
-      const auto     new_block_file_size = last_block_pos - nbytes_to_trim;
+      /// A blocks.log/blocks.index pair made of a preamble followed by the entries of consecutive segments
+      struct block_log_output {
+         fc::path                     log_path, index_path;
+         block_log_preamble           preamble;
+         std::vector<entries_segment> segments;
+      };
 
-      fc::datastream<fc::cfile> new_block_file;
-      new_block_file.set_file_path(new_block_filename.generic_string());
-      new_block_file.open(fc::cfile::truncate_rw_mode);
+      /// Write all outputs on num_threads threads. Entries are copied verbatim in pieces with
+      /// fc::cfile::copy_range_from(); only their trailing positions and the index entries are regenerated, shifted
+      /// by the distance each segment moved, through mappings of the new files.
+      void write_block_logs(const std::vector<block_log_output>& outputs, uint32_t num_threads) {
+         struct piece {
+            const block_entries_source* src;
+            uint32_t                    first, count;
+            fc::path                    dest_path;
+            uint64_t                    dest_pos;
+            char*                       dest_data;
+            uint64_t*                   index_data;
+         };
+
+         std::vector<boost::interprocess::mapped_region> regions;
+         std::vector<piece>                              pieces;
+         uint64_t                                        total_blocks = 0;
+         for (const auto& out : outputs)
+            for (const auto& seg : out.segments)
+               total_blocks += seg.count;
+         const uint32_t blocks_per_piece = std::max<uint64_t>(1, total_blocks / (uint64_t(num_threads) * 4));
+
+         for (const auto& out : outputs) {
+            uint64_t log_size = 0, num_blocks = 0;
+            {
+               fc::datastream<fc::cfile> new_block_file;
+               new_block_file.set_file_path(out.log_path);
+               new_block_file.open(fc::cfile::truncate_rw_mode);
+               out.preamble.write_to(new_block_file);
+               new_block_file.seek_end(0);
+               log_size = new_block_file.tellp();
 
-      if (num_blocks_to_skip == 0) {
-         copy_file_content(log_bundle.log_data.ro_stream_at(0), new_block_file, new_block_file_size);
-         fc::cfile new_index_file;
-         new_index_file.set_file_path(new_index_filename.generic_string());
-         new_index_file.open(fc::cfile::truncate_rw_mode);
-         const uint64_t index_file_size = num_blocks * sizeof(uint64_t);
-         log_bundle.log_index.copy_to(new_index_file, index_file_size);
-         return;
-      }
+               fc::cfile new_index_file;
+               new_index_file.set_file_path(out.index_path);
+               new_index_file.open(fc::cfile::truncate_rw_mode);
+            }
+            for (const auto& seg : out.segments) {
+               log_size += seg.src->position(seg.first + seg.count) - seg.src->position(seg.first);
+               num_blocks += seg.count;
+            }
+            if (num_blocks == 0)
+               continue;
+            fc::resize_file(out.log_path, log_size);
+            fc::resize_file(out.index_path, num_blocks * sizeof(uint64_t));
+
+            auto map = [&regions](const fc::path& path) {
+               boost::interprocess::file_mapping mapping(path.generic_string().c_str(), boost::interprocess::read_write);
+               regions.emplace_back(mapping, boost::interprocess::read_write);
+               return regions.back().get_address();
+            };
+            char* const     dest_data  = static_cast<char*>(map(out.log_path));
+            uint64_t* const index_data = static_cast<uint64_t*>(map(out.index_path));
+
+            uint64_t dest_pos = log_size, index_slot = num_blocks;
+            for (auto seg = out.segments.rbegin(); seg != out.segments.rend(); ++seg) {
+               for (uint32_t first = seg->first; first < seg->first + seg->count; first += blocks_per_piece) {
+                  const uint32_t count = std::min(blocks_per_piece, seg->first + seg->count - first);
+                  pieces.push_back(piece{ seg->src, first, count, out.log_path, 0, dest_data, nullptr });
+               }
+               // assign the destination offsets of the pieces of the segment, walking back from its end
+               dest_pos -= seg->src->position(seg->first + seg->count) - seg->src->position(seg->first);
+               index_slot -= seg->count;
+               const uint64_t seg_src_pos = seg->src->position(seg->first);
+               for (auto p = pieces.rbegin(); p != pieces.rend() && p->index_data == nullptr; ++p) {
+                  p->dest_pos   = dest_pos + seg->src->position(p->first) - seg_src_pos;
+                  p->index_data = index_data + index_slot + (p->first - seg->first);
+               }
+            }
+         }
 
-      block_log_preamble preamble;
-      preamble.ver             = block_log::max_supported_version;
-      preamble.first_block_num = first_block_num;
-      preamble.chain_context   = log_bundle.log_data.chain_id();
-      preamble.write_to(new_block_file);
-      new_block_file.seek_end(0);
-      copy_file_content(log_bundle.log_data.ro_stream_at(first_kept_block_pos), new_block_file,
-                        last_block_pos - first_kept_block_pos);
+         named_thread_pool<struct blkcpy> thread_pool;
+         thread_pool.start(num_threads, {});
+
+         std::vector<std::future<void>> copied;
+         for (const auto& p : pieces) {
+            copied.emplace_back(post_async_task(thread_pool.get_executor(), [&p]() {
+               fc::cfile src, dest;
+               src.set_file_path(p.src->log_path);
+               src.open("rb");
+               dest.set_file_path(p.dest_path);
+               dest.open(fc::cfile::update_rw_mode);
+
+               const uint64_t src_begin = p.src->position(p.first);
+               dest.copy_range_from(src, src_begin, p.dest_pos, p.src->position(p.first + p.count) - src_begin);
+
+               for (uint32_t i = 0; i < p.count; ++i) {
+                  const uint64_t pos      = p.src->position(p.first + i);
+                  const uint64_t new_pos  = pos - src_begin + p.dest_pos;
+                  char* const    trailing = p.dest_data + p.src->position(p.first + i + 1) - src_begin + p.dest_pos -
+                                         sizeof(uint64_t);
+                  uint64_t       old_pos;
+                  std::memcpy(&old_pos, trailing, sizeof(old_pos));
+                  EOS_ASSERT(old_pos == pos, block_log_exception,
+                             "Block log file ${file} contains a block position value: ${old} which disagrees with "
+                             "${pos} indicated by its index",
+                             ("file", p.src->log_path.generic_string())("old", old_pos)("pos", pos));
+                  std::memcpy(trailing, &new_pos, sizeof(new_pos));
+                  p.index_data[i] = new_pos;
+               }
+            }));
+         }
+         // every task refers to the mappings, wait for all of them before reporting the first failure
+         for (auto& f : copied)
+            f.wait();
+         for (auto& f : copied)
+            f.get();
+         for (auto& region : regions)
+            region.flush();
+      }
+   } // namespace
 
-      index_writer index(new_index_filename, num_blocks);
-      adjust_block_positions(index, new_block_file, block_log_preamble::nbytes_with_chain_id, -nbytes_to_trim);
+   void extract_blocklog_i(const block_entries_source& src, const fc::path& new_block_filename,
+                           const fc::path& new_index_filename, uint32_t first_block_num, uint32_t num_blocks,
+                           uint32_t num_threads) {
+      first_block_num = std::max(first_block_num, src.first_block_num());
+      const uint32_t first = std::min(first_block_num - src.first_block_num(), src.num_blocks);
+      num_blocks           = std::min(num_blocks, src.num_blocks - first);
+
+      block_log_output out{ new_block_filename, new_index_filename, src.preamble, { { &src, first, num_blocks } } };
+      if (first != 0) {
+         out.preamble.ver             = block_log::max_supported_version | (src.preamble.ver & detail::compressed_version_flag);
+         out.preamble.first_block_num = first_block_num;
+         out.preamble.chain_context   = src.preamble.chain_id();
+      }
+      write_block_logs({ out }, num_threads);
    }
 
    // static
@@ -1525,8 +1941,8 @@ namespace eosio { namespace chain {
       fc::path new_block_filename = temp_dir / "blocks.log";
       fc::path new_index_filename = temp_dir / "blocks.index";
 
-      extract_blocklog_i(log_bundle, new_block_filename, new_index_filename, truncate_at_block,
-                         log_bundle.log_data.last_block_num() - truncate_at_block + 1);
+      extract_blocklog_i(block_entries_source(log_bundle), new_block_filename, new_index_filename, truncate_at_block,
+                         log_bundle.log_data.last_block_num() - truncate_at_block + 1, 1);
 
       fc::path old_log = temp_dir / "old.log";
       rename(log_bundle.block_file_name, old_log);
@@ -1590,6 +2006,84 @@ namespace eosio { namespace chain {
       }
    }
 
+   // static
+   void block_log::full_validate(const fc::path& block_dir, uint32_t num_threads) {
+
+      block_log_bundle log_bundle(block_dir);
+      const uint32_t   num_blocks = log_bundle.log_index.num_blocks();
+      if (num_blocks == 0)
+         return;
+
+      const block_entries_view entries(log_bundle.log_data);
+      const bool               compressed = log_bundle.log_data.is_compressed();
+      log_mapped_file          index;
+      index.set_file_path(log_bundle.index_file_name);
+      EOS_ASSERT(index.map_to(num_blocks * sizeof(uint64_t)), block_log_exception, "unable to map ${file}",
+                 ("file", log_bundle.index_file_name.generic_string()));
+
+      // every range of blocks is validated on its own, the links between ranges are checked once all are done
+      struct range_result {
+         block_id_type first_previous;
+         block_id_type last_id;
+      };
+
+      num_threads = std::max(num_threads, 1U);
+      named_thread_pool<struct blkval> thread_pool;
+      thread_pool.start(num_threads, {});
+
+      const uint32_t                         num_ranges = std::min(num_threads * 16, num_blocks);
+      std::vector<std::future<range_result>> results;
+      for (uint32_t r = 0; r < num_ranges; ++r) {
+         const uint32_t begin = uint64_t(num_blocks) * r / num_ranges;
+         const uint32_t end   = uint64_t(num_blocks) * (r + 1) / num_ranges;
+         results.emplace_back(post_async_task(thread_pool.get_executor(), [&entries, &index, compressed, num_blocks, begin, end]() {
+            range_result result;
+            for (uint32_t i = begin; i < end; ++i) {
+               const uint32_t block_num = entries.first_block_num() + i;
+               const uint64_t pos       = index.read_at<uint64_t>(i * sizeof(uint64_t));
+               const uint64_t entry_end =
+                     i + 1 < num_blocks ? index.read_at<uint64_t>((i + 1) * sizeof(uint64_t)) : entries.end();
+               EOS_ASSERT(entry_end <= entries.end() && entries.is_linked_entry(pos, entry_end) &&
+                                entries.entry_pos(entry_end) == pos,
+                          block_log_exception,
+                          "the block position for block ${num} at the end of a block entry is incorrect",
+                          ("num", block_num));
+
+               signed_block                entry;
+               fc::datastream<const char*> ds(entries.file().data() + pos, entry_end - sizeof(uint64_t) - pos);
+               unpack_block_entry(ds, entry, compressed);
+               EOS_ASSERT(ds.remaining() == 0, block_log_exception,
+                          "Block ${num} does not span its whole block log entry", ("num", block_num));
+               EOS_ASSERT(entry.block_num() == block_num, block_log_exception,
+                          "At position ${pos} expected to find block number ${exp_bnum} but found ${act_bnum}",
+                          ("pos", pos)("exp_bnum", block_num)("act_bnum", entry.block_num()));
+               if (i == begin) {
+                  result.first_previous = entry.previous;
+               } else {
+                  EOS_ASSERT(entry.previous == result.last_id, block_log_exception,
+                             "Block ${num} does not link back to previous block. Expected previous: ${expected}. "
+                             "Actual previous: ${actual}.",
+                             ("num", block_num)("expected", result.last_id)("actual", entry.previous));
+               }
+               result.last_id = entry.calculate_id();
+            }
+            return result;
+         }));
+      }
+
+      block_id_type last_id;
+      for (uint32_t r = 0; r < num_ranges; ++r) {
+         const auto result = results[r].get();
+         EOS_ASSERT(r == 0 || result.first_previous == last_id, block_log_exception,
+                    "Block ${num} does not link back to previous block. Expected previous: ${expected}. "
+                    "Actual previous: ${actual}.",
+                    ("num", entries.first_block_num() + uint64_t(num_blocks) * r / num_ranges)("expected", last_id)(
+                          "actual", result.first_previous));
+         last_id = result.last_id;
+      }
+      ilog("Validated ${n} blocks, last block id ${id}", ("n", num_blocks)("id", last_id));
+   }
+
    std::pair<fc::path, fc::path> blocklog_files(const fc::path& dir, uint32_t start_block_num, uint32_t num_blocks) {
       const int bufsize = 64;
       char      buf[bufsize];
@@ -1602,7 +2096,8 @@ namespace eosio { namespace chain {
 
    // static
    void block_log::extract_block_range(const fc::path& block_dir, const fc::path& dest_dir,
-                                       block_num_type start_block_num, block_num_type last_block_num) {
+                                       block_num_type start_block_num, block_num_type last_block_num,
+                                       uint32_t num_threads) {
 
 
       block_log_bundle log_bundle(block_dir);
@@ -1618,27 +2113,40 @@ namespace eosio { namespace chain {
 
       auto [new_block_filename, new_index_filename] = blocklog_files(dest_dir, start_block_num, num_blocks);
 
-      extract_blocklog_i(log_bundle, new_block_filename, new_index_filename, start_block_num, num_blocks);
+      extract_blocklog_i(block_entries_source(log_bundle), new_block_filename, new_index_filename, start_block_num,
+                         num_blocks, num_threads);
    }
 
    // static
-   void block_log::split_blocklog(const fc::path& block_dir, const fc::path& dest_dir, uint32_t stride) {
+   void block_log::split_blocklog(const fc::path& block_dir, const fc::path& dest_dir, uint32_t stride,
+                                  uint32_t num_threads) {
 
-      block_log_bundle log_bundle(block_dir);
-      const uint32_t   first_block_num = log_bundle.log_data.first_block_num();
-      const uint32_t   last_block_num  = log_bundle.log_data.last_block_num();
+      block_log_bundle           log_bundle(block_dir);
+      const block_entries_source src(log_bundle);
+      const uint32_t             first_block_num = log_bundle.log_data.first_block_num();
+      const uint32_t             last_block_num  = log_bundle.log_data.last_block_num();
 
       if (!fc::exists(dest_dir))
          fc::create_directories(dest_dir);
 
+      // all the stride files are written at once so that their copies are spread over the threads together
+      std::vector<block_log_output> outputs;
       for (uint32_t i = (first_block_num - 1) / stride; i < (last_block_num + stride - 1) / stride; ++i) {
          uint32_t start_block_num = std::max(i * stride + 1, first_block_num);
          uint32_t num_blocks      = std::min((i + 1) * stride, last_block_num) - start_block_num + 1;
 
          auto [new_block_filename, new_index_filename] = blocklog_files(dest_dir, start_block_num, num_blocks);
 
-         extract_blocklog_i(log_bundle, new_block_filename, new_index_filename, start_block_num, num_blocks);
+         block_log_output out{ new_block_filename, new_index_filename, src.preamble,
+                               { { &src, start_block_num - first_block_num, num_blocks } } };
+         if (start_block_num != first_block_num) {
+            out.preamble.ver             = block_log::max_supported_version | (src.preamble.ver & detail::compressed_version_flag);
+            out.preamble.first_block_num = start_block_num;
+            out.preamble.chain_context   = src.preamble.chain_id();
+         }
+         outputs.push_back(std::move(out));
       }
+      write_block_logs(outputs, num_threads);
    }
 
    inline bfs::path operator+(const bfs::path& left, const bfs::path& right) { return bfs::path(left) += right; }
@@ -1660,7 +2168,7 @@ namespace eosio { namespace chain {
    }
 
    // static
-   void block_log::merge_blocklogs(const fc::path& blocks_dir, const fc::path& dest_dir) {
+   void block_log::merge_blocklogs(const fc::path& blocks_dir, const fc::path& dest_dir, uint32_t num_threads) {
       block_log_catalog catalog;
 
       catalog.open("", blocks_dir, "", "blocks");
@@ -1672,52 +2180,114 @@ namespace eosio { namespace chain {
       if (!fc::exists(dest_dir))
          fc::create_directories(dest_dir);
 
-      fc::temp_directory temp_dir;
-      bfs::path          temp_path   = temp_dir.path();
-      uint32_t           start_block = 0, end_block = 0;
-
-      bfs::path                 temp_block_log   = temp_path / "blocks.log";
-      bfs::path                 temp_block_index = temp_path / "blocks.index";
-      fc::datastream<fc::cfile> file;
-      file.set_file_path(temp_block_log);
-
+      // group the files into runs of consecutive blocks with the same compression, each run is merged into one file
+      std::vector<std::unique_ptr<block_entries_source>> sources;
+      std::vector<std::vector<const block_entries_source*>> runs;
       for (auto const& [first_block_num, val] : catalog.collection) {
-         if (bfs::exists(temp_block_log)) {
-            if (first_block_num == end_block + 1) {
-               block_log_data log_data;
-               log_data.open(val.filename_base + ".log");
-               if (!file.is_open())
-                  file.open(fc::cfile::update_rw_mode);
-               file.seek_end(0);
-               auto orig_log_size = file.tellp();
-               copy_file_content(log_data.ro_stream_at(log_data.first_block_position()), file);
-               file.flush();
-               end_block = val.last_block_num;
-               index_writer index(temp_block_index, end_block - start_block + 1, false);
-               adjust_block_positions(index, file, orig_log_size, orig_log_size - log_data.first_block_position());
-               file.flush();
+         block_log_bundle log_bundle(val.filename_base + ".log", val.filename_base + ".index");
+         const auto&      src = *sources.emplace_back(std::make_unique<block_entries_source>(log_bundle));
+         if (!runs.empty()) {
+            const auto& prev = *runs.back().back();
+            // compressed and uncompressed entries cannot be mixed in the same file
+            if (first_block_num == prev.first_block_num() + prev.num_blocks &&
+                src.preamble.is_compressed() == prev.preamble.is_compressed()) {
+               runs.back().push_back(&src);
                continue;
-
-            } else
-               wlog("${file}.log cannot be merged with previous block log file because of the discontinuity of blocks, "
-                    "skip merging.",
-                    ("file", val.filename_base.generic_string()));
-            // there is a version or block number gap between the stride files
-            move_blocklog_files(temp_path, dest_dir, start_block, end_block);
+            }
+            wlog("${file}.log cannot be merged with previous block log file because of the discontinuity of blocks "
+                 "or a different compression, skip merging.",
+                 ("file", val.filename_base.generic_string()));
          }
+         runs.push_back({ &src });
+      }
 
-         bfs::copy(val.filename_base + ".log", temp_block_log);
-         bfs::copy(val.filename_base + ".index", temp_block_index);
-         start_block = first_block_num;
-         end_block   = val.last_block_num;
+      // the merged files are written next to their destination, so that moving them in place is a rename
+      fc::temp_directory            temp_dir(dest_dir);
+      std::vector<block_log_output> outputs;
+      for (size_t i = 0; i < runs.size(); ++i) {
+         const auto  run_dir = temp_dir.path() / std::to_string(i);
+         fc::create_directories(run_dir);
+         auto& out = outputs.emplace_back(block_log_output{ run_dir / "blocks.log", run_dir / "blocks.index",
+                                                            runs[i].front()->preamble, {} });
+         for (const auto* src : runs[i])
+            out.segments.push_back({ src, 0, src->num_blocks });
       }
+      write_block_logs(outputs, num_threads);
 
-      if (file.is_open())
-         file.close();
+      for (size_t i = 0; i < runs.size(); ++i) {
+         const auto& last = *runs[i].back();
+         move_blocklog_files(temp_dir.path() / std::to_string(i), dest_dir, runs[i].front()->first_block_num(),
+                             last.first_block_num() + last.num_blocks - 1);
+      }
+   }
+
+   // static
+   void block_log::compress_blocklog(const fc::path& block_dir, const fc::path& output_dir) {
+      EOS_ASSERT(block_dir != output_dir, block_log_exception,
+                 "block_dir and output_dir need to be different directories");
+
+      block_log_bundle log_bundle(block_dir);
+      EOS_ASSERT(!log_bundle.log_data.is_compressed(), block_log_exception, "${file} is already compressed",
+                 ("file", log_bundle.block_file_name.generic_string()));
+
+      if (!fc::exists(output_dir))
+         fc::create_directories(output_dir);
+
+      fc::datastream<fc::cfile> new_block_file;
+      new_block_file.set_file_path(output_dir / "blocks.log");
+      new_block_file.open(fc::cfile::truncate_rw_mode);
+      fc::cfile new_index_file;
+      new_index_file.set_file_path(output_dir / "blocks.index");
+      new_index_file.open(fc::cfile::truncate_rw_mode);
 
-      if (bfs::exists(temp_block_log)) {
-         move_blocklog_files(temp_path, dest_dir, start_block, end_block);
+      block_log_preamble preamble = log_bundle.log_data.get_preamble();
+      preamble.ver |= detail::compressed_version_flag;
+      preamble.write_to(new_block_file);
+      new_block_file.seek_end(0);
+
+      const uint32_t num_blocks = log_bundle.log_index.num_blocks();
+      ilog("Compressing ${n} blocks of ${file}",
+           ("n", num_blocks)("file", log_bundle.block_file_name.generic_string()));
+
+      // entries are compressed on the thread pool a batch at a time and written out in order
+      named_thread_pool<struct blkcmp> thread_pool;
+      thread_pool.start(std::max(std::thread::hardware_concurrency(), 1U), {});
+      constexpr uint32_t batch_size = 1024;
+
+      uint64_t in_bytes = 0, out_bytes = 0;
+      for (uint32_t first = 0; first < num_blocks; first += batch_size) {
+         const uint32_t last = std::min(first + batch_size, num_blocks);
+
+         std::vector<std::future<std::vector<char>>> entries;
+         entries.reserve(last - first);
+         for (uint32_t n = first; n < last; ++n) {
+            const uint64_t pos = log_bundle.log_index.nth_block_position(n);
+            const uint64_t end = n + 1 < num_blocks ? log_bundle.log_index.nth_block_position(n + 1)
+                                                    : log_bundle.log_data.end_of_block_position();
+            std::vector<char> packed_block(end - pos - sizeof(uint64_t));
+            log_bundle.log_data.ro_stream_at(pos).read(packed_block.data(), packed_block.size());
+            in_bytes += packed_block.size();
+            entries.emplace_back(post_async_task(thread_pool.get_executor(), [packed_block{std::move(packed_block)}]() {
+               return compress_block_entry(packed_block.data(), packed_block.size());
+            }));
+         }
+
+         for (auto& f : entries) {
+            const auto     entry = f.get();
+            const uint64_t pos   = new_block_file.tellp();
+            new_block_file.write(entry.data(), entry.size());
+            new_block_file.write(reinterpret_cast<const char*>(&pos), sizeof(pos));
+            new_index_file.write(reinterpret_cast<const char*>(&pos), sizeof(pos));
+            out_bytes += entry.size();
+         }
+
+         if ((first / batch_size) % 1000 == 0)
+            ilog("Compressed ${n} of ${total} blocks", ("n", last)("total", num_blocks));
       }
+      new_block_file.flush();
+      new_index_file.flush();
+
+      ilog("Compressed ${n} blocks from ${in} to ${out} bytes", ("n", num_blocks)("in", in_bytes)("out", out_bytes));
    }
 
 }} // namespace eosio::chain
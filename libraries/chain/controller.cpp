@@ -30,12 +30,14 @@
 
 #include <chainbase/chainbase.hpp>
 #include <eosio/vm/allocator.hpp>
+#include <eosio/chain/webassembly/wasm_allocator_pool.hpp>
 #include <fc/io/json.hpp>
 #include <fc/log/logger_config.hpp>
 #include <fc/scoped_exit.hpp>
 #include <fc/variant_object.hpp>
 #include <eosio/chain/database_manager.hpp>
 
+#include <condition_variable>
 #include <new>
 #include <shared_mutex>
 
@@ -169,6 +171,8 @@ struct building_shard {
    deque<transaction_receipt>                   _pending_trx_receipts; // boost deque in 1.71 with 1024 elements performs better
    digests_t                                    _trx_mroot_or_receipt_digests;
    digests_t                                    _action_receipt_digests;
+   std::future<merkle_segment>                  _receipt_merkle_segment; // valid once started by shard_merkle_builder
+   std::future<merkle_segment>                  _action_merkle_segment;  // valid once started by shard_merkle_builder
    deque<xshard_id_type>                        _xsh_in_queue;
    flat_set<xshard_id_type>                     _xsh_in_set;
    deque<xsh_out_action>                        _xsh_out_actions;
@@ -194,6 +198,8 @@ struct shard_transaction_metadata {
 struct block_shard_context {
    vector<shard_transaction_metadata> trx_metas;
    building_shard             &pending_shard;
+   fc::microseconds           recover_keys_wait{};
+   fc::microseconds           execution{};
    block_shard_context(building_shard &pending_shard): pending_shard(pending_shard) {}
 };
 
@@ -212,6 +218,7 @@ struct building_block {
    size_t                                     _num_new_protocol_features_that_have_activated = 0;
    std::optional<checksum256_type>            _trx_mroot;
    std::map<shard_name, building_shard>       _shards;
+   bool                                       _merkle_segments_started = false;
 
    inline transaction_metadata_map extract_trx_metas() {
       transaction_metadata_map result;
@@ -233,22 +240,22 @@ struct building_block {
       return result;
    }
 
-   inline digests_t extract_receipt_digests() {
-      digests_t result;
+   // waits for the segments started by shard_merkle_builder
+   inline vector<merkle_segment> extract_receipt_merkle_segments() {
+      vector<merkle_segment> result;
+      result.reserve(_shards.size());
       for (auto& shard : _shards) {
-         if (!shard.second._trx_mroot_or_receipt_digests.empty()) {
-            fc::move_append( result, std::move(shard.second._trx_mroot_or_receipt_digests) );
-         }
+         result.emplace_back( shard.second._receipt_merkle_segment.get() );
       }
       return result;
    }
 
-   inline digests_t extract_action_receipt_digests() {
-      digests_t result;
+   // waits for the segments started by shard_merkle_builder
+   inline vector<merkle_segment> extract_action_merkle_segments() {
+      vector<merkle_segment> result;
+      result.reserve(_shards.size());
       for (auto& shard : _shards) {
-         if (!shard.second._action_receipt_digests.empty()) {
-            fc::move_append( result, std::move(shard.second._action_receipt_digests) );
-         }
+         result.emplace_back( shard.second._action_merkle_segment.get() );
       }
       return result;
    }
@@ -259,6 +266,91 @@ struct building_block {
 
 };
 
+/**
+ * Starts building the merkle segments of the receipt and action digests of every shard of a building block.
+ * The digests of a shard follow those of all shards before it in shard name order, so the segment of a shard can
+ * be started once it and every shard before it stopped executing. finished() is called by each shard as it stops:
+ * the shard builds its own segment on its own thread when possible and posts the segments of the shards after it
+ * that were only waiting for it. Shards not in @p executing are treated as already stopped.
+ */
+class shard_merkle_builder {
+public:
+   shard_merkle_builder( building_block& bb, const std::set<shard_name>& executing, boost::asio::io_context& ioc )
+   : _ioc( ioc ), _build_receipts( !bb._trx_mroot ) {
+      EOS_ASSERT( !bb._merkle_segments_started, block_validate_exception, "merkle segments already started" );
+      bb._merkle_segments_started = true;
+      _shards.reserve( bb._shards.size() );
+      for( auto& shard : bb._shards ) {
+         _shards.push_back( { &shard.second, executing.count( shard.first ) == 0 } );
+      }
+      start_ready( nullptr );
+   }
+
+   // thread safe, called from the shard thread once the shard will not produce any more digests
+   void finished( building_shard& shard ) {
+      {
+         std::lock_guard g( _mtx );
+         auto itr = std::find_if( _shards.begin(), _shards.end(), [&]( const auto& e ) { return e.shard == &shard; } );
+         EOS_ASSERT( itr != _shards.end(), block_validate_exception, "unknown shard ${s}", ("s", shard._name) );
+         itr->finished = true;
+      }
+      start_ready( &shard );
+   }
+
+private:
+   struct entry {
+      building_shard* shard    = nullptr;
+      bool            finished = false;
+   };
+
+   struct ready_shard {
+      building_shard*      shard;
+      deque<digest_type>   receipt_digests;
+      uint64_t             receipt_offset;
+      deque<digest_type>   action_digests;
+      uint64_t             action_offset;
+   };
+
+   void start_ready( building_shard* current ) {
+      vector<ready_shard> ready;
+      {
+         std::lock_guard g( _mtx );
+         for( ; _next < _shards.size() && _shards[_next].finished; ++_next ) {
+            auto& shard = *_shards[_next].shard;
+            auto& r = ready.emplace_back( ready_shard{ &shard, {}, _receipt_offset, std::move( shard._action_receipt_digests ), _action_offset } );
+            if( _build_receipts )
+               r.receipt_digests = std::move( shard._trx_mroot_or_receipt_digests );
+            _receipt_offset += r.receipt_digests.size();
+            _action_offset += r.action_digests.size();
+         }
+      }
+      for( auto& r : ready ) {
+         if( _build_receipts )
+            r.shard->_receipt_merkle_segment = start_segment( std::move( r.receipt_digests ), r.receipt_offset, r.shard == current );
+         r.shard->_action_merkle_segment = start_segment( std::move( r.action_digests ), r.action_offset, r.shard == current );
+      }
+   }
+
+   std::future<merkle_segment> start_segment( deque<digest_type> ids, uint64_t offset, bool on_this_thread ) {
+      if( on_this_thread ) {
+         std::promise<merkle_segment> segment;
+         segment.set_value( make_merkle_segment( std::move( ids ), offset ) );
+         return segment.get_future();
+      }
+      return post_async_task( _ioc, [ids{std::move( ids )}, offset]() mutable {
+         return make_merkle_segment( std::move( ids ), offset );
+      } );
+   }
+
+   boost::asio::io_context& _ioc;
+   const bool               _build_receipts;
+   std::mutex               _mtx;
+   vector<entry>            _shards;          // in shard name order, the order of the digests in the block
+   size_t                   _next = 0;        // first shard whose segments are not started yet
+   uint64_t                 _receipt_offset = 0;
+   uint64_t                 _action_offset = 0;
+};
+
 struct assembled_block {
    block_id_type                 _id;
    pending_block_header_state    _pending_block_header_state;
@@ -338,6 +430,69 @@ struct pending_state {
    }
 };
 
+/**
+ *  Bounded queue of irreversible blocks read ahead of replay. Filled in block number order by a reader thread,
+ *  drained by the replaying thread. Each entry carries the future of the preparation of its transaction metadata.
+ */
+class replay_prefetch_queue {
+public:
+   struct entry {
+      signed_block_ptr                       block;
+      std::future<transaction_metadata_map>  trx_metas;
+   };
+
+   explicit replay_prefetch_queue( size_t max_size ) : _max_size( max_size ) {}
+
+   /// called by the reader, blocks while full, returns false when stopped
+   bool push( entry&& e ) {
+      std::unique_lock g( _mtx );
+      _cv.wait( g, [&]() { return _stopped || _queue.size() < _max_size; } );
+      if( _stopped )
+         return false;
+      _queue.push_back( std::move( e ) );
+      _cv.notify_all();
+      return true;
+   }
+
+   /// called by the reader once all blocks are read, or with the exception that ended reading
+   void done( std::exception_ptr except = {} ) {
+      std::lock_guard g( _mtx );
+      _done = true;
+      _except = except;
+      _cv.notify_all();
+   }
+
+   /// called by the replaying thread, blocks until the next block is available, empty once all read blocks are popped
+   std::optional<entry> pop() {
+      std::unique_lock g( _mtx );
+      _cv.wait( g, [&]() { return _stopped || _done || !_queue.empty(); } );
+      if( !_queue.empty() ) {
+         entry e = std::move( _queue.front() );
+         _queue.pop_front();
+         _cv.notify_all();
+         return e;
+      }
+      if( _except )
+         std::rethrow_exception( _except );
+      return {};
+   }
+
+   void stop() {
+      std::lock_guard g( _mtx );
+      _stopped = true;
+      _cv.notify_all();
+   }
+
+private:
+   const size_t             _max_size;
+   std::mutex               _mtx;
+   std::condition_variable  _cv;
+   std::deque<entry>        _queue;
+   bool                     _done = false;
+   bool                     _stopped = false;
+   std::exception_ptr       _except;
+};
+
 struct controller_impl {
    enum class app_window_type {
       write, // Only main thread is running; read-only threads are not running.
@@ -360,6 +515,7 @@ struct controller_impl {
    std::optional<pending_state>    pending;
    block_state_ptr                 head;
    fork_database                   fork_db;
+   controller::fork_switch_stats   fork_switch_stats;
    resource_limits_manager         resource_limits;
    protocol_feature_manager        protocol_features;
    controller::config              conf;
@@ -373,6 +529,7 @@ struct controller_impl {
    struct chain; // chain is a namespace so use an embedded type for the named_thread_pool tag
    named_thread_pool<chain>        thread_pool;
    struct shard; // shard is a namespace so use an embedded type for the named_thread_pool tag
+   struct blkread; // replay block prefetch thread
    named_thread_pool<shard>        shard_thread_pool;
    deep_mind_handler*              deep_mind_logger = nullptr;
    bool                            okay_to_print_integrity_hash_on_stop = false;
@@ -381,10 +538,9 @@ struct controller_impl {
    thread_local static platform_timer timer; // a copy for main thread and each read-only thread
 #if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
    thread_local static vm::wasm_allocator wasm_alloc; // a copy for main thread and each read-only thread
+   thread_local static wasm_allocator_pool wasm_alloc_pool; // linear memories of contract executions, per thread
 #endif
-   wasm_interface  wasmif;  // used by main thread and all threads for EOSVMOC
-   std::mutex threaded_wasmifs_mtx;
-   std::unordered_map<std::thread::id, std::unique_ptr<wasm_interface>> threaded_wasmifs; // one for each read-only thread, used by eos-vm and eos-vm-jit
+   wasm_interface  wasmif;  // used by main, shard and read-only threads; instantiated modules are shared through its cache
    app_window_type app_window = app_window_type::write;
 
    typedef pair<scope_name,action_name>                   handler_key;
@@ -480,14 +636,13 @@ struct controller_impl {
       set_activation_handler<builtin_protocol_feature_t::get_code_hash>();
       set_activation_handler<builtin_protocol_feature_t::get_block_num>();
       set_activation_handler<builtin_protocol_feature_t::crypto_primitives>();
+      set_activation_handler<builtin_protocol_feature_t::bulk_table_scan>();
+      set_activation_handler<builtin_protocol_feature_t::batched_crypto>();
 
       self.irreversible_block.connect([this](const block_state_ptr& bsp) {
          // producer_plugin has already asserted irreversible_block signal is
          // called in write window
          wasmif.current_lib(bsp->block_num);
-         for (auto& w: threaded_wasmifs) {
-            w.second->current_lib(bsp->block_num);
-         }
       });
 
 
@@ -664,11 +819,16 @@ struct controller_impl {
          ilog( "existing block log, attempting to replay from ${s} to ${n} blocks",
                ("s", start_block_num)("n", blog_head->block_num()) );
          try {
-            while( auto next = blog.read_block_by_num( head->block_num + 1 ) ) {
-               replay_push_block( next, controller::block_status::irreversible );
-               if( check_shutdown() ) break;
-               if( next->block_num() % 500 == 0 ) {
-                  ilog( "${n} of ${head}", ("n", next->block_num())("head", blog_head->block_num()) );
+            if( conf.replay_prefetch_blocks > 0 ) {
+               replay_prefetched( blog_head->block_num(), check_shutdown );
+            } else {
+               blog.advise_sequential_read( start_block_num, blog_head->block_num() );
+               while( auto next = blog.read_block_by_num( head->block_num + 1 ) ) {
+                  replay_push_block( next, controller::block_status::irreversible );
+                  if( check_shutdown() ) break;
+                  if( next->block_num() % 500 == 0 ) {
+                     ilog( "${n} of ${head}", ("n", next->block_num())("head", blog_head->block_num()) );
+                  }
                }
             }
          } catch(  const database_guard_exception& e ) {
@@ -732,6 +892,67 @@ struct controller_impl {
       }
    }
 
+   // Irreversible replay pipeline: a reader thread reads and unpacks blocks ahead of execution, thread_pool verifies the
+   // transaction merkle and prepares the transaction metadata of each block, this thread only executes blocks.
+   void replay_prefetched( uint32_t last_block_num, const std::function<bool()>& check_shutdown ) {
+      replay_prefetch_queue queue( conf.replay_prefetch_blocks );
+      const bool recover_keys = conf.force_all_checks;
+
+      named_thread_pool<blkread> reader;
+      reader.start( 1, {} );
+      auto stop_reader = fc::make_scoped_exit( [&]() {
+         queue.stop();
+         reader.stop();
+      } );
+
+      boost::asio::post( reader.get_executor(), [&queue, recover_keys, last_block_num, first_block_num = head->block_num + 1, this]() {
+         try {
+            for( uint32_t n = first_block_num; n <= last_block_num; ++n ) {
+               // re-advise periodically, a hint only covers the retained block log file it starts in
+               if( (n - first_block_num) % 10000 == 0 )
+                  blog.advise_sequential_read( n, last_block_num );
+               auto b = blog.read_block_by_num( n );
+               if( !b )
+                  break;
+               auto trx_metas = post_async_task( thread_pool.get_executor(), [b, recover_keys, this]() {
+                  return prepare_replay_trx_metas( b, recover_keys );
+               } );
+               if( !queue.push( { std::move( b ), std::move( trx_metas ) } ) )
+                  return;
+            }
+            queue.done();
+         } catch( ... ) {
+            queue.done( std::current_exception() );
+         }
+      } );
+
+      while( auto next = queue.pop() ) {
+         replay_push_block( next->block, controller::block_status::irreversible, next->trx_metas.get() );
+         if( check_shutdown() ) break;
+         if( next->block->block_num() % 500 == 0 ) {
+            ilog( "${n} of ${head}", ("n", next->block->block_num())("head", last_block_num) );
+         }
+      }
+   }
+
+   // thread safe, expected to be called from thread other than the main thread
+   transaction_metadata_map prepare_replay_trx_metas( const signed_block_ptr& b, bool recover_keys ) {
+      auto trx_mroot = calculate_trx_merkle( b->transactions );
+      EOS_ASSERT( b->transaction_mroot == trx_mroot, block_validate_exception,
+                  "invalid block transaction merkle root ${b} != ${c}", ("b", b->transaction_mroot)("c", trx_mroot) );
+
+      transaction_metadata_map trx_metas;
+      for( const auto& receipt : b->transactions ) {
+         if( !std::holds_alternative<packed_transaction>( receipt.trx ) )
+            continue;
+         packed_transaction_ptr ptrx( b, &std::get<packed_transaction>( receipt.trx ) ); // alias signed_block_ptr
+         trx_metas[receipt.get_shard_name()].emplace_back( recover_keys
+               ? transaction_metadata::recover_keys( std::move( ptrx ), chain_id, fc::microseconds::maximum(), transaction_metadata::trx_type::input )
+               : transaction_metadata::create_no_recover_keys( std::move( ptrx ), transaction_metadata::trx_type::input ) );
+      }
+      return trx_metas;
+   }
+
    void startup(std::function<void()> shutdown, std::function<bool()> check_shutdown, const snapshot_reader_ptr& snapshot) {
       EOS_ASSERT( snapshot, snapshot_exception, "No snapshot reader provided" );
       this->shutdown = shutdown;
@@ -2311,21 +2532,16 @@ struct controller_impl {
       auto& pbhs = pending->get_pending_block_header_state();
 
       auto& bb = std::get<building_block>(pending->_block_stage);
+      auto& stages = pending->_block_report.stages;
 
-      auto action_merkle_fut = post_async_task( thread_pool.get_executor(),
-                                                [ids{bb.extract_action_receipt_digests()}]() mutable {
-                                                   return merkle( std::move( ids ) );
-                                                } );
-
-      std::future<checksum256_type> trx_merkle_fut;
-      if( !bb._trx_mroot ) {
-         trx_merkle_fut = post_async_task( thread_pool.get_executor(),
-                                           [ids{bb.extract_receipt_digests()}]() mutable {
-                                              return merkle( std::move( ids ) );
-                                           } );
+      // apply_block() starts the merkle segments of each shard as it finishes executing, otherwise build them all
+      // in parallel now; only the nodes spanning several shards are left to compute for the block header
+      if( !bb._merkle_segments_started ) {
+         shard_merkle_builder merkle_builder( bb, {}, thread_pool.get_executor() );
       }
 
       // process xshard
+      auto stage_start = fc::time_point::now();
       for (auto& shard_pair : bb._shards) {
          // xshout
          const auto& shard_name = shard_pair.first;
@@ -2401,7 +2617,10 @@ struct controller_impl {
       }
 
 
+      stages.xshard = fc::time_point::now() - stage_start;
+
       // Update resource limits:
+      stage_start = fc::time_point::now();
       resource_limits.process_account_limit_updates();
       const auto& chain_config = self.get_global_properties().configuration;
       uint64_t CPU_TARGET = EOS_PERCENT(chain_config.max_block_cpu_usage, chain_config.target_block_cpu_usage_pct);
@@ -2418,7 +2637,9 @@ struct controller_impl {
          processing_shard.push_back( &(shard_pair.second._db) );
       }
       resource_limits.process_block_usage( pbhs.block_num, processing_shard );
+      stages.process_block_usage = fc::time_point::now() - stage_start;
 
+      stage_start = fc::time_point::now();
       const auto& sc_indx = dbm.main_db().get_index<shard_change_index, by_id>();
       for(  auto itr = sc_indx.begin();
             itr != sc_indx.end() && itr->block_num <= pbhs.dpos_irreversible_blocknum;
@@ -2446,12 +2667,21 @@ struct controller_impl {
          }
          dbm.main_db().remove( *itr );
       }
+      stages.xshard += fc::time_point::now() - stage_start;
+
+      stage_start = fc::time_point::now();
       sync_shared_db_changes();
+      stages.sync_shared_db = fc::time_point::now() - stage_start;
+
+      stage_start = fc::time_point::now();
+      const checksum256_type trx_mroot = bb._trx_mroot ? *bb._trx_mroot : merkle( bb.extract_receipt_merkle_segments() );
+      const checksum256_type action_mroot = merkle( bb.extract_action_merkle_segments() );
+      stages.merkle = fc::time_point::now() - stage_start;
 
       // Create (unsigned) block:
       auto block_ptr = std::make_shared<signed_block>( pbhs.make_block_header(
-         bb._trx_mroot ? *bb._trx_mroot : trx_merkle_fut.get(),
-         action_merkle_fut.get(),
+         trx_mroot,
+         action_mroot,
          bb._new_pending_producer_schedule,
          std::move( bb._new_protocol_feature_activations ),
          protocol_features.get_protocol_feature_set()
@@ -2490,11 +2720,19 @@ struct controller_impl {
    /**
     * @post regardless of the success of commit block there is no active pending block
     */
-   void commit_block( bool add_to_fork_db ) {
+   void commit_block( bool add_to_fork_db, controller::block_stage_times* stages = nullptr ) {
       auto reset_pending_on_exit = fc::make_scoped_exit([this]{
          pending.reset();
       });
 
+      fc::microseconds commit_time, signals_time;
+      auto stage_start = fc::time_point::now();
+      auto end_stage = [&stage_start]( fc::microseconds& stage ) {
+         auto now = fc::time_point::now();
+         stage += now - stage_start;
+         stage_start = now;
+      };
+
       try {
          EOS_ASSERT( std::holds_alternative<completed_block>(pending->_block_stage), block_validate_exception,
                      "cannot call commit_block until pending block is completed" );
@@ -2504,7 +2742,9 @@ struct controller_impl {
          if( add_to_fork_db ) {
             fork_db.add( bsp );
             fork_db.mark_valid( bsp );
+            end_stage( commit_time );
             emit( self.accepted_block_header, bsp );
+            end_stage( signals_time );
             head = fork_db.head();
             EOS_ASSERT( bsp == head, fork_database_exception, "committed block did not become the new head in fork database");
          }
@@ -2514,7 +2754,9 @@ struct controller_impl {
             dm_logger->on_accepted_block(bsp);
          }
 
+         end_stage( commit_time );
          emit( self.accepted_block, bsp );
+         end_stage( signals_time );
 
          if( add_to_fork_db ) {
             log_irreversible();
@@ -2528,6 +2770,12 @@ struct controller_impl {
 
       // push the state for pending.
       pending->push();
+      end_stage( commit_time );
+
+      if( stages ) {
+         stages->commit  = commit_time;
+         stages->signals = signals_time;
+      }
    }
 
    /**
@@ -2702,21 +2950,30 @@ struct controller_impl {
             }
          }
 
+         std::set<shard_name> executing_shards;
+         for (const auto& shard_context : shard_contexts)
+            executing_shards.insert(shard_context.pending_shard._name);
+         shard_merkle_builder merkle_builder( std::get<building_block>(pending->_block_stage), executing_shards, thread_pool.get_executor() );
+
          std::vector<std::future<bool>> trx_futures;
+         const auto shards_start = fc::time_point::now();
 
          for (auto& shard_context : shard_contexts) {
             // TODO: how to set shard thread pool size??
-            trx_futures.emplace_back(post_async_task( shard_thread_pool.get_executor(), [&shard_context, &bsp, this]() {
+            trx_futures.emplace_back(post_async_task( shard_thread_pool.get_executor(), [&shard_context, &bsp, &merkle_builder, this]() {
+               const auto execution_start = fc::time_point::now();
                auto& pending_receipts = shard_context.pending_shard._pending_trx_receipts;
                for( auto& shard_trx : shard_context.trx_metas ) {
                   const auto& receipt = *shard_trx.trx_receipt;
                   transaction_trace_ptr trace;
                   auto num_pending_receipts = pending_receipts.size();
                   if( std::holds_alternative<packed_transaction>(receipt.trx) ) {
-                     const auto& trx_meta = ( bool(shard_trx.trx_meta ) ?
-                                                                  shard_trx.trx_meta
-                                                                  : shard_trx.trx_meta_future.get() );
-                     trace = push_transaction( shard_context.pending_shard, trx_meta, fc::time_point::maximum(), fc::microseconds::maximum(), receipt.cpu_usage_us, true, 0 );
+                     if( !shard_trx.trx_meta ) {
+                        const auto wait_start = fc::time_point::now();
+                        shard_trx.trx_meta = shard_trx.trx_meta_future.get();
+                        shard_context.recover_keys_wait += fc::time_point::now() - wait_start;
+                     }
+                     trace = push_transaction( shard_context.pending_shard, shard_trx.trx_meta, fc::time_point::maximum(), fc::microseconds::maximum(), receipt.cpu_usage_us, true, 0 );
                   } else if( std::holds_alternative<transaction_id_type>(receipt.trx) ) {
                      trace = push_scheduled_transaction( shard_context.pending_shard, std::get<transaction_id_type>(receipt.trx), fc::time_point::maximum(), fc::microseconds::maximum(), receipt.cpu_usage_us, true );
                   } else if( std::holds_alternative<shard_transaction_id_type>(receipt.trx) ) {
@@ -2745,15 +3002,27 @@ struct controller_impl {
                               block_validate_exception, "receipt does not match, ${lhs} != ${rhs}",
                               ("lhs", r)("rhs", static_cast<const transaction_receipt_header&>(receipt)) );
                }
+               shard_context.execution = fc::time_point::now() - execution_start;
+               merkle_builder.finished( shard_context.pending_shard );
                return true;
             }));
 
          };
 
 
+         // shard tasks reference shard_contexts and merkle_builder, let all of them stop before rethrowing any failure
+         for( auto& f: trx_futures )
+            f.wait();
          for( auto& f: trx_futures )
             f.get();
 
+         auto& stages = pending->_block_report.stages;
+         stages.shard_critical_path = fc::time_point::now() - shards_start;
+         for( const auto& shard_context : shard_contexts ) {
+            stages.recover_keys_wait += shard_context.recover_keys_wait;
+            stages.shard_execution[shard_context.pending_shard._name] = shard_context.execution;
+         }
+
          finalize_block();
 
          auto& ab = std::get<assembled_block>(pending->_block_stage);
@@ -2773,7 +3042,7 @@ struct controller_impl {
          pending->_block_stage = completed_block{ bsp };
 
          br = pending->_block_report; // copy before commit block destroys pending
-         commit_block(false);
+         commit_block(false, &br.stages);
          br.total_time = fc::time_point::now() - start;
          return;
       } catch ( const std::bad_alloc& ) {
@@ -2885,7 +3154,8 @@ struct controller_impl {
       } FC_LOG_AND_RETHROW( )
    }
 
-   void replay_push_block( const signed_block_ptr& b, controller::block_status s ) {
+   /// @param trx_metas prepared metadata of the packed transactions of b by shard, keys recovered when all checks are forced
+   void replay_push_block( const signed_block_ptr& b, controller::block_status s, transaction_metadata_map&& trx_metas = {} ) {
       self.validate_db_available_size();
 
       EOS_ASSERT(!pending, block_validate_exception, "it is not valid to push a block when there is a pending block");
@@ -2923,6 +3193,8 @@ struct controller_impl {
 
          controller::block_report br;
          if( s == controller::block_status::irreversible ) {
+            if( !trx_metas.empty() )
+               bsp->set_trxs_metas( std::move( trx_metas ), conf.force_all_checks );
             apply_block( br, bsp, s, trx_meta_cache_lookup{} );
             head = bsp;
 
@@ -2966,8 +3238,12 @@ struct controller_impl {
             dm_logger->on_switch_forks(head->id, new_head->id);
          }
 
+         const auto start = fc::time_point::now();
          auto branches = fork_db.fetch_branch_from( new_head->id, head->id );
 
+         // recover the keys of the whole new branch while the old one is popped and the new one applied in order
+         auto branch_trx_metas = start_branch_key_recovery( branches.first, trx_lookup );
+
          if( branches.second.size() > 0 ) {
             for( auto itr = branches.second.begin(); itr != branches.second.end(); ++itr ) {
                pop_block();
@@ -2982,6 +3258,17 @@ struct controller_impl {
             auto except = std::exception_ptr{};
             try {
                br = controller::block_report{};
+               auto& trx_metas = branch_trx_metas[ritr - branches.first.rbegin()];
+               if( trx_metas ) {
+                  transaction_metadata_map recovered;
+                  for( auto& [shard, futures] : *trx_metas ) {
+                     auto& metas = recovered[shard];
+                     for( auto& f : futures )
+                        metas.emplace_back( f.get() );
+                  }
+                  (*ritr)->set_trxs_metas( std::move( recovered ), true );
+                  trx_metas.reset();
+               }
                apply_block( br, *ritr, (*ritr)->is_valid() ? controller::block_status::validated
                                                            : controller::block_status::complete, trx_lookup );
                fork_db.mark_valid( *ritr );
@@ -3022,7 +3309,14 @@ struct controller_impl {
             } // end if exception
          } /// end for each block in branch
 
-         ilog("successfully switched fork to new head ${new_head_id}", ("new_head_id", new_head->id));
+         const auto elapsed = fc::time_point::now() - start;
+         ++fork_switch_stats.switches;
+         fork_switch_stats.blocks_applied += branches.first.size();
+         fork_switch_stats.last_time = elapsed;
+         fork_switch_stats.max_time = std::max( fork_switch_stats.max_time, elapsed );
+         fork_switch_stats.total_time += elapsed;
+         ilog("successfully switched fork to new head ${new_head_id}, ${n} blocks applied in ${t} us",
+              ("new_head_id", new_head->id)("n", branches.first.size())("t", elapsed.count()));
       } else {
          head_changed = false;
       }
@@ -3032,6 +3326,41 @@ struct controller_impl {
 
    } /// push_block
 
+   using branch_trx_metas_futures = std::map<shard_name, std::vector<recover_keys_future>>;
+
+   /// Start recovering the keys of the transactions of every block of branch (in descending block number order) whose
+   /// keys were not recovered yet, reusing the metadata known to trx_lookup. Returns the pending metadata of each block
+   /// in ascending block number order, empty for blocks apply_block() handles by itself.
+   std::vector<std::optional<branch_trx_metas_futures>> start_branch_key_recovery( const branch_type& branch,
+                                                                                   const trx_meta_cache_lookup& trx_lookup ) {
+      std::vector<std::optional<branch_trx_metas_futures>> result( branch.size() );
+      if( self.skip_auth_check() )
+         return result; // apply_block() does not recover keys
+      for( size_t i = 0; i < branch.size(); ++i ) {
+         const auto& bsp = branch[branch.size() - 1 - i];
+         if( bsp->is_pub_keys_recovered() )
+            continue;
+         auto& futures = result[i].emplace();
+         for( const auto& receipt : bsp->block->transactions ) {
+            if( !std::holds_alternative<packed_transaction>( receipt.trx ) )
+               continue;
+            const auto& pt = std::get<packed_transaction>( receipt.trx );
+            auto& shard_futures = futures[receipt.get_shard_name()];
+            transaction_metadata_ptr trx_meta_ptr = trx_lookup ? trx_lookup( receipt.get_shard_name(), pt.id() ) : transaction_metadata_ptr{};
+            if( trx_meta_ptr && *trx_meta_ptr->packed_trx() == pt && !trx_meta_ptr->recovered_keys().empty() ) {
+               std::promise<transaction_metadata_ptr> known;
+               known.set_value( std::move( trx_meta_ptr ) );
+               shard_futures.emplace_back( known.get_future() );
+            } else {
+               packed_transaction_ptr ptrx( bsp->block, &pt ); // alias signed_block_ptr
+               shard_futures.emplace_back( transaction_metadata::start_recover_keys(
+                     std::move( ptrx ), thread_pool.get_executor(), chain_id, microseconds::maximum(), transaction_metadata::trx_type::input ) );
+            }
+         }
+      }
+      return result;
+   }
+
    transaction_metadata_map abort_block() {
       transaction_metadata_map applied_trxs;
       if( pending ) {
@@ -3339,23 +3668,16 @@ struct controller_impl {
    }
 #endif
 
-   // only called from non-main threads (read-only trx execution threads)
-   // when producer_plugin starts them
+   // only called from non-main threads (shard and read-only trx execution threads)
+   // when they are started
    void init_thread_local_data() {
       EOS_ASSERT( !is_on_main_thread(), misc_exception, "init_thread_local_data called on the main thread");
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
       if ( is_eos_vm_oc_enabled() )
          // EOSVMOC needs further initialization of its thread local data
          wasmif.init_thread_local_data();
-      else
 #endif
-      {
-         // TODO: readonly threads, must supply shared_db and sub shard db
-         // auto& db = dbm.shared_db();
-         std::lock_guard g(threaded_wasmifs_mtx);
-         // Non-EOSVMOC needs a wasmif per thread
-         threaded_wasmifs[std::this_thread::get_id()]  = std::make_unique<wasm_interface>( conf.wasm_runtime, conf.eosvmoc_tierup, conf.state_dir, conf.eosvmoc_config, !conf.profile_accounts.empty());
-      }
+      // eos-vm and eos-vm-jit only keep the wasm allocator and timer per thread, both are thread_local
    }
 
    bool is_on_main_thread() { return main_thread_id == std::this_thread::get_id(); };
@@ -3371,24 +3693,11 @@ struct controller_impl {
    }
 
    wasm_interface& get_wasm_interface() {
-      if ( is_on_main_thread()
-#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
-          || is_eos_vm_oc_enabled()
-#endif
-         )
-         return wasmif;
-      else
-         return *threaded_wasmifs[std::this_thread::get_id()];
+      return wasmif;
    }
 
    void code_block_num_last_used(const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version, uint32_t block_num) {
-      // The caller of this function apply_eosio_setcode has already asserted that
-      // the transaction is not a read-only trx, which implies we are
-      // in write window. Safe to call threaded_wasmifs's code_block_num_last_used
       wasmif.code_block_num_last_used(code_hash, vm_type, vm_version, block_num);
-      for (auto& w: threaded_wasmifs) {
-         w.second->code_block_num_last_used(code_hash, vm_type, vm_version, block_num);
-      }
    }
 
    block_state_ptr fork_db_head() const;
@@ -3397,6 +3706,7 @@ struct controller_impl {
 thread_local platform_timer controller_impl::timer;
 #if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
 thread_local eosio::vm::wasm_allocator controller_impl::wasm_alloc;
+thread_local wasm_allocator_pool controller_impl::wasm_alloc_pool;
 #endif
 
 const resource_limits_manager&   controller::get_resource_limits_manager()const
@@ -3650,6 +3960,11 @@ void controller::commit_block() {
    my->commit_block(true);
 }
 
+void controller::commit_block( block_report& br ) {
+   validate_db_available_size();
+   my->commit_block(true, &br.stages);
+}
+
 building_shard& controller::init_building_shard(const shard_name& name, eosio::chain::shard_type shard_type) {
    EOS_ASSERT( my->pending && std::holds_alternative<building_block>(my->pending->_block_stage), transaction_exception, "Can not push transaction when state not in building block mode." );
    return my->init_building_shard(name, shard_type);
@@ -3674,6 +3989,10 @@ boost::asio::io_context& controller::get_thread_pool() {
    return my->thread_pool.get_executor();
 }
 
+const controller::fork_switch_stats& controller::get_fork_switch_stats()const {
+   return my->fork_switch_stats;
+}
+
 std::future<block_state_ptr> controller::create_block_state_future( const block_id_type& id, const signed_block_ptr& b ) {
    return my->create_block_state_future( id, b );
 }
@@ -3882,6 +4201,10 @@ signed_block_ptr controller::fetch_block_by_number( uint32_t block_num )const  {
    return my->blog.read_block_by_num(block_num);
 } FC_CAPTURE_AND_RETHROW( (block_num) ) }
 
+void controller::advise_sequential_block_read( uint32_t start_block_num, uint32_t end_block_num )const {
+   my->blog.advise_sequential_read( start_block_num, end_block_num );
+}
+
 std::optional<signed_block_header> controller::fetch_block_header_by_number( uint32_t block_num )const  { try {
    auto blk_state = fetch_block_state_by_number( block_num );
    if( blk_state ) {
@@ -4155,6 +4478,12 @@ bool controller::is_speculative_block()const {
    return (my->pending->_block_status == block_status::incomplete || my->pending->_block_status == block_status::ephemeral );
 }
 
+bool controller::is_producing_block()const {
+   if( !my->pending ) return false;
+
+   return my->pending->_block_status == block_status::incomplete;
+}
+
 bool controller::is_ram_billing_in_notify_allowed()const {
    return my->conf.disable_all_subjective_mitigations || !is_speculative_block() || my->conf.allow_ram_billing_in_notify;
 }
@@ -4307,6 +4636,10 @@ uint32_t controller::earliest_available_block_num() const{
 vm::wasm_allocator& controller::get_wasm_allocator() {
    return my->wasm_alloc;
 }
+
+vm::wasm_allocator& controller::get_wasm_allocator(uint32_t initial_pages) {
+   return my->wasm_alloc_pool.get(initial_pages);
+}
 #endif
 
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
@@ -4452,6 +4785,10 @@ void controller::code_block_num_last_used(const digest_type& code_hash, uint8_t
    return my->code_block_num_last_used(code_hash, vm_type, vm_version, block_num);
 }
 
+void controller::code_replaced(const digest_type& old_code_hash, uint8_t old_vm_version, const digest_type& new_code_hash, uint8_t new_vm_version) {
+   my->wasmif.code_replaced(old_code_hash, old_vm_version, new_code_hash, new_vm_version);
+}
+
 /// Protocol feature activation handlers:
 // TODO: on_activation on shared_db()??
 template<>
@@ -4566,6 +4903,35 @@ void controller_impl::on_activation<builtin_protocol_feature_t::crypto_primitive
    } );
 }
 
+template<>
+void controller_impl::on_activation<builtin_protocol_feature_t::bulk_table_scan>() {
+   auto& db = dbm.main_db();
+   db.modify( db.get<protocol_state_object>(), [&]( auto& ps ) {
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "db_next_batch_i64" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "db_idx64_next_batch" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "db_idx128_next_batch" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "db_idx256_next_batch" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "db_idx_double_next_batch" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "db_idx_long_double_next_batch" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "shared_db_next_batch_i64" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "shared_db_idx64_next_batch" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "shared_db_idx128_next_batch" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "shared_db_idx256_next_batch" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "shared_db_idx_double_next_batch" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "shared_db_idx_long_double_next_batch" );
+   } );
+}
+
+template<>
+void controller_impl::on_activation<builtin_protocol_feature_t::batched_crypto>() {
+   auto& db = dbm.main_db();
+   db.modify( db.get<protocol_state_object>(), [&]( auto& ps ) {
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "sha256_batch" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "recover_key_batch" );
+      add_intrinsic_to_whitelist( ps.whitelisted_intrinsics, "verify_signature_batch" );
+   } );
+}
+
 /// End of protocol feature activation handlers
 
 } } /// eosio::chain
@@ -145,7 +145,7 @@ void apply_flon_setcode(apply_context& context) {
 
    if( code_size > 0 ) {
      code_hash = fc::sha256::hash( act.code.data(), (uint32_t)act.code.size() );
-     wasm_interface::validate(context, act.code);
+     wasm_interface::validate(context, act.code, code_hash);
    }
 
    const auto& account = shared_db.get<account_object,by_name>(act.account);
@@ -188,6 +188,8 @@ void apply_flon_setcode(apply_context& context) {
             o.vm_version = act.vmversion;
          });
       }
+      if( existing_code )
+         context.control.code_replaced(account.code_hash, account.vm_version, code_hash, act.vmversion);
    }
 
    shared_db.modify( account, [&]( auto& a ) {
@@ -7,9 +7,11 @@
 #include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/global_fun.hpp>
 #include <boost/multi_index/composite_key.hpp>
+#include <fc/io/cfile.hpp>
 #include <fc/io/fstream.hpp>
-#include <fstream>
+#include <boost/crc.hpp>
 #include <shared_mutex>
+#include <unordered_set>
 
 namespace eosio { namespace chain {
    using boost::multi_index_container;
@@ -30,6 +32,32 @@ namespace eosio { namespace chain {
     * Version 1: initial version of the new refactored fork database portable format
     */
 
+   /**
+    * Every change of the fork database is appended to fork_db.journal as it happens, so that the reversible blocks
+    * survive a crash. The journal starts with the magic number and journal_version, followed by records of
+    *   [type:uint8][payload size:uint32][crc32 of payload:uint32][payload]
+    * It is rewritten from the current state once most of its records are obsolete.
+    */
+   enum class journal_record : uint8_t {
+      reset                 = 1, ///< root id, root block_header_state
+      add                   = 2, ///< id, previous, validated, block_state
+      mark_valid            = 3, ///< id
+      advance_root          = 4, ///< id
+      remove                = 5, ///< id
+      rollback_head_to_root = 6  ///< no payload
+   };
+
+   constexpr uint32_t journal_version            = 1;
+   constexpr size_t   journal_record_header_size = sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t);
+   /// the journal is rewritten on advance_root when it has more records than twice the blocks plus this
+   constexpr uint32_t journal_compaction_min_records = 1024;
+
+   inline uint32_t journal_crc( const char* data, size_t size ) {
+      boost::crc_32_type crc;
+      crc.process_bytes( data, size );
+      return crc.checksum();
+   }
+
    struct by_block_id;
    struct by_lib_block_num;
    struct by_prev;
@@ -70,12 +98,23 @@ namespace eosio { namespace chain {
       block_state_ptr       root; // Only uses the block_header_state portion
       block_state_ptr       head;
       fc::path              datadir;
+      fc::cfile             journal;             ///< open for appending once the fork database has a root
+      uint32_t              journal_records = 0; ///< number of records in the journal
 
       void open_impl( const std::function<void( block_timestamp_type,
                                                 const flat_set<digest_type>&,
                                                 const vector<digest_type>& )>& validator );
       void close_impl();
 
+      void replay_journal( const fc::path& journal_path,
+                           const std::function<void( block_timestamp_type,
+                                                     const flat_set<digest_type>&,
+                                                     const vector<digest_type>& )>& validator );
+      void write_journal();
+      void maybe_compact_journal();
+      template <typename... T>
+      void append_journal( journal_record type, const T&... args );
+
 
       block_header_state_ptr  get_block_header_impl( const block_id_type& id )const;
       block_state_ptr         get_block_impl( const block_id_type& id )const;
@@ -89,7 +128,7 @@ namespace eosio { namespace chain {
                                                              const block_id_type& second )const;
       void mark_valid_impl( const block_state_ptr& h );
 
-      void add_impl( const block_state_ptr& n,
+      bool add_impl( const block_state_ptr& n,
                      bool ignore_duplicate, bool validate,
                      const std::function<void( block_timestamp_type,
                                                const flat_set<digest_type>&,
@@ -184,73 +223,261 @@ namespace eosio { namespace chain {
             }
          } FC_CAPTURE_AND_RETHROW( (fork_db_dat) )
 
+         // written at shutdown by a version without the journal, the journal is created from it
+         write_journal();
          fc::remove( fork_db_dat );
+         return;
       }
-   }
 
-   void fork_database::close() {
-      std::lock_guard g( my->mtx );
-      my->close_impl();
+      auto journal_path = datadir / config::forkdb_journal_filename;
+      if( fc::exists( journal_path ) ) {
+         try {
+            replay_journal( journal_path, validator );
+         } FC_CAPTURE_AND_RETHROW( (journal_path) )
+
+         if( root ) {
+            journal.set_file_path( journal_path );
+            journal.open( fc::cfile::create_or_update_rw_mode );
+            maybe_compact_journal();
+         }
+      }
    }
 
-   void fork_database_impl::close_impl() {
-      auto fork_db_dat = datadir / config::forkdb_filename;
+   void fork_database_impl::replay_journal( const fc::path& journal_path,
+                                            const std::function<void( block_timestamp_type,
+                                                                      const flat_set<digest_type>&,
+                                                                      const vector<digest_type>& )>& validator )
+   {
+      string content;
+      fc::read_file_contents( journal_path, content );
+
+      fc::datastream<const char*> ds( content.data(), content.size() );
+
+      uint32_t totem = 0;
+      fc::raw::unpack( ds, totem );
+      EOS_ASSERT( totem == fork_database::magic_number, fork_database_exception,
+                  "Fork database journal '${filename}' has unexpected magic number: ${actual_totem}. Expected ${expected_totem}",
+                  ("filename", journal_path.generic_string())
+                  ("actual_totem", totem)
+                  ("expected_totem", fork_database::magic_number)
+      );
 
-      if( !root ) {
-         if( index.size() > 0 ) {
-            elog( "fork_database is in a bad state when closing; not writing out '${filename}'",
-                  ("filename", fork_db_dat.generic_string()) );
+      uint32_t version = 0;
+      fc::raw::unpack( ds, version );
+      EOS_ASSERT( version == journal_version, fork_database_exception,
+                  "Unsupported version of fork database journal '${filename}'. "
+                  "Journal version is ${version} while code supports version ${supported}",
+                  ("filename", journal_path.generic_string())
+                  ("version", version)
+                  ("supported", journal_version)
+      );
+
+      // First pass: follow the ids of the records to find the root and the blocks still in the fork database,
+      // the block states are only deserialized for those.
+      struct journaled_block {
+         block_id_type prev;
+         size_t        offset = 0; ///< of the block_state in content
+         bool          validated = false;
+      };
+      std::unordered_map<block_id_type, journaled_block, std::hash<block_id_type>> blocks;
+      block_id_type         root_id;
+      std::optional<size_t> root_offset;    ///< of the root block_header_state or block_state in content
+      bool                  root_is_block = false;
+      size_t                valid_end = ds.tellp();
+      uint32_t              num_records = 0;
+
+      while( ds.remaining() >= journal_record_header_size ) {
+         uint8_t  type = 0;
+         uint32_t size = 0, crc = 0;
+         fc::raw::unpack( ds, type );
+         fc::raw::unpack( ds, size );
+         fc::raw::unpack( ds, crc );
+         if( ds.remaining() < size || journal_crc( ds.pos(), size ) != crc )
+            break; // record interrupted by a crash
+
+         const size_t                offset = ds.tellp();
+         fc::datastream<const char*> rec( ds.pos(), size );
+         ds.skip( size );
+
+         block_id_type id;
+         switch( static_cast<journal_record>( type ) ) {
+            case journal_record::reset:
+               fc::raw::unpack( rec, root_id );
+               blocks.clear();
+               root_offset   = offset + rec.tellp();
+               root_is_block = false;
+               break;
+            case journal_record::add: {
+               journaled_block b;
+               fc::raw::unpack( rec, id );
+               fc::raw::unpack( rec, b.prev );
+               fc::raw::unpack( rec, b.validated );
+               b.offset = offset + rec.tellp();
+               blocks.insert_or_assign( id, b );
+               break;
+            }
+            case journal_record::mark_valid: {
+               fc::raw::unpack( rec, id );
+               auto itr = blocks.find( id );
+               if( itr != blocks.end() )
+                  itr->second.validated = true;
+               break;
+            }
+            case journal_record::advance_root: {
+               fc::raw::unpack( rec, id );
+               auto itr = blocks.find( id );
+               EOS_ASSERT( itr != blocks.end(), fork_database_exception,
+                           "journal advances root to block ${id} which is not in the fork database", ("id", id) );
+               root_id       = id;
+               root_offset   = itr->second.offset;
+               root_is_block = true;
+               // blocks not descending from the new root are dropped when the survivors are linked below
+               blocks.erase( itr );
+               break;
+            }
+            case journal_record::remove: {
+               fc::raw::unpack( rec, id );
+               deque<block_id_type> remove_queue{id};
+               for( uint32_t i = 0; i < remove_queue.size(); ++i ) {
+                  blocks.erase( remove_queue[i] );
+                  for( const auto& [bid, b] : blocks ) {
+                     if( b.prev == remove_queue[i] )
+                        remove_queue.emplace_back( bid );
+                  }
+               }
+               break;
+            }
+            case journal_record::rollback_head_to_root:
+               for( auto& [bid, b] : blocks )
+                  b.validated = false;
+               break;
+            default:
+               EOS_THROW( fork_database_exception, "unknown record type ${t} in fork database journal", ("t", type) );
          }
+         valid_end = ds.tellp();
+         ++num_records;
+      }
+
+      if( valid_end != content.size() ) {
+         wlog( "dropping ${n} bytes of an incomplete record at the end of fork database journal '${filename}'",
+               ("n", content.size() - valid_end)("filename", journal_path.generic_string()) );
+         fc::resize_file( journal_path, valid_end );
+      }
+      journal_records = num_records;
+
+      if( !root_offset )
          return;
+
+      // Second pass: deserialize the root and the blocks linking to it, parents before children
+      auto unpack_block_state = [&content]( size_t offset ) {
+         fc::datastream<const char*> bds( content.data() + offset, content.size() - offset );
+         block_state s;
+         fc::raw::unpack( bds, s );
+         return s;
+      };
+
+      if( root_is_block ) {
+         reset_impl( unpack_block_state( *root_offset ) );
+      } else {
+         fc::datastream<const char*> rds( content.data() + *root_offset, content.size() - *root_offset );
+         block_header_state bhs;
+         fc::raw::unpack( rds, bhs );
+         reset_impl( bhs );
       }
 
-      std::ofstream out( fork_db_dat.generic_string().c_str(), std::ios::out | std::ios::binary | std::ofstream::trunc );
-      fc::raw::pack( out, fork_database::magic_number );
-      fc::raw::pack( out, fork_database::max_supported_version ); // write out current version which is always max_supported_version
-      fc::raw::pack( out, *static_cast<block_header_state*>(&*root) );
-      uint32_t num_blocks_in_fork_db = index.size();
-      fc::raw::pack( out, unsigned_int{num_blocks_in_fork_db} );
+      std::vector<std::pair<uint32_t, const block_id_type*>> ordered;
+      ordered.reserve( blocks.size() );
+      for( const auto& [id, b] : blocks )
+         ordered.emplace_back( block_header::num_from_id( id ), &id );
+      std::sort( ordered.begin(), ordered.end(),
+                 []( const auto& lhs, const auto& rhs ) { return lhs.first < rhs.first; } );
+
+      std::unordered_set<block_id_type, std::hash<block_id_type>> linked{ root_id };
+      for( const auto& [num, id] : ordered ) {
+         const auto& b = blocks.at( *id );
+         if( linked.count( b.prev ) == 0 )
+            continue;
+         block_state s = unpack_block_state( b.offset );
+         // do not populate transaction_metadatas, they will be created as needed in apply_block with appropriate key recovery
+         s.header_exts = s.block->validate_and_extract_header_extensions();
+         s.validated   = b.validated;
+         add_impl( std::make_shared<block_state>( std::move( s ) ), false, true, validator );
+         linked.insert( *id );
+      }
+   }
 
-      const auto& indx = index.get<by_lib_block_num>();
+   template <typename... T>
+   void fork_database_impl::append_journal( journal_record type, const T&... args ) {
+      if( !journal.is_open() )
+         return;
 
-      auto unvalidated_itr = indx.rbegin();
-      auto unvalidated_end = boost::make_reverse_iterator( indx.lower_bound( false ) );
+      fc::datastream<size_t> ps;
+      ( fc::raw::pack( ps, args ), ... );
+      const uint32_t size = ps.tellp();
+
+      std::vector<char>     record( journal_record_header_size + size );
+      fc::datastream<char*> ds( record.data(), record.size() );
+      ds.seekp( journal_record_header_size );
+      ( fc::raw::pack( ds, args ), ... );
+      ds.seekp( 0 );
+      fc::raw::pack( ds, static_cast<uint8_t>( type ) );
+      fc::raw::pack( ds, size );
+      fc::raw::pack( ds, journal_crc( record.data() + journal_record_header_size, size ) );
+
+      // flushed to the OS so that the record survives a crash of the process, but not synced to disk
+      journal.write( record.data(), record.size() );
+      journal.flush();
+      ++journal_records;
+   }
 
-      auto validated_itr = unvalidated_end;
-      auto validated_end = indx.rend();
+   /// Replace the journal with one made of the current root and blocks
+   void fork_database_impl::write_journal() {
+      auto journal_path = datadir / config::forkdb_journal_filename;
+      journal.close();
+      journal_records = 0;
+      if( !root ) {
+         fc::remove( journal_path );
+         return;
+      }
 
-      for(  bool unvalidated_remaining = (unvalidated_itr != unvalidated_end),
-                 validated_remaining   = (validated_itr != validated_end);
+      auto temp_path = datadir / ( std::string( config::forkdb_journal_filename ) + ".tmp" );
+      journal.set_file_path( temp_path );
+      journal.open( fc::cfile::truncate_rw_mode );
+      journal.write( reinterpret_cast<const char*>( &fork_database::magic_number ), sizeof( fork_database::magic_number ) );
+      journal.write( reinterpret_cast<const char*>( &journal_version ), sizeof( journal_version ) );
 
-            unvalidated_remaining || validated_remaining;
+      append_journal( journal_record::reset, root->id, *static_cast<block_header_state*>( &*root ) );
 
-            unvalidated_remaining = (unvalidated_itr != unvalidated_end),
-            validated_remaining   = (validated_itr != validated_end)
-         )
-      {
-         auto itr = (validated_remaining ? validated_itr : unvalidated_itr);
+      std::vector<block_state_ptr> blocks( index.begin(), index.end() );
+      std::sort( blocks.begin(), blocks.end(),
+                 []( const auto& lhs, const auto& rhs ) { return lhs->block_num < rhs->block_num; } );
+      for( const auto& b : blocks )
+         append_journal( journal_record::add, b->id, b->header.previous, b->validated, *b );
 
-         if( unvalidated_remaining && validated_remaining ) {
-            if( first_preferred( **validated_itr, **unvalidated_itr ) ) {
-               itr = unvalidated_itr;
-               ++unvalidated_itr;
-            } else {
-               ++validated_itr;
-            }
-         } else if( unvalidated_remaining ) {
-            ++unvalidated_itr;
-         } else {
-            ++validated_itr;
-         }
+      // the previous journal is only replaced once the new one is complete on disk
+      journal.sync();
+      journal.close();
+      fc::rename( temp_path, journal_path );
 
-         fc::raw::pack( out, *(*itr) );
-      }
+      journal.set_file_path( journal_path );
+      journal.open( fc::cfile::create_or_update_rw_mode );
+   }
 
-      if( head ) {
-         fc::raw::pack( out, head->id );
-      } else {
-         elog( "head not set in fork database; '${filename}' will be corrupted",
-               ("filename", fork_db_dat.generic_string()) );
+   void fork_database_impl::maybe_compact_journal() {
+      if( journal_records > 2 * index.size() + journal_compaction_min_records )
+         write_journal();
+   }
+
+   void fork_database::close() {
+      std::lock_guard g( my->mtx );
+      my->close_impl();
+   }
+
+   void fork_database_impl::close_impl() {
+      // the journal already holds every change, there is nothing left to write out
+      if( journal.is_open() ) {
+         journal.flush();
+         journal.close();
       }
 
       index.clear();
@@ -263,6 +490,7 @@ namespace eosio { namespace chain {
    void fork_database::reset( const block_header_state& root_bhs ) {
       std::lock_guard g( my->mtx );
       my->reset_impl(root_bhs);
+      my->write_journal();
    }
 
    void fork_database_impl::reset_impl( const block_header_state& root_bhs ) {
@@ -276,6 +504,7 @@ namespace eosio { namespace chain {
    void fork_database::rollback_head_to_root() {
       std::lock_guard g( my->mtx );
       my->rollback_head_to_root_impl();
+      my->append_journal( journal_record::rollback_head_to_root );
    }
 
    void fork_database_impl::rollback_head_to_root_impl() {
@@ -293,6 +522,8 @@ namespace eosio { namespace chain {
    void fork_database::advance_root( const block_id_type& id ) {
       std::lock_guard g( my->mtx );
       my->advance_root_impl( id );
+      my->append_journal( journal_record::advance_root, id );
+      my->maybe_compact_journal();
    }
 
    void fork_database_impl::advance_root_impl( const block_id_type& id ) {
@@ -345,7 +576,7 @@ namespace eosio { namespace chain {
       return block_header_state_ptr();
    }
 
-   void fork_database_impl::add_impl( const block_state_ptr& n,
+   bool fork_database_impl::add_impl( const block_state_ptr& n,
                                       bool ignore_duplicate, bool validate,
                                       const std::function<void( block_timestamp_type,
                                                                 const flat_set<digest_type>&,
@@ -372,7 +603,7 @@ namespace eosio { namespace chain {
 
       auto inserted = index.insert(n);
       if( !inserted.second ) {
-         if( ignore_duplicate ) return;
+         if( ignore_duplicate ) return false;
          EOS_THROW( fork_database_exception, "duplicate block added", ("id", n->id) );
       }
 
@@ -380,16 +611,19 @@ namespace eosio { namespace chain {
       if( (*candidate)->is_valid() ) {
          head = *candidate;
       }
+      return true;
    }
 
    void fork_database::add( const block_state_ptr& n, bool ignore_duplicate ) {
       std::lock_guard g( my->mtx );
-      my->add_impl( n, ignore_duplicate, false,
-                    []( block_timestamp_type timestamp,
-                        const flat_set<digest_type>& cur_features,
-                        const vector<digest_type>& new_features )
-                    {}
+      bool added = my->add_impl( n, ignore_duplicate, false,
+                                 []( block_timestamp_type timestamp,
+                                     const flat_set<digest_type>& cur_features,
+                                     const vector<digest_type>& new_features )
+                                 {}
       );
+      if( added )
+         my->append_journal( journal_record::add, n->id, n->header.previous, n->validated, *n );
    }
 
    block_state_ptr fork_database::root()const {
@@ -516,7 +750,8 @@ namespace eosio { namespace chain {
    /// remove all of the invalid forks built off of this id including this id
    void fork_database::remove( const block_id_type& id ) {
       std::lock_guard g( my->mtx );
-      return my->remove_impl( id );
+      my->remove_impl( id );
+      my->append_journal( journal_record::remove, id );
    }
 
    void fork_database_impl::remove_impl( const block_id_type& id ) {
@@ -542,7 +777,9 @@ namespace eosio { namespace chain {
 
    void fork_database::mark_valid( const block_state_ptr& h ) {
       std::lock_guard g( my->mtx );
+      if( h->validated ) return;
       my->mark_valid_impl( h );
+      my->append_journal( journal_record::mark_valid, h->id );
    }
 
    void fork_database_impl::mark_valid_impl( const block_state_ptr& h ) {
@@ -36,6 +36,12 @@ namespace eosio { namespace chain {
     * how many blocks at the end of the log are valid. Any earlier blocks in the log are assumed destroyed
     * and unreadable due to reclamation for purposes of saving space.
     *
+    * In a compressed block log (see compress_blocklog) each block is stored compressed except for the leading bytes
+    * of its header that hold the previous block id, the positions and index are the same as in an uncompressed log.
+    *
+    * Blocks are read through a read only memory mapping of the log and index files (including the retained files
+    * of a partitioned log), writes still go through the regular file handles.
+    *
     * Object thread-safe. Not safe to have multiple block_log objects to same data_dir.
     */
 
@@ -57,6 +63,12 @@ namespace eosio { namespace chain {
          std::optional<signed_block_header> read_block_header_by_num(uint32_t block_num)const;
          block_id_type    read_block_id_by_num(uint32_t block_num)const;
 
+         /**
+          * Hint that blocks [start_block_num, end_block_num] are about to be read in order, e.g. by replay or when
+          * serving a sync request, so that the kernel reads them ahead into the page cache.
+          */
+         void advise_sequential_read(uint32_t start_block_num, uint32_t end_block_num)const;
+
          signed_block_ptr read_block_by_id(const block_id_type& id)const {
             return read_block_by_num(block_header::num_from_id(id));
          }
@@ -89,7 +101,12 @@ namespace eosio { namespace chain {
 
          static std::optional<chain_id_type> extract_chain_id( const fc::path& data_dir, const fc::path& retained_dir = fc::path{});
 
-         static void construct_index(const fc::path& block_file_name, const fc::path& index_file_name);
+         /**
+          * @param num_threads when more than 1, the index of a non-pruned log is built by that many threads, each
+          *                    walking its own chunk of the log
+          */
+         static void construct_index(const fc::path& block_file_name, const fc::path& index_file_name,
+                                     uint32_t num_threads = 1);
 
          static bool contains_genesis_state(uint32_t version, uint32_t first_block_num);
 
@@ -99,7 +116,12 @@ namespace eosio { namespace chain {
 
          static bool is_pruned_log(const fc::path& data_dir);
 
-         static void extract_block_range(const fc::path& block_dir, const fc::path&output_dir, block_num_type start, block_num_type end);
+         /**
+          * extract_block_range, split_blocklog and merge_blocklogs copy the block entries verbatim, spread over
+          * num_threads threads, and only regenerate the preambles, block positions and indices of the new files.
+          */
+         static void extract_block_range(const fc::path& block_dir, const fc::path&output_dir, block_num_type start, block_num_type end,
+                                         uint32_t num_threads = 1);
 
          static bool trim_blocklog_front(const fc::path& block_dir, const fc::path& temp_dir, uint32_t truncate_at_block);
          static int  trim_blocklog_end(const fc::path& block_dir, uint32_t n);
@@ -114,8 +136,21 @@ namespace eosio { namespace chain {
           */
          static void smoke_test(const fc::path& block_dir, uint32_t n);
 
-         static void split_blocklog(const fc::path& block_dir, const fc::path& dest_dir, uint32_t stride);
-         static void merge_blocklogs(const fc::path& block_dir, const fc::path& dest_dir);
+         /**
+          * Deserialize every block of blocks.log on num_threads threads, verifying the block numbers, ids, previous
+          * links and positions against blocks.index.
+          */
+         static void full_validate(const fc::path& block_dir, uint32_t num_threads);
+
+         static void split_blocklog(const fc::path& block_dir, const fc::path& dest_dir, uint32_t stride,
+                                    uint32_t num_threads = 1);
+         static void merge_blocklogs(const fc::path& block_dir, const fc::path& dest_dir, uint32_t num_threads = 1);
+
+         /**
+          * Write a copy of blocks.log/blocks.index of block_dir to dest_dir in which every block entry is compressed
+          * individually. Compressed logs are read and appended to transparently, but cannot be pruned.
+          */
+         static void compress_blocklog(const fc::path& block_dir, const fc::path& dest_dir);
    private:
          std::unique_ptr<detail::block_log_impl> my;
    };
@@ -12,6 +12,7 @@ const static auto reversible_blocks_dir_name = "reversible";
 
 const static auto default_state_dir_name     = "state";
 const static auto forkdb_filename            = "fork_db.dat";
+const static auto forkdb_journal_filename    = "fork_db.journal";
 const static auto shard_db_catalog_filename  = "shard_db_catalog.dat";
 const static auto default_state_size            = 1*1024*1024*1024ll;
 const static auto default_state_guard_size      =    128*1024*1024ll;
@@ -82,6 +83,7 @@ const static uint16_t   default_max_auth_depth                       = 6;
 const static uint32_t   default_sig_cpu_bill_pct                     = 50 * percent_1; // billable percentage of signature recovery
 const static uint32_t   default_block_cpu_effort_pct                 = 80 * percent_1; // percentage of block time used for producing block
 const static uint16_t   default_controller_thread_pool_size          = 2;
+const static uint32_t   default_replay_prefetch_blocks               = 64;
 const static uint32_t   default_max_variable_signature_length        = 16384u;
 const static uint32_t   default_max_nonprivileged_inline_action_size = 4 * 1024; // 4 KB
 const static uint32_t   default_max_action_return_value_size         = 256;
@@ -116,6 +118,7 @@ const static uint32_t   setcode_ram_bytes_multiplier       = 10;     ///< multip
 const static uint32_t   shared_contract_bytes_multiplier   = 2;     ///< multiplier on shared contract data size for multiple copies and cached compilation
 
 const static uint32_t   hashing_checktime_block_size       = 10*1024;  /// call checktime from hashing intrinsic once per this number of bytes
+const static uint32_t   table_scan_checktime_rows          = 1024;     /// call checktime from bulk table scan intrinsics once per this number of rows
 
 #ifdef EOSIO_EOS_VM_JIT_RUNTIME_ENABLED
 const static eosio::chain::wasm_interface::vm_type default_wasm_runtime = eosio::chain::wasm_interface::vm_type::eos_vm_jit;
@@ -3,6 +3,7 @@
 #include <eosio/chain/transaction.hpp>
 #include <eosio/chain/contract_table_objects.hpp>
 #include <eosio/chain/deep_mind.hpp>
+#include <eosio/chain/iterator_cache_storage.hpp>
 #include <fc/utility.hpp>
 #include <sstream>
 #include <algorithm>
@@ -30,33 +31,30 @@ class contract_table_context_base {
       template<typename T>
       class iterator_cache {
          public:
-            iterator_cache(){
-               _end_iterator_to_table.reserve(8);
-               _iterator_to_object.reserve(32);
-            }
+            iterator_cache()
+            :_end_iterator_to_table(8)
+            ,_iterator_to_object(32)
+            {}
 
             /// Returns end iterator of the table.
             int cache_table( const table_id_object& tobj ) {
-               auto itr = _table_cache.find(tobj.id);
-               if( itr != _table_cache.end() )
-                  return itr->second.second;
-
-               auto ei = index_to_end_iterator(_end_iterator_to_table.size());
-               _end_iterator_to_table.push_back( &tobj );
-               _table_cache.emplace( tobj.id, make_pair(&tobj, ei) );
-               return ei;
+               auto [entry, inserted] = _table_cache.emplace( table_key(tobj.id),
+                                                              cached_table{ &tobj, index_to_end_iterator(_end_iterator_to_table.size()) } );
+               if( inserted )
+                  _end_iterator_to_table.push_back( &tobj );
+               return entry->end_iterator;
             }
 
             const table_id_object& get_table( table_id_object_id_type i )const {
-               auto itr = _table_cache.find(i);
-               EOS_ASSERT( itr != _table_cache.end(), table_not_in_cache, "an invariant was broken, table should be in cache" );
-               return *itr->second.first;
+               auto entry = _table_cache.find( table_key(i) );
+               EOS_ASSERT( entry, table_not_in_cache, "an invariant was broken, table should be in cache" );
+               return *entry->table;
             }
 
             int get_end_iterator_by_table_id( table_id_object_id_type i )const {
-               auto itr = _table_cache.find(i);
-               EOS_ASSERT( itr != _table_cache.end(), table_not_in_cache, "an invariant was broken, table should be in cache" );
-               return itr->second.second;
+               auto entry = _table_cache.find( table_key(i) );
+               EOS_ASSERT( entry, table_not_in_cache, "an invariant was broken, table should be in cache" );
+               return entry->end_iterator;
             }
 
             const table_id_object* find_table_by_end_iterator( int ei )const {
@@ -83,25 +81,30 @@ class contract_table_context_base {
                auto obj_ptr = _iterator_to_object[iterator];
                if( !obj_ptr ) return;
                _iterator_to_object[iterator] = nullptr;
-               _object_to_iterator.erase( obj_ptr );
+               _object_to_iterator.erase( object_key(obj_ptr) );
             }
 
             int add( const T& obj ) {
-               auto itr = _object_to_iterator.find( &obj );
-               if( itr != _object_to_iterator.end() )
-                    return itr->second;
-
-               _iterator_to_object.push_back( &obj );
-               _object_to_iterator[&obj] = _iterator_to_object.size() - 1;
-
-               return _iterator_to_object.size() - 1;
+               auto [itr, inserted] = _object_to_iterator.emplace( object_key(&obj), _iterator_to_object.size() );
+               if( inserted )
+                  _iterator_to_object.push_back( &obj );
+               return *itr;
             }
 
          private:
-            map<table_id_object_id_type, pair<const table_id_object*, int>> _table_cache;
-            vector<const table_id_object*>                  _end_iterator_to_table;
-            vector<const T*>                                _iterator_to_object;
-            map<const T*,int>                               _object_to_iterator;
+            struct cached_table {
+               const table_id_object* table = nullptr;
+               int                    end_iterator = 0;
+            };
+
+            // flat storage recycled across actions rather than node based maps allocating for every row touched
+            flat_u64_map<cached_table>                 _table_cache;
+            recycled_vector<const table_id_object*>    _end_iterator_to_table;
+            recycled_vector<const T*>                  _iterator_to_object;
+            flat_u64_map<int>                          _object_to_iterator;
+
+            static uint64_t table_key( table_id_object_id_type i ) { return i._id; }
+            static uint64_t object_key( const T* obj ) { return reinterpret_cast<uintptr_t>(obj); }
 
             /// Precondition: std::numeric_limits<int>::min() < ei < -1
             /// Iterator of -1 is reserved for invalid iterators (i.e. when the appropriate table has not yet been created).
@@ -487,6 +490,39 @@ class contract_table_context_base {
                return itr_cache.add(*itr);
             }
 
+            /// Copies the primary and secondary key of the table row at @p iterator and of up to @p max_rows - 1 rows
+            /// following it to @p buffer, preceded by the 32-bit number of rows copied. Only the iterator of the first
+            /// row not copied enters the iterator cache.
+            /// @return iterator to the first row not copied, or the end iterator of the table once all rows are copied
+            int next_secondary_batch( int iterator, uint32_t max_rows, char* buffer, size_t buffer_size ) {
+               EOS_ASSERT( buffer_size >= sizeof(uint32_t), db_api_exception, "buffer too small for the number of rows" );
+               constexpr size_t row_size = sizeof(uint64_t) + sizeof(secondary_key_type);
+
+               uint32_t rows = 0;
+               if( iterator >= -1 ) { // nothing follows an end iterator
+                  const auto& obj = itr_cache.get(iterator); // Check for iterator != -1 happens in this call
+                  const auto& idx = context.db.template get_index<typename chainbase::get_index_type<ObjectType>::type, by_secondary>();
+
+                  auto itr = idx.iterator_to(obj);
+                  char* pos = buffer + sizeof(uint32_t);
+                  const size_t max_fit = (buffer_size - sizeof(uint32_t)) / row_size;
+                  for( ; rows < max_rows && rows < max_fit && itr != idx.end() && itr->t_id == obj.t_id; ++rows, ++itr ) {
+                     memcpy( pos, &itr->primary_key, sizeof(uint64_t) );
+                     memcpy( pos + sizeof(uint64_t), &itr->secondary_key, sizeof(secondary_key_type) );
+                     pos += row_size;
+                     if( (rows + 1) % config::table_scan_checktime_rows == 0 )
+                        context.trx_context.checktime();
+                  }
+
+                  if( itr == idx.end() || itr->t_id != obj.t_id )
+                     iterator = itr_cache.get_end_iterator_by_table_id(obj.t_id);
+                  else if( rows )
+                     iterator = itr_cache.add(*itr);
+               }
+               memcpy( buffer, &rows, sizeof(uint32_t) );
+               return iterator;
+            }
+
             void get( int iterator, uint64_t& primary, secondary_key_proxy_type secondary ) {
                const auto& obj = itr_cache.get( iterator );
                primary   = obj.primary_key;
@@ -695,6 +731,43 @@ class contract_table_context_base {
          return keyval_cache.add( *itr );
       }
 
+      /// Copies the table row at @p iterator and up to @p max_rows - 1 rows following it to @p buffer, preceded by
+      /// the 32-bit number of rows copied. Each row is its 64-bit primary key, the 32-bit size of its value and the
+      /// value. Stops before the first row that does not fit entirely. Only the iterator of the first row not copied
+      /// enters the iterator cache.
+      /// @return iterator to the first row not copied, or the end iterator of the table once all rows are copied
+      int db_next_batch_i64( int iterator, uint32_t max_rows, char* buffer, size_t buffer_size ) {
+         EOS_ASSERT( buffer_size >= sizeof(uint32_t), db_api_exception, "buffer too small for the number of rows" );
+
+         uint32_t rows = 0;
+         if( iterator >= -1 ) { // nothing follows an end iterator
+            const auto& obj = keyval_cache.get( iterator ); // Check for iterator != -1 happens in this call
+            const auto& idx = db.get_index<key_value_index, by_scope_primary>();
+
+            auto itr = idx.iterator_to( obj );
+            size_t pos = sizeof(uint32_t);
+            for( ; rows < max_rows && itr != idx.end() && itr->t_id == obj.t_id; ++rows, ++itr ) {
+               const uint32_t value_size = itr->value.size();
+               if( sizeof(uint64_t) + sizeof(uint32_t) + value_size > buffer_size - pos ) break;
+               memcpy( buffer + pos, &itr->primary_key, sizeof(uint64_t) );
+               pos += sizeof(uint64_t);
+               memcpy( buffer + pos, &value_size, sizeof(uint32_t) );
+               pos += sizeof(uint32_t);
+               memcpy( buffer + pos, itr->value.data(), value_size );
+               pos += value_size;
+               if( (rows + 1) % config::table_scan_checktime_rows == 0 )
+                  trx_context.checktime();
+            }
+
+            if( itr == idx.end() || itr->t_id != obj.t_id )
+               iterator = keyval_cache.get_end_iterator_by_table_id( obj.t_id );
+            else if( rows )
+               iterator = keyval_cache.add( *itr );
+         }
+         memcpy( buffer, &rows, sizeof(uint32_t) );
+         return iterator;
+      }
+
       int db_previous_i64( int iterator, uint64_t& primary ) {
          const auto& idx = db.get_index<key_value_index, by_scope_primary>();
 
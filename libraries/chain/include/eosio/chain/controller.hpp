@@ -86,6 +86,7 @@ namespace eosio { namespace chain {
             uint32_t                 maximum_variable_signature_length = chain::config::default_max_variable_signature_length;
             bool                     disable_all_subjective_mitigations = false; //< for developer & testing purposes, can be configured using `disable-all-subjective-mitigations` when `EOSIO_DEVELOPER` build option is provided
             uint32_t                 terminate_at_block     = 0;
+            uint32_t                 replay_prefetch_blocks = chain::config::default_replay_prefetch_blocks;
             bool                     integrity_hash_on_start= false;
             bool                     integrity_hash_on_stop = false;
 
@@ -163,16 +164,44 @@ namespace eosio { namespace chain {
                                                            fc::time_point block_deadline, fc::microseconds max_transaction_time,
                                                            uint32_t billed_cpu_time_us, bool explicit_billed_cpu_time );
 
+         /// Wall clock time of the stages of applying a block; shard stages are only known for applied blocks
+         /// and commit/signals only when the block_report is passed to commit_block
+         struct block_stage_times {
+            fc::microseconds                        recover_keys_wait{};   ///< shards blocked on key recovery, summed over shards
+            std::map<shard_name, fc::microseconds>  shard_execution;       ///< transaction execution of each shard
+            fc::microseconds                        shard_critical_path{}; ///< from starting the shards until the last one finished
+            fc::microseconds                        xshard{};              ///< cross shard and shard change processing
+            fc::microseconds                        sync_shared_db{};      ///< sync of main db changes to the shared db
+            fc::microseconds                        merkle{};              ///< waiting for and combining the merkle segments
+            fc::microseconds                        process_block_usage{}; ///< resource limits update
+            fc::microseconds                        commit{};              ///< undo session push; fork database and irreversible blocks
+                                                                           ///< only for produced blocks, applied blocks add to the fork
+                                                                           ///< database before and log irreversible blocks after this stage
+            fc::microseconds                        signals{};             ///< accepted_block_header and accepted_block dispatch
+         };
+
          struct block_report {
             size_t             total_net_usage = 0;
             size_t             total_cpu_usage_us = 0;
             fc::microseconds   total_elapsed_time{};
             fc::microseconds   total_time{};
+            block_stage_times  stages;
+         };
+
+         /// Latency of switching forks, from popping the blocks of the old branch to applying the new branch
+         struct fork_switch_stats {
+            uint64_t           switches = 0;
+            uint64_t           blocks_applied = 0; ///< blocks of the new branches
+            fc::microseconds   last_time{};
+            fc::microseconds   max_time{};
+            fc::microseconds   total_time{};
          };
 
          block_state_ptr finalize_block( block_report& br, const signer_callback_type& signer_callback );
          void sign_block( const signer_callback_type& signer_callback );
          void commit_block();
+         /// also fills the commit and signals stages of @p br
+         void commit_block( block_report& br );
 
          // thread-safe
          std::future<block_state_ptr> create_block_state_future( const block_id_type& id, const signed_block_ptr& b );
@@ -192,6 +221,9 @@ namespace eosio { namespace chain {
 
          boost::asio::io_context& get_thread_pool();
 
+         /// not thread safe, updated by push_block
+         const fork_switch_stats& get_fork_switch_stats()const;
+
          const chainbase::database& db()const;
          const database_manager& dbm()const;
 
@@ -252,6 +284,8 @@ namespace eosio { namespace chain {
          std::optional<signed_block_header> fetch_block_header_by_number( uint32_t block_num )const;
          // thread-safe
          std::optional<signed_block_header> fetch_block_header_by_id( const block_id_type& id )const;
+         // hint that irreversible blocks [start_block_num, end_block_num] are about to be fetched in order, thread-safe
+         void advise_sequential_block_read( uint32_t start_block_num, uint32_t end_block_num )const;
          // return block_state from forkdb, thread-safe
          block_state_ptr fetch_block_state_by_number( uint32_t block_num )const;
          // return block_state from forkdb, thread-safe
@@ -272,6 +306,7 @@ namespace eosio { namespace chain {
 
          bool is_building_block()const;
          bool is_speculative_block()const;
+         bool is_producing_block()const;
 
          bool is_ram_billing_in_notify_allowed()const;
 
@@ -329,6 +364,8 @@ namespace eosio { namespace chain {
 
 #if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
          vm::wasm_allocator&  get_wasm_allocator();
+         // linear memory of this thread last used by modules with the same initial page count
+         vm::wasm_allocator&  get_wasm_allocator(uint32_t initial_pages);
          bool is_eos_vm_oc_enabled() const;
 #endif
 
@@ -390,6 +427,7 @@ namespace eosio { namespace chain {
       void set_to_read_window();
       bool is_write_window() const;
       void code_block_num_last_used(const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version, uint32_t block_num);
+      void code_replaced(const digest_type& old_code_hash, uint8_t old_vm_version, const digest_type& new_code_hash, uint8_t new_vm_version);
 
       private:
          friend class apply_context;
@@ -403,3 +441,9 @@ namespace eosio { namespace chain {
    };
 
 } }  /// eosio::chain
+
+FC_REFLECT( eosio::chain::controller::block_stage_times,
+            (recover_keys_wait)(shard_execution)(shard_critical_path)(xshard)(sync_shared_db)(merkle)
+            (process_block_usage)(commit)(signals) )
+FC_REFLECT( eosio::chain::controller::block_report,
+            (total_net_usage)(total_cpu_usage_us)(total_elapsed_time)(total_time)(stages) )
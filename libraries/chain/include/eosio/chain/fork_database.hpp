@@ -17,6 +17,9 @@ namespace eosio { namespace chain {
     * blocks older than the last irreversible block are freed after emitting the
     * irreversible signal.
     *
+    * Every change is appended to a journal in the data directory as it is made, so the
+    * reversible blocks are recovered by open() after a crash as well as after a clean close().
+    *
     * An internal mutex is used to provide thread-safety.
     */
    class fork_database {
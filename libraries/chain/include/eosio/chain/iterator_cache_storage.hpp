@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace eosio { namespace chain {
+
+/// Per thread pool of vectors whose capacity is reused by the next owner.
+///
+/// Iterator caches live as long as the apply_context of one action. Handing their storage back to the pool when the
+/// action ends and taking it again for the next action keeps table access free of heap allocations once a thread has
+/// executed a few actions. Vectors grown unusually large are released instead of pooled.
+template<typename T>
+class recycled_vector_pool {
+ public:
+   static constexpr size_t max_pooled         = 64;
+   static constexpr size_t max_pooled_capacity = 4096;
+
+   static std::vector<T> take() {
+      auto& p = pool();
+      if( p.empty() )
+         return {};
+      std::vector<T> v = std::move( p.back() );
+      p.pop_back();
+      return v;
+   }
+
+   /// @pre the elements of @p v are in the state the next owner expects, usually @p v is empty
+   static void give( std::vector<T>&& v ) {
+      auto& p = pool();
+      if( v.capacity() == 0 || v.capacity() > max_pooled_capacity || p.size() >= max_pooled )
+         return;
+      p.push_back( std::move( v ) );
+   }
+
+ private:
+   static std::vector<std::vector<T>>& pool() {
+      thread_local std::vector<std::vector<T>> p;
+      return p;
+   }
+};
+
+/// Vector whose storage comes from and returns to recycled_vector_pool
+template<typename T>
+class recycled_vector {
+ public:
+   explicit recycled_vector( size_t reserve ) : _v( recycled_vector_pool<T>::take() ) {
+      _v.reserve( reserve );
+   }
+   ~recycled_vector() {
+      _v.clear();
+      recycled_vector_pool<T>::give( std::move( _v ) );
+   }
+   recycled_vector( const recycled_vector& ) = delete;
+   recycled_vector& operator=( const recycled_vector& ) = delete;
+
+   size_t   size()const                 { return _v.size(); }
+   void     push_back( const T& t )     { _v.push_back( t ); }
+   T&       operator[]( size_t i )      { return _v[i]; }
+   const T& operator[]( size_t i )const { return _v[i]; }
+
+ private:
+   std::vector<T> _v;
+};
+
+/// Open addressing hash map from a 64-bit key to a small trivially copyable value.
+///
+/// Linear probing over a power of two number of slots, with backward shift deletion so erased entries leave no
+/// tombstones behind. The slot array is recycled through recycled_vector_pool. The maximum 64-bit value is reserved
+/// as the empty key; table ids and object addresses never take it.
+template<typename Value>
+class flat_u64_map {
+ public:
+   static constexpr uint64_t empty_key        = std::numeric_limits<uint64_t>::max();
+   static constexpr size_t   initial_capacity = 32;
+
+   struct slot {
+      uint64_t key = empty_key;
+      Value    value{};
+   };
+
+   flat_u64_map() : _slots( recycled_vector_pool<slot>::take() ) {
+      if( _slots.empty() )
+         _slots.resize( initial_capacity );
+      _mask = _slots.size() - 1;
+   }
+
+   ~flat_u64_map() {
+      if( _size ) {
+         for( slot& s : _slots )
+            s = slot{};
+      }
+      recycled_vector_pool<slot>::give( std::move( _slots ) );
+   }
+
+   flat_u64_map( const flat_u64_map& ) = delete;
+   flat_u64_map& operator=( const flat_u64_map& ) = delete;
+
+   size_t size()const { return _size; }
+
+   const Value* find( uint64_t key )const {
+      for( size_t i = bucket( key );; i = (i + 1) & _mask ) {
+         const slot& s = _slots[i];
+         if( s.key == key )
+            return &s.value;
+         if( s.key == empty_key )
+            return nullptr;
+      }
+   }
+
+   /// @return the value stored for @p key and whether it was inserted; an existing value is left unchanged
+   std::pair<Value*, bool> emplace( uint64_t key, const Value& value ) {
+      if( (_size + 1) * 4 > _slots.size() * 3 )
+         grow();
+      for( size_t i = bucket( key );; i = (i + 1) & _mask ) {
+         slot& s = _slots[i];
+         if( s.key == key )
+            return { &s.value, false };
+         if( s.key == empty_key ) {
+            s.key   = key;
+            s.value = value;
+            ++_size;
+            return { &s.value, true };
+         }
+      }
+   }
+
+   void erase( uint64_t key ) {
+      size_t i = bucket( key );
+      for( ;; i = (i + 1) & _mask ) {
+         if( _slots[i].key == key )
+            break;
+         if( _slots[i].key == empty_key )
+            return;
+      }
+      // shift following entries of the probe sequence back into the hole
+      for( size_t j = (i + 1) & _mask;; j = (j + 1) & _mask ) {
+         if( _slots[j].key == empty_key )
+            break;
+         const size_t home = bucket( _slots[j].key );
+         // move j into the hole at i unless its home lies cyclically within (i, j]
+         const bool home_in_range = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+         if( !home_in_range ) {
+            _slots[i] = _slots[j];
+            i = j;
+         }
+      }
+      _slots[i] = slot{};
+      --_size;
+   }
+
+ private:
+   size_t bucket( uint64_t key )const {
+      // fibonacci hashing, object addresses differ mostly in their middle bits
+      return ((key * 0x9E3779B97F4A7C15ull) >> 32) & _mask;
+   }
+
+   void grow() {
+      std::vector<slot> old( _slots.size() * 2 );
+      old.swap( _slots );
+      _mask = _slots.size() - 1;
+      for( const slot& s : old ) {
+         if( s.key == empty_key )
+            continue;
+         size_t i = bucket( s.key );
+         while( _slots[i].key != empty_key )
+            i = (i + 1) & _mask;
+         _slots[i] = s;
+      }
+   }
+
+   std::vector<slot> _slots;
+   size_t            _mask = 0;
+   size_t            _size = 0;
+};
+
+} } // namespace eosio::chain
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <fc/io/datastream.hpp>
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+
+namespace eosio {
+namespace chain {
+
+/// Read only memory mapping of a log file.
+///
+/// The file may keep growing through appends made with a separate cfile; map_to() extends the mapping on demand
+/// so that data written and flushed by the appender becomes readable without any read syscall. The address range
+/// reserved grows geometrically past the end of the file, appends within it only need a file size check, so a log
+/// growing by small appends is remapped a logarithmic number of times. Shrinking or replacing the file while it is
+/// mapped is not allowed, call close() before truncating it.
+/// Not thread safe, the owner is expected to serialize access with the appender.
+class log_mapped_file {
+   boost::filesystem::path            path_;
+   boost::interprocess::mapped_region region_;
+   uint64_t                           size_ = 0;     // bytes of the file known to be readable
+   uint64_t                           capacity_ = 0; // bytes of address space mapped, may extend past the file
+
+ public:
+   /// upper bound of bytes asked to be read ahead by a single advise_sequential() call
+   static constexpr uint64_t max_willneed_bytes = 64 * 1024 * 1024;
+   /// smallest address range reserved by a mapping
+   static constexpr uint64_t min_capacity = 64 * 1024 * 1024;
+
+   log_mapped_file() = default;
+   log_mapped_file(const log_mapped_file&) = delete;
+   log_mapped_file& operator=(const log_mapped_file&) = delete;
+
+   void set_file_path(const boost::filesystem::path& path) {
+      close();
+      path_ = path;
+   }
+
+   const boost::filesystem::path& get_file_path() const { return path_; }
+
+   void close() {
+      boost::interprocess::mapped_region().swap(region_);
+      size_     = 0;
+      capacity_ = 0;
+   }
+
+   uint64_t    size() const { return size_; }
+   const char* data() const { return static_cast<const char*>(region_.get_address()); }
+
+   /// Make sure at least the first @p end bytes of the file are mapped.
+   /// @return false if the file is smaller than @p end or cannot be mapped, the previous mapping is kept in that case
+   bool map_to(uint64_t end) {
+      if (end <= size_)
+         return true;
+      if (path_.empty())
+         return false;
+      try {
+         const uint64_t file_size = boost::filesystem::file_size(path_);
+         if (file_size < end || file_size == 0)
+            return false;
+         if (file_size > capacity_) {
+            // pages of a shared mapping past the end of the file become readable as the file grows into them
+            const uint64_t capacity = std::max({file_size, capacity_ * 2, min_capacity});
+            boost::interprocess::file_mapping  mapping(path_.string().c_str(), boost::interprocess::read_only);
+            boost::interprocess::mapped_region region(mapping, boost::interprocess::read_only, 0, capacity);
+            region_.swap(region);
+            capacity_ = capacity;
+         }
+         size_ = file_size;
+         return true;
+      } catch (...) {
+         return false;
+      }
+   }
+
+   /// @pre map_to(pos) returned true
+   fc::datastream<const char*> stream_at(uint64_t pos) const { return { data() + pos, size_ - pos }; }
+
+   /// @pre map_to(pos + sizeof(T)) returned true
+   template <typename T>
+   T read_at(uint64_t pos) const {
+      T value;
+      std::memcpy(&value, data() + pos, sizeof(value));
+      return value;
+   }
+
+   /// Hint that [pos, pos + len) is about to be read in order: the kernel reads the range ahead aggressively and may
+   /// drop pages once they have been read. At most max_willneed_bytes are requested to be paged in right away.
+   void advise_sequential(uint64_t pos, uint64_t len) const {
+      advise(pos, len, MADV_SEQUENTIAL);
+      advise(pos, std::min(len, max_willneed_bytes), MADV_WILLNEED);
+   }
+
+   /// Restore the default readahead behavior of the whole mapping
+   void advise_normal() const { advise(0, size_, MADV_NORMAL); }
+
+ private:
+   void advise(uint64_t pos, uint64_t len, int advice) const {
+      if (pos >= size_)
+         return;
+      len = std::min(len, size_ - pos);
+      if (len == 0)
+         return;
+      // madvise requires a page aligned address, the mapping itself always starts at a page boundary
+      const uint64_t page_size = boost::interprocess::mapped_region::get_page_size();
+      const uint64_t begin     = pos & ~(page_size - 1);
+      ::madvise(const_cast<char*>(data()) + begin, pos + len - begin, advice);
+   }
+};
+
+} // namespace chain
+} // namespace eosio
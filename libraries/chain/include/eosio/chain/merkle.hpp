@@ -19,4 +19,21 @@ namespace eosio { namespace chain {
     */
    digest_type merkle( deque<digest_type> ids );
 
+   /**
+    *  The part of the merkle tree of a list of digests that only depends on the leaves [offset, offset + leaves) of
+    *  that list. Segments of consecutive ranges, e.g. the digests of each shard of a block, can be built
+    *  independently and combined by merkle( segments ) into the root merkle() computes over the whole list.
+    */
+   struct merkle_segment {
+      uint64_t                     offset = 0;
+      vector<vector<digest_type>>  levels; ///< levels[0] the leaves, levels[k] the nodes of height k whose leaves all lie in the segment
+   };
+
+   merkle_segment make_merkle_segment( deque<digest_type> ids, uint64_t offset );
+
+   /**
+    *  Calculates the merkle root of the concatenation of @p segments, which must be ordered and contiguous from offset 0
+    */
+   digest_type merkle( vector<merkle_segment> segments );
+
 } } /// eosio::chain
@@ -35,6 +35,8 @@ enum class builtin_protocol_feature_t : uint32_t {
    configurable_wasm_limits = 18, // configurable_wasm_limits2,
    crypto_primitives = 19,
    get_block_num = 20,
+   bulk_table_scan = 21,
+   batched_crypto = 22,
    reserved_private_fork_protocol_features = 500000,
 };
 
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index/member.hpp>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+namespace eosio { namespace chain {
+
+/// Public keys recovered from transaction signatures, keyed by signing digest and signature.
+///
+/// A transaction's signatures are recovered when it arrives through the net or http API, and again when the block
+/// containing it is applied without its transaction_metadata at hand: after an aborted block, a fork switch, or on a
+/// node that received the transaction by another path. Every recovery goes through this cache so the same signature
+/// is recovered once while it is cached. Entries are split over independently locked shards, each dropping its least
+/// recently used entry when full. Recovery failures are not cached. Thread safe, one instance is shared by the process.
+class signature_recovery_cache {
+ public:
+   static constexpr size_t default_max_entries = 100'000;
+
+   struct stats {
+      uint64_t hits = 0;
+      uint64_t misses = 0;
+      size_t   size = 0;
+   };
+
+   static signature_recovery_cache& instance();
+
+   explicit signature_recovery_cache( size_t max_entries = default_max_entries );
+
+   /// 0 disables the cache, every signature is then recovered
+   void set_max_entries( size_t max_entries );
+
+   /// the public key of @p sig over @p digest
+   public_key_type recover( const signature_type& sig, const digest_type& digest );
+
+   stats get_stats() const;
+
+ private:
+   static constexpr size_t num_shards = 16;
+
+   struct entry {
+      digest_type     key; // hash of the signing digest and signature
+      public_key_type pub;
+   };
+   struct by_key;
+   using entry_index = boost::multi_index_container<
+      entry,
+      boost::multi_index::indexed_by<
+         boost::multi_index::sequenced<>,
+         boost::multi_index::hashed_unique<boost::multi_index::tag<by_key>,
+                                           boost::multi_index::member<entry, digest_type, &entry::key>,
+                                           std::hash<digest_type>>
+      >
+   >;
+   struct shard {
+      mutable std::mutex mtx;
+      entry_index        entries;
+   };
+
+   std::array<shard, num_shards> _shards;
+   std::atomic<size_t>           _max_entries_per_shard;
+   std::atomic<uint64_t>         _hits{0};
+   std::atomic<uint64_t>         _misses{0};
+};
+
+} } // eosio::chain
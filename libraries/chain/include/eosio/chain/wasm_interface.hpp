@@ -3,6 +3,8 @@
 #include <eosio/chain/types.hpp>
 #include <eosio/chain/whitelisted_intrinsics.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/wasm_validation_cache.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/compile_stats.hpp>
 #include <functional>
 #include "Runtime/Linker.h"
 #include "Runtime/Runtime.h"
@@ -52,15 +54,25 @@ namespace eosio { namespace chain {
          void indicate_shutting_down();
 
          //validates code -- does a WASM validation pass and checks the wasm against EOSIO specific constraints
-         static void validate(apply_context& context, const bytes& code);
+         //code that passed under the same constraints before is not validated again
+         static void validate(apply_context& context, const bytes& code, const digest_type& code_hash);
+
+         //validations that passed, shared by every controller of the process
+         static wasm_validation_cache& validation_cache();
 
          //indicate that a particular code probably won't be used after given block_num
          void code_block_num_last_used(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, const uint32_t& block_num);
 
+         //indicate that an account's code was replaced by setcode, used to compile the new code of hot accounts ahead of use
+         void code_replaced(const digest_type& old_code_hash, const uint8_t& old_vm_version, const digest_type& new_code_hash, const uint8_t& new_vm_version);
+
+         //EOS VM OC compiles by priority, all zero when OC tier-up is not enabled. Not thread safe, call from the main thread
+         eosvmoc::compile_stats oc_compile_stats() const;
+
          //indicate the current LIB. evicts old cache entries
          void current_lib(const uint32_t lib);
 
-         //Calls apply or error on a given code
+         //Calls apply or error on a given code. Thread safe, instantiated modules are shared by all executing threads
          void apply(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, apply_context& context);
 
          //Returns true if the code is cached
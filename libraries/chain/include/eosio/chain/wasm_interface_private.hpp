@@ -14,6 +14,9 @@
 #include <eosio/chain/exceptions.hpp>
 #include <fc/scoped_exit.hpp>
 
+#include <mutex>
+#include <vector>
+
 #include "IR/Module.h"
 #include "Runtime/Intrinsics.h"
 #include "Platform/Platform.h"
@@ -36,11 +39,13 @@ namespace eosio { namespace chain {
 
    struct wasm_interface_impl {
       struct wasm_cache_entry {
-         digest_type                                          code_hash;
-         uint32_t                                             last_block_num_used;
-         std::unique_ptr<wasm_instantiated_module_interface>  module;
-         uint8_t                                              vm_type = 0;
-         uint8_t                                              vm_version = 0;
+         digest_type                                                       code_hash;
+         uint32_t                                                          last_block_num_used;
+         // instantiated modules not executing on any thread; an instantiated module carries its own execution
+         // context, so as many are instantiated as there are threads executing the code at the same time
+         std::vector<std::unique_ptr<wasm_instantiated_module_interface>>  idle_modules;
+         uint8_t                                                           vm_type = 0;
+         uint8_t                                                           vm_version = 0;
       };
       struct by_hash;
       struct by_first_block_num;
@@ -99,16 +104,41 @@ namespace eosio { namespace chain {
          if(is_shutting_down)
             for(wasm_cache_index::iterator it = wasm_instantiation_cache.begin(); it != wasm_instantiation_cache.end(); ++it)
                wasm_instantiation_cache.modify(it, [](wasm_cache_entry& e) {
-                  e.module.release()->fast_shutdown();
+                  for(auto& m : e.idle_modules)
+                     m.release()->fast_shutdown();
                });
       }
 
+      /// Exclusive use of an instantiated module by the executing thread, hands the module back to the cache on destruction
+      class module_lease {
+         public:
+            module_lease(wasm_interface_impl& impl, const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version,
+                         std::unique_ptr<wasm_instantiated_module_interface> module)
+               : impl(impl), code_hash(code_hash), vm_type(vm_type), vm_version(vm_version), module(std::move(module)) {}
+            module_lease(const module_lease&) = delete;
+            module_lease& operator=(const module_lease&) = delete;
+            ~module_lease() {
+               impl.release_module(code_hash, vm_type, vm_version, std::move(module));
+            }
+
+            wasm_instantiated_module_interface* operator->() const { return module.get(); }
+
+         private:
+            wasm_interface_impl&                                 impl;
+            const digest_type                                    code_hash;
+            const uint8_t                                        vm_type;
+            const uint8_t                                        vm_version;
+            std::unique_ptr<wasm_instantiated_module_interface>  module;
+      };
+
       bool is_code_cached(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version) const {
+         std::lock_guard g(cache_mtx);
          wasm_cache_index::iterator it = wasm_instantiation_cache.find( boost::make_tuple(code_hash, vm_type, vm_version) );
          return it != wasm_instantiation_cache.end();
       }
 
       void code_block_num_last_used(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, const uint32_t& block_num) {
+         std::lock_guard g(cache_mtx);
          wasm_cache_index::iterator it = wasm_instantiation_cache.find(boost::make_tuple(code_hash, vm_type, vm_version));
          if(it != wasm_instantiation_cache.end())
             wasm_instantiation_cache.modify(it, [block_num](wasm_cache_entry& e) {
@@ -117,6 +147,7 @@ namespace eosio { namespace chain {
       }
 
       void current_lib(uint32_t lib) {
+         std::lock_guard g(cache_mtx);
          //anything last used before or on the LIB can be evicted
          const auto first_it = wasm_instantiation_cache.get<by_last_block_num>().begin();
          const auto last_it  = wasm_instantiation_cache.get<by_last_block_num>().upper_bound(lib);
@@ -127,37 +158,65 @@ namespace eosio { namespace chain {
          wasm_instantiation_cache.get<by_last_block_num>().erase(first_it, last_it);
       }
 
-      const std::unique_ptr<wasm_instantiated_module_interface>& get_instantiated_module( const digest_type& code_hash, const uint8_t& vm_type,
-                                                                                 const uint8_t& vm_version, transaction_context& trx_context )
+      // Shared by all threads. An idle instantiated module is handed out when there is one, otherwise the code is
+      // instantiated again for this thread. eos-vm times out by revoking execute access to the code of the running
+      // module, so the compiled code of a module must never run on two threads at once.
+      module_lease acquire_instantiated_module( const digest_type& code_hash, const uint8_t& vm_type,
+                                                const uint8_t& vm_version, transaction_context& trx_context )
       {
-         wasm_cache_index::iterator it = wasm_instantiation_cache.find(
-                                             boost::make_tuple(code_hash, vm_type, vm_version) );
-         const code_object* codeobject = nullptr;
+         if(auto module = take_idle_module(code_hash, vm_type, vm_version))
+            return { *this, code_hash, vm_type, vm_version, std::move(module) };
+
+         // instantiate outside of the lock, other threads keep executing cached modules meanwhile
+         const code_object& codeobject = trx_context.shared_db.get<code_object,by_code_hash>(boost::make_tuple(code_hash, vm_type, vm_version));
+
+         auto timer_pause = fc::make_scoped_exit([&](){
+            trx_context.resume_billing_timer();
+         });
+         trx_context.pause_billing_timer();
+         return { *this, code_hash, vm_type, vm_version,
+                  runtime_interface->instantiate_module(codeobject.code.data(), codeobject.code.size(), code_hash, vm_type, vm_version) };
+      }
+
+      // An idle instantiated module of the code, nullptr when there is none and the caller has to instantiate one.
+      // The cache entry of the code is created on its first use.
+      std::unique_ptr<wasm_instantiated_module_interface> take_idle_module( const digest_type& code_hash, uint8_t vm_type,
+                                                                            uint8_t vm_version )
+      {
+         std::lock_guard g(cache_mtx);
+         wasm_cache_index::iterator it = wasm_instantiation_cache.find(boost::make_tuple(code_hash, vm_type, vm_version));
          if(it == wasm_instantiation_cache.end()) {
-            codeobject = &trx_context.shared_db.get<code_object,by_code_hash>(boost::make_tuple(code_hash, vm_type, vm_version));
-
-            it = wasm_instantiation_cache.emplace( wasm_interface_impl::wasm_cache_entry{
-                                                      .code_hash = code_hash,
-                                                      .last_block_num_used = UINT32_MAX,
-                                                      .module = nullptr,
-                                                      .vm_type = vm_type,
-                                                      .vm_version = vm_version
-                                                   } ).first;
+            wasm_instantiation_cache.emplace( wasm_interface_impl::wasm_cache_entry{
+                                                 .code_hash = code_hash,
+                                                 .last_block_num_used = UINT32_MAX,
+                                                 .idle_modules = {},
+                                                 .vm_type = vm_type,
+                                                 .vm_version = vm_version
+                                              } );
+            return {};
          }
-
-         if(!it->module) {
-            if(!codeobject)
-               codeobject = &trx_context.shared_db.get<code_object,by_code_hash>(boost::make_tuple(code_hash, vm_type, vm_version));
-
-            auto timer_pause = fc::make_scoped_exit([&](){
-               trx_context.resume_billing_timer();
-            });
-            trx_context.pause_billing_timer();
-            wasm_instantiation_cache.modify(it, [&](auto& c) {
-               c.module = runtime_interface->instantiate_module(codeobject->code.data(), codeobject->code.size(), code_hash, vm_type, vm_version);
+         std::unique_ptr<wasm_instantiated_module_interface> module;
+         if(!it->idle_modules.empty()) {
+            wasm_instantiation_cache.modify(it, [&](wasm_cache_entry& e) {
+               module = std::move(e.idle_modules.back());
+               e.idle_modules.pop_back();
             });
          }
-         return it->module;
+         return module;
+      }
+
+      void release_module( const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version,
+                           std::unique_ptr<wasm_instantiated_module_interface> module )
+      {
+         if(!module)
+            return;
+         std::lock_guard g(cache_mtx);
+         wasm_cache_index::iterator it = wasm_instantiation_cache.find(boost::make_tuple(code_hash, vm_type, vm_version));
+         if(it == wasm_instantiation_cache.end())
+            return; // evicted while executing
+         wasm_instantiation_cache.modify(it, [&](wasm_cache_entry& e) {
+            e.idle_modules.emplace_back(std::move(module));
+         });
       }
 
       bool is_shutting_down = false;
@@ -176,6 +235,7 @@ namespace eosio { namespace chain {
             ordered_non_unique<tag<by_last_block_num>, member<wasm_cache_entry, uint32_t, &wasm_cache_entry::last_block_num_used>>
          >
       > wasm_cache_index;
+      mutable std::mutex cache_mtx; // guards wasm_instantiation_cache
       wasm_cache_index wasm_instantiation_cache;
 
       const wasm_interface::vm_type wasm_runtime_time;
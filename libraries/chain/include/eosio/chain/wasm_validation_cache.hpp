@@ -0,0 +1,76 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index/identity.hpp>
+
+#include <atomic>
+#include <mutex>
+
+namespace eosio { namespace chain {
+
+/// Bounded set of wasm validations known to have passed.
+///
+/// Validating a module on setcode parses it and checks it against the chain's constraints, which for the same code,
+/// the same constraints and the same whitelisted intrinsics always gives the same answer. Identical code deployed to
+/// many accounts, or set again after a fork switch, is then validated once. Keys digest everything the outcome
+/// depends on; only successful validations are remembered so failures keep reporting their original error. The least
+/// recently used key is dropped once max_entries are held. Thread safe, one instance is shared by the process.
+class wasm_validation_cache {
+ public:
+   static constexpr size_t default_max_entries = 1024;
+
+   explicit wasm_validation_cache( size_t max_entries = default_max_entries ) : _max_entries( max_entries ) {}
+
+   /// @return true and marks @p key as most recently used if a validation with @p key passed before
+   bool contains( const digest_type& key ) {
+      std::lock_guard g( _mtx );
+      auto& by_key = _validated.get<by_hash>();
+      auto itr = by_key.find( key );
+      if( itr == by_key.end() ) {
+         ++_misses;
+         return false;
+      }
+      _validated.relocate( _validated.begin(), _validated.project<0>( itr ) );
+      ++_hits;
+      return true;
+   }
+
+   void insert( const digest_type& key ) {
+      std::lock_guard g( _mtx );
+      if( !_validated.push_front( key ).second )
+         return;
+      while( _validated.size() > _max_entries )
+         _validated.pop_back();
+   }
+
+   size_t size() const {
+      std::lock_guard g( _mtx );
+      return _validated.size();
+   }
+
+   uint64_t hits() const   { return _hits; }
+   uint64_t misses() const { return _misses; }
+
+ private:
+   struct by_hash;
+   using validated_index = boost::multi_index_container<
+      digest_type,
+      boost::multi_index::indexed_by<
+         boost::multi_index::sequenced<>,
+         boost::multi_index::hashed_unique<boost::multi_index::tag<by_hash>,
+                                           boost::multi_index::identity<digest_type>, std::hash<digest_type>>
+      >
+   >;
+
+   mutable std::mutex    _mtx;
+   validated_index       _validated;
+   const size_t          _max_entries;
+   std::atomic<uint64_t> _hits{0};
+   std::atomic<uint64_t> _misses{0};
+};
+
+} } // eosio::chain
@@ -4,11 +4,16 @@
 
 #include <eosio/chain/webassembly/eos-vm-oc/eos-vm-oc.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/ipc_helpers.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/compile_queue.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/compile_stats.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/hot_codes.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index/composite_key.hpp>
 #include <boost/multi_index/key_extractors.hpp>
+#include <boost/multi_index/identity.hpp>
 
 #include <boost/interprocess/mem_algo/rbtree_best_fit.hpp>
 #include <boost/asio/local/datagram_protocol.hpp>
@@ -17,15 +22,9 @@
 #include <thread>
 #include <shared_mutex>
 
-namespace std {
-    template<> struct hash<eosio::chain::eosvmoc::code_tuple> {
-        size_t operator()(const eosio::chain::eosvmoc::code_tuple& ct) const noexcept {
-            return ct.code_id._hash[0];
-        }
-    };
-}
-
-namespace eosio { namespace chain { namespace eosvmoc {
+namespace eosio { namespace chain {
+class code_object;
+namespace eosvmoc {
 
 using namespace boost::multi_index;
 using namespace boost::asio;
@@ -80,8 +79,14 @@ class code_cache_base {
 
       //these are really only useful to the async code cache, but keep them here so
       //free_code can be shared
-      std::unordered_set<code_tuple> _queued_compiles;
-      std::unordered_map<code_tuple, bool> _outstanding_compiles_and_poison;
+      compile_queue _queued_compiles; //compiled in priority order once a compile thread is available
+
+      struct outstanding_compile {
+         bool             poison = false; //freed while compiling, do not insert the result in to the cache
+         compile_priority priority = compile_priority::block;
+         fc::time_point   requested;
+      };
+      std::unordered_map<code_tuple, outstanding_compile> _outstanding_compiles_and_poison;
 
       size_t _free_bytes_eviction_threshold;
       void check_eviction_threshold(size_t free_bytes);
@@ -89,6 +94,10 @@ class code_cache_base {
 
       void set_on_disk_region_dirty(bool);
 
+      //wasm function table of a successful compile handed to the profiler, when it is enabled
+      bfs::path _function_tables_path;
+      void record_function_table(const wasm_compilation_result_message& result, const std::vector<wrapped_fd>& fds);
+
       template <typename T>
       void serialize_cache_index(fc::datastream<T>& ds);
 };
@@ -101,15 +110,36 @@ class code_cache_async : public code_cache_base {
       //If code is in cache: returns pointer & bumps to front of MRU list
       //If code is not in cache, and not blacklisted, and not currently compiling: return nullptr and kick off compile
       //otherwise: return nullptr
-      const code_descriptor* const get_descriptor_for_code(const digest_type& code_id, const uint8_t& vm_version, const chainbase::database& shared_db, bool is_write_window, get_cd_failure& failure);
+      //A compile kicked off is started ahead of queued compiles of a lower priority. Compiles of priorities below
+      //compile_priority::block leave one compile thread free for block execution when there is more than one thread.
+      const code_descriptor* const get_descriptor_for_code(const digest_type& code_id, const uint8_t& vm_version, const chainbase::database& shared_db, bool is_write_window, compile_priority priority, get_cd_failure& failure);
+
+      //Called when an account's code is replaced by setcode. If the old code is hot the new code inherits its use count
+      //and is compiled ahead of its first use
+      void code_replaced(const digest_type& old_code_id, const uint8_t& old_vm_version, const digest_type& new_code_id, const uint8_t& new_vm_version);
+
+      //queued and running compiles and compile latency by priority; not thread safe, updated in the write window
+      compile_stats get_compile_stats() const;
 
    private:
       std::thread _monitor_reply_thread;
       boost::lockfree::spsc_queue<wasm_compilation_result_message> _result_queue;
       void wait_on_compile_monitor_message();
       std::tuple<size_t, size_t> consume_compile_thread_queue();
+      void launch_queued_compiles(const chainbase::database& shared_db);
       std::unordered_set<code_tuple> _blacklist;
       size_t _threads;
+
+      bool can_launch(compile_priority priority) const;
+      void start_compile(const code_tuple& ct, const code_object& codeobject, compile_priority priority, fc::time_point requested);
+      compile_stats _compile_stats;
+
+      //persisted to _hot_codes_path on shutdown; the hot codes not in the cache on startup are queued for compile,
+      //most used first, on the first lookup
+      hot_codes _hot_codes;
+      std::vector<code_tuple> _warmup;
+      bfs::path _hot_codes_path;
+      void load_hot_codes();
 };
 
 class code_cache_sync : public code_cache_base {
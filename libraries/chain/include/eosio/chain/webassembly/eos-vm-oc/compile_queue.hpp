@@ -0,0 +1,86 @@
+#pragma once
+
+#include <eosio/chain/webassembly/eos-vm-oc/compile_stats.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/ipc_protocol.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/member.hpp>
+
+namespace eosio { namespace chain { namespace eosvmoc {
+
+/// Compiles waiting for a compile thread. They are started most urgent priority first; within a priority, codes
+/// queued at the front (in use right now) are started last queued first, ahead of the codes queued at the back in
+/// the order they were queued. Not thread safe, used in the write window.
+class compile_queue {
+   public:
+      struct entry {
+         code_tuple       code;
+         compile_priority priority;
+         int64_t          order;      //within a priority, lowest is compiled first
+         fc::time_point   requested;
+      };
+
+      /// queues @p ct, or moves it when already queued: the earliest request and the most urgent priority are kept
+      void push(const code_tuple& ct, compile_priority priority, fc::time_point requested, bool front) {
+         auto& by_code = _entries.get<by_code_tag>();
+         if(auto it = by_code.find(ct); it != by_code.end()) {
+            requested = std::min(requested, it->requested);
+            priority = std::min(priority, it->priority);
+            by_code.erase(it);
+         }
+         _entries.insert(entry{ct, priority, front ? --_front_order : ++_back_order, requested});
+      }
+
+      bool contains(const code_tuple& ct) const { return _entries.get<by_code_tag>().count(ct); }
+      void erase(const code_tuple& ct) { _entries.get<by_code_tag>().erase(ct); }
+
+      bool   empty() const { return _entries.empty(); }
+      size_t size() const { return _entries.size(); }
+
+      /// the next compile to start
+      const entry& top() const { return *_entries.begin(); }
+      entry pop() {
+         entry e = *_entries.begin();
+         _entries.erase(_entries.begin());
+         return e;
+      }
+
+      void count_queued(compile_stats& stats) const {
+         for(const entry& e : _entries)
+            ++stats[static_cast<size_t>(e.priority)].queued;
+      }
+
+      /// whether a compile of @p priority may start while @p running of @p threads compile threads are busy. With
+      /// more than one thread, the last free one is kept for code executed by blocks.
+      static bool can_launch(compile_priority priority, size_t running, size_t threads) {
+         if(running >= threads)
+            return false;
+         return priority == compile_priority::block || threads == 1 || running + 1 < threads;
+      }
+
+   private:
+      struct by_priority_tag;
+      struct by_code_tag;
+      typedef boost::multi_index_container<
+         entry,
+         boost::multi_index::indexed_by<
+            boost::multi_index::ordered_unique<boost::multi_index::tag<by_priority_tag>,
+               boost::multi_index::composite_key< entry,
+                  boost::multi_index::member<entry, compile_priority, &entry::priority>,
+                  boost::multi_index::member<entry, int64_t,          &entry::order>
+               >
+            >,
+            boost::multi_index::hashed_unique<boost::multi_index::tag<by_code_tag>,
+               boost::multi_index::member<entry, code_tuple, &entry::code>, std::hash<code_tuple>>
+         >
+      > entry_index;
+
+      entry_index _entries;
+      int64_t     _front_order = 0;
+      int64_t     _back_order = 0;
+};
+
+}}}
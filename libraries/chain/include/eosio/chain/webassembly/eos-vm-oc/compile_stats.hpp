@@ -0,0 +1,50 @@
+#pragma once
+
+#include <fc/time.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace eosio { namespace chain { namespace eosvmoc {
+
+/// Order in which queued compiles are started, most urgent first
+enum class compile_priority : uint8_t {
+   block,        ///< executed while applying or producing a block
+   transaction,  ///< executed speculatively for an incoming transaction
+   ahead_of_use, ///< compiled before it is executed: hot codes after a restart or a setcode
+   count
+};
+
+inline const char* compile_priority_name(compile_priority p) {
+   switch(p) {
+      case compile_priority::block:        return "block";
+      case compile_priority::transaction:  return "transaction";
+      case compile_priority::ahead_of_use: return "ahead_of_use";
+      default:                             return "unknown";
+   }
+}
+
+/// Compiles of one priority class. Latency is measured from the first request of a code to its compiled code being
+/// available to executions, queueing included.
+struct compile_tier_stats {
+   /// upper bounds of the latency buckets, a compile counts in the first bucket its latency does not exceed
+   static constexpr std::array<int64_t, 12> latency_bounds_us{ 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000,
+                                                               500000, 1000000, 2500000, 5000000 };
+
+   uint64_t          queued = 0;   ///< waiting for a compile thread right now
+   uint64_t          compiling = 0; ///< running right now
+   uint64_t          compiled = 0; ///< finished, successfully or not
+   std::array<uint64_t, latency_bounds_us.size() + 1> latency_counts{}; ///< compiled per bucket, the last one unbounded
+   fc::microseconds  total_latency{};
+
+   void observe_latency(fc::microseconds latency) {
+      const auto it = std::lower_bound(latency_bounds_us.begin(), latency_bounds_us.end(), latency.count());
+      ++latency_counts[it - latency_bounds_us.begin()];
+      total_latency += latency;
+   }
+};
+
+using compile_stats = std::array<compile_tier_stats, static_cast<size_t>(compile_priority::count)>;
+
+}}}
@@ -13,6 +13,8 @@ namespace eosio { namespace chain { namespace eosvmoc {
 struct config {
    uint64_t cache_size = 1024u*1024u*1024u;
    uint64_t threads    = 1u;
+   uint64_t hot_codes  = 64u; // most used codes remembered across restarts and compiled ahead of use
+   uint32_t profile_hz = 0u;  // samples per second of CPU time taken by the sampling profiler, 0 disables it
 };
 
 }}}
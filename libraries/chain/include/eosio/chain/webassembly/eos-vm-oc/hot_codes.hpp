@@ -0,0 +1,56 @@
+#pragma once
+
+#include <eosio/chain/webassembly/eos-vm-oc/ipc_protocol.hpp>
+
+#include <boost/filesystem/path.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace eosio { namespace chain { namespace eosvmoc {
+
+/// Number of times each code was looked up in the write window. The hot codes, the most used ones, are persisted
+/// across restarts and compiled ahead of their first use.
+///
+/// At most max_tracked() codes are counted: beyond that the least used half is dropped, so a code has to keep being
+/// used to stay tracked. Whether a code is hot is decided against the uses of the least used hot code, refreshed when
+/// codes are dropped and every refresh_interval lookups, so is_hot() is constant time and may lag behind the counts
+/// by that many lookups. Not thread safe, used in the write window.
+class hot_codes {
+   public:
+      static constexpr size_t   tracked_per_hot_code = 8;
+      static constexpr size_t   min_tracked = 1024;
+      static constexpr uint64_t refresh_interval = 1024;
+
+      explicit hot_codes(size_t hot);
+
+      void record_use(const code_tuple& ct);
+      bool is_hot(const code_tuple& ct) const;
+      uint64_t uses(const code_tuple& ct) const;
+
+      /// @p to counts at least as many uses as @p from, e.g. the new code of an account after a setcode
+      void inherit(const code_tuple& from, const code_tuple& to);
+
+      size_t size() const { return _uses.size(); }
+      size_t max_tracked() const { return std::max(_hot * tracked_per_hot_code, min_tracked); }
+
+      /// the hot codes and their uses, most used first
+      std::vector<std::pair<code_tuple, uint64_t>> most_used() const;
+
+      /// replaces the counts with the hot codes saved to @p file; returns them most used first, empty when the file
+      /// does not exist or is of an unknown version
+      std::vector<code_tuple> load(const boost::filesystem::path& file);
+      void save(const boost::filesystem::path& file) const;
+
+   private:
+      void trim();
+      void refresh_threshold();
+
+      size_t                                   _hot;
+      std::unordered_map<code_tuple, uint64_t> _uses;
+      uint64_t                                 _threshold = 0; //uses of the least used hot code, 0 while all are hot
+      uint64_t                                 _lookups_since_refresh = 0;
+};
+
+}}}
@@ -332,7 +332,26 @@ inline constexpr auto get_intrinsic_table() {
       "env.shared_db_idx256_upperbound",
       "env.shared_db_idx256_end",
       "env.shared_db_idx256_next",
-      "env.shared_db_idx256_previous"
+      "env.shared_db_idx256_previous",
+
+      // bulk_table_scan protocol feature
+      "env.db_next_batch_i64",
+      "env.db_idx64_next_batch",
+      "env.db_idx128_next_batch",
+      "env.db_idx256_next_batch",
+      "env.db_idx_double_next_batch",
+      "env.db_idx_long_double_next_batch",
+      "env.shared_db_next_batch_i64",
+      "env.shared_db_idx64_next_batch",
+      "env.shared_db_idx128_next_batch",
+      "env.shared_db_idx256_next_batch",
+      "env.shared_db_idx_double_next_batch",
+      "env.shared_db_idx_long_double_next_batch",
+
+      // batched_crypto protocol feature
+      "env.sha256_batch",
+      "env.recover_key_batch",
+      "env.verify_signature_batch"
    );
 }
 inline constexpr std::size_t find_intrinsic_index(std::string_view hf) {
@@ -22,6 +22,7 @@ struct code_tuple {
 
 struct compile_wasm_message {
    code_tuple code;
+   bool with_function_table = false; //also send the function table of the compiled code, only used by the profiler
    //Two sent fd: 1) communication socket for result, 2) the wasm to compile
 };
 
@@ -62,9 +63,17 @@ using eosvmoc_message = std::variant<initialize_message,
 FC_REFLECT(eosio::chain::eosvmoc::initialize_message, )
 FC_REFLECT(eosio::chain::eosvmoc::initalize_response_message, (error_message))
 FC_REFLECT(eosio::chain::eosvmoc::code_tuple, (code_id)(vm_version))
-FC_REFLECT(eosio::chain::eosvmoc::compile_wasm_message, (code))
+FC_REFLECT(eosio::chain::eosvmoc::compile_wasm_message, (code)(with_function_table))
 FC_REFLECT(eosio::chain::eosvmoc::evict_wasms_message, (codes))
 FC_REFLECT(eosio::chain::eosvmoc::code_compilation_result_message, (start)(apply_offset)(starting_memory_pages)(initdata_prologue_size))
 FC_REFLECT(eosio::chain::eosvmoc::compilation_result_unknownfailure, )
 FC_REFLECT(eosio::chain::eosvmoc::compilation_result_toofull, )
 FC_REFLECT(eosio::chain::eosvmoc::wasm_compilation_result_message, (code)(result)(cache_free_bytes))
+
+namespace std {
+    template<> struct hash<eosio::chain::eosvmoc::code_tuple> {
+        size_t operator()(const eosio::chain::eosvmoc::code_tuple& ct) const noexcept {
+            return ct.code_id._hash[0];
+        }
+    };
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <boost/filesystem/path.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace eosio { namespace chain { namespace eosvmoc {
+
+struct code_descriptor;
+
+/// Start of each compiled function of a code, relative to the start of the code
+struct function_table {
+   std::vector<uint32_t> offsets; // ascending
+   std::vector<uint32_t> indices; // wasm function index (imports included) of the function at the same position
+
+   /// wasm function index of the function containing @p offset, -1 if unknown
+   int64_t function_at(uint32_t offset) const;
+};
+
+struct profile_entry {
+   account_name receiver;
+   action_name  action;
+   digest_type  code_hash;
+   int64_t      function_index = -1; // -1 for host functions and code compiled without a function table
+   uint64_t     samples = 0;
+};
+
+struct profile_report {
+   uint32_t                   sample_hz = 0;
+   uint64_t                   total_samples = 0;
+   uint64_t                   dropped_samples = 0;
+   std::vector<profile_entry> entries; // most samples first
+};
+
+/// Sampling profiler of the code executed by EOS VM OC.
+///
+/// Every thread running an executor arms a timer on its own CPU time that raises SIGPROF sample_hz times per second of
+/// CPU used. While wasm is running the handler records the interrupted program counter; samples are attributed to a
+/// wasm function through the function table the compiler produced for the code, and aggregated per receiver, action,
+/// code and function when the action completes. Samples taken while a host function runs are attributed to the
+/// action with a function index of -1.
+class sampling_profiler {
+   public:
+      static sampling_profiler& instance();
+
+      /// Enable sampling for the process, @p sample_hz of 0 keeps it disabled. Call before executors are created.
+      void start(uint32_t sample_hz);
+      bool enabled() const { return _sample_hz != 0; }
+      uint32_t sample_hz() const { return _sample_hz; }
+
+      /// Arm the sampling timer of the calling thread, called by each executor
+      void thread_init();
+
+      void begin_execution(const code_descriptor& code, uintptr_t code_base, uint64_t code_length,
+                           account_name receiver, action_name action);
+      void end_execution();
+
+      /// pc offset of a sample taken outside of the code
+      static constexpr uint32_t host_pc_offset = UINT32_MAX;
+
+      /// Attribute @p count samples at offsets @p pc_offsets of the code to the action, called by end_execution
+      void aggregate(const digest_type& code_hash, uint8_t vm_version, account_name receiver, action_name action,
+                     const uint32_t* pc_offsets, size_t count, uint64_t dropped);
+
+      void set_function_table(const digest_type& code_hash, uint8_t vm_version, function_table table);
+      void erase_function_table(const digest_type& code_hash, uint8_t vm_version);
+
+      /// Function tables outlive the process together with the compiled code they describe
+      void load_function_tables(const boost::filesystem::path& file);
+      void save_function_tables(const boost::filesystem::path& file) const;
+
+      /// Aggregated samples, at most @p limit entries (0 for all). @p reset starts a new profile.
+      profile_report report(size_t limit, bool reset);
+
+      /// Aggregated samples encoded as a pprof profile (profile.proto, uncompressed). @p reset starts a new profile.
+      std::vector<char> pprof(bool reset);
+
+   private:
+      using function_key = std::tuple<digest_type, uint8_t>;
+      using sample_key = std::tuple<account_name, action_name, digest_type, int64_t>;
+
+      uint32_t                                                       _sample_hz = 0;
+      mutable std::mutex                                             _mtx;
+      std::map<function_key, std::shared_ptr<const function_table>>  _function_tables;
+      std::map<sample_key, uint64_t>                                 _samples;
+      uint64_t                                                       _total_samples = 0;
+      uint64_t                                                       _dropped_samples = 0;
+      fc::time_point                                                 _profile_start = fc::time_point::now();
+};
+
+}}}
+
+FC_REFLECT(eosio::chain::eosvmoc::profile_entry, (receiver)(action)(code_hash)(function_index)(samples))
+FC_REFLECT(eosio::chain::eosvmoc::profile_report, (sample_hz)(total_samples)(dropped_samples)(entries))
@@ -845,6 +845,20 @@ namespace webassembly {
           */
          int32_t db_next_i64(int32_t itr, legacy_ptr<uint64_t> primary);
 
+         /**
+          * Copy the referenced table row and the table rows following it in a primary 64-bit integer index table in one call.
+          *
+          * @ingroup database primary-index
+          * @param itr - the iterator to the first table row to copy.
+          * @param max_rows - the maximum number of table rows to copy.
+          * @param[out] buffer - receives the number of table rows copied as a `uint32_t`, followed by each table row as its `uint64_t` primary key, the `uint32_t` size of its value and the value.
+          *
+          * @return iterator to the first table row not copied (or the end iterator of the table if the last table row was copied).
+          * @pre `itr` points to an existing table row in the table or it is the end iterator of the table, in which case no table row is copied.
+          * @post copying stops before the first table row that does not fit entirely in `buffer`; a returned iterator equal to `itr` means the table row at `itr` needs a larger buffer.
+          */
+         int32_t db_next_batch_i64(int32_t itr, uint32_t max_rows, span<char> buffer);
+
          /**
           * Find the table row preceding the referenced table row in a primary 64-bit integer index table.
           *
@@ -1038,6 +1052,19 @@ namespace webassembly {
           */
          int32_t db_idx64_next(int32_t iterator, legacy_ptr<uint64_t> primary);
 
+         /**
+          * Copy the primary and secondary keys of the referenced table row and the table rows following it in a secondary 64-bit integer index table in one call.
+          *
+          * @ingroup database uint64_t-secondary-index
+          * @param iterator - the iterator to the first table row to copy.
+          * @param max_rows - the maximum number of table rows to copy.
+          * @param[out] buffer - receives the number of table rows copied as a `uint32_t`, followed by the `uint64_t` primary key and the uint64_t secondary key of each table row.
+          *
+          * @return iterator to the first table row not copied (or the end iterator of the table if the last table row was copied).
+          * @pre `iterator` points to an existing table row in the table or it is the end iterator of the table, in which case no table row is copied.
+          */
+         int32_t db_idx64_next_batch(int32_t iterator, uint32_t max_rows, span<char> buffer);
+
          /**
           * Find the table row preceding the referenced table row in a secondary 64-bit integer index table.
           *
@@ -1179,6 +1206,19 @@ namespace webassembly {
           */
          int32_t db_idx128_next(int32_t iterator, legacy_ptr<uint64_t> primary);
 
+         /**
+          * Copy the primary and secondary keys of the referenced table row and the table rows following it in a secondary 128-bit integer index table in one call.
+          *
+          * @ingroup database uint128_t-secondary-index
+          * @param iterator - the iterator to the first table row to copy.
+          * @param max_rows - the maximum number of table rows to copy.
+          * @param[out] buffer - receives the number of table rows copied as a `uint32_t`, followed by the `uint64_t` primary key and the uint128_t secondary key of each table row.
+          *
+          * @return iterator to the first table row not copied (or the end iterator of the table if the last table row was copied).
+          * @pre `iterator` points to an existing table row in the table or it is the end iterator of the table, in which case no table row is copied.
+          */
+         int32_t db_idx128_next_batch(int32_t iterator, uint32_t max_rows, span<char> buffer);
+
          /**
           * Find the table row preceding the referenced table row in a secondary 128-bit integer index table.
           *
@@ -1323,6 +1363,19 @@ namespace webassembly {
           */
          int32_t db_idx256_next(int32_t iterator, legacy_ptr<uint64_t> primary);
 
+         /**
+          * Copy the primary and secondary keys of the referenced table row and the table rows following it in a secondary 256-bit integer index table in one call.
+          *
+          * @ingroup database 256-bit-secondary-index
+          * @param iterator - the iterator to the first table row to copy.
+          * @param max_rows - the maximum number of table rows to copy.
+          * @param[out] buffer - receives the number of table rows copied as a `uint32_t`, followed by the `uint64_t` primary key and the two uint128_t secondary key of each table row.
+          *
+          * @return iterator to the first table row not copied (or the end iterator of the table if the last table row was copied).
+          * @pre `iterator` points to an existing table row in the table or it is the end iterator of the table, in which case no table row is copied.
+          */
+         int32_t db_idx256_next_batch(int32_t iterator, uint32_t max_rows, span<char> buffer);
+
          /**
           * Find the table row preceding the referenced table row in a secondary 256-bit integer index table.
           *
@@ -1467,6 +1520,19 @@ namespace webassembly {
           */
          int32_t db_idx_double_next(int32_t iterator, legacy_ptr<uint64_t> primary);
 
+         /**
+          * Copy the primary and secondary keys of the referenced table row and the table rows following it in a secondary double-precision floating-point index table in one call.
+          *
+          * @ingroup database double-secondary-index
+          * @param iterator - the iterator to the first table row to copy.
+          * @param max_rows - the maximum number of table rows to copy.
+          * @param[out] buffer - receives the number of table rows copied as a `uint32_t`, followed by the `uint64_t` primary key and the float64_t secondary key of each table row.
+          *
+          * @return iterator to the first table row not copied (or the end iterator of the table if the last table row was copied).
+          * @pre `iterator` points to an existing table row in the table or it is the end iterator of the table, in which case no table row is copied.
+          */
+         int32_t db_idx_double_next_batch(int32_t iterator, uint32_t max_rows, span<char> buffer);
+
          /**
           * Find the table row preceding the referenced table row in a secondary double-precision floating-point index table.
           *
@@ -1611,6 +1677,19 @@ namespace webassembly {
           */
          int32_t db_idx_long_double_next(int32_t iterator, legacy_ptr<uint64_t> primary);
 
+         /**
+          * Copy the primary and secondary keys of the referenced table row and the table rows following it in a secondary quadruple-precision floating-point index table in one call.
+          *
+          * @ingroup database long-double-secondary-index
+          * @param iterator - the iterator to the first table row to copy.
+          * @param max_rows - the maximum number of table rows to copy.
+          * @param[out] buffer - receives the number of table rows copied as a `uint32_t`, followed by the `uint64_t` primary key and the float128_t secondary key of each table row.
+          *
+          * @return iterator to the first table row not copied (or the end iterator of the table if the last table row was copied).
+          * @pre `iterator` points to an existing table row in the table or it is the end iterator of the table, in which case no table row is copied.
+          */
+         int32_t db_idx_long_double_next_batch(int32_t iterator, uint32_t max_rows, span<char> buffer);
+
          /**
           * Find the table row preceding the referenced table row in a secondary quadruple-precision floating-point index table.
           *
@@ -1813,6 +1892,39 @@ namespace webassembly {
          */
          int32_t k1_recover( span<const char> signature, span<const char> digest, span<char> pub) const;
 
+         /**
+          * Hashes several buffers using SHA256.
+          *
+          * @ingroup crypto
+          * @param data - the buffers to hash back to back, each preceded by its size as a 32-bit little-endian word.
+          * @param[out] hash_vals - the resulting digests, 32 bytes each in the order of the buffers.
+          *
+          * @return the number of digests written, -1 if data is malformed or hash_vals cannot hold every digest.
+         */
+         int32_t sha256_batch( span<const char> data, span<char> hash_vals ) const;
+
+         /**
+          * Calculates the public keys used for several signatures.
+          *
+          * @ingroup crypto
+          * @param requests - packed vector of (digest, signature) pairs.
+          * @param[out] pubs - output buffer for the packed vector of the recovered public keys, in the order of requests.
+          *
+          * @return number of bytes required by the packed public keys, written only when pubs is large enough.
+         */
+         int32_t recover_key_batch( span<const char> requests, span<char> pubs ) const;
+
+         /**
+          * Tests several public keys with the public keys recovered from their digest and signature.
+          *
+          * @ingroup crypto
+          * @param requests - packed vector of (digest, signature, public key) tuples.
+          *
+          * @return the number of signatures which recover their public key; a signature from which no key can be
+          * recovered does not.
+         */
+         int32_t verify_signature_batch( span<const char> requests ) const;
+
 
          /**
           * Store a record in a primary 64-bit integer index table of shared db.
@@ -1885,6 +1997,20 @@ namespace webassembly {
           */
          int32_t shared_db_next_i64(int32_t itr, legacy_ptr<uint64_t> primary);
 
+         /**
+          * Copy the referenced table row and the table rows following it in a primary 64-bit integer index table of shared db in one call.
+          *
+          * @ingroup shared database primary-index
+          * @param itr - the iterator to the first table row to copy.
+          * @param max_rows - the maximum number of table rows to copy.
+          * @param[out] buffer - receives the number of table rows copied as a `uint32_t`, followed by each table row as its `uint64_t` primary key, the `uint32_t` size of its value and the value.
+          *
+          * @return iterator to the first table row not copied (or the end iterator of the table if the last table row was copied).
+          * @pre `itr` points to an existing table row in the table or it is the end iterator of the table, in which case no table row is copied.
+          * @post copying stops before the first table row that does not fit entirely in `buffer`; a returned iterator equal to `itr` means the table row at `itr` needs a larger buffer.
+          */
+         int32_t shared_db_next_batch_i64(int32_t itr, uint32_t max_rows, span<char> buffer);
+
          /**
           * Find the table row preceding the referenced table row in a primary 64-bit integer index table of shared db.
           *
@@ -2078,6 +2204,19 @@ namespace webassembly {
           */
          int32_t shared_db_idx64_next(int32_t iterator, legacy_ptr<uint64_t> primary);
 
+         /**
+          * Copy the primary and secondary keys of the referenced table row and the table rows following it in a secondary 64-bit integer index table of shared db in one call.
+          *
+          * @ingroup shared database uint64_t-secondary-index
+          * @param iterator - the iterator to the first table row to copy.
+          * @param max_rows - the maximum number of table rows to copy.
+          * @param[out] buffer - receives the number of table rows copied as a `uint32_t`, followed by the `uint64_t` primary key and the uint64_t secondary key of each table row.
+          *
+          * @return iterator to the first table row not copied (or the end iterator of the table if the last table row was copied).
+          * @pre `iterator` points to an existing table row in the table or it is the end iterator of the table, in which case no table row is copied.
+          */
+         int32_t shared_db_idx64_next_batch(int32_t iterator, uint32_t max_rows, span<char> buffer);
+
          /**
           * Find the table row preceding the referenced table row in a secondary 64-bit integer index table of shared db.
           *
@@ -2219,6 +2358,19 @@ namespace webassembly {
           */
          int32_t shared_db_idx128_next(int32_t iterator, legacy_ptr<uint64_t> primary);
 
+         /**
+          * Copy the primary and secondary keys of the referenced table row and the table rows following it in a secondary 128-bit integer index table of shared db in one call.
+          *
+          * @ingroup shared database uint128_t-secondary-index
+          * @param iterator - the iterator to the first table row to copy.
+          * @param max_rows - the maximum number of table rows to copy.
+          * @param[out] buffer - receives the number of table rows copied as a `uint32_t`, followed by the `uint64_t` primary key and the uint128_t secondary key of each table row.
+          *
+          * @return iterator to the first table row not copied (or the end iterator of the table if the last table row was copied).
+          * @pre `iterator` points to an existing table row in the table or it is the end iterator of the table, in which case no table row is copied.
+          */
+         int32_t shared_db_idx128_next_batch(int32_t iterator, uint32_t max_rows, span<char> buffer);
+
          /**
           * Find the table row preceding the referenced table row in a secondary 128-bit integer index table of shared db.
           *
@@ -2363,6 +2515,19 @@ namespace webassembly {
           */
          int32_t shared_db_idx256_next(int32_t iterator, legacy_ptr<uint64_t> primary);
 
+         /**
+          * Copy the primary and secondary keys of the referenced table row and the table rows following it in a secondary 256-bit integer index table of shared db in one call.
+          *
+          * @ingroup shared database 256-bit-secondary-index
+          * @param iterator - the iterator to the first table row to copy.
+          * @param max_rows - the maximum number of table rows to copy.
+          * @param[out] buffer - receives the number of table rows copied as a `uint32_t`, followed by the `uint64_t` primary key and the two uint128_t secondary key of each table row.
+          *
+          * @return iterator to the first table row not copied (or the end iterator of the table if the last table row was copied).
+          * @pre `iterator` points to an existing table row in the table or it is the end iterator of the table, in which case no table row is copied.
+          */
+         int32_t shared_db_idx256_next_batch(int32_t iterator, uint32_t max_rows, span<char> buffer);
+
          /**
           * Find the table row preceding the referenced table row in a secondary 256-bit integer index table of shared db.
           *
@@ -2507,6 +2672,19 @@ namespace webassembly {
           */
          int32_t shared_db_idx_double_next(int32_t iterator, legacy_ptr<uint64_t> primary);
 
+         /**
+          * Copy the primary and secondary keys of the referenced table row and the table rows following it in a secondary double-precision floating-point index table of shared db in one call.
+          *
+          * @ingroup shared database double-secondary-index
+          * @param iterator - the iterator to the first table row to copy.
+          * @param max_rows - the maximum number of table rows to copy.
+          * @param[out] buffer - receives the number of table rows copied as a `uint32_t`, followed by the `uint64_t` primary key and the float64_t secondary key of each table row.
+          *
+          * @return iterator to the first table row not copied (or the end iterator of the table if the last table row was copied).
+          * @pre `iterator` points to an existing table row in the table or it is the end iterator of the table, in which case no table row is copied.
+          */
+         int32_t shared_db_idx_double_next_batch(int32_t iterator, uint32_t max_rows, span<char> buffer);
+
          /**
           * Find the table row preceding the referenced table row in a secondary double-precision floating-point index table of shared db.
           *
@@ -2651,6 +2829,19 @@ namespace webassembly {
           */
          int32_t shared_db_idx_long_double_next(int32_t iterator, legacy_ptr<uint64_t> primary);
 
+         /**
+          * Copy the primary and secondary keys of the referenced table row and the table rows following it in a secondary quadruple-precision floating-point index table of shared db in one call.
+          *
+          * @ingroup shared database long-double-secondary-index
+          * @param iterator - the iterator to the first table row to copy.
+          * @param max_rows - the maximum number of table rows to copy.
+          * @param[out] buffer - receives the number of table rows copied as a `uint32_t`, followed by the `uint64_t` primary key and the float128_t secondary key of each table row.
+          *
+          * @return iterator to the first table row not copied (or the end iterator of the table if the last table row was copied).
+          * @pre `iterator` points to an existing table row in the table or it is the end iterator of the table, in which case no table row is copied.
+          */
+         int32_t shared_db_idx_long_double_next_batch(int32_t iterator, uint32_t max_rows, span<char> buffer);
+
          /**
           * Find the table row preceding the referenced table row in a secondary quadruple-precision floating-point index table of shared db.
           *
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <eosio/vm/allocator.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+namespace eosio { namespace chain {
+
+/// Linear memories of eos-vm and eos-vm-jit executions, one per initial page count of the executed modules.
+///
+/// Resetting a wasm_allocator for the next execution zeroes every page the previous execution left allocated and,
+/// when the page count differs, changes the protection of the whole range. Executing a module in the memory last
+/// used by a module of the same initial size keeps the zeroing to the pages of similar contracts and avoids the
+/// mprotect calls entirely when they do not grow their memory. When all slots are taken the least recently used
+/// memory is released. Not thread safe, each executing thread owns its pool.
+class wasm_allocator_pool {
+ public:
+   static constexpr size_t max_memories = 8;
+
+   vm::wasm_allocator& get(uint32_t initial_pages) {
+      ++_clock;
+      slot* victim = nullptr;
+      for (slot& s : _slots) {
+         if (s.alloc && s.initial_pages == initial_pages) {
+            s.last_used = _clock;
+            return *s.alloc;
+         }
+         if (!victim || (victim->alloc && (!s.alloc || s.last_used < victim->last_used)))
+            victim = &s;
+      }
+      victim->alloc         = std::make_unique<vm::wasm_allocator>();
+      victim->initial_pages = initial_pages;
+      victim->last_used     = _clock;
+      ++_memories_created;
+      return *victim->alloc;
+   }
+
+   /// number of linear memories reserved over the life of the pool
+   uint64_t memories_created() const { return _memories_created; }
+
+ private:
+   struct slot {
+      uint32_t                            initial_pages = 0;
+      uint64_t                            last_used     = 0;
+      std::unique_ptr<vm::wasm_allocator> alloc;
+   };
+
+   std::array<slot, max_memories> _slots;
+   uint64_t                       _clock            = 0;
+   uint64_t                       _memories_created = 0;
+};
+
+} } // eosio::chain
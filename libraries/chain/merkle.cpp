@@ -1,6 +1,8 @@
 #include <eosio/chain/merkle.hpp>
 #include <fc/io/raw.hpp>
 
+#include <map>
+
 namespace eosio { namespace chain {
 
 /**
@@ -35,18 +37,112 @@ bool is_canonical_right(const digest_type& val) {
 digest_type merkle(deque<digest_type> ids) {
    if( 0 == ids.size() ) { return digest_type(); }
 
-   while( ids.size() > 1 ) {
-      if( ids.size() % 2 )
-         ids.push_back(ids.back());
+   static_assert( sizeof(digest_type) == 32, "canonical pairs are hashed straight out of the level buffer" );
+
+   // every level is hashed as one batch of 64 byte canonical pairs laid out back to back
+   vector<digest_type> level( std::make_move_iterator(ids.begin()), std::make_move_iterator(ids.end()) );
+   vector<digest_type> next;
+   while( level.size() > 1 ) {
+      if( level.size() % 2 )
+         level.push_back(level.back());
+
+      const size_t pairs = level.size() / 2;
+      for (size_t i = 0; i < pairs; i++) {
+         level[2 * i]       = make_canonical_left(level[2 * i]);
+         level[(2 * i) + 1] = make_canonical_right(level[(2 * i) + 1]);
+      }
+
+      next.resize(pairs);
+      digest_type::hash_64_byte_batch(level.front().data(), pairs, next.data());
+      level.swap(next);
+   }
+
+   return level.front();
+}
+
+merkle_segment make_merkle_segment(deque<digest_type> ids, uint64_t offset) {
+   merkle_segment segment{ offset };
+   segment.levels.emplace_back( std::make_move_iterator(ids.begin()), std::make_move_iterator(ids.end()) );
+
+   // index of the first node of the current level within the whole level
+   uint64_t first = offset;
+   while( true ) {
+      auto& level = segment.levels.back();
+      // nodes of the next level that have both children in this segment
+      const uint64_t next_first = (first + 1) / 2;
+      const uint64_t next_end   = (first + level.size()) / 2;
+      if( next_end <= next_first )
+         break;
+
+      // the side of every node is fixed by its index in the whole level, so it can be made canonical in place; a
+      // node used as a child is never the root, and merkle( segments ) canonicalizes the boundary nodes it uses again
+      for( uint64_t i = first % 2; i < level.size(); i += 2 ) {
+         level[i] = make_canonical_left(level[i]);
+         if( i + 1 < level.size() )
+            level[i + 1] = make_canonical_right(level[i + 1]);
+      }
+      if( first % 2 )
+         level.front() = make_canonical_right(level.front());
+
+      vector<digest_type> next( next_end - next_first );
+      digest_type::hash_64_byte_batch( level[2 * next_first - first].data(), next.size(), next.data() );
+      segment.levels.emplace_back( std::move(next) );
+      first = next_first;
+   }
+   return segment;
+}
+
+digest_type merkle(vector<merkle_segment> segments) {
+   uint64_t leaves = 0;
+   for( const auto& s : segments ) {
+      FC_ASSERT( s.offset == leaves, "merkle segments must be contiguous" );
+      leaves += s.levels.empty() ? 0 : s.levels.front().size();
+   }
+   if( 0 == leaves ) { return digest_type(); }
+
+   // nodes of the current level not covered by any segment, i.e. spanning segments or duplicated at the end
+   std::map<uint64_t, digest_type> computed;
+   auto node = [&]( size_t height, uint64_t index ) -> const digest_type& {
+      for( const auto& s : segments ) {
+         if( s.levels.size() <= height )
+            continue;
+         const auto& level = s.levels[height];
+         const uint64_t first = (s.offset + (uint64_t(1) << height) - 1) >> height;
+         if( index >= first && index < first + level.size() )
+            return level[index - first];
+      }
+      return computed.at( index );
+   };
+
+   size_t   height = 0;
+   uint64_t size   = leaves;
+   for( ; size > 1; ++height ) {
+      const uint64_t next_size = (size + 1) / 2;
+      std::map<uint64_t, digest_type> next_computed;
 
-      for (size_t i = 0; i < ids.size() / 2; i++) {
-         ids[i] = digest_type::hash(make_canonical_pair(ids[2 * i], ids[(2 * i) + 1]));
+      // walk the gaps between the node ranges the segments cover on the next level
+      uint64_t index = 0;
+      auto fill = [&]( uint64_t end ) {
+         for( ; index < end; ++index ) {
+            const auto& l = node( height, 2 * index );
+            const auto& r = 2 * index + 1 < size ? node( height, 2 * index + 1 ) : l;
+            next_computed[index] = digest_type::hash( make_canonical_pair( l, r ) );
+         }
+      };
+      for( const auto& s : segments ) {
+         if( s.levels.size() <= height + 1 )
+            continue;
+         const uint64_t first = (s.offset + (uint64_t(1) << (height + 1)) - 1) >> (height + 1);
+         fill( first );
+         index = first + s.levels[height + 1].size();
       }
+      fill( next_size );
 
-      ids.resize(ids.size() / 2);
+      computed = std::move( next_computed );
+      size = next_size;
    }
 
-   return ids.front();
+   return node( height, 0 );
 }
 
 } } // eosio::chain
@@ -258,6 +258,33 @@ Adds new cryptographic host functions
 Builtin protocol feature: GET_BLOCK_NUM
 
 Enables new `get_block_num` intrinsic which returns the current block number.
+*/
+            {}
+         } )
+         (  builtin_protocol_feature_t::bulk_table_scan, builtin_protocol_feature_spec{
+            "BULK_TABLE_SCAN",
+            fc::variant("98e697c3110481c36b2c87ace9a7afd6b241cb82240139fb46351a20b333bcf4").as<digest_type>(),
+            // SHA256 hash of the raw message below within the comment delimiters (do not modify message below).
+/*
+Builtin protocol feature: BULK_TABLE_SCAN
+
+Adds new host functions which copy a batch of consecutive table rows to the caller in one call
+- primary index rows with their values (db_next_batch_i64, shared_db_next_batch_i64)
+- secondary index primary and secondary keys (db_idx64_next_batch, db_idx128_next_batch, db_idx256_next_batch, db_idx_double_next_batch, db_idx_long_double_next_batch and their shared_db_ counterparts)
+*/
+            {}
+         } )
+         (  builtin_protocol_feature_t::batched_crypto, builtin_protocol_feature_spec{
+            "BATCHED_CRYPTO",
+            fc::variant("b44ac9c09ad39b7c2d6bc17ce93a4acdcf431a0e3e9ca9bb8048ded525a6d993").as<digest_type>(),
+            // SHA256 hash of the raw message below within the comment delimiters (do not modify message below).
+/*
+Builtin protocol feature: BATCHED_CRYPTO
+
+Adds new host functions which process several inputs in one call
+- sha256_batch hashes several buffers, 64 byte buffers with a multi-buffer SHA256 implementation
+- recover_key_batch recovers the public keys of several signatures
+- verify_signature_batch counts the signatures which recover their given public key
 */
             {}
          } )
@@ -0,0 +1,68 @@
+#include <eosio/chain/signature_recovery_cache.hpp>
+
+#include <fc/io/raw.hpp>
+
+namespace eosio { namespace chain {
+
+signature_recovery_cache& signature_recovery_cache::instance() {
+   static signature_recovery_cache cache;
+   return cache;
+}
+
+signature_recovery_cache::signature_recovery_cache( size_t max_entries ) {
+   set_max_entries( max_entries );
+}
+
+void signature_recovery_cache::set_max_entries( size_t max_entries ) {
+   const size_t per_shard = max_entries ? std::max<size_t>( max_entries / num_shards, 1 ) : 0;
+   _max_entries_per_shard = per_shard;
+   for( shard& s : _shards ) {
+      std::lock_guard g( s.mtx );
+      while( s.entries.size() > per_shard )
+         s.entries.pop_back();
+   }
+}
+
+public_key_type signature_recovery_cache::recover( const signature_type& sig, const digest_type& digest ) {
+   if( _max_entries_per_shard == 0 )
+      return public_key_type( sig, digest );
+
+   // a cryptographic key keeps entries small and crafted signatures from piling up in a bucket
+   digest_type::encoder enc;
+   fc::raw::pack( enc, digest );
+   fc::raw::pack( enc, sig );
+   const digest_type key = enc.result();
+   shard& s = _shards[key._hash[1] % num_shards];
+
+   {
+      std::lock_guard g( s.mtx );
+      auto& by_k = s.entries.get<by_key>();
+      if( auto itr = by_k.find( key ); itr != by_k.end() ) {
+         s.entries.relocate( s.entries.begin(), s.entries.project<0>( itr ) );
+         ++_hits;
+         return itr->pub;
+      }
+   }
+
+   ++_misses;
+   public_key_type pub( sig, digest ); // outside the lock, throws if no key can be recovered
+
+   std::lock_guard g( s.mtx );
+   if( s.entries.push_front( entry{ key, pub } ).second ) {
+      const size_t max_entries = _max_entries_per_shard;
+      while( s.entries.size() > max_entries )
+         s.entries.pop_back();
+   }
+   return pub;
+}
+
+signature_recovery_cache::stats signature_recovery_cache::get_stats() const {
+   stats result{ _hits, _misses, 0 };
+   for( const shard& s : _shards ) {
+      std::lock_guard g( s.mtx );
+      result.size += s.entries.size();
+   }
+   return result;
+}
+
+} } // eosio::chain
@@ -10,6 +10,7 @@
 #include <eosio/chain/config.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/transaction.hpp>
+#include <eosio/chain/signature_recovery_cache.hpp>
 
 namespace eosio { namespace chain {
 
@@ -83,7 +84,7 @@ fc::microseconds transaction::get_signature_keys( const vector<signature_type>&
          auto now = fc::time_point::now();
          EOS_ASSERT( now < deadline, tx_cpu_usage_exceeded, "transaction signature verification executed for too long ${time}us",
                      ("time", now - start)("now", now)("deadline", deadline)("start", start) );
-         auto[ itr, successful_insertion ] = recovered_pub_keys.emplace( sig, digest );
+         auto[ itr, successful_insertion ] = recovered_pub_keys.emplace( signature_recovery_cache::instance().recover( sig, digest ) );
          EOS_ASSERT( allow_duplicate_keys || successful_insertion, tx_duplicate_sig,
                      "transaction includes more than one signature signed using the same key associated with public key: ${key}",
                      ("key", *itr ) );
@@ -46,12 +46,38 @@ namespace eosio { namespace chain {
    }
 #endif
 
-   void wasm_interface::validate(apply_context& context, const bytes& code) {
+   wasm_validation_cache& wasm_interface::validation_cache() {
+      static wasm_validation_cache cache;
+      return cache;
+   }
+
+   void wasm_interface::validate(apply_context& context, const bytes& code, const digest_type& code_hash) {
       const auto& pso = context.shared_db.get<protocol_state_object>();
+      const bool configurable_limits = context.is_builtin_activated(builtin_protocol_feature_t::configurable_wasm_limits);
+
+      // everything the outcome depends on besides the code: the constraints checked and the importable intrinsics
+      digest_type::encoder enc;
+      fc::raw::pack( enc, code_hash );
+      fc::raw::pack( enc, configurable_limits );
+      if (configurable_limits) {
+         fc::raw::pack( enc, context.shared_db.get<global_property_object>().wasm_configuration );
+      } else {
+         fc::raw::pack( enc, context.is_speculative_block() );
+      }
+      for( const auto& p : pso.whitelisted_intrinsics ) {
+         fc::raw::pack( enc, fc::unsigned_int(p.second.size()) );
+         enc.write( p.second.data(), p.second.size() );
+      }
+      const digest_type key = enc.result();
 
-      if (context.is_builtin_activated(builtin_protocol_feature_t::configurable_wasm_limits)) {
+      auto& cache = validation_cache();
+      if (cache.contains(key))
+         return;
+
+      if (configurable_limits) {
          const auto& gpo = context.shared_db.get<global_property_object>();
          webassembly::eos_vm_runtime::validate( code, gpo.wasm_configuration, pso.whitelisted_intrinsics );
+         cache.insert(key);
          return;
       }
       Module module;
@@ -68,6 +94,7 @@ namespace eosio { namespace chain {
       validator.validate();
 
       webassembly::eos_vm_runtime::validate( code, pso.whitelisted_intrinsics );
+      cache.insert(key);
 
       //there are a couple opportunties for improvement here--
       //Easy: Cache the Module created here so it can be reused for instantiaion
@@ -82,6 +109,21 @@ namespace eosio { namespace chain {
       my->code_block_num_last_used(code_hash, vm_type, vm_version, block_num);
    }
 
+   void wasm_interface::code_replaced(const digest_type& old_code_hash, const uint8_t& old_vm_version, const digest_type& new_code_hash, const uint8_t& new_vm_version) {
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+      if(my->eosvmoc)
+         my->eosvmoc->cc.code_replaced(old_code_hash, old_vm_version, new_code_hash, new_vm_version);
+#endif
+   }
+
+   eosvmoc::compile_stats wasm_interface::oc_compile_stats() const {
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+      if(my->eosvmoc)
+         return my->eosvmoc->cc.get_compile_stats();
+#endif
+      return {};
+   }
+
    void wasm_interface::current_lib(const uint32_t lib) {
       my->current_lib(lib);
    }
@@ -93,8 +135,11 @@ namespace eosio { namespace chain {
       if(my->eosvmoc) {
          const chain::eosvmoc::code_descriptor* cd = nullptr;
          chain::eosvmoc::code_cache_base::get_cd_failure failure = chain::eosvmoc::code_cache_base::get_cd_failure::temporary;
+         //code executed by the block being applied or produced is compiled ahead of code of speculative transactions
+         const auto priority = context.control.is_speculative_block() && !context.control.is_producing_block()
+                               ? chain::eosvmoc::compile_priority::transaction : chain::eosvmoc::compile_priority::block;
          try {
-            cd = my->eosvmoc->cc.get_descriptor_for_code(code_hash, vm_version, context.shared_db, context.control.is_write_window(), failure);
+            cd = my->eosvmoc->cc.get_descriptor_for_code(code_hash, vm_version, context.shared_db, context.control.is_write_window(), priority, failure);
          }
          catch(...) {
             //swallow errors here, if EOS VM OC has gone in to the weeds we shouldn't bail: continue to try and run baseline
@@ -117,7 +162,7 @@ namespace eosio { namespace chain {
          }
       }
 #endif
-      my->get_instantiated_module(code_hash, vm_type, vm_version, context.trx_context)->apply(context);
+      my->acquire_instantiated_module(code_hash, vm_type, vm_version, context.trx_context)->apply(context);
    }
 
    bool wasm_interface::is_code_cached(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version) const {
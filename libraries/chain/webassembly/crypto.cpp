@@ -246,4 +246,118 @@ namespace eosio { namespace chain { namespace webassembly {
       return return_code::success;
    }
 
+   int32_t interface::sha256_batch( span<const char> data, span<char> hash_vals ) const {
+      std::vector<std::pair<const char*, uint32_t>> inputs;
+      datastream<const char*> ds( data.data(), data.size() );
+      while( ds.remaining() ) {
+         uint32_t size = 0;
+         if( ds.remaining() < sizeof(size) )
+            return return_code::failure;
+         fc::raw::unpack( ds, size );
+         if( ds.remaining() < size )
+            return return_code::failure;
+         inputs.emplace_back( ds.pos(), size );
+         ds.skip( size );
+      }
+      if( hash_vals.size() / sizeof(fc::sha256) < inputs.size() )
+         return return_code::failure;
+
+      // 64 byte inputs, e.g. two concatenated digests, go through the multi-buffer kernel together
+      std::vector<fc::sha256> digests( inputs.size() );
+      std::vector<char>       blocks;
+      std::vector<size_t>     block_inputs;
+      for( size_t i = 0; i < inputs.size(); ++i ) {
+         const auto& [in, size] = inputs[i];
+         if( size == 64 ) {
+            blocks.insert( blocks.end(), in, in + size );
+            block_inputs.push_back( i );
+            continue;
+         }
+         digests[i] = context.trx_context.hash_with_checktime<fc::sha256>( in, size );
+         context.trx_context.checktime();
+      }
+
+      const size_t blocks_per_checktime = config::hashing_checktime_block_size / 64;
+      std::vector<fc::sha256> block_digests( block_inputs.size() );
+      for( size_t first = 0; first < block_inputs.size(); first += blocks_per_checktime ) {
+         const size_t count = std::min( blocks_per_checktime, block_inputs.size() - first );
+         fc::sha256::hash_64_byte_batch( blocks.data() + first * 64, count, block_digests.data() + first );
+         context.trx_context.checktime();
+      }
+      for( size_t j = 0; j < block_inputs.size(); ++j )
+         digests[block_inputs[j]] = block_digests[j];
+
+      std::memcpy( hash_vals.data(), digests.data(), digests.size() * sizeof(fc::sha256) );
+      return digests.size();
+   }
+
+   int32_t interface::recover_key_batch( span<const char> requests, span<char> pubs ) const {
+      const auto num_supported_key_types = context.db.get<protocol_state_object>().num_supported_key_types;
+      const bool speculative = context.control.is_speculative_block();
+
+      datastream<const char*> ds( requests.data(), requests.size() );
+      fc::unsigned_int count;
+      fc::raw::unpack( ds, count );
+
+      std::vector<fc::crypto::public_key> recovered;
+      for( uint32_t i = 0; i < count.value; ++i ) {
+         fc::sha256 digest;
+         fc::crypto::signature s;
+         fc::raw::unpack( ds, digest );
+         fc::raw::unpack( ds, s );
+
+         EOS_ASSERT(s.which() < num_supported_key_types, unactivated_signature_type,
+                    "Unactivated signature type used during recover_key_batch");
+         if(speculative)
+            EOS_ASSERT(s.variable_size() <= context.control.configured_subjective_signature_length_limit(),
+                       sig_variable_size_limit_exception, "signature variable length component size greater than subjective maximum");
+
+         recovered.emplace_back( s, digest, false );
+         context.trx_context.checktime();
+      }
+
+      const auto packed = fc::raw::pack( recovered );
+      if( pubs.size() >= packed.size() )
+         std::memcpy( pubs.data(), packed.data(), packed.size() );
+      return packed.size();
+   }
+
+   int32_t interface::verify_signature_batch( span<const char> requests ) const {
+      const auto num_supported_key_types = context.db.get<protocol_state_object>().num_supported_key_types;
+      const bool speculative = context.control.is_speculative_block();
+
+      datastream<const char*> ds( requests.data(), requests.size() );
+      fc::unsigned_int count;
+      fc::raw::unpack( ds, count );
+
+      int32_t verified = 0;
+      for( uint32_t i = 0; i < count.value; ++i ) {
+         fc::sha256 digest;
+         fc::crypto::signature s;
+         fc::crypto::public_key p;
+         fc::raw::unpack( ds, digest );
+         fc::raw::unpack( ds, s );
+         fc::raw::unpack( ds, p );
+
+         EOS_ASSERT(s.which() < num_supported_key_types, unactivated_signature_type,
+                    "Unactivated signature type used during verify_signature_batch");
+         EOS_ASSERT(p.which() < num_supported_key_types, unactivated_key_type,
+                    "Unactivated key type used during verify_signature_batch");
+         if(speculative)
+            EOS_ASSERT(s.variable_size() <= context.control.configured_subjective_signature_length_limit(),
+                       sig_variable_size_limit_exception, "signature variable length component size greater than subjective maximum");
+
+         bool matches = false;
+         try {
+            matches = fc::crypto::public_key( s, digest, false ) == p;
+         } catch( const fc::exception& ) {
+            // no key can be recovered from the signature
+         }
+         if( matches )
+            ++verified;
+         context.trx_context.checktime();
+      }
+      return verified;
+   }
+
 }}} // ns eosio::chain::webassembly
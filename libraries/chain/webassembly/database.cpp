@@ -21,6 +21,9 @@ namespace eosio { namespace chain { namespace webassembly {
    int32_t interface::db_next_i64( int32_t itr, legacy_ptr<uint64_t> primary ) {
       return context.table_context().db_next_i64(itr, *primary);
    }
+   int32_t interface::db_next_batch_i64( int32_t itr, uint32_t max_rows, span<char> buffer ) {
+      return context.table_context().db_next_batch_i64(itr, max_rows, buffer.data(), buffer.size());
+   }
    int32_t interface::db_previous_i64( int32_t itr, legacy_ptr<uint64_t> primary ) {
       return context.table_context().db_previous_i64(itr, *primary);
    }
@@ -73,6 +76,9 @@ namespace eosio { namespace chain { namespace webassembly {
    int32_t interface::db_idx64_next( int32_t iterator, legacy_ptr<uint64_t> primary ) {
       return context.table_context().idx64.next_secondary(iterator, *primary);
    }
+   int32_t interface::db_idx64_next_batch( int32_t iterator, uint32_t max_rows, span<char> buffer ) {
+      return context.table_context().idx64.next_secondary_batch(iterator, max_rows, buffer.data(), buffer.size());
+   }
    int32_t interface::db_idx64_previous( int32_t iterator, legacy_ptr<uint64_t> primary ) {
       return context.table_context().idx64.previous_secondary(iterator, *primary);
    }
@@ -114,6 +120,9 @@ namespace eosio { namespace chain { namespace webassembly {
    int32_t interface::db_idx128_next( int32_t iterator, legacy_ptr<uint64_t> primary ) {
       return context.table_context().idx128.next_secondary(iterator, *primary);
    }
+   int32_t interface::db_idx128_next_batch( int32_t iterator, uint32_t max_rows, span<char> buffer ) {
+      return context.table_context().idx128.next_secondary_batch(iterator, max_rows, buffer.data(), buffer.size());
+   }
    int32_t interface::db_idx128_previous( int32_t iterator, legacy_ptr<uint64_t> primary ) {
       return context.table_context().idx128.previous_secondary(iterator, *primary);
    }
@@ -179,6 +188,9 @@ namespace eosio { namespace chain { namespace webassembly {
    int32_t interface::db_idx256_next( int32_t iterator, legacy_ptr<uint64_t> primary ) {
       return context.table_context().idx256.next_secondary(iterator, *primary);
    }
+   int32_t interface::db_idx256_next_batch( int32_t iterator, uint32_t max_rows, span<char> buffer ) {
+      return context.table_context().idx256.next_secondary_batch(iterator, max_rows, buffer.data(), buffer.size());
+   }
    int32_t interface::db_idx256_previous( int32_t iterator, legacy_ptr<uint64_t> primary ) {
       return context.table_context().idx256.previous_secondary(iterator, *primary);
    }
@@ -219,6 +231,9 @@ namespace eosio { namespace chain { namespace webassembly {
    int32_t interface::db_idx_double_next( int32_t iterator, legacy_ptr<uint64_t> primary ) {
       return context.table_context().idx_double.next_secondary(iterator, *primary);
    }
+   int32_t interface::db_idx_double_next_batch( int32_t iterator, uint32_t max_rows, span<char> buffer ) {
+      return context.table_context().idx_double.next_secondary_batch(iterator, max_rows, buffer.data(), buffer.size());
+   }
    int32_t interface::db_idx_double_previous( int32_t iterator, legacy_ptr<uint64_t> primary ) {
       return context.table_context().idx_double.previous_secondary(iterator, *primary);
    }
@@ -259,6 +274,9 @@ namespace eosio { namespace chain { namespace webassembly {
    int32_t interface::db_idx_long_double_next( int32_t iterator, legacy_ptr<uint64_t> primary ) {
       return context.table_context().idx_long_double.next_secondary(iterator, *primary);
    }
+   int32_t interface::db_idx_long_double_next_batch( int32_t iterator, uint32_t max_rows, span<char> buffer ) {
+      return context.table_context().idx_long_double.next_secondary_batch(iterator, max_rows, buffer.data(), buffer.size());
+   }
    int32_t interface::db_idx_long_double_previous( int32_t iterator, legacy_ptr<uint64_t> primary ) {
       return context.table_context().idx_long_double.previous_secondary(iterator, *primary);
    }
@@ -7,8 +7,11 @@
 #include <eosio/chain/webassembly/eos-vm-oc/eos-vm-oc.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/intrinsic.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/compile_monitor.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/profiler.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <fc/io/raw.hpp>
 
+#include <fstream>
 #include <unistd.h>
 #include <sys/syscall.h>
 #include <sys/mman.h>
@@ -42,10 +45,14 @@ static_assert(sizeof(code_cache_header) <= header_size, "code_cache_header too b
 code_cache_async::code_cache_async(const bfs::path data_dir, const eosvmoc::config& eosvmoc_config ) 
 :code_cache_base(data_dir, eosvmoc_config),
    _result_queue(eosvmoc_config.threads * 2),
-   _threads(eosvmoc_config.threads)
+   _threads(eosvmoc_config.threads),
+   _hot_codes(eosvmoc_config.hot_codes),
+   _hot_codes_path(data_dir/"code_cache_hot.bin")
 {
    FC_ASSERT(_threads, "EOS VM OC requires at least 1 compile thread");
 
+   load_hot_codes();
+
    wait_on_compile_monitor_message();
 
    _monitor_reply_thread = std::thread([this]() {
@@ -58,6 +65,66 @@ code_cache_async::~code_cache_async() {
    _compile_monitor_write_socket.shutdown(local::datagram_protocol::socket::shutdown_send);
    _monitor_reply_thread.join();
    consume_compile_thread_queue();
+   try {
+      _hot_codes.save(_hot_codes_path);
+   } FC_LOG_AND_DROP(("EOS VM OC hot code list save ERROR"));
+}
+
+void code_cache_async::load_hot_codes() {
+   try {
+      const std::vector<code_tuple> hot = _hot_codes.load(_hot_codes_path);
+      for(const code_tuple& ct : hot)
+         if(_cache_index.get<by_hash>().find(boost::make_tuple(ct.code_id, ct.vm_version)) == _cache_index.get<by_hash>().end())
+            _warmup.emplace_back(ct);
+      if(hot.size())
+         ilog("EOS VM OC hot code list loaded with ${h} entries, ${w} to compile ahead of use", ("h", hot.size())("w", _warmup.size()));
+   } FC_LOG_AND_DROP(("EOS VM OC hot code list load ERROR"));
+}
+
+void code_cache_async::code_replaced(const digest_type& old_code_id, const uint8_t& old_vm_version, const digest_type& new_code_id, const uint8_t& new_vm_version) {
+   const code_tuple old_ct{old_code_id, old_vm_version};
+   if(!_hot_codes.is_hot(old_ct))
+      return;
+   //the old count is kept as the setcode may still be rolled back
+   const code_tuple new_ct{new_code_id, new_vm_version};
+   _hot_codes.inherit(old_ct, new_ct);
+   if(_cache_index.get<by_hash>().find(boost::make_tuple(new_code_id, new_vm_version)) != _cache_index.get<by_hash>().end() ||
+      _outstanding_compiles_and_poison.count(new_ct) || _blacklist.count(new_ct))
+      return;
+   //the code object only exists once the setcode is applied, it is read when the compile is launched
+   _queued_compiles.push(new_ct, compile_priority::ahead_of_use, fc::time_point::now(), true);
+}
+
+bool code_cache_async::can_launch(compile_priority priority) const {
+   return compile_queue::can_launch(priority, _outstanding_compiles_and_poison.size(), _threads);
+}
+
+void code_cache_async::start_compile(const code_tuple& ct, const code_object& codeobject, compile_priority priority, fc::time_point requested) {
+   _outstanding_compiles_and_poison.emplace(ct, outstanding_compile{false, priority, requested});
+   std::vector<wrapped_fd> fds_to_pass;
+   fds_to_pass.emplace_back(memfd_for_bytearray(codeobject.code));
+   FC_ASSERT(write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ ct, sampling_profiler::instance().enabled() }, fds_to_pass),
+             "EOS VM failed to communicate to OOP manager");
+}
+
+void code_cache_async::launch_queued_compiles(const chainbase::database& shared_db) {
+   while(!_queued_compiles.empty() && can_launch(_queued_compiles.top().priority)) {
+      const compile_queue::entry nextup = _queued_compiles.pop();
+
+      //the code may be gone by now: a warm-up entry of code replaced while the node was down, or a rolled back setcode
+      const code_object* const codeobject = shared_db.find<code_object,by_code_hash>(boost::make_tuple(nextup.code.code_id, 0, nextup.code.vm_version));
+      if(!codeobject || _cache_index.get<by_hash>().find(boost::make_tuple(nextup.code.code_id, nextup.code.vm_version)) != _cache_index.get<by_hash>().end())
+         continue;
+      start_compile(nextup.code, *codeobject, nextup.priority, nextup.requested);
+   }
+}
+
+compile_stats code_cache_async::get_compile_stats() const {
+   compile_stats stats = _compile_stats;
+   _queued_compiles.count_queued(stats);
+   for(const auto& [_, oc] : _outstanding_compiles_and_poison)
+      ++stats[static_cast<size_t>(oc.priority)].compiling;
+   return stats;
 }
 
 //remember again: wait_on_compile_monitor_message's callback is non-main thread!
@@ -74,6 +141,7 @@ void code_cache_async::wait_on_compile_monitor_message() {
          return;
       }
 
+      record_function_table(std::get<wasm_compilation_result_message>(message), fds);
       _result_queue.push(std::get<wasm_compilation_result_message>(message));
 
       wait_on_compile_monitor_message();
@@ -84,8 +152,14 @@ void code_cache_async::wait_on_compile_monitor_message() {
 //number processed, bytes available (only if number processed > 0)
 std::tuple<size_t, size_t> code_cache_async::consume_compile_thread_queue() {
    size_t bytes_remaining = 0;
+   const fc::time_point now = fc::time_point::now();
    size_t gotsome = _result_queue.consume_all([&](const wasm_compilation_result_message& result) {
-      if(_outstanding_compiles_and_poison[result.code] == false) {
+      const outstanding_compile& oc = _outstanding_compiles_and_poison[result.code];
+      compile_tier_stats& tier = _compile_stats[static_cast<size_t>(oc.priority)];
+      ++tier.compiled;
+      tier.observe_latency(now - oc.requested);
+
+      if(oc.poison == false) {
          std::visit(overloaded {
             [&](const code_descriptor& cd) {
                _cache_index.push_front(cd);
@@ -99,6 +173,8 @@ std::tuple<size_t, size_t> code_cache_async::consume_compile_thread_queue() {
             }
          }, result.result);
       }
+      else if(std::holds_alternative<code_descriptor>(result.result))
+         sampling_profiler::instance().erase_function_table(result.code.code_id, result.code.vm_version);
       _outstanding_compiles_and_poison.erase(result.code);
       bytes_remaining = result.cache_free_bytes;
    });
@@ -107,31 +183,29 @@ std::tuple<size_t, size_t> code_cache_async::consume_compile_thread_queue() {
 }
 
 
-const code_descriptor* const code_cache_async::get_descriptor_for_code(const digest_type& code_id, const uint8_t& vm_version, const chainbase::database& shared_db, bool is_write_window, get_cd_failure& failure) {
+const code_descriptor* const code_cache_async::get_descriptor_for_code(const digest_type& code_id, const uint8_t& vm_version, const chainbase::database& shared_db, bool is_write_window, compile_priority priority, get_cd_failure& failure) {
    //if there are any outstanding compiles, process the result queue now
    //When app is in write window, all tasks are running sequentially and read-only threads
    //are not running. Safe to update cache entries.
-   if(is_write_window && _outstanding_compiles_and_poison.size()) {
-      auto [count_processed, bytes_remaining] = consume_compile_thread_queue();
-
-      if(count_processed)
-         check_eviction_threshold(bytes_remaining);
-
-      while(count_processed && _queued_compiles.size()) {
-         auto nextup = _queued_compiles.begin();
-
-         //it's not clear this check is required: if apply() was called for code then it existed in the code_index; and then
-         // if we got notification of it no longer existing we would have removed it from queued_compiles
-         const code_object* const codeobject = shared_db.find<code_object,by_code_hash>(boost::make_tuple(nextup->code_id, 0, nextup->vm_version));
-         if(codeobject) {
-            _outstanding_compiles_and_poison.emplace(*nextup, false);
-            std::vector<wrapped_fd> fds_to_pass;
-            fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
-            FC_ASSERT(write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ *nextup }, fds_to_pass), "EOS VM failed to communicate to OOP manager");
-            --count_processed;
-         }
-         _queued_compiles.erase(nextup);
+   if(is_write_window) {
+      if(_outstanding_compiles_and_poison.size()) {
+         auto [count_processed, bytes_remaining] = consume_compile_thread_queue();
+
+         if(count_processed)
+            check_eviction_threshold(bytes_remaining);
+      }
+
+      //first lookup since startup, queue the hot codes of the last run that are not in the cache anymore
+      if(_warmup.size()) {
+         const fc::time_point now = fc::time_point::now();
+         for(const code_tuple& ct : _warmup)
+            _queued_compiles.push(ct, compile_priority::ahead_of_use, now, false);
+         _warmup.clear();
       }
+
+      launch_queued_compiles(shared_db);
+
+      _hot_codes.record_use(code_tuple{code_id, vm_version});
    }
 
    //check for entry in cache
@@ -154,16 +228,18 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(const dig
    }
    if(auto it = _outstanding_compiles_and_poison.find(ct); it != _outstanding_compiles_and_poison.end()) {
       failure = get_cd_failure::temporary; // Compile might not be done yet
-      it->second = false;
+      it->second.poison = false;
       return nullptr;
    }
-   if(_queued_compiles.find(ct) != _queued_compiles.end()) {
+   if(_queued_compiles.contains(ct)) {
+      //in use right now, compile ahead of the queued compiles of its priority
+      _queued_compiles.push(ct, priority, fc::time_point::now(), true);
       failure = get_cd_failure::temporary; // Compile might not be done yet
       return nullptr;
    }
 
-   if(_outstanding_compiles_and_poison.size() >= _threads) {
-      _queued_compiles.emplace(ct);
+   if(!can_launch(priority)) {
+      _queued_compiles.push(ct, priority, fc::time_point::now(), true);
       failure = get_cd_failure::temporary; // Compile might not be done yet
       return nullptr;
    }
@@ -174,10 +250,7 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(const dig
       return nullptr;
    }
 
-   _outstanding_compiles_and_poison.emplace(ct, false);
-   std::vector<wrapped_fd> fds_to_pass;
-   fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
-   write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ ct }, fds_to_pass);
+   start_compile(ct, *codeobject, priority, fc::time_point::now());
    failure = get_cd_failure::temporary; // Compile might not be done yet
    return nullptr;
 }
@@ -209,13 +282,14 @@ const code_descriptor* const code_cache_sync::get_descriptor_for_code_sync(const
    std::vector<wrapped_fd> fds_to_pass;
    fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
 
-   write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ {code_id, vm_version} }, fds_to_pass);
+   write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ {code_id, vm_version}, sampling_profiler::instance().enabled() }, fds_to_pass);
    auto [success, message, fds] = read_message_with_fds(_compile_monitor_read_socket);
    EOS_ASSERT(success, wasm_execution_error, "failed to read response from monitor process");
    EOS_ASSERT(std::holds_alternative<wasm_compilation_result_message>(message), wasm_execution_error, "unexpected response from monitor process");
 
    wasm_compilation_result_message result = std::get<wasm_compilation_result_message>(message);
    EOS_ASSERT(std::holds_alternative<code_descriptor>(result.result), wasm_execution_error, "failed to compile wasm");
+   record_function_table(result, fds);
 
    check_eviction_threshold(result.cache_free_bytes);
 
@@ -223,12 +297,18 @@ const code_descriptor* const code_cache_sync::get_descriptor_for_code_sync(const
 }
 
 code_cache_base::code_cache_base(const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config ) :
-   _cache_file_path(data_dir/"code_cache.bin")
+   _cache_file_path(data_dir/"code_cache.bin"),
+   _function_tables_path(data_dir/"code_cache_functions.bin")
 {
    static_assert(sizeof(allocator_t) <= header_offset, "header offset intersects with allocator");
 
    bfs::create_directories(data_dir);
 
+   sampling_profiler& profiler = sampling_profiler::instance();
+   profiler.start(eosvmoc_config.profile_hz);
+   if(profiler.enabled())
+      profiler.load_function_tables(_function_tables_path);
+
    if(!bfs::exists(_cache_file_path)) {
       EOS_ASSERT(eosvmoc_config.cache_size >= allocator_t::get_min_size(total_header_size), database_exception, "configured code cache size is too small");
       std::ofstream ofs(_cache_file_path.generic_string(), std::ofstream::trunc);
@@ -284,6 +364,7 @@ code_cache_base::code_cache_base(const boost::filesystem::path data_dir, const e
          if(cd.codegen_version != current_codegen_version) {
             allocator->deallocate(code_mapping + cd.code_begin);
             allocator->deallocate(code_mapping + cd.initdata_begin);
+            sampling_profiler::instance().erase_function_table(cd.code_hash, cd.vm_version);
             continue;
          }
          _cache_index.push_back(std::move(cd));
@@ -314,6 +395,21 @@ void code_cache_base::set_on_disk_region_dirty(bool dirty) {
       elog("Syncing code cache failed");
 }
 
+void code_cache_base::record_function_table(const wasm_compilation_result_message& result, const std::vector<wrapped_fd>& fds) {
+   sampling_profiler& profiler = sampling_profiler::instance();
+   if(!profiler.enabled() || fds.empty() || !std::holds_alternative<code_descriptor>(result.result))
+      return;
+   try {
+      std::vector<uint8_t> packed = vector_for_memfd(fds[0]);
+      fc::datastream<const char*> ds((const char*)packed.data(), packed.size());
+      function_table table;
+      fc::raw::unpack(ds, table.offsets);
+      fc::raw::unpack(ds, table.indices);
+      if(table.offsets.size() == table.indices.size())
+         profiler.set_function_table(result.code.code_id, result.code.vm_version, std::move(table));
+   } FC_LOG_AND_DROP(("EOS VM OC function table ERROR"));
+}
+
 template <typename T>
 void code_cache_base::serialize_cache_index(fc::datastream<T>& ds) {
    unsigned entries = _cache_index.size();
@@ -367,6 +463,9 @@ code_cache_base::~code_cache_base() {
    close(_cache_fd);
    set_on_disk_region_dirty(false);
 
+   if(sampling_profiler::instance().enabled())
+      sampling_profiler::instance().save_function_tables(_function_tables_path);
+
 }
 
 void code_cache_base::free_code(const digest_type& code_id, const uint8_t& vm_version) {
@@ -374,23 +473,25 @@ void code_cache_base::free_code(const digest_type& code_id, const uint8_t& vm_ve
    if(it != _cache_index.get<by_hash>().end()) {
       write_message_with_fds(_compile_monitor_write_socket, evict_wasms_message{ {*it} });
       _cache_index.get<by_hash>().erase(it);
+      sampling_profiler::instance().erase_function_table(code_id, vm_version);
    }
 
    //if it's in the queued list, erase it
-   _queued_compiles.erase({code_id, vm_version});
+   _queued_compiles.erase(code_tuple{code_id, vm_version});
 
    //however, if it's currently being compiled there is no way to cancel the compile,
    //so instead set a poison boolean that indicates not to insert the code in to the cache
    //once the compile is complete
-   const std::unordered_map<code_tuple, bool>::iterator compiling_it = _outstanding_compiles_and_poison.find({code_id, vm_version});
+   const auto compiling_it = _outstanding_compiles_and_poison.find({code_id, vm_version});
    if(compiling_it != _outstanding_compiles_and_poison.end())
-      compiling_it->second = true;
+      compiling_it->second.poison = true;
 }
 
 void code_cache_base::run_eviction_round() {
    evict_wasms_message evict_msg;
    for(unsigned int i = 0; i < 25 && _cache_index.size() > 1; ++i) {
       evict_msg.codes.emplace_back(_cache_index.back());
+      sampling_profiler::instance().erase_function_table(_cache_index.back().code_hash, _cache_index.back().vm_version);
       _cache_index.pop_back();
    }
    write_message_with_fds(_compile_monitor_write_socket, evict_msg);
@@ -71,7 +71,7 @@ struct compile_monitor_session {
                   connection_dead_signal();
                   return;
                }
-               kick_compile_off(compile.code, std::move(fds[0]));
+               kick_compile_off(compile.code, compile.with_function_table, std::move(fds[0]));
             },
             [&](const evict_wasms_message& evict) {
                for(const code_descriptor& cd : evict.codes) {
@@ -90,7 +90,7 @@ struct compile_monitor_session {
       });
    }
 
-   void kick_compile_off(const code_tuple& code_id, wrapped_fd&& wasm_code) {
+   void kick_compile_off(const code_tuple& code_id, bool with_function_table, wrapped_fd&& wasm_code) {
       //prepare a requst to go out to the trampoline
       int socks[2];
       socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, socks);
@@ -100,7 +100,7 @@ struct compile_monitor_session {
       fds_pass_to_trampoline.emplace_back(socks[1]);
       fds_pass_to_trampoline.emplace_back(std::move(wasm_code));
 
-      eosvmoc_message trampoline_compile_request = compile_wasm_message{code_id};
+      eosvmoc_message trampoline_compile_request = compile_wasm_message{code_id, with_function_table};
       if(write_message_with_fds(_trampoline_socket, trampoline_compile_request, fds_pass_to_trampoline) == false) {
          wasm_compilation_result_message reply{code_id, compilation_result_unknownfailure{}, _allocator->get_free_memory()};
          write_message_with_fds(_nodeos_instance_socket, reply);
@@ -122,8 +122,9 @@ struct compile_monitor_session {
          
          void* code_ptr = nullptr;
          void* mem_ptr = nullptr;
+         std::vector<wrapped_fd> fds_to_pass;
          try {
-            if(success && std::holds_alternative<code_compilation_result_message>(message) && fds.size() == 2) {
+            if(success && std::holds_alternative<code_compilation_result_message>(message) && fds.size() >= 2) {
                code_compilation_result_message& result = std::get<code_compilation_result_message>(message);
                code_ptr = _allocator->allocate(get_size_of_fd(fds[0]));
                mem_ptr = _allocator->allocate(get_size_of_fd(fds[1]));
@@ -149,6 +150,9 @@ struct compile_monitor_session {
                      (unsigned)get_size_of_fd(fds[1]),
                      result.initdata_prologue_size
                   };
+                  //the function table only matters to the profiler in nodeos, pass it along as is
+                  if(fds.size() > 2)
+                     fds_to_pass.emplace_back(std::move(fds[2]));
                }
             }
          }
@@ -157,7 +161,7 @@ struct compile_monitor_session {
             _allocator->deallocate(mem_ptr);
          }
 
-         write_message_with_fds(_nodeos_instance_socket, reply);
+         write_message_with_fds(_nodeos_instance_socket, reply, fds_to_pass);
 
          //either way, we are done
          _ctx.post([this, current_compile_it]() {
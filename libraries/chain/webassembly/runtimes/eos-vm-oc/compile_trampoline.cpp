@@ -2,6 +2,7 @@
 #include <eosio/chain/webassembly/eos-vm-oc/ipc_protocol.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/memory.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/intrinsic.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/profiler.hpp>
 #include <eosio/chain/wasm_eosio_injection.hpp>
 
 #include <sys/prctl.h>
@@ -17,7 +18,7 @@ using namespace IR;
 
 namespace eosio { namespace chain { namespace eosvmoc {
 
-void run_compile(wrapped_fd&& response_sock, wrapped_fd&& wasm_code) noexcept {  //noexcept; we'll just blow up if anything tries to cross this boundry
+void run_compile(wrapped_fd&& response_sock, wrapped_fd&& wasm_code, bool with_function_table) noexcept {  //noexcept; we'll just blow up if anything tries to cross this boundry
    std::vector<uint8_t> wasm = vector_for_memfd(wasm_code);
 
    //ideally we catch exceptions and sent them upstream as strings for easier reporting
@@ -133,6 +134,21 @@ void run_compile(wrapped_fd&& response_sock, wrapped_fd&& wasm_code) noexcept {
    std::vector<wrapped_fd> fds_to_send;
    fds_to_send.emplace_back(memfd_for_bytearray(code.code));
    fds_to_send.emplace_back(memfd_for_bytearray(initdata_prep));
+
+   if(with_function_table) {
+      //start of every function in the code ordered by offset, for attributing profiler samples to wasm functions
+      std::vector<std::pair<uintptr_t, unsigned>> function_starts;
+      function_starts.reserve(function_to_offsets.size());
+      for(const auto& [def_index, offset] : function_to_offsets)
+         function_starts.emplace_back(offset, def_index + module.functions.imports.size());
+      std::sort(function_starts.begin(), function_starts.end());
+      function_table functions;
+      for(const auto& [offset, index] : function_starts) {
+         functions.offsets.push_back(offset);
+         functions.indices.push_back(index);
+      }
+      fds_to_send.emplace_back(memfd_for_bytearray(fc::raw::pack(functions.offsets, functions.indices)));
+   }
    write_message_with_fds(response_sock, result_message, fds_to_send);
 }
 
@@ -174,7 +190,7 @@ void run_compile_trampoline(int fd) {
          struct rlimit core_limits = {0u, 0u};
          setrlimit(RLIMIT_CORE, &core_limits);
 
-         run_compile(std::move(fds[0]), std::move(fds[1]));
+         run_compile(std::move(fds[0]), std::move(fds[1]), std::get<compile_wasm_message>(message).with_function_table);
          _exit(0);
       }
       else if(pid == -1)
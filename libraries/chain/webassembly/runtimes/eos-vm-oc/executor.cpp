@@ -3,6 +3,7 @@
 #include <eosio/chain/webassembly/eos-vm-oc/memory.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/intrinsic_mapping.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/intrinsic.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/profiler.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/eos-vm-oc.h>
 #include <eosio/chain/wasm_eosio_constraints.hpp>
 #include <eosio/chain/apply_context.hpp>
@@ -147,6 +148,8 @@ executor::executor(const code_cache_base& cc) {
    FC_ASSERT(code_mapping != MAP_FAILED, "failed to map code cache in to executor");
    code_mapping_size = s.st_size;
    mapping_is_executable = true;
+
+   sampling_profiler::instance().thread_init();
 }
 
 void executor::execute(const code_descriptor& code, memory& mem, apply_context& context) {
@@ -218,7 +221,18 @@ void executor::execute(const code_descriptor& code, memory& mem, apply_context&
    }, this);
    context.trx_context.checktime(); //catch any expiration that might have occurred before setting up callback
 
-   auto cleanup = fc::make_scoped_exit([cb, &tt=context.trx_context.transaction_timer, &mem=mem](){
+   sampling_profiler& profiler = sampling_profiler::instance();
+   const bool profiling = profiler.enabled();
+   if(profiling) {
+      // the size of the code's own allocation, so samples in other modules' code count as host time; it exceeds the
+      // compiled code only by the allocator's alignment padding
+      const uint64_t code_length = reinterpret_cast<const allocator_t*>(code_mapping)->size(code_mapping + code.code_begin);
+      profiler.begin_execution(code, cb->running_code_base, code_length, context.get_receiver(), context.get_action().name);
+   }
+
+   auto cleanup = fc::make_scoped_exit([cb, &tt=context.trx_context.transaction_timer, &mem=mem, &profiler, profiling](){
+      if(profiling)
+         profiler.end_execution();
       cb->is_running = false;
       cb->bounce_buffers->clear();
       tt.set_expiration_callback(nullptr, nullptr);
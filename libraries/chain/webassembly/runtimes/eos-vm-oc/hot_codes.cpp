@@ -0,0 +1,117 @@
+#include <eosio/chain/webassembly/eos-vm-oc/hot_codes.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+#include <fstream>
+#include <functional>
+
+namespace eosio { namespace chain { namespace eosvmoc {
+
+static constexpr uint64_t hot_codes_id = 0x31544f484f4d5645ULL; //"EVMOHOT1" little endian
+
+namespace {
+//descending by uses, the first n of @p v end up most used first
+void sort_most_used(std::vector<std::pair<code_tuple, uint64_t>>& v, size_t n) {
+   n = std::min(n, v.size());
+   std::partial_sort(v.begin(), v.begin() + n, v.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+   v.resize(n);
+}
+}
+
+hot_codes::hot_codes(size_t hot) : _hot(hot) {}
+
+void hot_codes::record_use(const code_tuple& ct) {
+   auto [it, inserted] = _uses.try_emplace(ct, 0);
+   ++it->second;
+   if(inserted && _uses.size() > max_tracked())
+      trim();
+   else if(++_lookups_since_refresh >= refresh_interval || (inserted && _uses.size() == _hot + 1))
+      refresh_threshold();
+}
+
+bool hot_codes::is_hot(const code_tuple& ct) const {
+   if(!_hot)
+      return false;
+   auto it = _uses.find(ct);
+   return it != _uses.end() && it->second >= _threshold;
+}
+
+uint64_t hot_codes::uses(const code_tuple& ct) const {
+   auto it = _uses.find(ct);
+   return it == _uses.end() ? 0 : it->second;
+}
+
+void hot_codes::inherit(const code_tuple& from, const code_tuple& to) {
+   const uint64_t from_uses = uses(from);
+   auto [it, inserted] = _uses.try_emplace(to, from_uses);
+   it->second = std::max(it->second, from_uses);
+   if(inserted && _uses.size() > max_tracked())
+      trim();
+   else if(inserted && _uses.size() == _hot + 1)
+      refresh_threshold();
+}
+
+std::vector<std::pair<code_tuple, uint64_t>> hot_codes::most_used() const {
+   std::vector<std::pair<code_tuple, uint64_t>> hot(_uses.begin(), _uses.end());
+   sort_most_used(hot, _hot);
+   return hot;
+}
+
+void hot_codes::trim() {
+   std::vector<std::pair<code_tuple, uint64_t>> kept(_uses.begin(), _uses.end());
+   sort_most_used(kept, max_tracked() / 2);
+   _uses = std::unordered_map<code_tuple, uint64_t>(kept.begin(), kept.end());
+   refresh_threshold();
+}
+
+void hot_codes::refresh_threshold() {
+   _lookups_since_refresh = 0;
+   if(!_hot || _uses.size() <= _hot) {
+      _threshold = 0;
+      return;
+   }
+   std::vector<uint64_t> counts;
+   counts.reserve(_uses.size());
+   for(const auto& [_, uses] : _uses)
+      counts.push_back(uses);
+   std::nth_element(counts.begin(), counts.begin() + (_hot - 1), counts.end(), std::greater<>());
+   _threshold = counts[_hot - 1];
+}
+
+std::vector<code_tuple> hot_codes::load(const boost::filesystem::path& file) {
+   std::vector<code_tuple> loaded;
+   std::ifstream ifs(file.generic_string(), std::ifstream::binary);
+   if(!ifs.good())
+      return loaded;
+   std::vector<char> buff((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+   fc::datastream<const char*> ds(buff.data(), buff.size());
+   uint64_t id;
+   std::vector<std::pair<code_tuple, uint64_t>> hot;
+   fc::raw::unpack(ds, id);
+   if(id != hot_codes_id) {
+      wlog("ignoring EOS VM OC hot code list ${p} of an unknown version", ("p", file));
+      return loaded;
+   }
+   fc::raw::unpack(ds, hot);
+   sort_most_used(hot, _hot);
+
+   _uses = std::unordered_map<code_tuple, uint64_t>(hot.begin(), hot.end());
+   refresh_threshold();
+   loaded.reserve(hot.size());
+   for(const auto& [ct, _] : hot)
+      loaded.push_back(ct);
+   return loaded;
+}
+
+void hot_codes::save(const boost::filesystem::path& file) const {
+   std::ofstream ofs(file.generic_string(), std::ofstream::binary | std::ofstream::trunc);
+   auto data = fc::raw::pack(hot_codes_id);
+   auto list = fc::raw::pack(most_used());
+   ofs.write(data.data(), data.size());
+   ofs.write(list.data(), list.size());
+   if(!ofs.good())
+      elog("unable to write EOS VM OC hot code list ${p}", ("p", file));
+}
+
+}}}
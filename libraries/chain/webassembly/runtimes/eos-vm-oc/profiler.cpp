@@ -0,0 +1,343 @@
+#include <eosio/chain/webassembly/eos-vm-oc/profiler.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/eos-vm-oc.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#include <signal.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace eosio { namespace chain { namespace eosvmoc {
+
+namespace {
+
+constexpr size_t   max_samples_per_execution = 4096;
+constexpr uint64_t function_tables_id        = 0x31534e464d564f45ULL; //"EOVMFNS1" little endian
+
+// Written by the SIGPROF handler of its own thread. Only raw values are kept: a trivially constructible thread_local
+// is zero initialized with the thread's storage, so the handler never goes through a lazy initialization wrapper.
+struct thread_sampler {
+   volatile sig_atomic_t running;
+   uintptr_t             code_begin;
+   uintptr_t             code_end;
+   uint32_t              count;
+   uint64_t              dropped;
+   uint32_t              pc_offsets[max_samples_per_execution];
+
+   char                  code_hash[sizeof(digest_type)];
+   uint8_t               vm_version;
+   uint64_t              receiver;
+   uint64_t              action;
+};
+static_assert(std::is_trivially_default_constructible_v<thread_sampler> && std::is_trivially_destructible_v<thread_sampler>);
+thread_local thread_sampler sampler;
+
+struct thread_timer {
+   bool    armed = false;
+   timer_t timer;
+   ~thread_timer() {
+      if(armed)
+         timer_delete(timer);
+   }
+};
+
+struct sigaction chained_action;
+
+void sigprof_handler(int sig, siginfo_t* info, void* ctx) {
+   thread_sampler& s = sampler;
+   if(!s.running) {
+      if(chained_action.sa_flags & SA_SIGINFO)
+         chained_action.sa_sigaction(sig, info, ctx);
+      else if(chained_action.sa_handler != SIG_IGN && chained_action.sa_handler != SIG_DFL)
+         chained_action.sa_handler(sig);
+      return;
+   }
+   if(s.count == max_samples_per_execution) {
+      ++s.dropped;
+      return;
+   }
+   const uintptr_t pc = static_cast<ucontext_t*>(ctx)->uc_mcontext.gregs[REG_RIP];
+   s.pc_offsets[s.count++] = (pc >= s.code_begin && pc < s.code_end) ? static_cast<uint32_t>(pc - s.code_begin)
+                                                                     : sampling_profiler::host_pc_offset;
+}
+
+// minimal protobuf encoder for the pprof profile
+struct pb_writer {
+   std::vector<char> buf;
+
+   void varint(uint64_t v) {
+      while(v >= 0x80) {
+         buf.push_back(static_cast<char>(v | 0x80));
+         v >>= 7;
+      }
+      buf.push_back(static_cast<char>(v));
+   }
+   void uint(uint32_t field, uint64_t v) {
+      varint(field << 3);
+      varint(v);
+   }
+   void bytes(uint32_t field, const char* d, size_t n) {
+      varint((field << 3) | 2);
+      varint(n);
+      buf.insert(buf.end(), d, d + n);
+   }
+   void message(uint32_t field, const pb_writer& m) { bytes(field, m.buf.data(), m.buf.size()); }
+   void packed(uint32_t field, const std::vector<uint64_t>& values) {
+      pb_writer p;
+      for(uint64_t v : values)
+         p.varint(v);
+      message(field, p);
+   }
+};
+
+}
+
+int64_t function_table::function_at(uint32_t offset) const {
+   auto it = std::upper_bound(offsets.begin(), offsets.end(), offset);
+   if(it == offsets.begin())
+      return -1;
+   return indices[it - offsets.begin() - 1];
+}
+
+sampling_profiler& sampling_profiler::instance() {
+   static sampling_profiler the_profiler;
+   return the_profiler;
+}
+
+void sampling_profiler::start(uint32_t sample_hz) {
+   if(!sample_hz || _sample_hz)
+      return;
+   struct sigaction sig_action;
+   sig_action.sa_sigaction = sigprof_handler;
+   sigemptyset(&sig_action.sa_mask);
+   sig_action.sa_flags = SA_SIGINFO | SA_RESTART;
+   FC_ASSERT(sigaction(SIGPROF, &sig_action, &chained_action) == 0, "unable to install EOS VM OC profiler signal handler");
+   _sample_hz = sample_hz;
+   ilog("EOS VM OC sampling profiler enabled at ${hz} Hz of CPU time per executing thread", ("hz", sample_hz));
+}
+
+void sampling_profiler::thread_init() {
+   if(!enabled())
+      return;
+   static thread_local thread_timer tt;
+   if(tt.armed)
+      return;
+   sampler.running = 0;
+
+   struct sigevent sev = {};
+   sev.sigev_notify = SIGEV_THREAD_ID;
+   sev.sigev_signo = SIGPROF;
+   sev.sigev_notify_thread_id = syscall(SYS_gettid);
+   if(timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &tt.timer)) {
+      wlog("unable to create EOS VM OC profiler timer, error: ${e}", ("e", errno));
+      return;
+   }
+   tt.armed = true;
+
+   struct itimerspec its = {};
+   its.it_interval.tv_sec  = 1 / _sample_hz;
+   its.it_interval.tv_nsec = (1000000000ull / _sample_hz) % 1000000000;
+   its.it_value = its.it_interval;
+   if(timer_settime(tt.timer, 0, &its, nullptr))
+      wlog("unable to arm EOS VM OC profiler timer, error: ${e}", ("e", errno));
+}
+
+void sampling_profiler::begin_execution(const code_descriptor& code, uintptr_t code_base, uint64_t code_length,
+                                        account_name receiver, action_name action) {
+   thread_sampler& s = sampler;
+   s.code_begin = code_base;
+   s.code_end   = code_base + code_length;
+   s.count      = 0;
+   s.dropped    = 0;
+   memcpy(s.code_hash, code.code_hash.data(), sizeof(s.code_hash));
+   s.vm_version = code.vm_version;
+   s.receiver   = receiver.to_uint64_t();
+   s.action     = action.to_uint64_t();
+   std::atomic_signal_fence(std::memory_order_seq_cst);
+   s.running = 1;
+   std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+void sampling_profiler::end_execution() {
+   thread_sampler& s = sampler;
+   s.running = 0;
+   std::atomic_signal_fence(std::memory_order_seq_cst);
+   if(s.count || s.dropped)
+      aggregate(digest_type(s.code_hash, sizeof(s.code_hash)), s.vm_version, account_name(s.receiver), action_name(s.action),
+                s.pc_offsets, s.count, s.dropped);
+}
+
+void sampling_profiler::aggregate(const digest_type& code_hash, uint8_t vm_version, account_name receiver, action_name action,
+                                  const uint32_t* pc_offsets, size_t count, uint64_t dropped) {
+   std::lock_guard g(_mtx);
+   auto table_it = _function_tables.find(function_key{code_hash, vm_version});
+   const function_table* table = table_it == _function_tables.end() ? nullptr : table_it->second.get();
+   for(size_t i = 0; i < count; ++i) {
+      const int64_t function_index = (pc_offsets[i] == host_pc_offset || !table) ? -1 : table->function_at(pc_offsets[i]);
+      ++_samples[sample_key{receiver, action, code_hash, function_index}];
+   }
+   _total_samples += count;
+   _dropped_samples += dropped;
+}
+
+void sampling_profiler::set_function_table(const digest_type& code_hash, uint8_t vm_version, function_table table) {
+   auto t = std::make_shared<const function_table>(std::move(table));
+   std::lock_guard g(_mtx);
+   _function_tables[function_key{code_hash, vm_version}] = std::move(t);
+}
+
+void sampling_profiler::erase_function_table(const digest_type& code_hash, uint8_t vm_version) {
+   std::lock_guard g(_mtx);
+   _function_tables.erase(function_key{code_hash, vm_version});
+}
+
+void sampling_profiler::load_function_tables(const boost::filesystem::path& file) {
+   try {
+      std::ifstream ifs(file.generic_string(), std::ifstream::binary);
+      if(!ifs.good())
+         return;
+      std::vector<char> buff((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+      fc::datastream<const char*> ds(buff.data(), buff.size());
+      uint64_t id;
+      fc::raw::unpack(ds, id);
+      if(id != function_tables_id)
+         return;
+      uint32_t entries;
+      fc::raw::unpack(ds, entries);
+      std::lock_guard g(_mtx);
+      for(uint32_t i = 0; i < entries; ++i) {
+         digest_type code_hash;
+         uint8_t vm_version;
+         function_table table;
+         fc::raw::unpack(ds, code_hash);
+         fc::raw::unpack(ds, vm_version);
+         fc::raw::unpack(ds, table.offsets);
+         fc::raw::unpack(ds, table.indices);
+         if(table.offsets.size() == table.indices.size())
+            _function_tables[function_key{code_hash, vm_version}] = std::make_shared<const function_table>(std::move(table));
+      }
+   } FC_LOG_AND_DROP(("EOS VM OC function tables load ERROR"));
+}
+
+void sampling_profiler::save_function_tables(const boost::filesystem::path& file) const {
+   try {
+      std::lock_guard g(_mtx);
+      std::ofstream ofs(file.generic_string(), std::ofstream::binary | std::ofstream::trunc);
+      auto write = [&](const auto& v) {
+         auto data = fc::raw::pack(v);
+         ofs.write(data.data(), data.size());
+      };
+      write(function_tables_id);
+      write(static_cast<uint32_t>(_function_tables.size()));
+      for(const auto& [key, table] : _function_tables) {
+         write(std::get<0>(key));
+         write(std::get<1>(key));
+         write(table->offsets);
+         write(table->indices);
+      }
+   } FC_LOG_AND_DROP(("EOS VM OC function tables save ERROR"));
+}
+
+profile_report sampling_profiler::report(size_t limit, bool reset) {
+   profile_report r;
+   {
+      std::lock_guard g(_mtx);
+      r.sample_hz       = _sample_hz;
+      r.total_samples   = _total_samples;
+      r.dropped_samples = _dropped_samples;
+      r.entries.reserve(_samples.size());
+      for(const auto& [key, samples] : _samples)
+         r.entries.push_back(profile_entry{std::get<0>(key), std::get<1>(key), std::get<2>(key), std::get<3>(key), samples});
+      if(reset) {
+         _samples.clear();
+         _total_samples = _dropped_samples = 0;
+         _profile_start = fc::time_point::now();
+      }
+   }
+   std::stable_sort(r.entries.begin(), r.entries.end(), [](const auto& a, const auto& b) { return a.samples > b.samples; });
+   if(limit && r.entries.size() > limit)
+      r.entries.resize(limit);
+   return r;
+}
+
+std::vector<char> sampling_profiler::pprof(bool reset) {
+   // every sample is a two frame stack: the wasm function, called by the receiver::action it ran for
+   fc::time_point start;
+   {
+      std::lock_guard g(_mtx);
+      start = _profile_start;
+   }
+   const profile_report r = report(0, reset);
+   const uint64_t period_ns = r.sample_hz ? 1000000000u / r.sample_hz : 0;
+
+   std::vector<std::string> strings{""};
+   std::map<std::string, uint64_t> string_ids{{"", 0}};
+   auto str = [&](const std::string& s) {
+      auto [it, inserted] = string_ids.emplace(s, strings.size());
+      if(inserted)
+         strings.push_back(s);
+      return it->second;
+   };
+   auto value_type = [&](const char* type, const char* unit) {
+      pb_writer vt;
+      vt.uint(1, str(type));
+      vt.uint(2, str(unit));
+      return vt;
+   };
+
+   pb_writer profile;
+   profile.message(1, value_type("samples", "count"));
+   profile.message(1, value_type("cpu", "nanoseconds"));
+
+   // functions and locations share ids, one location per function
+   std::map<std::pair<std::string, std::string>, uint64_t> function_ids;
+   auto function_id = [&](const std::string& name, const std::string& file) {
+      auto [it, inserted] = function_ids.emplace(std::make_pair(name, file), function_ids.size() + 1);
+      if(inserted) {
+         pb_writer f;
+         f.uint(1, it->second);
+         f.uint(2, str(name));
+         f.uint(3, str(name));
+         f.uint(4, str(file));
+         profile.message(5, f);
+
+         pb_writer line;
+         line.uint(1, it->second);
+         pb_writer loc;
+         loc.uint(1, it->second);
+         loc.message(4, line);
+         profile.message(4, loc);
+      }
+      return it->second;
+   };
+
+   for(const profile_entry& e : r.entries) {
+      const std::string code = e.code_hash.str();
+      const std::string fn = e.function_index < 0 ? std::string("[host]")
+                                                  : "wasm-function[" + std::to_string(e.function_index) + "]";
+      pb_writer sample;
+      sample.packed(1, {function_id(fn, code), function_id(e.receiver.to_string() + "::" + e.action.to_string(), "")});
+      sample.packed(2, {e.samples, e.samples * period_ns});
+      profile.message(2, sample);
+   }
+
+   const fc::time_point now = fc::time_point::now();
+   profile.uint(9, start.time_since_epoch().count() * 1000);
+   profile.uint(10, (now - start).count() * 1000);
+   profile.message(11, value_type("cpu", "nanoseconds"));
+   profile.uint(12, period_ns);
+   for(const std::string& s : strings)
+      profile.bytes(6, s.data(), s.size());
+   return std::move(profile.buf);
+}
+
+}}}
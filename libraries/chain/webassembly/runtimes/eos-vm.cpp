@@ -124,13 +124,14 @@ class eos_vm_instantiated_module : public wasm_instantiated_module_interface {
    using backend_t = eos_vm_backend_t<Impl>;
    public:
 
-      eos_vm_instantiated_module(eos_vm_runtime<Impl>* runtime, std::unique_ptr<backend_t> mod) :
-         _runtime(runtime),
-         _instantiated_module(std::move(mod)) {}
+      explicit eos_vm_instantiated_module(std::unique_ptr<backend_t> mod) :
+         _instantiated_module(std::move(mod)) {
+         const auto& memories = _instantiated_module->get_module().memories;
+         _initial_pages = memories.size() ? memories[0].limits.initial : 0;
+      }
 
       void apply(apply_context& context) override {
-         _instantiated_module->set_wasm_allocator(&context.control.get_wasm_allocator());
-         _runtime->_bkend = _instantiated_module.get();
+         _instantiated_module->set_wasm_allocator(&context.control.get_wasm_allocator(_initial_pages));
          apply_options opts;
          if(context.control.is_builtin_activated(builtin_protocol_feature_t::configurable_wasm_limits)) {
             const wasm_config& config = context.control.get_global_properties().wasm_configuration;
@@ -138,8 +139,8 @@ class eos_vm_instantiated_module : public wasm_instantiated_module_interface {
          }
          auto fn = [&]() {
             eosio::chain::webassembly::interface iface(context);
-            _runtime->_bkend->initialize(&iface, opts);
-            _runtime->_bkend->call(
+            _instantiated_module->initialize(&iface, opts);
+            _instantiated_module->call(
                 iface, "env", "apply",
                 context.get_receiver().to_uint64_t(),
                 context.get_action().account.to_uint64_t(),
@@ -147,7 +148,7 @@ class eos_vm_instantiated_module : public wasm_instantiated_module_interface {
          };
          try {
             checktime_watchdog wd(context.trx_context.transaction_timer);
-            _runtime->_bkend->timed_run(wd, fn);
+            _instantiated_module->timed_run(wd, fn);
          } catch(eosio::vm::timeout_exception&) {
             context.trx_context.checktime();
          } catch(eosio::vm::wasm_memory_exception& e) {
@@ -155,12 +156,11 @@ class eos_vm_instantiated_module : public wasm_instantiated_module_interface {
          } catch(eosio::vm::exception& e) {
             FC_THROW_EXCEPTION(wasm_execution_error, "eos-vm system failure");
          }
-         _runtime->_bkend = nullptr;
       }
 
    private:
-      eos_vm_runtime<Impl>*            _runtime;
       std::unique_ptr<backend_t> _instantiated_module;
+      uint32_t                   _initial_pages = 0;
 };
 
 #ifdef __x86_64__
@@ -245,7 +245,7 @@ std::unique_ptr<wasm_instantiated_module_interface> eos_vm_runtime<Impl>::instan
                                 .max_call_depth = 0 };
       std::unique_ptr<backend_t> bkend = std::make_unique<backend_t>(code, code_size, nullptr, options, false); // uses 2-passes parsing
       eos_vm_host_functions_t::resolve(bkend->get_module());
-      return std::make_unique<eos_vm_instantiated_module<Impl>>(this, std::move(bkend));
+      return std::make_unique<eos_vm_instantiated_module<Impl>>(std::move(bkend));
    } catch(eosio::vm::exception& e) {
       FC_THROW_EXCEPTION(wasm_execution_error, "Error building eos-vm interp: ${e}", ("e", e.what()));
    }
@@ -697,6 +697,25 @@ REGISTER_CF_HOST_FUNCTION( blake2_f );
 REGISTER_CF_HOST_FUNCTION( sha3 );
 REGISTER_CF_HOST_FUNCTION( k1_recover );
 
+// bulk_table_scan protocol feature
+REGISTER_HOST_FUNCTION( db_next_batch_i64 );
+REGISTER_HOST_FUNCTION( db_idx64_next_batch );
+REGISTER_HOST_FUNCTION( db_idx128_next_batch );
+REGISTER_HOST_FUNCTION( db_idx256_next_batch );
+REGISTER_HOST_FUNCTION( db_idx_double_next_batch );
+REGISTER_HOST_FUNCTION( db_idx_long_double_next_batch );
+REGISTER_HOST_FUNCTION( shared_db_next_batch_i64 );
+REGISTER_HOST_FUNCTION( shared_db_idx64_next_batch );
+REGISTER_HOST_FUNCTION( shared_db_idx128_next_batch );
+REGISTER_HOST_FUNCTION( shared_db_idx256_next_batch );
+REGISTER_HOST_FUNCTION( shared_db_idx_double_next_batch );
+REGISTER_HOST_FUNCTION( shared_db_idx_long_double_next_batch );
+
+// batched_crypto protocol feature
+REGISTER_CF_HOST_FUNCTION( sha256_batch );
+REGISTER_CF_HOST_FUNCTION( recover_key_batch );
+REGISTER_CF_HOST_FUNCTION( verify_signature_batch );
+
 } // namespace webassembly
 } // namespace chain
 } // namespace eosio
@@ -30,6 +30,13 @@ class sha256
     static sha256 hash( const string& );
     static sha256 hash( const sha256& );
 
+    /**
+     * Hashes @p count independent 64 byte inputs stored back to back at @p in, out[i] = hash( in + 64 * i, 64 ).
+     * Uses multi-buffer SHA-NI or AVX2 kernels when the cpu supports them, intended for merkle trees where
+     * every node is the hash of two concatenated digests. @p out must not overlap @p in.
+     */
+    static void hash_64_byte_batch( const char* in, size_t count, sha256* out );
+
     template<typename T>
     static sha256 hash( const T& t ) 
     { 
@@ -5,6 +5,9 @@
 #include <ios>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
 
 #include <boost/interprocess/file_mapping.hpp>
 
@@ -179,6 +182,55 @@ public:
       flush();
    }
 
+   //copies n bytes starting at src_offset of src to dest_offset of this file; the kernel copies the data without
+   //going through user space where supported (copy_file_range), otherwise it falls back to pread/pwrite.
+   //Neither file position is used nor changed, so distinct ranges of the same files can be copied concurrently.
+   //Any data buffered for writing in this file must have been flushed first.
+   void copy_range_from(const cfile& src, uint64_t src_offset, uint64_t dest_offset, uint64_t n) {
+      const int in_fd  = src.fileno();
+      const int out_fd = fileno();
+#if defined(__linux__)
+      while(n > 0) {
+         loff_t  in_off  = src_offset;
+         loff_t  out_off = dest_offset;
+         ssize_t copied  = copy_file_range(in_fd, &in_off, out_fd, &out_off, n, 0);
+         if(copied > 0) {
+            src_offset += copied;
+            dest_offset += copied;
+            n -= copied;
+            continue;
+         }
+         if(copied == -1 && errno == EINTR)
+            continue;
+         if(copied == 0 || errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)
+            break; // not supported between these files, copy the rest through user space
+         throw std::ios_base::failure( "cfile: " + _file_path.generic_string() + " unable to copy from " +
+                                       src._file_path.generic_string() + ", error: " + std::to_string( errno ) );
+      }
+#endif
+      std::vector<char> buf(std::min<uint64_t>(n, 4 * 1024 * 1024));
+      while(n > 0) {
+         ssize_t len = pread(in_fd, buf.data(), std::min<uint64_t>(n, buf.size()), src_offset);
+         if(len == -1 && errno == EINTR)
+            continue;
+         if(len <= 0)
+            throw std::ios_base::failure( "cfile: " + src._file_path.generic_string() + " unable to read " +
+                                          std::to_string( n ) + " bytes at " + std::to_string( src_offset ) );
+         for(ssize_t written = 0; written < len;) {
+            ssize_t w = pwrite(out_fd, buf.data() + written, len - written, dest_offset + written);
+            if(w == -1 && errno == EINTR)
+               continue;
+            if(w <= 0)
+               throw std::ios_base::failure( "cfile: " + _file_path.generic_string() + " unable to write " +
+                                             std::to_string( len - written ) + " bytes at " + std::to_string( dest_offset + written ) );
+            written += w;
+         }
+         src_offset += len;
+         dest_offset += len;
+         n -= len;
+      }
+   }
+
    static bool supports_hole_punching() {
 #if defined(__linux__) || defined(__APPLE__)
       return true;
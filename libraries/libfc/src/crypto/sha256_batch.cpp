@@ -0,0 +1,284 @@
+#include <fc/crypto/sha256.hpp>
+#include <openssl/sha.h>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FC_SHA256_BATCH_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+/**
+ * Multi-buffer SHA-256 of 64 byte inputs, the shape of every merkle node (two concatenated digests).
+ *
+ * A 64 byte message is exactly one data block followed by a padding block that is the same for every input, so
+ * the kernels below skip the generic init/update/final bookkeeping and hash several independent inputs at once:
+ *  - SHA-NI: two inputs interleaved so that the latency of one sha256rnds2 chain hides behind the other,
+ *  - AVX2: eight inputs, one per 32 bit lane, with the message schedule of the padding block precomputed,
+ *  - otherwise each input goes through OpenSSL one at a time.
+ * The kernel is chosen once from cpuid; all of them produce exactly what sha256::hash(in, 64) produces.
+ */
+
+namespace fc {
+
+namespace {
+
+constexpr size_t input_size = 64;
+
+constexpr uint32_t initial_state[8] = {
+   0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+alignas(16) constexpr uint32_t round_constants[64] = {
+   0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+   0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+   0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+   0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+   0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+   0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+   0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+   0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/// the second block of every 64 byte message: 0x80 terminator, zeros, message length of 512 bits
+alignas(16) constexpr uint8_t padding_block[input_size] = {
+   0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x02, 0
+};
+
+void hash_scalar( const char* in, size_t count, sha256* out ) {
+   for( size_t i = 0; i < count; ++i )
+      SHA256( reinterpret_cast<const uint8_t*>(in + i * input_size), input_size, reinterpret_cast<uint8_t*>(out[i].data()) );
+}
+
+#ifdef FC_SHA256_BATCH_X86
+
+inline uint32_t rotr( uint32_t x, int n ) { return (x >> n) | (x << (32 - n)); }
+
+/// K[t] + W[t] of the padding block, its message schedule does not depend on the input
+struct padding_schedule {
+   uint32_t kw[64];
+
+   padding_schedule() {
+      uint32_t w[64];
+      for( int t = 0; t < 16; ++t )
+         w[t] = uint32_t(padding_block[4*t]) << 24 | uint32_t(padding_block[4*t+1]) << 16 |
+                uint32_t(padding_block[4*t+2]) << 8 | uint32_t(padding_block[4*t+3]);
+      for( int t = 16; t < 64; ++t ) {
+         const uint32_t s0 = rotr(w[t-15], 7) ^ rotr(w[t-15], 18) ^ (w[t-15] >> 3);
+         const uint32_t s1 = rotr(w[t-2], 17) ^ rotr(w[t-2], 19) ^ (w[t-2] >> 10);
+         w[t] = w[t-16] + s0 + w[t-7] + s1;
+      }
+      for( int t = 0; t < 64; ++t )
+         kw[t] = round_constants[t] + w[t];
+   }
+};
+
+const padding_schedule& get_padding_schedule() {
+   static const padding_schedule schedule;
+   return schedule;
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+// SHA-NI, two inputs per call
+
+#define FC_TARGET_SHA __attribute__((target("sha,sse4.1")))
+
+/// runs one block through the compression function of each of the N states held in ABEF/CDGH order
+template<size_t N>
+FC_TARGET_SHA inline void sha_ni_compress( __m128i (&abef)[N], __m128i (&cdgh)[N], const uint8_t* const (&blocks)[N] ) {
+   const __m128i bswap_mask = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+   __m128i abef_save[N], cdgh_save[N], w[N][4];
+
+   for( size_t n = 0; n < N; ++n ) {
+      abef_save[n] = abef[n];
+      cdgh_save[n] = cdgh[n];
+   }
+   for( size_t j = 0; j < 16; ++j ) {
+      const __m128i k = _mm_load_si128( reinterpret_cast<const __m128i*>(round_constants + 4 * j) );
+      for( size_t n = 0; n < N; ++n ) {
+         __m128i& x = w[n][j % 4];
+         if( j < 4 ) {
+            x = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>(blocks[n] + 16 * j) ), bswap_mask );
+         } else {
+            // W[t] = s1(W[t-2]) + W[t-7] + s0(W[t-15]) + W[t-16] for four words at a time
+            const __m128i& prev1 = w[n][(j + 3) % 4];
+            const __m128i& prev2 = w[n][(j + 2) % 4];
+            const __m128i  t     = _mm_add_epi32( _mm_sha256msg1_epu32( x, w[n][(j + 1) % 4] ), _mm_alignr_epi8( prev1, prev2, 4 ) );
+            x = _mm_sha256msg2_epu32( t, prev1 );
+         }
+         __m128i msg = _mm_add_epi32( x, k );
+         cdgh[n] = _mm_sha256rnds2_epu32( cdgh[n], abef[n], msg );
+         msg     = _mm_shuffle_epi32( msg, 0x0E );
+         abef[n] = _mm_sha256rnds2_epu32( abef[n], cdgh[n], msg );
+      }
+   }
+   for( size_t n = 0; n < N; ++n ) {
+      abef[n] = _mm_add_epi32( abef[n], abef_save[n] );
+      cdgh[n] = _mm_add_epi32( cdgh[n], cdgh_save[n] );
+   }
+}
+
+template<size_t N>
+FC_TARGET_SHA void sha_ni_hash( const char* in, sha256* out ) {
+   const __m128i bswap_mask = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+   __m128i abef[N], cdgh[N];
+
+   const __m128i abcd = _mm_shuffle_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(initial_state) ), 0xB1 );
+   const __m128i efgh = _mm_shuffle_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(initial_state + 4) ), 0x1B );
+   for( size_t n = 0; n < N; ++n ) {
+      abef[n] = _mm_alignr_epi8( abcd, efgh, 8 );
+      cdgh[n] = _mm_blend_epi16( efgh, abcd, 0xF0 );
+   }
+
+   const uint8_t* data[N];
+   const uint8_t* padding[N];
+   for( size_t n = 0; n < N; ++n ) {
+      data[n]    = reinterpret_cast<const uint8_t*>(in + n * input_size);
+      padding[n] = padding_block;
+   }
+   sha_ni_compress<N>( abef, cdgh, data );
+   sha_ni_compress<N>( abef, cdgh, padding );
+
+   for( size_t n = 0; n < N; ++n ) {
+      const __m128i feba = _mm_shuffle_epi32( abef[n], 0x1B );
+      const __m128i dchg = _mm_shuffle_epi32( cdgh[n], 0xB1 );
+      const __m128i dcba = _mm_blend_epi16( feba, dchg, 0xF0 );
+      const __m128i hgfe = _mm_alignr_epi8( dchg, feba, 8 );
+      char* dest = out[n].data();
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(dest),      _mm_shuffle_epi8( dcba, bswap_mask ) );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(dest + 16), _mm_shuffle_epi8( hgfe, bswap_mask ) );
+   }
+}
+
+void hash_sha_ni( const char* in, size_t count, sha256* out ) {
+   size_t i = 0;
+   for( ; i + 2 <= count; i += 2 )
+      sha_ni_hash<2>( in + i * input_size, out + i );
+   if( i < count )
+      sha_ni_hash<1>( in + i * input_size, out + i );
+}
+
+#undef FC_TARGET_SHA
+
+// ---------------------------------------------------------------------------------------------------------------
+// AVX2, eight inputs per call, one per 32 bit lane
+
+#define FC_TARGET_AVX2 __attribute__((target("avx2")))
+
+FC_TARGET_AVX2 inline __m256i rotr8( __m256i x, int n ) {
+   return _mm256_or_si256( _mm256_srli_epi32( x, n ), _mm256_slli_epi32( x, 32 - n ) );
+}
+
+FC_TARGET_AVX2 inline void avx2_round( __m256i (&s)[8], __m256i kw ) {
+   const __m256i& a = s[0]; const __m256i& b = s[1]; const __m256i& c = s[2]; const __m256i& d = s[3];
+   const __m256i& e = s[4]; const __m256i& f = s[5]; const __m256i& g = s[6]; const __m256i& h = s[7];
+
+   const __m256i s1  = _mm256_xor_si256( _mm256_xor_si256( rotr8( e, 6 ), rotr8( e, 11 ) ), rotr8( e, 25 ) );
+   const __m256i ch  = _mm256_xor_si256( _mm256_and_si256( e, f ), _mm256_andnot_si256( e, g ) );
+   const __m256i t1  = _mm256_add_epi32( _mm256_add_epi32( h, s1 ), _mm256_add_epi32( ch, kw ) );
+   const __m256i s0  = _mm256_xor_si256( _mm256_xor_si256( rotr8( a, 2 ), rotr8( a, 13 ) ), rotr8( a, 22 ) );
+   const __m256i maj = _mm256_or_si256( _mm256_and_si256( a, b ), _mm256_and_si256( c, _mm256_or_si256( a, b ) ) );
+   const __m256i t2  = _mm256_add_epi32( s0, maj );
+   const __m256i new_e = _mm256_add_epi32( d, t1 );
+   const __m256i new_a = _mm256_add_epi32( t1, t2 );
+
+   s[7] = g; s[6] = f; s[5] = e; s[4] = new_e;
+   s[3] = c; s[2] = b; s[1] = a; s[0] = new_a;
+}
+
+FC_TARGET_AVX2 void avx2_hash8( const char* in, sha256* out ) {
+   const __m256i bswap_mask = _mm256_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL,
+                                                 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+   const __m256i lane_offsets = _mm256_setr_epi32( 0, 64, 128, 192, 256, 320, 384, 448 );
+
+   __m256i s[8], w[16];
+   for( int i = 0; i < 8; ++i )
+      s[i] = _mm256_set1_epi32( initial_state[i] );
+
+   // data block, word t of every input lands in lane n of w[t]
+   for( int t = 0; t < 64; ++t ) {
+      __m256i& x = w[t % 16];
+      if( t < 16 ) {
+         x = _mm256_i32gather_epi32( reinterpret_cast<const int*>(in + 4 * t), lane_offsets, 1 );
+         x = _mm256_shuffle_epi8( x, bswap_mask );
+      } else {
+         const __m256i& w15 = w[(t - 15) % 16];
+         const __m256i& w2  = w[(t - 2) % 16];
+         const __m256i  s0  = _mm256_xor_si256( _mm256_xor_si256( rotr8( w15, 7 ), rotr8( w15, 18 ) ), _mm256_srli_epi32( w15, 3 ) );
+         const __m256i  s1  = _mm256_xor_si256( _mm256_xor_si256( rotr8( w2, 17 ), rotr8( w2, 19 ) ), _mm256_srli_epi32( w2, 10 ) );
+         x = _mm256_add_epi32( _mm256_add_epi32( x, s0 ), _mm256_add_epi32( w[(t - 7) % 16], s1 ) );
+      }
+      avx2_round( s, _mm256_add_epi32( x, _mm256_set1_epi32( round_constants[t] ) ) );
+   }
+   __m256i mid[8];
+   for( int i = 0; i < 8; ++i ) {
+      s[i]   = _mm256_add_epi32( s[i], _mm256_set1_epi32( initial_state[i] ) );
+      mid[i] = s[i];
+   }
+
+   // padding block
+   const padding_schedule& padding = get_padding_schedule();
+   for( int t = 0; t < 64; ++t )
+      avx2_round( s, _mm256_set1_epi32( padding.kw[t] ) );
+
+   alignas(32) uint32_t words[8][8];
+   for( int i = 0; i < 8; ++i )
+      _mm256_store_si256( reinterpret_cast<__m256i*>(words[i]), _mm256_shuffle_epi8( _mm256_add_epi32( s[i], mid[i] ), bswap_mask ) );
+   for( int n = 0; n < 8; ++n ) {
+      char* dest = out[n].data();
+      for( int i = 0; i < 8; ++i )
+         memcpy( dest + 4 * i, &words[i][n], 4 );
+   }
+}
+
+void hash_avx2( const char* in, size_t count, sha256* out ) {
+   size_t i = 0;
+   for( ; i + 8 <= count; i += 8 )
+      avx2_hash8( in + i * input_size, out + i );
+   hash_scalar( in + i * input_size, count - i, out + i );
+}
+
+#undef FC_TARGET_AVX2
+
+using batch_kernel = void (*)( const char*, size_t, sha256* );
+
+batch_kernel select_kernel() {
+   unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+   if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+      return hash_scalar;
+   const bool sse41   = ecx & bit_SSE4_1;
+   const bool osxsave = ecx & bit_OSXSAVE;
+   if( !__get_cpuid_count( 7, 0, &eax, &ebx, &ecx, &edx ) )
+      return hash_scalar;
+   const bool sha  = ebx & (1u << 29);
+   const bool avx2 = ebx & (1u << 5);
+
+   if( sha && sse41 )
+      return hash_sha_ni;
+   if( avx2 && osxsave ) {
+      // the os has to save the ymm registers on context switches
+      uint32_t xcr0_lo = 0, xcr0_hi = 0;
+      __asm__( "xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0) );
+      if( (xcr0_lo & 0x6) == 0x6 )
+         return hash_avx2;
+   }
+   return hash_scalar;
+}
+
+#endif // FC_SHA256_BATCH_X86
+
+} // anonymous namespace
+
+void sha256::hash_64_byte_batch( const char* in, size_t count, sha256* out ) {
+#ifdef FC_SHA256_BATCH_X86
+   static const batch_kernel kernel = select_kernel();
+   kernel( in, count, out );
+#else
+   hash_scalar( in, count, out );
+#endif
+}
+
+} // namespace fc
@@ -3,6 +3,7 @@
 
 #include <fc/crypto/hex.hpp>
 #include <fc/crypto/sha3.hpp>
+#include <fc/crypto/sha256.hpp>
 #include <fc/utility.hpp>
 
 using namespace fc;
@@ -67,4 +68,20 @@ BOOST_AUTO_TEST_CASE(keccak256) try {
 
 } FC_LOG_AND_RETHROW();
 
+BOOST_AUTO_TEST_CASE(sha256_64_byte_batch) try {
+
+   // counts around the 2 and 8 input multi-buffer kernel widths exercise every remainder path
+   for( size_t count : { 0, 1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 100 } ) {
+      std::vector<char> in( count * 64 );
+      for( size_t i = 0; i < in.size(); ++i )
+         in[i] = static_cast<char>( (i * 131 + count) & 0xff );
+
+      std::vector<fc::sha256> out( count );
+      fc::sha256::hash_64_byte_batch( in.data(), count, out.data() );
+      for( size_t i = 0; i < count; ++i )
+         BOOST_CHECK_EQUAL( out[i].str(), fc::sha256::hash( in.data() + i * 64, 64 ).str() );
+   }
+
+} FC_LOG_AND_RETHROW();
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
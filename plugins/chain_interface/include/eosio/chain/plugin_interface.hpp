@@ -17,6 +17,13 @@ namespace eosio { namespace chain { namespace plugin_interface {
 
    struct chain_plugin_interface;
 
+   /// transaction with keys already recovered, and the callback to report its result
+   struct incoming_transaction {
+      transaction_metadata_ptr             trx;
+      next_function<transaction_trace_ptr> next;
+   };
+   using incoming_transaction_batch = std::vector<incoming_transaction>;
+
    namespace channels {
       using pre_accepted_block     = channel_decl<struct pre_accepted_block_tag,    signed_block_ptr>;
       using rejected_block         = channel_decl<struct rejected_block_tag,        signed_block_ptr>;
@@ -41,6 +48,8 @@ namespace eosio { namespace chain { namespace plugin_interface {
          // synchronously push a block/trx to a single provider, block_state_ptr may be null
          using block_sync            = method_decl<chain_plugin_interface, bool(const signed_block_ptr&, const std::optional<block_id_type>&, const block_state_ptr&), first_provider_policy>;
          using transaction_async     = method_decl<chain_plugin_interface, void(const packed_transaction_ptr&, bool, transaction_metadata::trx_type, bool, next_function<transaction_trace_ptr>), first_provider_policy>;
+         // asynchronously push a batch of p2p transactions with recovered keys, processed by a single application thread post
+         using transaction_batch_async = method_decl<chain_plugin_interface, void(incoming_transaction_batch), first_provider_policy>;
       }
    }
 
@@ -2,6 +2,7 @@
 
 #include <fc/time.hpp>
 
+#include <algorithm>
 #include <functional>
 #include <string>
 #include <vector>
@@ -14,7 +15,25 @@ namespace eosio::chain::plugin_interface {
 
    enum class metric_type {
       gauge = 1,
-      counter = 2
+      counter = 2,
+      histogram = 3
+   };
+
+   /// observations of a histogram metric: counts[i] observations fell in (bounds[i-1], bounds[i]], the last of the
+   /// bounds.size() + 1 counts is the +Inf bucket
+   struct histogram_data {
+      std::vector<double> bounds;
+      std::vector<double> counts;
+      double              sum = 0;
+
+      histogram_data() = default;
+      explicit histogram_data(std::vector<double> b) : bounds(std::move(b)), counts(bounds.size() + 1) {}
+
+      void observe(double value) {
+         auto itr = std::lower_bound(bounds.begin(), bounds.end(), value);
+         counts[itr - bounds.begin()] += 1;
+         sum += value;
+      }
    };
 
    struct runtime_metric {
@@ -22,6 +41,7 @@ namespace eosio::chain::plugin_interface {
       std::string family;
       std::string label;
       int64_t value = 0;
+      histogram_data histogram; ///< only for metric_type::histogram
    };
 
    using metrics_listener = std::function<void(std::vector<runtime_metric>)>;
@@ -8,6 +8,7 @@
 #include <eosio/chain/code_object.hpp>
 #include <eosio/chain/config.hpp>
 #include <eosio/chain/wasm_interface.hpp>
+#include <eosio/chain/signature_recovery_cache.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
@@ -140,6 +141,7 @@ public:
    ,applied_transaction_channel(app().get_channel<channels::applied_transaction>())
    ,incoming_block_sync_method(app().get_method<incoming::methods::block_sync>())
    ,incoming_transaction_async_method(app().get_method<incoming::methods::transaction_async>())
+   ,incoming_transaction_batch_async_method(app().get_method<incoming::methods::transaction_batch_async>())
    {}
 
    bfs::path                        blocks_dir;
@@ -170,6 +172,7 @@ public:
    // retained references to methods for easy calling
    incoming::methods::block_sync::method_type&        incoming_block_sync_method;
    incoming::methods::transaction_async::method_type& incoming_transaction_async_method;
+   incoming::methods::transaction_batch_async::method_type& incoming_transaction_batch_async_method;
 
    // method provider handles
    methods::get_block_by_number::method_type::handle                 get_block_by_number_provider;
@@ -330,10 +333,20 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
                   EOS_ASSERT(false, plugin_exception, "");
                }
          }), "Number of threads to use for EOS VM OC tier-up")
+         ("eos-vm-oc-hot-codes", bpo::value<uint64_t>()->default_value(eosvmoc::config().hot_codes),
+          "Number of most used contracts remembered across restarts and compiled by EOS VM OC ahead of their first use after startup or a setcode")
+         ("eos-vm-oc-profile-hz", bpo::value<uint32_t>()->default_value(eosvmoc::config().profile_hz)->notifier([](const auto hz) {
+               if(hz > 10000) {
+                  elog("eos-vm-oc-profile-hz must not exceed 10000");
+                  EOS_ASSERT(false, plugin_exception, "");
+               }
+         }), "Samples per second of CPU time taken of contracts executing in EOS VM OC, reported by the producer API get_oc_profile. 0 disables the profiler. Uses SIGPROF, do not combine with profile-account")
          ("eos-vm-oc-enable", bpo::bool_switch(), "Enable EOS VM OC tier-up runtime")
 #endif
          ("enable-account-queries", bpo::value<bool>()->default_value(false), "enable queries to find accounts by various metadata.")
          ("max-nonprivileged-inline-action-size", bpo::value<uint32_t>()->default_value(config::default_max_nonprivileged_inline_action_size), "maximum allowed size (in bytes) of an inline action for a nonprivileged account")
+         ("signature-recovery-cache-size", bpo::value<uint32_t>()->default_value(signature_recovery_cache::default_max_entries),
+          "Maximum number of public keys recovered from transaction signatures kept for reuse by the net, producer and block apply paths. 0 disables the cache.")
          ("transaction-retry-max-storage-size-gb", bpo::value<uint64_t>(),
           "Maximum size (in GiB) allowed to be allocated for the Transaction Retry feature. Setting above 0 enables this feature.")
          ("transaction-retry-interval-sec", bpo::value<uint32_t>()->default_value(20),
@@ -390,6 +403,8 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "stop hard replay / block log recovery at this block number (if set to non-zero number)")
          ("terminate-at-block", bpo::value<uint32_t>()->default_value(0),
           "terminate after reaching this block number (if set to a non-zero number)")
+         ("replay-prefetch-blocks", bpo::value<uint32_t>()->default_value(config::default_replay_prefetch_blocks),
+          "number of irreversible blocks read and prepared ahead of execution during replay, 0 to disable")
          ("snapshot", bpo::value<bfs::path>(), "File to read Snapshot State from")
          ;
 
@@ -592,6 +607,8 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
 
       my->abi_serializer_max_time_us = fc::microseconds(options.at("abi-serializer-max-time-ms").as<uint32_t>() * 1000);
 
+      signature_recovery_cache::instance().set_max_entries( options.at( "signature-recovery-cache-size" ).as<uint32_t>() );
+
       my->chain_config->blocks_dir = my->blocks_dir;
       my->chain_config->state_dir = my->state_dir;
       my->chain_config->read_only = my->readonly;
@@ -648,6 +665,8 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
       if( options.count( "terminate-at-block" ))
          my->chain_config->terminate_at_block = options.at( "terminate-at-block" ).as<uint32_t>();
 
+      my->chain_config->replay_prefetch_blocks = options.at( "replay-prefetch-blocks" ).as<uint32_t>();
+
       // move fork_db to new location
       upgrade_from_reversible_to_fork_db( my.get() );
 
@@ -916,6 +935,10 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
          my->chain_config->eosvmoc_config.cache_size = options.at( "eos-vm-oc-cache-size-mb" ).as<uint64_t>() * 1024u * 1024u;
       if( options.count("eos-vm-oc-compile-threads") )
          my->chain_config->eosvmoc_config.threads = options.at("eos-vm-oc-compile-threads").as<uint64_t>();
+      if( options.count("eos-vm-oc-hot-codes") )
+         my->chain_config->eosvmoc_config.hot_codes = options.at("eos-vm-oc-hot-codes").as<uint64_t>();
+      if( options.count("eos-vm-oc-profile-hz") )
+         my->chain_config->eosvmoc_config.profile_hz = options.at("eos-vm-oc-profile-hz").as<uint32_t>();
       if( options["eos-vm-oc-enable"].as<bool>() )
          my->chain_config->eosvmoc_tierup = true;
 #endif
@@ -1192,6 +1215,10 @@ void chain_plugin::accept_transaction(const chain::packed_transaction_ptr& trx,
    my->incoming_transaction_async_method(trx, false, transaction_metadata::trx_type::input, false, std::move(next));
 }
 
+void chain_plugin::accept_recovered_transactions(chain::plugin_interface::incoming_transaction_batch batch) {
+   my->incoming_transaction_batch_async_method(std::move(batch));
+}
+
 controller& chain_plugin::chain() { return *my->chain; }
 const controller& chain_plugin::chain() const { return *my->chain; }
 
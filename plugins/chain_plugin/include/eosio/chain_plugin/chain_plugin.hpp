@@ -887,6 +887,8 @@ public:
 
    bool accept_block( const chain::signed_block_ptr& block, const chain::block_id_type& id, const chain::block_state_ptr& bsp );
    void accept_transaction(const chain::packed_transaction_ptr& trx, chain::plugin_interface::next_function<chain::transaction_trace_ptr> next);
+   // all transactions of the batch must have their keys recovered and belong to the same shard
+   void accept_recovered_transactions(chain::plugin_interface::incoming_transaction_batch batch);
 
    // Only call this after plugin_initialize()!
    controller& chain();
@@ -12,13 +12,31 @@ namespace eosio {
       chain::plugin_interface::runtime_metric num_peers{ chain::plugin_interface::metric_type::gauge, "num_peers", "num_peers", 0 };
       chain::plugin_interface::runtime_metric num_clients{ chain::plugin_interface::metric_type::gauge, "num_clients", "num_clients", 0 };
       chain::plugin_interface::runtime_metric dropped_trxs{ chain::plugin_interface::metric_type::counter, "dropped_trxs", "dropped_trxs", 0 };
+      chain::plugin_interface::runtime_metric dropped_trx_relays{ chain::plugin_interface::metric_type::counter, "dropped_trx_relays", "dropped_trx_relays", 0 };
+      chain::plugin_interface::runtime_metric send_buffers_created{ chain::plugin_interface::metric_type::counter, "send_buffers_created", "send_buffers_created", 0 };
+      chain::plugin_interface::runtime_metric send_buffers_reused{ chain::plugin_interface::metric_type::counter, "send_buffers_reused", "send_buffers_reused", 0 };
+      // received count, bytes and net thread cpu time of each net_message type, 3 consecutive entries per type in net_message_names order
+      vector<chain::plugin_interface::runtime_metric> received_msg_metrics;
+
+      net_plugin_metrics() {
+         for( const char* name : net_message_names ) {
+            const string n( name );
+            received_msg_metrics.push_back( { chain::plugin_interface::metric_type::counter, n + "_received", n + "_received", 0 } );
+            received_msg_metrics.push_back( { chain::plugin_interface::metric_type::counter, n + "_received_bytes", n + "_received_bytes", 0 } );
+            received_msg_metrics.push_back( { chain::plugin_interface::metric_type::counter, n + "_cpu_us", n + "_cpu_us", 0 } );
+         }
+      }
 
       vector<chain::plugin_interface::runtime_metric> metrics() final {
          vector<chain::plugin_interface::runtime_metric> metrics {
             num_peers,
             num_clients,
-            dropped_trxs
+            dropped_trxs,
+            dropped_trx_relays,
+            send_buffers_created,
+            send_buffers_reused
          };
+         metrics.insert( metrics.end(), received_msg_metrics.begin(), received_msg_metrics.end() );
 
          return metrics;
       }
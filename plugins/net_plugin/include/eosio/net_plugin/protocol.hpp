@@ -1,6 +1,7 @@
 #pragma once
 #include <eosio/chain/block.hpp>
 #include <eosio/chain/types.hpp>
+#include <array>
 #include <chrono>
 
 namespace eosio {
@@ -142,6 +143,19 @@ namespace eosio {
                                     signed_block,         // which = 7
                                     packed_transaction>;  // which = 8
 
+   /// names of the net_message types, indexed by which
+   constexpr std::array<const char*, std::variant_size_v<net_message>> net_message_names{
+      "handshake_message",
+      "chain_size_message",
+      "go_away_message",
+      "time_message",
+      "notice_message",
+      "request_message",
+      "sync_request_message",
+      "signed_block",
+      "packed_transaction"
+   };
+
 } // namespace eosio
 
 FC_REFLECT( eosio::select_ids<fc::sha256>, (mode)(pending)(ids) )
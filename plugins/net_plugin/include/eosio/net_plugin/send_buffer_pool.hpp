@@ -0,0 +1,91 @@
+#pragma once
+
+#include <boost/asio/buffer.hpp>
+#include <boost/core/noncopyable.hpp>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace eosio {
+
+   /// non-owning buffer sequence, avoids asio copying the vector of buffers into every write operation
+   struct const_buffer_view {
+      using value_type = boost::asio::const_buffer;
+      using const_iterator = const boost::asio::const_buffer*;
+
+      const_iterator first = nullptr;
+      const_iterator last = nullptr;
+
+      const_iterator begin() const { return first; }
+      const_iterator end() const { return last; }
+   };
+
+   /**
+    *  Pool of send buffers in power of 2 size classes. Send buffers are shared between connections and
+    *  are returned to the pool by whichever thread releases the last reference. Thread safe.
+    */
+   class send_buffer_pool : boost::noncopyable {
+   public:
+      static constexpr size_t min_class_bits = 8;           // 256 bytes
+      static constexpr size_t num_classes = 13;             // up to 1MB, larger buffers are not pooled
+      static constexpr size_t max_free_per_class = 256;
+
+      std::shared_ptr<std::vector<char>> get( size_t size ) {
+         const size_t cls = size_class( size );
+         std::unique_ptr<std::vector<char>> buff;
+         if( cls < num_classes ) {
+            std::lock_guard<std::mutex> g( classes[cls].mtx );
+            if( !classes[cls].free.empty() ) {
+               buff = std::move( classes[cls].free.back() );
+               classes[cls].free.pop_back();
+            }
+         }
+         if( buff ) {
+            ++reused;
+         } else {
+            ++created;
+            buff = std::make_unique<std::vector<char>>();
+            buff->reserve( cls < num_classes ? class_size( cls ) : size );
+         }
+         buff->resize( size );
+         return std::shared_ptr<std::vector<char>>( buff.release(), [this, cls]( std::vector<char>* b ) { release( cls, b ); } );
+      }
+
+      uint64_t buffers_created() const { return created; }
+      uint64_t buffers_reused() const { return reused; }
+
+   private:
+      static size_t class_size( size_t cls ) { return size_t{1} << (cls + min_class_bits); }
+
+      static size_t size_class( size_t size ) {
+         size_t cls = 0;
+         while( cls < num_classes && class_size( cls ) < size )
+            ++cls;
+         return cls;
+      }
+
+      void release( size_t cls, std::vector<char>* b ) {
+         std::unique_ptr<std::vector<char>> buff( b );
+         if( cls < num_classes ) {
+            std::lock_guard<std::mutex> g( classes[cls].mtx );
+            if( classes[cls].free.size() < max_free_per_class ) {
+               buff->clear();
+               classes[cls].free.emplace_back( std::move( buff ) );
+            }
+         }
+      }
+
+      struct size_class_list {
+         std::mutex                                       mtx;
+         std::vector<std::unique_ptr<std::vector<char>>>  free;
+      };
+
+      std::array<size_class_list, num_classes>         classes;
+      std::atomic<uint64_t>                            created{0};
+      std::atomic<uint64_t>                            reused{0};
+   };
+
+} // namespace eosio
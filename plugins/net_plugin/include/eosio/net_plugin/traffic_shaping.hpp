@@ -0,0 +1,223 @@
+#pragma once
+
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/time.hpp>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eosio {
+
+   /// write queue lanes of a connection, a lane is only sent when all lanes before it are empty
+   enum class queue_lane : uint8_t {
+      sync,     ///< blocks requested by the peer via sync_request_message
+      block,    ///< broadcast blocks
+      control,  ///< handshake, time, notice, request and go_away messages
+      trx,      ///< relayed transactions, shaped per peer class and dropped first on congestion
+      count
+   };
+
+   /**
+    *  Token bucket refilled at rate tokens per second holding at most one second of tokens,
+    *  a rate of 0 is unlimited. Not thread safe.
+    */
+   class token_bucket {
+      uint64_t         rate = 0;
+      double           tokens = 0;
+      fc::time_point   last_refill;
+
+   public:
+      void set_rate( uint64_t r ) {
+         if( r != rate ) {
+            rate = r;
+            tokens = r;
+            last_refill = fc::time_point();
+         }
+      }
+
+      /// a request larger than the bucket is allowed when the bucket is full, leaving it in debt
+      bool try_consume( uint64_t n, const fc::time_point& now ) {
+         if( rate == 0 )
+            return true;
+         if( last_refill != fc::time_point() )
+            tokens = std::min<double>( rate, tokens + (now - last_refill).count() * (rate / 1'000'000.0) );
+         last_refill = now;
+         if( tokens < std::min<double>( n, rate ) )
+            return false;
+         tokens -= n;
+         return true;
+      }
+   };
+
+   /// shaping limits applied to all connections of a peer class, 0 is unlimited
+   struct peer_class_limits {
+      uint64_t max_trx_send_bytes_per_sec = 0;
+      uint32_t max_trx_recv_per_sec = 0;
+   };
+
+   enum class peer_class : uint8_t {
+      default_peer,
+      producer_peer, ///< auto bp peering connection
+      count
+   };
+
+   /// parses a p2p-peer-class-limit entry, class:max-trx-send-bytes-per-sec:max-trx-recv-per-sec
+   inline std::pair<peer_class, peer_class_limits> parse_peer_class_limit( const std::string& entry ) {
+      std::vector<std::string> parts;
+      boost::split( parts, entry, boost::is_any_of( ":" ) );
+      EOS_ASSERT( parts.size() == 3, chain::plugin_config_exception,
+                  "p2p-peer-class-limit ${e} must be of the form class:max-trx-send-bytes-per-sec:max-trx-recv-per-sec", ("e", entry) );
+      peer_class pc;
+      if( parts[0] == "default" )
+         pc = peer_class::default_peer;
+      else if( parts[0] == "producer" )
+         pc = peer_class::producer_peer;
+      else
+         EOS_THROW( chain::plugin_config_exception, "p2p-peer-class-limit unknown peer class ${c}", ("c", parts[0]) );
+      peer_class_limits l;
+      try {
+         l.max_trx_send_bytes_per_sec = std::stoull( parts[1] );
+         l.max_trx_recv_per_sec = std::stoul( parts[2] );
+      } catch( const std::exception& e ) {
+         EOS_THROW( chain::plugin_config_exception, "p2p-peer-class-limit ${e} invalid number: ${what}", ("e", entry)("what", e.what()) );
+      }
+      return { pc, l };
+   }
+
+   /**
+    *  Write queue of a connection split in lanes. Every write takes the queued messages in lane order, so a lower
+    *  lane is only sent once all lanes before it are empty. Thread safe.
+    */
+   class queued_buffer : boost::noncopyable {
+   public:
+      /// @param max_write_queue_size queued bytes beyond which relayed transactions are dropped, twice that closes the connection
+      /// @param max_trx_queue_size queued bytes of the trx lane beyond which relayed transactions are dropped
+      /// @param max_write_batch_size bytes coalesced into a single write
+      queued_buffer( uint32_t max_write_queue_size, uint32_t max_trx_queue_size, size_t max_write_batch_size )
+      : max_write_queue_size( max_write_queue_size ), max_trx_queue_size( max_trx_queue_size ),
+        max_write_batch_size( max_write_batch_size ) {}
+
+      void clear_write_queue() {
+         std::lock_guard<std::mutex> g( _mtx );
+         for( auto& q : _write_queues ) {
+            q.clear();
+         }
+         _write_queue_size = 0;
+         _trx_queue_size = 0;
+      }
+
+      void clear_out_queue() {
+         std::lock_guard<std::mutex> g( _mtx );
+         while ( _out_queue.size() > 0 ) {
+            _out_queue.pop_front();
+         }
+      }
+
+      uint32_t write_queue_size() const {
+         std::lock_guard<std::mutex> g( _mtx );
+         return _write_queue_size;
+      }
+
+      bool is_out_queue_empty() const {
+         std::lock_guard<std::mutex> g( _mtx );
+         return _out_queue.empty();
+      }
+
+      /// @return true if a relayed transaction of size bytes should be dropped rather than queued
+      bool trx_lane_congested( uint32_t size ) const {
+         std::lock_guard<std::mutex> g( _mtx );
+         // never let transactions grow the queue to the point of disconnecting, blocks must still fit
+         return _write_queue_size + size > max_write_queue_size || _trx_queue_size + size > max_trx_queue_size;
+      }
+
+      bool ready_to_send() const {
+         std::lock_guard<std::mutex> g( _mtx );
+         // if out_queue is not empty then async_write is in progress
+         return _out_queue.empty() && std::any_of( _write_queues.begin(), _write_queues.end(), []( const auto& q ) { return !q.empty(); } );
+      }
+
+      // @param callback must not callback into queued_buffer
+      bool add_write_queue( const std::shared_ptr<std::vector<char>>& buff,
+                            std::function<void( boost::system::error_code, std::size_t )> callback,
+                            queue_lane lane ) {
+         std::lock_guard<std::mutex> g( _mtx );
+         _write_queues[static_cast<size_t>(lane)].push_back( {buff, callback} );
+         _write_queue_size += buff->size();
+         if( lane == queue_lane::trx ) {
+            _trx_queue_size += buff->size();
+         }
+         if( _write_queue_size > 2 * max_write_queue_size ) {
+            return false;
+         }
+         return true;
+      }
+
+      // coalesces queued messages of all lanes, in lane order, into a single vectored write of at most
+      // max_write_batch_size bytes (or one message if larger)
+      void fill_out_buffer( std::vector<boost::asio::const_buffer>& bufs ) {
+         std::lock_guard<std::mutex> g( _mtx );
+         size_t batch_size = 0;
+         for( size_t lane = 0; lane < _write_queues.size(); ++lane ) {
+            if( !fill_out_buffer( bufs, _write_queues[lane], batch_size, lane == static_cast<size_t>(queue_lane::trx) ) )
+               break;
+         }
+      }
+
+      void out_callback( boost::system::error_code ec, std::size_t w ) {
+         std::lock_guard<std::mutex> g( _mtx );
+         for( auto& m : _out_queue ) {
+            m.callback( ec, w );
+         }
+      }
+
+   private:
+      struct queued_write;
+      // @return false if the batch is full
+      bool fill_out_buffer( std::vector<boost::asio::const_buffer>& bufs,
+                            std::deque<queued_write>& w_queue, size_t& batch_size, bool trx_lane ) {
+         while ( w_queue.size() > 0 ) {
+            auto& m = w_queue.front();
+            if( batch_size > 0 && batch_size + m.buff->size() > max_write_batch_size )
+               return false;
+            bufs.push_back( boost::asio::buffer( *m.buff ));
+            batch_size += m.buff->size();
+            _write_queue_size -= m.buff->size();
+            if( trx_lane )
+               _trx_queue_size -= m.buff->size();
+            _out_queue.emplace_back( std::move( m ) );
+            w_queue.pop_front();
+         }
+         return true;
+      }
+
+   private:
+      struct queued_write {
+         std::shared_ptr<std::vector<char>> buff;
+         std::function<void( boost::system::error_code, std::size_t )> callback;
+      };
+
+      const uint32_t      max_write_queue_size;
+      const uint32_t      max_trx_queue_size;
+      const size_t        max_write_batch_size;
+
+      mutable std::mutex  _mtx;
+      uint32_t            _write_queue_size{0};
+      uint32_t            _trx_queue_size{0}; // portion of _write_queue_size in the trx lane
+      std::array<std::deque<queued_write>, static_cast<size_t>(queue_lane::count)> _write_queues; // sent in lane order
+      std::deque<queued_write> _out_queue;
+
+   }; // queued_buffer
+
+} // namespace eosio
@@ -3,6 +3,8 @@
 #include <eosio/net_plugin/net_plugin.hpp>
 #include <eosio/net_plugin/protocol.hpp>
 #include <eosio/net_plugin/auto_bp_peering.hpp>
+#include <eosio/net_plugin/send_buffer_pool.hpp>
+#include <eosio/net_plugin/traffic_shaping.hpp>
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/block.hpp>
@@ -20,6 +22,7 @@
 #include <fc/reflect/variant.hpp>
 #include <fc/crypto/rand.hpp>
 #include <fc/exception/exception.hpp>
+#include <fc/scoped_exit.hpp>
 
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ip/host_name.hpp>
@@ -194,12 +197,105 @@ namespace eosio {
       void expire_txns();
    };
 
+   /**
+    *  Lossy, lock-free set of recently seen transaction ids, direct mapped by id.
+    *  A hit means the id was seen before, a miss is inconclusive as slots are overwritten.
+    */
+   class trx_seen_filter {
+      const uint64_t                              mask;
+      std::unique_ptr<std::atomic<uint64_t>[]>    slots;
+
+   public:
+      /// @param size must be a power of 2
+      explicit trx_seen_filter( uint64_t size )
+      : mask( size - 1 )
+      , slots( new std::atomic<uint64_t>[size] ) {
+         for( uint64_t i = 0; i < size; ++i )
+            slots[i].store( 0, std::memory_order_relaxed );
+      }
+
+      /// thread safe
+      /// @return true if id was already in the filter
+      bool check_and_insert( const transaction_id_type& id ) {
+         // ids are sha256, use one word as the slot and another as the fingerprint, never 0 so empty slots never match
+         const uint64_t fingerprint = id._hash[1] | 1;
+         return slots[id._hash[0] & mask].exchange( fingerprint, std::memory_order_relaxed ) == fingerprint;
+      }
+   };
+
+   /**
+    *  Staged ingress of p2p transactions. Every stage runs on the net thread pool so that the
+    *  application thread only receives transactions that are ready to execute:
+    *    1. unpack and dedupe against the seen filter and local_txns, on the connection strand
+    *    2. expiration precheck against the last known head block time
+    *    3. signature recovery
+    *    4. a single application thread post per shard of all transactions recovered since the last flush
+    */
+   class transaction_ingress {
+      trx_seen_filter                                     seen_filter{1u << 20};
+      const uint32_t                                      max_variable_sig_size;
+      std::atomic<int64_t>                                max_trx_cpu_usage_us{fc::microseconds::maximum().count()};
+
+      std::mutex                                          pending_mtx;
+      std::map<shard_name, incoming_transaction_batch>    pending; // ready trxs per shard, protected by pending_mtx
+      bool                                                flush_scheduled = false; // protected by pending_mtx
+
+   public:
+      explicit transaction_ingress( uint32_t max_variable_sig_size )
+      : max_variable_sig_size( max_variable_sig_size ) {}
+
+      /// thread safe
+      /// @return true if trx id was recently received
+      bool seen( const transaction_id_type& id ) { return seen_filter.check_and_insert( id ); }
+
+      /// thread safe, called from application thread as producer runtime options change
+      void set_max_trx_cpu_usage( fc::microseconds max_trx_cpu_usage ) { max_trx_cpu_usage_us = max_trx_cpu_usage.count(); }
+
+      /// called from any thread, next is called from a net thread on failure, from the application thread otherwise
+      void recover( packed_transaction_ptr trx, next_function<transaction_trace_ptr> next );
+
+   private:
+      void precheck( const packed_transaction_ptr& trx ) const;
+      void queue_ready( transaction_metadata_ptr trx, next_function<transaction_trace_ptr> next );
+      void flush();
+   };
+
+   /// counters of received messages per net_message type, thread safe
+   class received_message_stats {
+      struct counters {
+         std::atomic<uint64_t> count{0};
+         std::atomic<uint64_t> bytes{0};
+         std::atomic<uint64_t> cpu_us{0};
+      };
+      std::array<counters, std::variant_size_v<net_message>> by_type;
+
+   public:
+      /// @param cpu time spent on the connection strand handling the message, excludes any work posted elsewhere
+      void record( uint32_t which, uint32_t bytes, const fc::microseconds& cpu ) {
+         if( which >= by_type.size() )
+            return;
+         auto& c = by_type[which];
+         c.count.fetch_add( 1, std::memory_order_relaxed );
+         c.bytes.fetch_add( bytes, std::memory_order_relaxed );
+         c.cpu_us.fetch_add( cpu.count(), std::memory_order_relaxed );
+      }
+
+      void update( net_plugin_metrics& metrics ) const {
+         for( size_t i = 0; i < by_type.size(); ++i ) {
+            metrics.received_msg_metrics[3*i].value = by_type[i].count.load( std::memory_order_relaxed );
+            metrics.received_msg_metrics[3*i + 1].value = by_type[i].bytes.load( std::memory_order_relaxed );
+            metrics.received_msg_metrics[3*i + 2].value = by_type[i].cpu_us.load( std::memory_order_relaxed );
+         }
+      }
+   };
+
    /**
     * default value initializers
     */
    constexpr auto     def_send_buffer_size_mb = 4;
    constexpr auto     def_send_buffer_size = 1024*1024*def_send_buffer_size_mb;
    constexpr auto     def_max_write_queue_size = def_send_buffer_size*10;
+   constexpr auto     def_max_trx_queue_size = def_send_buffer_size; // trx relay dropped rather than queued beyond this
    constexpr auto     def_max_trx_in_progress_size = 100*1024*1024; // 100 MB
    constexpr auto     def_max_consecutive_immediate_connection_close = 9; // back off if client keeps closing
    constexpr auto     def_max_clients = 25; // 0 for unlimited clients
@@ -223,6 +319,7 @@ namespace eosio {
 
       unique_ptr< sync_manager >       sync_master;
       unique_ptr< dispatch_manager >   dispatcher;
+      unique_ptr< transaction_ingress > trx_ingress;
 
       /**
        * Thread safe, only updated in plugin initialize
@@ -254,6 +351,7 @@ namespace eosio {
       uint32_t                              max_nodes_per_host = 1;
       bool                                  p2p_accept_transactions = true;
       fc::microseconds                      p2p_dedup_cache_expire_time_us{};
+      std::array<peer_class_limits, static_cast<size_t>(peer_class::count)> peer_limits;
 
       /// Peer clock may be no more than 1 second skewed from our clock, including network latency.
       const std::chrono::system_clock::duration peer_authentication_interval{std::chrono::seconds{1}};
@@ -290,12 +388,15 @@ namespace eosio {
       boost::asio::deadline_timer           accept_error_timer{thread_pool.get_executor()};
 
       net_plugin_metrics   metrics;
+      received_message_stats received_msg_stats;
 
       struct chain_info_t {
          uint32_t      lib_num = 0;
          block_id_type lib_id;
          uint32_t      head_num = 0;
          block_id_type head_id;
+         fc::time_point   head_time;
+         fc::microseconds max_trx_lifetime;
       };
 
    private:
@@ -363,6 +464,9 @@ namespace eosio {
       template <typename Function>
       void for_each_connection(Function&& fun) const;
 
+      const peer_class_limits& get_peer_class_limits( peer_class pc ) const { return peer_limits[static_cast<size_t>(pc)]; }
+      void set_peer_class_limits( const vector<string>& limits );
+
       void plugin_shutdown();
       bool in_sync() const;
       fc::logger& get_logger() { return logger; }
@@ -457,99 +561,8 @@ namespace eosio {
       time_point   start_time; ///< time request made or received
    };
 
-   // thread safe
-   class queued_buffer : boost::noncopyable {
-   public:
-      void clear_write_queue() {
-         std::lock_guard<std::mutex> g( _mtx );
-         _write_queue.clear();
-         _sync_write_queue.clear();
-         _write_queue_size = 0;
-      }
-
-      void clear_out_queue() {
-         std::lock_guard<std::mutex> g( _mtx );
-         while ( _out_queue.size() > 0 ) {
-            _out_queue.pop_front();
-         }
-      }
-
-      uint32_t write_queue_size() const {
-         std::lock_guard<std::mutex> g( _mtx );
-         return _write_queue_size;
-      }
-
-      bool is_out_queue_empty() const {
-         std::lock_guard<std::mutex> g( _mtx );
-         return _out_queue.empty();
-      }
-
-      bool ready_to_send() const {
-         std::lock_guard<std::mutex> g( _mtx );
-         // if out_queue is not empty then async_write is in progress
-         return ((!_sync_write_queue.empty() || !_write_queue.empty()) && _out_queue.empty());
-      }
-
-      // @param callback must not callback into queued_buffer
-      bool add_write_queue( const std::shared_ptr<vector<char>>& buff,
-                            std::function<void( boost::system::error_code, std::size_t )> callback,
-                            bool to_sync_queue ) {
-         std::lock_guard<std::mutex> g( _mtx );
-         if( to_sync_queue ) {
-            _sync_write_queue.push_back( {buff, callback} );
-         } else {
-            _write_queue.push_back( {buff, callback} );
-         }
-         _write_queue_size += buff->size();
-         if( _write_queue_size > 2 * def_max_write_queue_size ) {
-            return false;
-         }
-         return true;
-      }
-
-      void fill_out_buffer( std::vector<boost::asio::const_buffer>& bufs ) {
-         std::lock_guard<std::mutex> g( _mtx );
-         if( _sync_write_queue.size() > 0 ) { // always send msgs from sync_write_queue first
-            fill_out_buffer( bufs, _sync_write_queue );
-         } else { // postpone real_time write_queue if sync queue is not empty
-            fill_out_buffer( bufs, _write_queue );
-            EOS_ASSERT( _write_queue_size == 0, plugin_exception, "write queue size expected to be zero" );
-         }
-      }
-
-      void out_callback( boost::system::error_code ec, std::size_t w ) {
-         std::lock_guard<std::mutex> g( _mtx );
-         for( auto& m : _out_queue ) {
-            m.callback( ec, w );
-         }
-      }
-
-   private:
-      struct queued_write;
-      void fill_out_buffer( std::vector<boost::asio::const_buffer>& bufs,
-                            deque<queued_write>& w_queue ) {
-         while ( w_queue.size() > 0 ) {
-            auto& m = w_queue.front();
-            bufs.push_back( boost::asio::buffer( *m.buff ));
-            _write_queue_size -= m.buff->size();
-            _out_queue.emplace_back( m );
-            w_queue.pop_front();
-         }
-      }
-
-   private:
-      struct queued_write {
-         std::shared_ptr<vector<char>> buff;
-         std::function<void( boost::system::error_code, std::size_t )> callback;
-      };
-
-      mutable std::mutex  _mtx;
-      uint32_t            _write_queue_size{0};
-      deque<queued_write> _write_queue;
-      deque<queued_write> _sync_write_queue; // sync_write_queue will be sent first
-      deque<queued_write> _out_queue;
-
-   }; // queued_buffer
+   // outlives all connections and their queued send buffers
+   static send_buffer_pool send_buffers;
 
 
    /// monitors the status of blocks as to whether a block is accepted (sync'd) or
@@ -635,7 +648,8 @@ namespace eosio {
       fc::message_buffer<1024*1024>    pending_message_buffer;
       std::atomic<std::size_t>         outstanding_read_bytes{0}; // accessed only from strand threads
 
-      queued_buffer           buffer_queue;
+      queued_buffer           buffer_queue{def_max_write_queue_size, def_max_trx_queue_size, def_send_buffer_size};
+      std::vector<boost::asio::const_buffer> write_bufs; // reused for every write, only accessed from connection strand
 
       fc::sha256              conn_node_id;
       string                  short_conn_node_id;
@@ -649,6 +663,8 @@ namespace eosio {
 
       std::atomic<uint32_t>   trx_in_progress_size{0};
       fc::time_point          last_dropped_trx_msg_time;
+      token_bucket            trx_send_bucket; // only accessed from connection strand
+      token_bucket            trx_recv_bucket; // only accessed from connection strand
       const uint32_t          connection_id;
       int16_t                 sent_handshake_count = 0;
       std::atomic<bool>       connecting{true};
@@ -755,7 +771,9 @@ namespace eosio {
       void enqueue_block( const signed_block_ptr& sb, bool to_sync_queue = false);
       void enqueue_buffer( const std::shared_ptr<std::vector<char>>& send_buffer,
                            go_away_reason close_after_send,
-                           bool to_sync_queue = false);
+                           queue_lane lane = queue_lane::control);
+      /// @return false if the trx was dropped by the shaping of this connection's peer class
+      bool enqueue_trx_buffer( const std::shared_ptr<std::vector<char>>& send_buffer );
       void cancel_sync(go_away_reason);
       void flush_queues();
       bool enqueue_sync_block();
@@ -769,7 +787,7 @@ namespace eosio {
 
       void queue_write(const std::shared_ptr<vector<char>>& buff,
                        std::function<void(boost::system::error_code, std::size_t)> callback,
-                       bool to_sync_queue = false);
+                       queue_lane lane);
       void do_queue_write();
 
       bool is_valid( const handshake_message& msg ) const;
@@ -1117,6 +1135,7 @@ namespace eosio {
       }
       if( peer_requested->start_block <= peer_requested->end_block ) {
          peer_ilog( this, "enqueue ${s} - ${e}", ("s", peer_requested->start_block)("e", peer_requested->end_block) );
+         my_impl->chain_plug->chain().advise_sequential_block_read( peer_requested->start_block, peer_requested->end_block );
          enqueue_sync_block();
       } else {
          peer_ilog( this, "nothing to enqueue" );
@@ -1218,8 +1237,8 @@ namespace eosio {
    // called from connection strand
    void connection::queue_write(const std::shared_ptr<vector<char>>& buff,
                                 std::function<void(boost::system::error_code, std::size_t)> callback,
-                                bool to_sync_queue) {
-      if( !buffer_queue.add_write_queue( buff, callback, to_sync_queue )) {
+                                queue_lane lane) {
+      if( !buffer_queue.add_write_queue( buff, callback, lane )) {
          peer_wlog( this, "write_queue full ${s} bytes, giving up on connection", ("s", buffer_queue.write_queue_size()) );
          close();
          return;
@@ -1233,11 +1252,12 @@ namespace eosio {
          return;
       connection_ptr c(shared_from_this());
 
-      std::vector<boost::asio::const_buffer> bufs;
-      buffer_queue.fill_out_buffer( bufs );
+      // only one write in flight, write_bufs is not modified again until its callback
+      write_bufs.clear();
+      buffer_queue.fill_out_buffer( write_bufs );
 
-      strand.post( [c{std::move(c)}, bufs{std::move(bufs)}]() {
-         boost::asio::async_write( *c->socket, bufs,
+      strand.post( [c{std::move(c)}]() {
+         boost::asio::async_write( *c->socket, const_buffer_view{ c->write_bufs.data(), c->write_bufs.data() + c->write_bufs.size() },
             boost::asio::bind_executor( c->strand, [c, socket=c->socket]( boost::system::error_code ec, std::size_t w ) {
             try {
                c->buffer_queue.clear_out_queue();
@@ -1357,7 +1377,7 @@ namespace eosio {
          const char* const header = reinterpret_cast<const char* const>(&payload_size); // avoid variable size encoding of uint32_t
          const size_t buffer_size = message_header_size + payload_size;
 
-         auto send_buffer = std::make_shared<vector<char>>(buffer_size);
+         auto send_buffer = send_buffers.get( buffer_size );
          fc::datastream<char*> ds( send_buffer->data(), buffer_size);
          ds.write( header, message_header_size );
          fc::raw::pack( ds, m );
@@ -1374,7 +1394,7 @@ namespace eosio {
          const char* const header = reinterpret_cast<const char* const>(&payload_size); // avoid variable size encoding of uint32_t
          const size_t buffer_size = message_header_size + payload_size;
 
-         auto send_buffer = std::make_shared<vector<char>>( buffer_size );
+         auto send_buffer = send_buffers.get( buffer_size );
          fc::datastream<char*> ds( send_buffer->data(), buffer_size );
          ds.write( header, message_header_size );
          fc::raw::pack( ds, unsigned_int( which ) );
@@ -1449,13 +1469,27 @@ namespace eosio {
       block_buffer_factory buff_factory;
       auto sb = buff_factory.get_send_buffer( b );
       latest_blk_time = std::chrono::system_clock::now();
-      enqueue_buffer( sb, no_reason, to_sync_queue);
+      enqueue_buffer( sb, no_reason, to_sync_queue ? queue_lane::sync : queue_lane::block );
+   }
+
+   // called from connection strand
+   bool connection::enqueue_trx_buffer( const std::shared_ptr<std::vector<char>>& send_buffer ) {
+      const auto& limits = my_impl->get_peer_class_limits( is_bp_connection ? peer_class::producer_peer : peer_class::default_peer );
+      trx_send_bucket.set_rate( limits.max_trx_send_bytes_per_sec );
+      // drop low priority trx relay before it can delay blocks or push the connection over its write queue limit
+      if( buffer_queue.trx_lane_congested( send_buffer->size() ) ||
+          !trx_send_bucket.try_consume( send_buffer->size(), fc::time_point::now() ) ) {
+         ++my_impl->metrics.dropped_trx_relays.value;
+         return false;
+      }
+      enqueue_buffer( send_buffer, no_reason, queue_lane::trx );
+      return true;
    }
 
    // called from connection strand
    void connection::enqueue_buffer( const std::shared_ptr<std::vector<char>>& send_buffer,
                                     go_away_reason close_after_send,
-                                    bool to_sync_queue)
+                                    queue_lane lane)
    {
       connection_ptr self = shared_from_this();
       queue_write(send_buffer,
@@ -1468,7 +1502,7 @@ namespace eosio {
                            return;
                         }
                   },
-                  to_sync_queue);
+                  lane);
    }
 
    // thread safe
@@ -2172,7 +2206,7 @@ namespace eosio {
             bool has_block = cp->peer_lib_num >= bnum;
             if( !has_block ) {
                peer_dlog( cp, "bcast block ${b}", ("b", bnum) );
-               cp->enqueue_buffer( sb, no_reason );
+               cp->enqueue_buffer( sb, no_reason, queue_lane::block );
             }
          });
          return true;
@@ -2215,7 +2249,9 @@ namespace eosio {
          send_buffer_type sb = buff_factory.get_send_buffer( trx );
          fc_dlog( logger, "sending trx: ${id}, to connection ${cid}", ("id", trx->id())("cid", cp->connection_id) );
          cp->strand.post( [cp, sb{std::move(sb)}]() {
-            cp->enqueue_buffer( sb, no_reason );
+            if( !cp->enqueue_trx_buffer( sb ) ) {
+               peer_dlog( cp, "not sending trx, trx relay shaped or congested" );
+            }
          } );
          return true;
       } );
@@ -2605,6 +2641,11 @@ namespace eosio {
          auto peek_ds = pending_message_buffer.create_peek_datastream();
          unsigned_int which{};
          fc::raw::unpack( peek_ds, which );
+
+         const auto start = fc::time_point::now();
+         auto record_stats = fc::make_scoped_exit( [which = which.value, message_length, start]() {
+            my_impl->received_msg_stats.record( which, message_length + message_header_size, fc::time_point::now() - start );
+         } );
          if( which == signed_block_which ) {
             latest_blk_time = std::chrono::system_clock::now();
             return process_next_block_message( message_length );
@@ -2724,7 +2765,8 @@ namespace eosio {
          }
          return true;
       }
-      bool have_trx = my_impl->dispatcher->have_txn( ptr->id() );
+      // always insert into the seen filter, only fall back to the locked local_txns on a filter miss
+      bool have_trx = my_impl->trx_ingress->seen( ptr->id() ) || my_impl->dispatcher->have_txn( ptr->id() );
       my_impl->dispatcher->add_peer_txn( ptr->id(), ptr->expiration(), connection_id );
 
       if( have_trx ) {
@@ -2732,6 +2774,15 @@ namespace eosio {
          return true;
       }
 
+      // only new transactions count against the receive rate, duplicates relayed by several peers are free
+      const auto& limits = my_impl->get_peer_class_limits( is_bp_connection ? peer_class::producer_peer : peer_class::default_peer );
+      trx_recv_bucket.set_rate( limits.max_trx_recv_per_sec );
+      if( !trx_recv_bucket.try_consume( 1, fc::time_point::now() ) ) {
+         ++my_impl->metrics.dropped_trxs.value;
+         peer_dlog( this, "trx receive rate limit reached - dropping txn" );
+         return true;
+      }
+
       handle_message( std::move( ptr ) );
       return true;
    }
@@ -2783,6 +2834,12 @@ namespace eosio {
          chain_info.lib_id = cc.last_irreversible_block_id();
          chain_info.head_num = head_num = cc.fork_db_head_block_num();
          chain_info.head_id = cc.fork_db_head_block_id();
+         chain_info.head_time = cc.head_block_time();
+         chain_info.max_trx_lifetime = fc::seconds( cc.get_global_properties().configuration.max_transaction_lifetime );
+      }
+      if( trx_ingress && producer_plug != nullptr ) {
+         const auto max_trx_time_ms = producer_plug->get_runtime_options().max_transaction_time.value_or( -1 );
+         trx_ingress->set_max_trx_cpu_usage( max_trx_time_ms < 0 ? fc::microseconds::maximum() : fc::milliseconds( max_trx_time_ms ) );
       }
       fc_dlog( logger, "updating chain info lib ${lib}, fork ${fork}", ("lib", lib_num)("fork", head_num) );
    }
@@ -3194,6 +3251,8 @@ namespace eosio {
          else {
             peer_requested = peer_sync_state( msg.start_block, msg.end_block, msg.start_block-1);
          }
+         // blocks beyond lib are served from the fork database, the hint only applies to the block log part
+         my_impl->chain_plug->chain().advise_sequential_block_read( msg.start_block, msg.end_block );
          enqueue_sync_block();
       }
    }
@@ -3208,9 +3267,9 @@ namespace eosio {
       peer_dlog( this, "received packed_transaction ${id}", ("id", tid) );
 
       trx_in_progress_size += calc_trx_size( trx );
-      my_impl->chain_plug->accept_transaction( trx,
+      my_impl->trx_ingress->recover( trx,
          [weak = weak_from_this(), trx](const std::variant<fc::exception_ptr, transaction_trace_ptr>& result) mutable {
-         // next (this lambda) called from application thread
+         // next (this lambda) called from application thread, or from a net thread if rejected before reaching the producer
          if (std::holds_alternative<fc::exception_ptr>(result)) {
             fc_dlog( logger, "bad packed_transaction : ${m}", ("m", std::get<fc::exception_ptr>(result)->what()) );
          } else {
@@ -3228,6 +3287,76 @@ namespace eosio {
       });
    }
 
+   // called from any thread
+   void transaction_ingress::recover( packed_transaction_ptr trx, next_function<transaction_trace_ptr> next ) {
+      boost::asio::post( my_impl->thread_pool.get_executor(), [this, trx{std::move(trx)}, next{std::move(next)}]() mutable {
+         fc::exception_ptr except_ptr;
+         try {
+            precheck( trx );
+            auto trx_meta = transaction_metadata::recover_keys( trx, my_impl->chain_id, fc::microseconds( max_trx_cpu_usage_us.load() ),
+                                                               transaction_metadata::trx_type::input, max_variable_sig_size );
+            queue_ready( std::move( trx_meta ), std::move( next ) );
+            return;
+         } catch( const fc::exception& e ) {
+            except_ptr = e.dynamic_copy_exception();
+         } catch( const std::exception& e ) {
+            except_ptr = fc::std_exception_wrapper::from_current_exception( e ).dynamic_copy_exception();
+         }
+         if( my_impl->producer_plug != nullptr )
+            my_impl->producer_plug->log_failed_transaction( trx->id(), trx, except_ptr->what() );
+         // acked like the transactions the producer rejects, so ack subscribers see every rejection
+         app().get_channel<compat::channels::transaction_ack>().publish(
+               priority::low, std::pair<fc::exception_ptr, packed_transaction_ptr>( except_ptr, trx ) );
+         next( except_ptr );
+      } );
+   }
+
+   // called from net thread
+   // checks only what can be checked without chain state, the producer validates again against the pending block
+   void transaction_ingress::precheck( const packed_transaction_ptr& trx ) const {
+      const auto chain_info = my_impl->get_chain_info();
+      const fc::time_point expire = trx->expiration();
+      EOS_ASSERT( expire >= chain_info.head_time, expired_tx_exception,
+                  "expired transaction ${id}, expiration ${e}, head block time ${bt}",
+                  ("id", trx->id())("e", expire)("bt", chain_info.head_time) );
+      // pending block time is at least head block time, and about now when speculating
+      const fc::time_point earliest_pending = std::max( chain_info.head_time, fc::time_point::now() );
+      EOS_ASSERT( expire <= earliest_pending + chain_info.max_trx_lifetime, tx_exp_too_far_exception,
+                  "transaction ${id} expiration ${e} too far in the future relative to ${t}",
+                  ("id", trx->id())("e", expire)("t", earliest_pending) );
+   }
+
+   // called from net thread
+   void transaction_ingress::queue_ready( transaction_metadata_ptr trx, next_function<transaction_trace_ptr> next ) {
+      bool schedule_flush = false;
+      {
+         std::lock_guard<std::mutex> g( pending_mtx );
+         const auto shard = trx->get_shard_name();
+         pending[shard].push_back( incoming_transaction{ std::move( trx ), std::move( next ) } );
+         schedule_flush = !std::exchange( flush_scheduled, true );
+      }
+      // trxs recovered on other net threads before the flush runs are batched with this one
+      if( schedule_flush ) {
+         boost::asio::post( my_impl->thread_pool.get_executor(), [this]() {
+            flush();
+         } );
+      }
+   }
+
+   // called from net thread
+   void transaction_ingress::flush() {
+      std::map<shard_name, incoming_transaction_batch> ready;
+      {
+         std::lock_guard<std::mutex> g( pending_mtx );
+         ready.swap( pending );
+         flush_scheduled = false;
+      }
+      for( auto& [shard, batch] : ready ) {
+         fc_dlog( logger, "posting ${n} recovered transactions of shard ${s}", ("n", batch.size())("s", shard) );
+         my_impl->chain_plug->accept_recovered_transactions( std::move( batch ) );
+      }
+   }
+
    // called from connection strand
    void connection::handle_message( const block_id_type& id, signed_block_ptr ptr ) {
       peer_dlog( this, "received signed_block ${num}, id ${id}", ("num", block_header::num_from_id(id))("id", id) );
@@ -3500,6 +3629,9 @@ namespace eosio {
 
       metrics.num_clients.value = num_clients;
       metrics.num_peers.value = num_peers;
+      metrics.send_buffers_created.value = send_buffers.buffers_created();
+      metrics.send_buffers_reused.value = send_buffers.buffers_reused();
+      received_msg_stats.update( metrics );
       metrics.post_metrics();
 
       if( num_clients > 0 || num_peers > 0 )
@@ -3545,6 +3677,14 @@ namespace eosio {
       });
    }
 
+   // call only from plugin_initialize
+   void net_plugin_impl::set_peer_class_limits( const vector<string>& limits ) {
+      for( const auto& entry : limits ) {
+         auto [pc, l] = parse_peer_class_limit( entry );
+         peer_limits[static_cast<size_t>(pc)] = l;
+      }
+   }
+
    bool net_plugin_impl::authenticate_peer(const handshake_message& msg) const {
       if(allowed_connections == None)
          return false;
@@ -3685,6 +3825,14 @@ namespace eosio {
          ( "connection-cleanup-period", bpo::value<int>()->default_value(def_conn_retry_wait), "number of seconds to wait before cleaning up dead connections")
          ( "max-cleanup-time-msec", bpo::value<int>()->default_value(10), "max connection cleanup time per cleanup call in milliseconds")
          ( "p2p-dedup-cache-expire-time-sec", bpo::value<uint32_t>()->default_value(10), "Maximum time to track transaction for duplicate optimization")
+         ( "p2p-peer-class-limit", bpo::value< vector<string> >()->composing(),
+           "Transaction relay shaping applied to each connection of a peer class. Blocks and control messages are never shaped,\n"
+           "transactions are always queued after them and relayed transactions over the limit are dropped. 0 is unlimited.\n"
+           "   Syntax: class:max-trx-send-bytes-per-sec:max-trx-recv-per-sec\n"
+           "   Where class is 'default' or 'producer' (connections made by p2p-auto-bp-peer)\n"
+           "   Example,\n"
+           "     default:1048576:1000\n"
+           "     producer:0:0\n")
          ( "net-threads", bpo::value<uint16_t>()->default_value(my->thread_pool_size),
            "Number of worker threads in net_plugin thread pool" )
          ( "sync-fetch-span", bpo::value<uint32_t>()->default_value(def_sync_fetch_span), "number of blocks to retrieve in a chunk from any individual peer during synchronization")
@@ -3727,6 +3875,9 @@ namespace eosio {
          my->max_client_count = options.at( "max-clients" ).as<int>();
          my->max_nodes_per_host = options.at( "p2p-max-nodes-per-host" ).as<int>();
          my->p2p_accept_transactions = options.at( "p2p-accept-transactions" ).as<bool>();
+         if( options.count( "p2p-peer-class-limit" ) ) {
+            my->set_peer_class_limits( options.at( "p2p-peer-class-limit" ).as<vector<string>>() );
+         }
 
          my->use_socket_read_watermark = options.at( "use-socket-read-watermark" ).as<bool>();
          my->keepalive_interval = std::chrono::milliseconds( options.at( "p2p-keepalive-interval-ms" ).as<int>() );
@@ -3839,6 +3990,7 @@ namespace eosio {
       } );
 
       my->dispatcher.reset( new dispatch_manager( my_impl->thread_pool.get_executor() ) );
+      my->trx_ingress.reset( new transaction_ingress( my->chain_plug->chain().configured_subjective_signature_length_limit() ) );
 
       if( !my->p2p_accept_transactions && my->p2p_address.size() ) {
          fc_ilog( logger, "\n"
@@ -0,0 +1,143 @@
+#define BOOST_TEST_MODULE send_buffer_pool
+#include <boost/test/included/unit_test.hpp>
+#include <eosio/net_plugin/send_buffer_pool.hpp>
+#include <eosio/net_plugin/traffic_shaping.hpp>
+
+#include <thread>
+
+using namespace eosio;
+
+namespace {
+
+std::shared_ptr<std::vector<char>> make_buffer( size_t size, char fill ) {
+   return std::make_shared<std::vector<char>>( size, fill );
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(reuse_by_size_class) {
+   send_buffer_pool pool;
+   const char* data = nullptr;
+   {
+      auto b = pool.get( 300 );
+      BOOST_CHECK_EQUAL( b->size(), 300u );
+      BOOST_CHECK_GE( b->capacity(), 512u );
+      data = b->data();
+   }
+   BOOST_CHECK_EQUAL( pool.buffers_created(), 1u );
+
+   // any size of the same class reuses the released buffer
+   {
+      auto b = pool.get( 512 );
+      BOOST_CHECK_EQUAL( b->size(), 512u );
+      BOOST_CHECK( b->data() == data );
+      BOOST_CHECK_EQUAL( pool.buffers_reused(), 1u );
+
+      // taken: another one is created, as is one of another class
+      auto c = pool.get( 257 );
+      auto d = pool.get( 100 );
+      BOOST_CHECK( c->data() != data );
+      BOOST_CHECK_EQUAL( pool.buffers_created(), 3u );
+   }
+   auto b = pool.get( 200 );
+   BOOST_CHECK_EQUAL( pool.buffers_created(), 3u );
+   BOOST_CHECK_EQUAL( pool.buffers_reused(), 2u );
+}
+
+BOOST_AUTO_TEST_CASE(large_buffers_not_pooled) {
+   send_buffer_pool pool;
+   const size_t largest = size_t{1} << (send_buffer_pool::min_class_bits + send_buffer_pool::num_classes - 1);
+   pool.get( largest );
+   pool.get( largest );
+   BOOST_CHECK_EQUAL( pool.buffers_created(), 1u );
+   BOOST_CHECK_EQUAL( pool.buffers_reused(), 1u );
+
+   pool.get( largest + 1 );
+   pool.get( largest + 1 );
+   BOOST_CHECK_EQUAL( pool.buffers_created(), 3u );
+   BOOST_CHECK_EQUAL( pool.buffers_reused(), 1u );
+}
+
+BOOST_AUTO_TEST_CASE(free_list_bounded) {
+   send_buffer_pool pool;
+   const size_t n = send_buffer_pool::max_free_per_class + 10;
+   {
+      std::vector<std::shared_ptr<std::vector<char>>> held;
+      for( size_t i = 0; i < n; ++i )
+         held.push_back( pool.get( 1000 ) );
+   }
+   BOOST_CHECK_EQUAL( pool.buffers_created(), n );
+
+   std::vector<std::shared_ptr<std::vector<char>>> held;
+   for( size_t i = 0; i < n; ++i )
+      held.push_back( pool.get( 1000 ) );
+   BOOST_CHECK_EQUAL( pool.buffers_reused(), send_buffer_pool::max_free_per_class );
+   BOOST_CHECK_EQUAL( pool.buffers_created(), n + 10 );
+}
+
+BOOST_AUTO_TEST_CASE(released_on_any_thread) {
+   send_buffer_pool pool;
+   constexpr size_t num_threads = 4;
+   constexpr size_t per_thread = 1000;
+
+   // buffers shared between connections are released by whichever thread drops the last reference
+   std::vector<std::thread> threads;
+   for( size_t t = 0; t < num_threads; ++t ) {
+      threads.emplace_back( [&pool, t]() {
+         for( size_t i = 0; i < per_thread; ++i ) {
+            auto b = pool.get( 256 + (i % 4) * 1000 );
+            std::fill( b->begin(), b->end(), char( t ) );
+            auto shared = b;
+            std::thread( [s{std::move( shared )}]() mutable { s.reset(); } ).join();
+         }
+      } );
+   }
+   for( auto& t : threads )
+      t.join();
+   BOOST_CHECK_EQUAL( pool.buffers_created() + pool.buffers_reused(), num_threads * per_thread );
+   BOOST_CHECK_GT( pool.buffers_reused(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE(writes_coalesced) {
+   queued_buffer q( 100'000, 100'000, 1'000 );
+   auto callback = []( boost::system::error_code, std::size_t ) {};
+   for( char c : { 'a', 'b', 'c', 'd' } )
+      q.add_write_queue( make_buffer( 300, c ), callback, queue_lane::control );
+   q.add_write_queue( make_buffer( 300, 's' ), callback, queue_lane::sync );
+
+   // as many messages as fit the batch size, in lane order
+   std::vector<boost::asio::const_buffer> bufs;
+   q.fill_out_buffer( bufs );
+   BOOST_REQUIRE_EQUAL( bufs.size(), 3u );
+   BOOST_CHECK_EQUAL( *static_cast<const char*>( bufs[0].data() ), 's' );
+   BOOST_CHECK_EQUAL( *static_cast<const char*>( bufs[2].data() ), 'b' );
+   BOOST_CHECK_EQUAL( boost::asio::buffer_size( const_buffer_view{ bufs.data(), bufs.data() + bufs.size() } ), 900u );
+   BOOST_CHECK_EQUAL( q.write_queue_size(), 600u );
+   q.clear_out_queue();
+
+   bufs.clear();
+   q.fill_out_buffer( bufs );
+   BOOST_REQUIRE_EQUAL( bufs.size(), 2u );
+   BOOST_CHECK_EQUAL( *static_cast<const char*>( bufs[0].data() ), 'c' );
+   q.clear_out_queue();
+
+   // a message larger than the batch size is written on its own
+   q.add_write_queue( make_buffer( 5'000, 'l' ), callback, queue_lane::block );
+   q.add_write_queue( make_buffer( 10, 't' ), callback, queue_lane::trx );
+   bufs.clear();
+   q.fill_out_buffer( bufs );
+   BOOST_REQUIRE_EQUAL( bufs.size(), 1u );
+   BOOST_CHECK_EQUAL( bufs[0].size(), 5'000u );
+   q.clear_out_queue();
+   bufs.clear();
+   q.fill_out_buffer( bufs );
+   BOOST_REQUIRE_EQUAL( bufs.size(), 1u );
+   BOOST_CHECK_EQUAL( q.write_queue_size(), 0u );
+   BOOST_CHECK( !q.trx_lane_congested( 100'000 ) );
+}
+
+BOOST_AUTO_TEST_CASE(empty_buffer_view) {
+   const_buffer_view view;
+   BOOST_CHECK( view.begin() == view.end() );
+   BOOST_CHECK_EQUAL( boost::asio::buffer_size( view ), 0u );
+}
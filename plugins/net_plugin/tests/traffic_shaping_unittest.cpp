@@ -0,0 +1,156 @@
+#define BOOST_TEST_MODULE traffic_shaping
+#include <boost/test/included/unit_test.hpp>
+#include <eosio/net_plugin/traffic_shaping.hpp>
+
+using namespace eosio;
+
+namespace {
+
+std::shared_ptr<std::vector<char>> make_buffer( size_t size, char fill ) {
+   return std::make_shared<std::vector<char>>( size, fill );
+}
+
+// what the lanes of a single write hold, by the fill of each buffer
+std::string written( queued_buffer& q ) {
+   std::vector<boost::asio::const_buffer> bufs;
+   q.fill_out_buffer( bufs );
+   std::string r;
+   for( const auto& b : bufs )
+      r += *static_cast<const char*>( b.data() );
+   return r;
+}
+
+const fc::time_point t0 = fc::time_point( fc::seconds( 1000 ) );
+
+}
+
+BOOST_AUTO_TEST_CASE(token_bucket_unlimited) {
+   token_bucket bucket;
+   for( int i = 0; i < 1000; ++i )
+      BOOST_CHECK( bucket.try_consume( 1'000'000, t0 ) );
+}
+
+BOOST_AUTO_TEST_CASE(token_bucket_rate) {
+   token_bucket bucket;
+   bucket.set_rate( 10 );
+   // starts full with one second of tokens
+   for( int i = 0; i < 10; ++i )
+      BOOST_CHECK( bucket.try_consume( 1, t0 ) );
+   BOOST_CHECK( !bucket.try_consume( 1, t0 ) );
+
+   // refilled at 10 per second
+   BOOST_CHECK( !bucket.try_consume( 1, t0 + fc::milliseconds( 50 ) ) );
+   BOOST_CHECK( bucket.try_consume( 1, t0 + fc::milliseconds( 150 ) ) );
+   BOOST_CHECK( !bucket.try_consume( 1, t0 + fc::milliseconds( 150 ) ) );
+
+   // never holds more than one second of tokens
+   const fc::time_point later = t0 + fc::seconds( 60 );
+   for( int i = 0; i < 10; ++i )
+      BOOST_CHECK( bucket.try_consume( 1, later ) );
+   BOOST_CHECK( !bucket.try_consume( 1, later ) );
+
+   // the same rate keeps the state, a new one starts full again
+   bucket.set_rate( 10 );
+   BOOST_CHECK( !bucket.try_consume( 1, later ) );
+   bucket.set_rate( 5 );
+   for( int i = 0; i < 5; ++i )
+      BOOST_CHECK( bucket.try_consume( 1, later ) );
+   BOOST_CHECK( !bucket.try_consume( 1, later ) );
+
+   bucket.set_rate( 0 );
+   BOOST_CHECK( bucket.try_consume( 1'000, later ) );
+}
+
+BOOST_AUTO_TEST_CASE(token_bucket_debt) {
+   token_bucket bucket;
+   bucket.set_rate( 100 );
+   // larger than the bucket: only allowed when full, and paid back before anything else is allowed
+   BOOST_CHECK( bucket.try_consume( 250, t0 ) );
+   BOOST_CHECK( !bucket.try_consume( 1, t0 ) );
+   BOOST_CHECK( !bucket.try_consume( 1, t0 + fc::milliseconds( 1000 ) ) );
+   BOOST_CHECK( !bucket.try_consume( 1, t0 + fc::milliseconds( 1490 ) ) );
+   BOOST_CHECK( bucket.try_consume( 1, t0 + fc::milliseconds( 1520 ) ) );
+
+   // and only once the bucket is full again
+   BOOST_CHECK( !bucket.try_consume( 250, t0 + fc::milliseconds( 2000 ) ) );
+   BOOST_CHECK( bucket.try_consume( 250, t0 + fc::milliseconds( 3000 ) ) );
+}
+
+BOOST_AUTO_TEST_CASE(parse_peer_class_limits) {
+   auto [pc, l] = parse_peer_class_limit( "default:1048576:1000" );
+   BOOST_CHECK( pc == peer_class::default_peer );
+   BOOST_CHECK_EQUAL( l.max_trx_send_bytes_per_sec, 1048576u );
+   BOOST_CHECK_EQUAL( l.max_trx_recv_per_sec, 1000u );
+
+   std::tie( pc, l ) = parse_peer_class_limit( "producer:0:0" );
+   BOOST_CHECK( pc == peer_class::producer_peer );
+   BOOST_CHECK_EQUAL( l.max_trx_send_bytes_per_sec, 0u );
+   BOOST_CHECK_EQUAL( l.max_trx_recv_per_sec, 0u );
+
+   BOOST_CHECK_THROW( parse_peer_class_limit( "default:1000" ), eosio::chain::plugin_config_exception );
+   BOOST_CHECK_THROW( parse_peer_class_limit( "seed:1000:10" ), eosio::chain::plugin_config_exception );
+   BOOST_CHECK_THROW( parse_peer_class_limit( "default:lots:10" ), eosio::chain::plugin_config_exception );
+}
+
+BOOST_AUTO_TEST_CASE(lane_order) {
+   queued_buffer q( 10'000, 1'000, 100'000 );
+   BOOST_CHECK( !q.ready_to_send() );
+
+   // queued lowest priority first, each lane in order
+   int callbacks = 0;
+   auto callback = [&]( boost::system::error_code, std::size_t ) { ++callbacks; };
+   BOOST_CHECK( q.add_write_queue( make_buffer( 100, 't' ), callback, queue_lane::trx ) );
+   BOOST_CHECK( q.add_write_queue( make_buffer( 100, 'u' ), callback, queue_lane::trx ) );
+   BOOST_CHECK( q.add_write_queue( make_buffer( 10, 'c' ), callback, queue_lane::control ) );
+   BOOST_CHECK( q.add_write_queue( make_buffer( 500, 'b' ), callback, queue_lane::block ) );
+   BOOST_CHECK( q.add_write_queue( make_buffer( 500, 's' ), callback, queue_lane::sync ) );
+   BOOST_CHECK( q.add_write_queue( make_buffer( 500, 'S' ), callback, queue_lane::sync ) );
+   BOOST_CHECK_EQUAL( q.write_queue_size(), 1710u );
+   BOOST_CHECK( q.ready_to_send() );
+
+   // sync blocks, broadcast blocks, control messages, then transactions
+   BOOST_CHECK_EQUAL( written( q ), "sSbctu" );
+   BOOST_CHECK_EQUAL( q.write_queue_size(), 0u );
+   // a write is in progress
+   BOOST_CHECK( !q.ready_to_send() );
+   BOOST_CHECK( !q.is_out_queue_empty() );
+
+   q.out_callback( {}, 1710 );
+   BOOST_CHECK_EQUAL( callbacks, 6 );
+   q.clear_out_queue();
+   BOOST_CHECK( q.is_out_queue_empty() );
+   BOOST_CHECK( !q.ready_to_send() );
+
+   // a block queued after a transaction is still written first
+   q.add_write_queue( make_buffer( 100, 't' ), callback, queue_lane::trx );
+   q.add_write_queue( make_buffer( 100, 'b' ), callback, queue_lane::block );
+   BOOST_CHECK_EQUAL( written( q ), "bt" );
+}
+
+BOOST_AUTO_TEST_CASE(trx_lane_congestion) {
+   queued_buffer q( 1'000, 300, 100'000 );
+   auto callback = []( boost::system::error_code, std::size_t ) {};
+
+   BOOST_CHECK( !q.trx_lane_congested( 300 ) );
+   BOOST_CHECK( q.trx_lane_congested( 301 ) );
+   q.add_write_queue( make_buffer( 200, 't' ), callback, queue_lane::trx );
+   BOOST_CHECK( !q.trx_lane_congested( 100 ) );
+   BOOST_CHECK( q.trx_lane_congested( 101 ) );
+
+   // blocks count against the whole queue
+   q.add_write_queue( make_buffer( 750, 'b' ), callback, queue_lane::block );
+   BOOST_CHECK( !q.trx_lane_congested( 50 ) );
+   BOOST_CHECK( q.trx_lane_congested( 51 ) );
+
+   // writing the queue out makes room again
+   BOOST_CHECK_EQUAL( written( q ), "bt" );
+   BOOST_CHECK( !q.trx_lane_congested( 300 ) );
+   q.clear_out_queue();
+
+   // beyond twice the queue limit the connection gives up
+   BOOST_CHECK( q.add_write_queue( make_buffer( 2'000, 'b' ), callback, queue_lane::block ) );
+   BOOST_CHECK( !q.add_write_queue( make_buffer( 1, 'c' ), callback, queue_lane::control ) );
+   q.clear_write_queue();
+   BOOST_CHECK_EQUAL( q.write_queue_size(), 0u );
+   BOOST_CHECK( !q.trx_lane_congested( 300 ) );
+}
@@ -120,6 +120,10 @@ void producer_api_plugin::plugin_startup() {
                      INVOKE_R_R_D(producer, get_unapplied_transactions, producer_plugin::get_unapplied_transactions_params), 200),
        CALL_WITH_400(producer, producer, get_snapshot_requests,
                      INVOKE_R_V(producer, get_snapshot_requests), 201),
+       CALL_WITH_400(producer, producer, get_block_timings,
+                     INVOKE_R_R_II(producer, get_block_timings, producer_plugin::get_block_timings_params), 201),
+       CALL_WITH_400(producer, producer, get_oc_profile,
+                     INVOKE_R_R_II(producer, get_oc_profile, producer_plugin::get_oc_profile_params), 201),
    }, appbase::exec_queue::read_only, appbase::priority::medium_high);
 
    // Not safe to run in parallel
@@ -14,6 +14,7 @@ using chain::plugin_interface::runtime_metric;
 using chain::plugin_interface::metric_type;
 using chain::plugin_interface::metrics_listener;
 using chain::plugin_interface::plugin_metrics;
+using chain::plugin_interface::histogram_data;
 
 struct producer_plugin_metrics : public plugin_metrics {
    runtime_metric unapplied_transactions{metric_type::gauge, "unapplied_transactions", "unapplied_transactions", 0};
@@ -24,19 +25,98 @@ struct producer_plugin_metrics : public plugin_metrics {
    runtime_metric head_block_num{metric_type::gauge, "head_block_num", "head_block_num", 0};
    runtime_metric subjective_bill_account_size{metric_type::gauge, "subjective_bill_account_size", "subjective_bill_account_size", 0};
    runtime_metric scheduled_trxs{metric_type::gauge, "scheduled_trxs", "scheduled_trxs", 0};
+   runtime_metric fork_switches{metric_type::counter, "fork_switches", "fork_switches", 0};
+   runtime_metric fork_switch_blocks{metric_type::counter, "fork_switch_blocks", "fork_switch_blocks", 0};
+   runtime_metric fork_switch_last_us{metric_type::gauge, "fork_switch_last_us", "fork_switch_last_us", 0};
+   runtime_metric fork_switch_max_us{metric_type::gauge, "fork_switch_max_us", "fork_switch_max_us", 0};
+   runtime_metric fork_switch_total_us{metric_type::counter, "fork_switch_total_us", "fork_switch_total_us", 0};
+   runtime_metric signature_cache_hits{metric_type::counter, "signature_cache_hits", "signature_cache_hits", 0};
+   runtime_metric signature_cache_misses{metric_type::counter, "signature_cache_misses", "signature_cache_misses", 0};
+   runtime_metric signature_cache_size{metric_type::gauge, "signature_cache_size", "signature_cache_size", 0};
+
+   // wall clock time of the stages of applied and produced blocks, see controller::block_stage_times
+   inline static const std::vector<double> block_stage_bounds_us{ 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000 };
+   runtime_metric block_total_us{metric_type::histogram, "block_total_us", "block_total_us", 0, histogram_data(block_stage_bounds_us)};
+   runtime_metric block_recover_keys_wait_us{metric_type::histogram, "block_recover_keys_wait_us", "block_recover_keys_wait_us", 0, histogram_data(block_stage_bounds_us)};
+   runtime_metric block_shard_execution_us{metric_type::histogram, "block_shard_execution_us", "block_shard_execution_us", 0, histogram_data(block_stage_bounds_us)};
+   runtime_metric block_shard_critical_path_us{metric_type::histogram, "block_shard_critical_path_us", "block_shard_critical_path_us", 0, histogram_data(block_stage_bounds_us)};
+   runtime_metric block_xshard_us{metric_type::histogram, "block_xshard_us", "block_xshard_us", 0, histogram_data(block_stage_bounds_us)};
+   runtime_metric block_sync_shared_db_us{metric_type::histogram, "block_sync_shared_db_us", "block_sync_shared_db_us", 0, histogram_data(block_stage_bounds_us)};
+   runtime_metric block_merkle_us{metric_type::histogram, "block_merkle_us", "block_merkle_us", 0, histogram_data(block_stage_bounds_us)};
+   runtime_metric block_process_block_usage_us{metric_type::histogram, "block_process_block_usage_us", "block_process_block_usage_us", 0, histogram_data(block_stage_bounds_us)};
+   runtime_metric block_commit_us{metric_type::histogram, "block_commit_us", "block_commit_us", 0, histogram_data(block_stage_bounds_us)};
+   runtime_metric block_signals_us{metric_type::histogram, "block_signals_us", "block_signals_us", 0, histogram_data(block_stage_bounds_us)};
+
+   // EOS VM OC compiles, one family of each per compile priority, e.g. oc_compile_queue_depth_block
+   std::vector<runtime_metric> oc_compiles;
+
+   void observe_oc_compiles(const chain::eosvmoc::compile_stats& stats) {
+      oc_compiles.clear();
+      for (size_t p = 0; p < stats.size(); ++p) {
+         const std::string tier = chain::eosvmoc::compile_priority_name(static_cast<chain::eosvmoc::compile_priority>(p));
+         const auto& s = stats[p];
+         auto add = [&](metric_type type, const std::string& family, int64_t value) {
+            oc_compiles.push_back(runtime_metric{type, family + "_" + tier, family + "_" + tier, value});
+         };
+         add(metric_type::gauge, "oc_compile_queue_depth", s.queued);
+         add(metric_type::gauge, "oc_compiles_running", s.compiling);
+         add(metric_type::counter, "oc_compiles", s.compiled);
+
+         const auto& bounds = chain::eosvmoc::compile_tier_stats::latency_bounds_us;
+         runtime_metric latency{metric_type::histogram, "oc_compile_latency_us_" + tier, "oc_compile_latency_us_" + tier, 0,
+                                histogram_data(std::vector<double>(bounds.begin(), bounds.end()))};
+         latency.histogram.counts.assign(s.latency_counts.begin(), s.latency_counts.end());
+         latency.histogram.sum = s.total_latency.count();
+         oc_compiles.push_back(std::move(latency));
+      }
+   }
+
+   void observe_block(const chain::controller::block_report& br) {
+      const auto& stages = br.stages;
+      block_total_us.histogram.observe(br.total_time.count());
+      block_recover_keys_wait_us.histogram.observe(stages.recover_keys_wait.count());
+      for (const auto& shard : stages.shard_execution) {
+         block_shard_execution_us.histogram.observe(shard.second.count());
+      }
+      block_shard_critical_path_us.histogram.observe(stages.shard_critical_path.count());
+      block_xshard_us.histogram.observe(stages.xshard.count());
+      block_sync_shared_db_us.histogram.observe(stages.sync_shared_db.count());
+      block_merkle_us.histogram.observe(stages.merkle.count());
+      block_process_block_usage_us.histogram.observe(stages.process_block_usage.count());
+      block_commit_us.histogram.observe(stages.commit.count());
+      block_signals_us.histogram.observe(stages.signals.count());
+   }
 
    vector<runtime_metric> metrics() final {
+      // unapplied_transactions, blacklisted_transactions, subjective_bill_account_size and scheduled_trxs are left out
+      // while they are not maintained per shard, they would read as a constant 0
       vector<runtime_metric> metrics{
-            unapplied_transactions,
-            blacklisted_transactions,
             blocks_produced,
             trxs_produced,
             last_irreversible,
             head_block_num,
-            subjective_bill_account_size,
-            scheduled_trxs
+            fork_switches,
+            fork_switch_blocks,
+            fork_switch_last_us,
+            fork_switch_max_us,
+            fork_switch_total_us,
+            signature_cache_hits,
+            signature_cache_misses,
+            signature_cache_size,
+            block_total_us,
+            block_recover_keys_wait_us,
+            block_shard_execution_us,
+            block_shard_critical_path_us,
+            block_xshard_us,
+            block_sync_shared_db_us,
+            block_merkle_us,
+            block_process_block_usage_us,
+            block_commit_us,
+            block_signals_us
       };
 
+      metrics.insert(metrics.end(), oc_compiles.begin(), oc_compiles.end());
+
       return metrics;
    }
 };
@@ -200,6 +280,37 @@ public:
 
    get_unapplied_transactions_result get_unapplied_transactions( const get_unapplied_transactions_params& params, const fc::time_point& deadline ) const;
 
+   struct get_block_timings_params {
+      std::optional<uint32_t>    limit; ///< defaults to all kept blocks, see block-timing-history
+   };
+
+   struct block_timing {
+      uint32_t                          block_num = 0;
+      chain::block_id_type              id;
+      bool                              produced = false;
+      chain::controller::block_report   report;
+   };
+
+   struct get_block_timings_result {
+      std::vector<block_timing>  blocks; ///< most recent block first
+   };
+
+   get_block_timings_result get_block_timings( const get_block_timings_params& params ) const;
+
+   struct get_oc_profile_params {
+      std::optional<uint32_t>    limit;       ///< most sampled entries to return, defaults to all
+      std::optional<bool>        reset;       ///< start a new profile after this one is returned, defaults to false
+      std::optional<bool>        write_pprof; ///< also write the profile as a pprof file, defaults to false
+   };
+
+   struct get_oc_profile_result {
+      fc::variant                profile;
+      std::optional<string>      pprof_file;
+   };
+
+   /// samples taken by the EOS VM OC sampling profiler, see eos-vm-oc-profile-hz
+   get_oc_profile_result get_oc_profile( const get_oc_profile_params& params ) const;
+
 
    void log_failed_transaction(const transaction_id_type& trx_id, const chain::packed_transaction_ptr& packed_trx_ptr, const char* reason) const;
    void register_metrics_listener(metrics_listener listener);
@@ -235,3 +346,8 @@ FC_REFLECT(eosio::producer_plugin::get_account_ram_corrections_result, (rows)(mo
 FC_REFLECT(eosio::producer_plugin::get_unapplied_transactions_params, (lower_bound)(limit)(time_limit_ms))
 FC_REFLECT(eosio::producer_plugin::unapplied_trx, (trx_id)(expiration)(trx_type)(first_auth)(first_receiver)(first_action)(total_actions)(billed_cpu_time_us)(size))
 FC_REFLECT(eosio::producer_plugin::get_unapplied_transactions_result, (size)(incoming_size)(trxs)(more))
+FC_REFLECT(eosio::producer_plugin::get_block_timings_params, (limit))
+FC_REFLECT(eosio::producer_plugin::block_timing, (block_num)(id)(produced)(report))
+FC_REFLECT(eosio::producer_plugin::get_block_timings_result, (blocks))
+FC_REFLECT(eosio::producer_plugin::get_oc_profile_params, (limit)(reset)(write_pprof))
+FC_REFLECT(eosio::producer_plugin::get_oc_profile_result, (profile)(pprof_file))
@@ -9,8 +9,12 @@
 #include <eosio/chain/transaction_object.hpp>
 #include <eosio/chain/thread_utils.hpp>
 #include <eosio/chain/unapplied_transaction_queue.hpp>
+#include <eosio/chain/signature_recovery_cache.hpp>
 #include <eosio/resource_monitor_plugin/resource_monitor_plugin.hpp>
 #include <eosio/chain/xshard_object.hpp>
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+#include <eosio/chain/webassembly/eos-vm-oc/profiler.hpp>
+#endif
 
 #include <fc/io/json.hpp>
 #include <fc/log/logger_config.hpp>
@@ -21,6 +25,7 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 #include <iostream>
+#include <fstream>
 #include <algorithm>
 #include <mutex>
 #include <boost/algorithm/string/predicate.hpp>
@@ -468,6 +473,7 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
 
       incoming::methods::block_sync::method_type::handle        _incoming_block_sync_provider;
       incoming::methods::transaction_async::method_type::handle _incoming_transaction_async_provider;
+      incoming::methods::transaction_batch_async::method_type::handle _incoming_transaction_batch_async_provider;
 
       pending_snapshot_index                                   _pending_snapshot_index;
       subjective_billing                                       _subjective_billing;
@@ -481,6 +487,10 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
 
       producer_plugin_metrics                                   _metrics;
 
+      uint32_t                                                  _block_timing_history = 100;
+      mutable std::mutex                                        _block_timings_mtx;
+      std::deque<producer_plugin::block_timing>                 _block_timings; // most recent block first
+
       /*
        * HACK ALERT
        * Boost timers can be in a state where a handler has not yet executed but is not abortable.
@@ -654,22 +664,46 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          }
       }
 
+      void record_block_timing( uint32_t block_num, const block_id_type& id, bool produced, const controller::block_report& br ) {
+         _metrics.observe_block( br );
+         if( _block_timing_history == 0 )
+            return;
+         std::lock_guard g( _block_timings_mtx );
+         _block_timings.push_front( producer_plugin::block_timing{ block_num, id, produced, br } );
+         if( _block_timings.size() > _block_timing_history )
+            _block_timings.pop_back();
+      }
+
       void update_block_metrics() {
          if (_metrics.should_post()) {
-            // TODO: update_block_metrics
+            // TODO: update_block_metrics, not exported by producer_plugin_metrics::metrics() until maintained
             // _metrics.unapplied_transactions.value = _unapplied_transactions.size();
             // _metrics.subjective_bill_account_size.value = _subjective_billing.get_account_cache_size();
             // _metrics.blacklisted_transactions.value = _blacklisted_transactions.size();
             // _metrics.unapplied_transactions.value = _unapplied_transactions.size();
 
-            // auto &chain = chain_plug->chain();
-            // _metrics.last_irreversible.value = chain.last_irreversible_block_num();
-            // _metrics.head_block_num.value = chain.head_block_num();
+            auto &chain = chain_plug->chain();
+            _metrics.last_irreversible.value = chain.last_irreversible_block_num();
+            _metrics.head_block_num.value = chain.head_block_num();
 
             // const auto& sch_idx = chain.db().get_index<generated_transaction_multi_index, by_delay>();
             // _metrics.scheduled_trxs.value = sch_idx.size();
 
-            // _metrics.post_metrics();
+            const auto& fork_switch_stats = chain.get_fork_switch_stats();
+            _metrics.fork_switches.value        = fork_switch_stats.switches;
+            _metrics.fork_switch_blocks.value   = fork_switch_stats.blocks_applied;
+            _metrics.fork_switch_last_us.value  = fork_switch_stats.last_time.count();
+            _metrics.fork_switch_max_us.value   = fork_switch_stats.max_time.count();
+            _metrics.fork_switch_total_us.value = fork_switch_stats.total_time.count();
+
+            const auto sig_cache_stats = signature_recovery_cache::instance().get_stats();
+            _metrics.signature_cache_hits.value   = sig_cache_stats.hits;
+            _metrics.signature_cache_misses.value = sig_cache_stats.misses;
+            _metrics.signature_cache_size.value   = sig_cache_stats.size;
+
+            _metrics.observe_oc_compiles( chain.get_wasm_interface().oc_compile_stats() );
+
+            _metrics.post_metrics();
          }
       }
 
@@ -799,6 +833,9 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
             }
          }
 
+         if( hbs->id == id ) {
+            record_block_timing( blk_num, id, false, br );
+         }
          update_block_metrics();
 
          return true;
@@ -845,18 +882,7 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
 
          auto is_transient = (trx_type == transaction_metadata::trx_type::read_only || trx_type == transaction_metadata::trx_type::dry_run);
          if( !is_transient ) {
-            next = [this, trx, next{std::move(next)}]( const std::variant<fc::exception_ptr, transaction_trace_ptr>& response ) {
-               next( response );
-
-               fc::exception_ptr except_ptr; // rejected
-               if( std::holds_alternative<fc::exception_ptr>( response ) ) {
-                  except_ptr = std::get<fc::exception_ptr>( response );
-               } else if( std::get<transaction_trace_ptr>( response )->except ) {
-                  except_ptr = std::get<transaction_trace_ptr>( response )->except->dynamic_copy_exception();
-               }
-
-               _transaction_ack_channel.publish( priority::low, std::pair<fc::exception_ptr, packed_transaction_ptr>( except_ptr, trx ) );
-            };
+            next = make_trx_ack_next( trx, std::move(next) );
          }
 
          boost::asio::post(_thread_pool.get_executor(), [self = this, future{std::move(future)}, api_trx, is_transient, return_failure_traces,
@@ -864,52 +890,94 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
             if( future.valid() ) {
                future.wait();
                app().executor().post( priority::low, exec_queue::read_write, [self, future{std::move(future)}, api_trx, is_transient, next{std::move( next )}, trx{std::move(trx)}, return_failure_traces]() mutable {
-
-                  // fc::time_point bt = chain.is_building_block() ? chain.pending_block_time() : chain.head_block_time();
-                  // const fc::time_point expire = trx->packed_trx()->expiration();
-                  chain::controller& chain = self->chain_plug->chain();
-                  if( !chain.is_shard_available(trx->get_shard_name()) ) {
-                     auto except_ptr = std::static_pointer_cast<fc::exception>(
-                           std::make_shared<expired_tx_exception>(
-                                 FC_LOG_MESSAGE( error, "shard ${s} not available , tx=${tx}",
-                                                ("s", trx->get_shard_name())("tx", trx->id()))));
-
-                     self->log_trx_results( trx, nullptr, except_ptr, 0, fc::time_point::now(), is_transient );
-                     next( std::move(except_ptr) );
-                     return;
-                  }
-                  auto shard_itr = self->get_processing_shard_itr(trx->get_shard_name());
-                  auto& shard = shard_itr->second;
-
-                  auto start = fc::time_point::now();
-                  bool shard_is_processing = shard.trx_task_fut.valid();
-                  if (!shard_is_processing) {
-                     // _time_tracker and _idle_trx_time must be protected by shard.trx_task_fut for multi-threads.
-                     auto idle_time = start - shard._idle_trx_time;
-                     shard._time_tracker.add_idle_time( idle_time );
-                     fc_tlog( _log, "Time since last trx: ${t}us, shard=${s}, tx=${tx}", ("t", idle_time)("s", trx->get_shard_name())("tx", trx->id()) );
-                  }
-
-                  auto exception_handler = self->make_trx_exception_handler(shard_itr, trx,
-                                                next, start, is_transient, !shard_is_processing);
-                  try {
-                     auto result = future.get();
-                     if( !self->process_incoming_transaction_async( result, api_trx, return_failure_traces, next) ) {
-                        if( self->in_producing_mode() ) {
-                           self->schedule_maybe_produce_block( true );
-                        } else {
-                           self->restart_speculative_block();
-                        }
-                     } else {
-                        if ( !shard_is_processing && !shard.trx_task_fut.valid() )
-                           shard._idle_trx_time = fc::time_point::now();
-                     }
-                  } CATCH_AND_CALL(exception_handler);
+                  self->push_incoming_transaction( trx, [&future]() { return future.get(); }, api_trx, is_transient, return_failure_traces, next );
                } );
             }
          });
       }
 
+      // called from any thread, keys of each transaction already recovered on the caller's thread pool
+      void on_incoming_transaction_batch_async(incoming_transaction_batch batch) {
+         if( batch.empty() )
+            return;
+
+         for( auto& in : batch ) {
+            fc_dlog(_trx_log, "[TRX_TRACE] Receive new recovered transaction ${trx}, shard: ${s}",
+                    ("trx", in.trx->id())("s", in.trx->get_shard_name()));
+            in.next = make_trx_ack_next( in.trx->packed_trx(), std::move(in.next) );
+         }
+
+         app().executor().post( priority::low, exec_queue::read_write, [self = this, batch{std::move(batch)}]() mutable {
+            for( auto& in : batch ) {
+               self->push_incoming_transaction( in.trx->packed_trx(), [&in]() { return in.trx; }, false, false, false, in.next );
+            }
+         } );
+      }
+
+      // wrap next so that the result is also published on the transaction ack channel
+      next_function<transaction_trace_ptr> make_trx_ack_next( const packed_transaction_ptr& trx, next_function<transaction_trace_ptr> next ) {
+         return [this, trx, next{std::move(next)}]( const std::variant<fc::exception_ptr, transaction_trace_ptr>& response ) {
+            next( response );
+
+            fc::exception_ptr except_ptr; // rejected
+            if( std::holds_alternative<fc::exception_ptr>( response ) ) {
+               except_ptr = std::get<fc::exception_ptr>( response );
+            } else if( std::get<transaction_trace_ptr>( response )->except ) {
+               except_ptr = std::get<transaction_trace_ptr>( response )->except->dynamic_copy_exception();
+            }
+
+            _transaction_ack_channel.publish( priority::low, std::pair<fc::exception_ptr, packed_transaction_ptr>( except_ptr, trx ) );
+         };
+      }
+
+      // called from application thread
+      // @param get_trx_meta returns the transaction_metadata_ptr, may throw if key recovery failed
+      template<typename GetTrxMeta>
+      void push_incoming_transaction( const packed_transaction_ptr& trx, GetTrxMeta&& get_trx_meta, bool api_trx,
+                                      bool is_transient, bool return_failure_traces,
+                                      const next_function<transaction_trace_ptr>& next ) {
+         // fc::time_point bt = chain.is_building_block() ? chain.pending_block_time() : chain.head_block_time();
+         // const fc::time_point expire = trx->packed_trx()->expiration();
+         chain::controller& chain = chain_plug->chain();
+         if( !chain.is_shard_available(trx->get_shard_name()) ) {
+            auto except_ptr = std::static_pointer_cast<fc::exception>(
+                  std::make_shared<expired_tx_exception>(
+                        FC_LOG_MESSAGE( error, "shard ${s} not available , tx=${tx}",
+                                       ("s", trx->get_shard_name())("tx", trx->id()))));
+
+            log_trx_results( trx, nullptr, except_ptr, 0, fc::time_point::now(), is_transient );
+            next( std::move(except_ptr) );
+            return;
+         }
+         auto shard_itr = get_processing_shard_itr(trx->get_shard_name());
+         auto& shard = shard_itr->second;
+
+         auto start = fc::time_point::now();
+         bool shard_is_processing = shard.trx_task_fut.valid();
+         if (!shard_is_processing) {
+            // _time_tracker and _idle_trx_time must be protected by shard.trx_task_fut for multi-threads.
+            auto idle_time = start - shard._idle_trx_time;
+            shard._time_tracker.add_idle_time( idle_time );
+            fc_tlog( _log, "Time since last trx: ${t}us, shard=${s}, tx=${tx}", ("t", idle_time)("s", trx->get_shard_name())("tx", trx->id()) );
+         }
+
+         auto exception_handler = make_trx_exception_handler(shard_itr, trx,
+                                       next, start, is_transient, !shard_is_processing);
+         try {
+            auto result = get_trx_meta();
+            if( !process_incoming_transaction_async( result, api_trx, return_failure_traces, next) ) {
+               if( in_producing_mode() ) {
+                  schedule_maybe_produce_block( true );
+               } else {
+                  restart_speculative_block();
+               }
+            } else {
+               if ( !shard_is_processing && !shard.trx_task_fut.valid() )
+                  shard._idle_trx_time = fc::time_point::now();
+            }
+         } CATCH_AND_CALL(exception_handler);
+      }
+
       bool process_incoming_transaction_async(const transaction_metadata_ptr& trx,
                                               bool api_trx,
                                               bool return_failure_trace,
@@ -1107,6 +1175,8 @@ void producer_plugin::set_program_options(
           "Time in microseconds the write window lasts.")
          ("read-only-read-window-time-us", bpo::value<uint32_t>()->default_value(my->_ro_read_window_time_us.count()),
           "Time in microseconds the read window lasts.")
+         ("block-timing-history", bpo::value<uint32_t>()->default_value(my->_block_timing_history),
+          "Number of most recent applied or produced blocks whose stage timings are kept for /v1/producer/get_block_timings")
          ;
    config_file_options.add(producer_options);
 }
@@ -1228,6 +1298,7 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
    my->_subjective_billing.set_expired_accumulator_average_window( subjective_account_decay_time );
 
    my->_max_transaction_time_ms = options.at("max-transaction-time").as<int32_t>();
+   my->_block_timing_history = options.at("block-timing-history").as<uint32_t>();
 
    my->_max_irreversible_block_age_us = fc::seconds(options.at("max-irreversible-block-age").as<int32_t>());
 
@@ -1369,6 +1440,11 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
       return my->on_incoming_transaction_async(trx, api_trx, trx_type, return_failure_traces, next );
    });
 
+   my->_incoming_transaction_batch_async_provider = app().get_method<incoming::methods::transaction_batch_async>().register_provider(
+         [this](incoming_transaction_batch batch) -> void {
+      return my->on_incoming_transaction_batch_async( std::move(batch) );
+   });
+
    if (options.count("greylist-account")) {
       std::vector<std::string> greylist = options["greylist-account"].as<std::vector<std::string>>();
       greylist_params param;
@@ -1870,6 +1946,44 @@ producer_plugin::get_account_ram_corrections( const get_account_ram_corrections_
    return result;
 }
 
+producer_plugin::get_block_timings_result
+producer_plugin::get_block_timings( const get_block_timings_params& p ) const {
+   get_block_timings_result result;
+   std::lock_guard g( my->_block_timings_mtx );
+   const size_t limit = std::min<size_t>( p.limit.value_or( my->_block_timings.size() ), my->_block_timings.size() );
+   result.blocks.assign( my->_block_timings.begin(), my->_block_timings.begin() + limit );
+   return result;
+}
+
+producer_plugin::get_oc_profile_result
+producer_plugin::get_oc_profile( const get_oc_profile_params& p ) const {
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+   auto& profiler = chain::eosvmoc::sampling_profiler::instance();
+   EOS_ASSERT( profiler.enabled(), plugin_config_exception, "EOS VM OC profiler is not enabled, see eos-vm-oc-profile-hz" );
+
+   get_oc_profile_result result;
+   const bool reset = p.reset.value_or( false );
+   if( p.write_pprof.value_or( false ) ) {
+      // the report is taken before the pprof so both describe the same samples, only the pprof resets
+      result.profile = fc::variant( profiler.report( p.limit.value_or( 0 ), false ) );
+      const std::vector<char> pprof = profiler.pprof( reset );
+
+      const bfs::path dir = app().data_dir() / "oc-profiles";
+      fc::create_directories( dir );
+      const bfs::path file = dir / ("oc-profile-" + std::to_string( fc::time_point::now().time_since_epoch().count() ) + ".pb");
+      std::ofstream ofs( file.generic_string(), std::ofstream::binary | std::ofstream::trunc );
+      ofs.write( pprof.data(), pprof.size() );
+      EOS_ASSERT( ofs.good(), plugin_exception, "unable to write EOS VM OC profile ${f}", ("f", file.generic_string()) );
+      result.pprof_file = file.generic_string();
+   } else {
+      result.profile = fc::variant( profiler.report( p.limit.value_or( 0 ), reset ) );
+   }
+   return result;
+#else
+   EOS_THROW( plugin_config_exception, "EOS VM OC is not supported by this build" );
+#endif
+}
+
 producer_plugin::get_unapplied_transactions_result
 producer_plugin::get_unapplied_transactions( const get_unapplied_transactions_params& p, const fc::time_point& deadline ) const {
 
@@ -3318,7 +3432,7 @@ void producer_plugin_impl::produce_block() {
       return sigs;
    } );
 
-   chain.commit_block();
+   chain.commit_block( br );
 
    block_state_ptr new_bs = chain.head_block_state();
 
@@ -3332,6 +3446,7 @@ void producer_plugin_impl::produce_block() {
    auto trx_size = new_bs->block->get_trx_size();
    ++_metrics.blocks_produced.value;
    _metrics.trxs_produced.value += trx_size;
+   record_block_timing( new_bs->block_num, new_bs->id, true, br );
 
    ilog("Produced block ${id}... #${n} @ ${t} signed by ${p} "
         "[trxs: ${count}, lib: ${lib}, confirmed: ${confs}, net: ${net}, cpu: ${cpu}, elapsed: ${et}, time: ${tt}]",
@@ -13,6 +13,7 @@
 #include <prometheus/metric_family.h>
 #include <prometheus/collectable.h>
 #include <prometheus/counter.h>
+#include <prometheus/histogram.h>
 #include <prometheus/summary.h>
 #include <prometheus/text_serializer.h>
 #include <prometheus/registry.h>
@@ -42,6 +43,7 @@ namespace eosio {
       std::shared_ptr<Registry> _registry;
       std::vector<std::reference_wrapper<Family<Gauge>>> _gauges;
       std::vector<std::reference_wrapper<Family<Counter>>> _counters;
+      std::vector<std::reference_wrapper<Family<Histogram>>> _histograms;
 
       void add_gauge_metric(const runtime_metric& plugin_metric) {
          auto& gauge_family = BuildGauge()
@@ -68,6 +70,18 @@ namespace eosio {
          tlog("Added counter metric ${f}:${l}", ("f", plugin_metric.family) ("l", plugin_metric.label));
       }
 
+      void add_histogram_metric(const runtime_metric& plugin_metric) {
+         auto& histogram_family = BuildHistogram()
+               .Name(plugin_metric.family)
+               .Help("")
+               .Register(*_registry);
+         auto& histogram = histogram_family.Add({}, plugin_metric.histogram.bounds);
+         histogram.ObserveMultiple(plugin_metric.histogram.counts, plugin_metric.histogram.sum);
+         _histograms.push_back(histogram_family);
+
+         tlog("Added histogram metric ${f}:${l}", ("f", plugin_metric.family) ("l", plugin_metric.label));
+      }
+
       void add_runtime_metric(const runtime_metric& plugin_metric) {
          switch(plugin_metric.type) {
             case metric_type::gauge:
@@ -76,6 +90,9 @@ namespace eosio {
             case metric_type::counter:
                add_counter_metric(plugin_metric);
                break;
+            case metric_type::histogram:
+               add_histogram_metric(plugin_metric);
+               break;
 
             default:
                break;
@@ -78,6 +78,7 @@ void blocklog_actions::setup(CLI::App& app) {
    // subcommand - make index
    auto* make_index = sub->add_subcommand("make-index", "Create blocks.index from blocks.log. Must give 'blocks-dir'. Give 'output-file' relative to current directory or absolute path (default is <blocks-dir>/blocks.index).")->callback([err_guard]() { err_guard(&blocklog_actions::make_index); });
    make_index->add_option("--output-file,-o", opt->output_file, "The file to write the output to (absolute or relative path).  If not specified then output is to stdout.");
+   make_index->add_option("--threads", opt->threads, "The number of threads used to scan blocks.log.")->capture_default_str();
 
    // subcommand - trim blocklog
    auto* trim_blocklog = sub->add_subcommand("trim-blocklog", "Trim blocks.log and blocks.index. Must give 'blocks-dir' and 'first' and/or 'last'.")->callback([err_guard]() { err_guard(&blocklog_actions::trim_blocklog); });
@@ -89,21 +90,32 @@ void blocklog_actions::setup(CLI::App& app) {
    extract_blocks->add_option("--first,-f", opt->first_block, "The first block number to keep.")->required();
    extract_blocks->add_option("--last,-l", opt->last_block, "The last block number to keep.")->required();
    extract_blocks->add_option("--output-dir", opt->output_dir, "The output directory for the block log extracted from blocks-dir.")->required();
+   extract_blocks->add_option("--threads", opt->threads, "The number of threads used to copy blocks.")->capture_default_str();
 
    // subcommand - split blocks
    auto* split_blocks = sub->add_subcommand("split-blocks", "Split the blocks.log based on the stride and store the result in the specified 'output-dir'.")->callback([err_guard]() { err_guard(&blocklog_actions::split_blocks); });
    split_blocks->add_option("--blocks-dir", opt->blocks_dir, "The location of the blocks directory (absolute path or relative to the current directory).");
    split_blocks->add_option("--output-dir", opt->output_dir, "The output directory for the split block log.")->required();
    split_blocks->add_option("--stride", opt->stride, "The number of blocks to split into each file.")->required();
+   split_blocks->add_option("--threads", opt->threads, "The number of threads used to copy blocks.")->capture_default_str();
 
    // subcommand - merge blocks
    auto* merge_blocks = sub->add_subcommand("merge-blocks", "Merge block log files in 'blocks-dir' with the file pattern 'blocks-\\d+-\\d+.[log,index]' to 'output-dir' whenever possible."
           "The files in 'blocks-dir' will be kept without change.")->callback([err_guard]() { err_guard(&blocklog_actions::merge_blocks); });
    merge_blocks->add_option("--blocks-dir", opt->blocks_dir, "The location of the blocks directory (absolute path or relative to the current directory).");
    merge_blocks->add_option("--output-dir", opt->output_dir, "The output directory for the merged block log.")->required();
+   merge_blocks->add_option("--threads", opt->threads, "The number of threads used to copy blocks.")->capture_default_str();
+
+   // subcommand - compress blocks
+   auto* compress_blocks = sub->add_subcommand("compress", "Write a copy of blocks.log and blocks.index of 'blocks-dir' to 'output-dir' in which each block is compressed individually. "
+          "The compressed block log can be used in place of the original one.")->callback([err_guard]() { err_guard(&blocklog_actions::compress_blocks); });
+   compress_blocks->add_option("--blocks-dir", opt->blocks_dir, "The location of the blocks directory (absolute path or relative to the current directory).");
+   compress_blocks->add_option("--output-dir", opt->output_dir, "The output directory for the compressed block log.")->required();
 
    // subcommand - smoke test
-   sub->add_subcommand("smoke-test", "Quick test that blocks.log and blocks.index are well formed and agree with each other.")->callback([err_guard]() { err_guard(&blocklog_actions::smoke_test); });
+   auto* smoke_test = sub->add_subcommand("smoke-test", "Quick test that blocks.log and blocks.index are well formed and agree with each other.")->callback([err_guard]() { err_guard(&blocklog_actions::smoke_test); });
+   smoke_test->add_flag("--full", opt->full_validation, "Deserialize every block and verify its id and link to the previous block instead of sampling block numbers.");
+   smoke_test->add_option("--threads", opt->threads, "The number of threads used by --full.")->capture_default_str();
 
    // subcommand - vacuum
    sub->add_subcommand("vacuum", "Vacuum a pruned blocks.log in to an un-pruned blocks.log")->callback([err_guard]() { err_guard(&blocklog_actions::do_vacuum); });
@@ -146,7 +158,7 @@ int blocklog_actions::make_index() {
    report_time rt("making index");
    const auto log_level = fc::logger::get(DEFAULT_LOGGER).get_log_level();
    fc::logger::get(DEFAULT_LOGGER).set_log_level(fc::log_level::debug);
-   block_log::construct_index(block_file.generic_string(), out_file.generic_string());
+   block_log::construct_index(block_file.generic_string(), out_file.generic_string(), opt->threads);
    fc::logger::get(DEFAULT_LOGGER).set_log_level(log_level);
    rt.report();
 
@@ -223,7 +235,7 @@ bool blocklog_actions::trim_blocklog_front(bfs::path block_dir, uint32_t n) {//n
 void blocklog_actions::extract_block_range(bfs::path block_dir, bfs::path output_dir, uint32_t start, uint32_t last) {
    report_time rt("extracting block range");
    EOS_ASSERT(last > start, block_log_exception, "extract range end must be greater than start");
-   block_log::extract_block_range(block_dir, output_dir, start, last);
+   block_log::extract_block_range(block_dir, output_dir, start, last, opt->threads);
    rt.report();
 }
 
@@ -232,6 +244,11 @@ int blocklog_actions::smoke_test() {
    bfs::path block_dir = opt->blocks_dir;
    cout << "\nSmoke test of blocks.log and blocks.index in directory " << block_dir << '\n';
    block_log::smoke_test(block_dir, 0);
+   if(opt->full_validation) {
+      report_time rt("validating all blocks");
+      block_log::full_validate(block_dir, opt->threads);
+      rt.report();
+   }
    cout << "\nno problems found\n"; // if get here there were no exceptions
    return 0;
 }
@@ -271,9 +288,10 @@ int blocklog_actions::read_log() {
 
    eosio::chain::branch_type fork_db_branch;
 
-   if(fc::exists(bfs::path(opt->blocks_dir) / config::reversible_blocks_dir_name / config::forkdb_filename)) {
+   const bfs::path fork_db_dir = bfs::path(opt->blocks_dir) / config::reversible_blocks_dir_name;
+   if(fc::exists(fork_db_dir / config::forkdb_journal_filename) || fc::exists(fork_db_dir / config::forkdb_filename)) {
       ilog("opening fork_db");
-      fork_database fork_db(bfs::path(opt->blocks_dir) / config::reversible_blocks_dir_name);
+      fork_database fork_db(fork_db_dir);
 
       fork_db.open([](block_timestamp_type timestamp,
                       const flat_set<digest_type>& cur_features,
@@ -354,12 +372,19 @@ int blocklog_actions::read_log() {
 }
 
 int blocklog_actions::split_blocks() {
-   block_log::split_blocklog(opt->blocks_dir, opt->output_dir, opt->stride);
+   block_log::split_blocklog(opt->blocks_dir, opt->output_dir, opt->stride, opt->threads);
    return 0;
 
 }
 
 int blocklog_actions::merge_blocks() {
-   block_log::merge_blocklogs(opt->blocks_dir, opt->output_dir);
+   block_log::merge_blocklogs(opt->blocks_dir, opt->output_dir, opt->threads);
+   return 0;
+}
+
+int blocklog_actions::compress_blocks() {
+   report_time rt("compressing block log");
+   block_log::compress_blocklog(opt->blocks_dir, opt->output_dir);
+   rt.report();
    return 0;
 }
\ No newline at end of file
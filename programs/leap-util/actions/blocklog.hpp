@@ -3,6 +3,7 @@
 #include <boost/filesystem/path.hpp>
 #include <eosio/chain/block_log.hpp>
 #include <eosio/chain/config.hpp>
+#include <thread>
 
 namespace bfs = boost::filesystem;
 using namespace eosio::chain;
@@ -14,10 +15,12 @@ struct blocklog_options {
    uint32_t last_block = std::numeric_limits<uint32_t>::max();
    std::string output_dir = "";
    uint32_t stride = 100000;
+   uint32_t threads = std::max(std::thread::hardware_concurrency(), 1U);
 
    // flags
    bool no_pretty_print = false;
    bool as_json_array = false;
+   bool full_validation = false;
 
    block_log_config blog_conf;
 };
@@ -43,4 +46,5 @@ protected:
 
    int split_blocks();
    int merge_blocks();
+   int compress_blocks();
 };
\ No newline at end of file
@@ -1517,6 +1517,8 @@ class Cluster(object):
             os.remove(f)
         for f in glob.glob(f"{Utils.DataDir}/first_trx_*.txt"):
             os.remove(f)
+        for f in glob.glob(f"{Utils.DataDir}/shard_stats_*.txt"):
+            os.remove(f)
 
         for f in self.filesToCleanup:
             os.remove(f)
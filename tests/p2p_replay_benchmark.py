@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+
+import json
+import os
+import re
+import shutil
+import signal
+import time
+import urllib.request
+
+from datetime import datetime
+from TestHarness import Node, TestHelper, Utils
+from TestHarness.TestHelper import AppArgs
+
+###############################################################
+# p2p_replay_benchmark
+#
+#   Benchmark harness for net_plugin block propagation. A recorded block log (e.g. taken from mainnet) is
+#   served by node 0 and relayed down a line of loopback nodes 0 -> 1 -> ... -> N-1.
+#   Every node runs net_plugin with debug logging and the prometheus plugin so that
+#     - the time each block is first received on each node gives the per hop and end to end propagation
+#       latency distribution (node 1 is the origin, node 0 only serves the recorded blocks),
+#     - the per message type counters of net_plugin give the bytes received per block and the net thread
+#       cpu time spent per message type on every node.
+#   Not run by ctest, requires --block-log-dir pointing at a directory holding blocks.log/blocks.index.
+###############################################################
+
+Print=Utils.Print
+
+appArgs = AppArgs()
+appArgs.add(flag="--block-log-dir", type=str, help="directory holding the recorded blocks.log and blocks.index", default=None)
+appArgs.add(flag="--nodes", type=int, help="number of nodes in the line topology, including the serving node", default=4)
+appArgs.add(flag="--blocks", type=int, help="number of blocks to relay, 0 relays the whole recorded log", default=0)
+appArgs.add(flag="--net-threads", type=int, help="net_plugin thread count of each node", default=2)
+appArgs.add(flag="--timeout", type=int, help="seconds to wait for the last node to receive all blocks", default=600)
+appArgs.add(flag="--report-file", type=str, help="write the report as json to this file", default=None)
+args = TestHelper.parse_args({"-v","--keep-logs","--leave-running"}, applicationSpecificArgs=appArgs)
+Utils.Debug=args.v
+
+if args.block_log_dir is None or not os.path.exists(os.path.join(args.block_log_dir, "blocks.log")):
+    Utils.errorExit("--block-log-dir must point to a directory containing blocks.log")
+if args.nodes < 3:
+    Utils.errorExit("--nodes must be at least 3 to measure a hop")
+
+p2pBasePort=9876
+httpBasePort=8888
+prometheusBasePort=9101
+
+receivedRegex = re.compile(r'^debug\s+(\S+)\s.*received signed_block: #(\d+) ')
+
+loggingConfig = {
+    "includes": [],
+    "appenders": [{
+        "name": "stderr",
+        "type": "console",
+        "args": { "stream": "std_error", "level_colors": [] },
+        "enabled": True
+    }],
+    "loggers": [{
+        "name": "default", "level": "info", "enabled": True, "additivity": False, "appenders": ["stderr"]
+    },{
+        "name": "net_plugin_impl", "level": "debug", "enabled": True, "additivity": False, "appenders": ["stderr"]
+    }]
+}
+
+def percentile(sortedValues, pct):
+    if len(sortedValues) == 0:
+        return 0
+    idx = min(len(sortedValues) - 1, int(round(pct / 100.0 * (len(sortedValues) - 1))))
+    return sortedValues[idx]
+
+def distribution(values):
+    values = sorted(values)
+    if len(values) == 0:
+        return {"count": 0}
+    return {
+        "count": len(values),
+        "min": values[0],
+        "avg": round(sum(values) / len(values), 3),
+        "p50": percentile(values, 50),
+        "p90": percentile(values, 90),
+        "p99": percentile(values, 99),
+        "max": values[-1]
+    }
+
+def prepareNode(nodeId):
+    dataDir = Utils.getNodeDataDir(nodeId)
+    configDir = Utils.getNodeConfigDir(nodeId)
+    for d in (dataDir, configDir):
+        if os.path.exists(d):
+            shutil.rmtree(d)
+        os.makedirs(d)
+    with open(os.path.join(configDir, "logging.json"), "w") as f:
+        json.dump(loggingConfig, f, indent=2)
+    return dataDir, configDir
+
+def nodeCmd(nodeId, dataDir, configDir):
+    cmd = f"{Utils.EosServerPath} --data-dir={dataDir} --config-dir={configDir}" \
+          f" --plugin=eosio::net_plugin --plugin=eosio::prometheus_plugin --plugin=eosio::http_plugin" \
+          f" --net-threads {args.net_threads} --sync-fetch-span 1000" \
+          f" --p2p-listen-endpoint 127.0.0.1:{p2pBasePort + nodeId}" \
+          f" --http-server-address 127.0.0.1:{httpBasePort + nodeId}" \
+          f" --prometheus-exporter-address 127.0.0.1:{prometheusBasePort + nodeId}"
+    if nodeId > 0:
+        cmd += f" --p2p-peer-address 127.0.0.1:{p2pBasePort + nodeId - 1}"
+    return cmd
+
+def receivedTimes(nodeId):
+    """Time each block was first received on nodeId, read from the node's stderr log."""
+    times = {}
+    dataDir = Utils.getNodeDataDir(nodeId)
+    for fileName in sorted(os.listdir(dataDir)):
+        if not fileName.startswith("stderr."):
+            continue
+        with open(os.path.join(dataDir, fileName), "r") as f:
+            for line in f:
+                m = receivedRegex.match(line)
+                if m is None:
+                    continue
+                blockNum = int(m.group(2))
+                if blockNum not in times:
+                    times[blockNum] = datetime.strptime(m.group(1), "%Y-%m-%dT%H:%M:%S.%f")
+    return times
+
+def scrapeMetrics(nodeId):
+    url = f"http://127.0.0.1:{prometheusBasePort + nodeId}/v1/prometheus/metrics"
+    metrics = {}
+    with urllib.request.urlopen(url, timeout=10) as resp:
+        for line in resp.read().decode("utf-8").splitlines():
+            if line.startswith("#") or len(line.strip()) == 0:
+                continue
+            name, value = line.rsplit(" ", 1)
+            metrics[name.split("{")[0]] = float(value)
+    return metrics
+
+def headBlockNum(node):
+    info = node.getInfo(silentErrors=True)
+    return info["head_block_num"] if info is not None else 0
+
+nodes = []
+testSuccessful = False
+try:
+    # node 0 serves the recorded blocks, the others start from the recorded genesis and sync through the line
+    dataDir, configDir = prepareNode(0)
+    blocksDir = os.path.join(dataDir, "blocks")
+    os.makedirs(blocksDir)
+    for f in ("blocks.log", "blocks.index"):
+        if os.path.exists(os.path.join(args.block_log_dir, f)):
+            shutil.copy(os.path.join(args.block_log_dir, f), blocksDir)
+    genesisFile = os.path.join(configDir, "genesis.json")
+    if os.system(f"{Utils.EosServerPath} --data-dir={dataDir} --config-dir={configDir} --extract-genesis-json {genesisFile}") != 0:
+        Utils.errorExit("Failed to extract genesis from recorded block log")
+
+    node = Node(TestHelper.LOCAL_HOST, httpBasePort, 0)
+    node.launchCmd(nodeCmd(0, dataDir, configDir) + " --replay-blockchain", cachePopen=True)
+    nodes.append(node)
+    Print("Waiting for serving node to replay recorded blocks")
+    # http is only served once replay completes, at which point head is the last recorded block
+    assert Utils.waitForBool(lambda: headBlockNum(nodes[0]) > 0, timeout=args.timeout), "serving node failed to replay"
+    lastBlock = headBlockNum(nodes[0])
+    if args.blocks > 0:
+        lastBlock = min(lastBlock, args.blocks)
+
+    for nodeId in range(1, args.nodes):
+        dataDir, configDir = prepareNode(nodeId)
+        node = Node(TestHelper.LOCAL_HOST, httpBasePort + nodeId, nodeId)
+        node.launchCmd(nodeCmd(nodeId, dataDir, configDir) + f" --genesis-json {genesisFile}", cachePopen=True)
+        nodes.append(node)
+
+    start = time.time()
+    Print(f"Relaying {lastBlock} blocks through {args.nodes} nodes")
+    assert Utils.waitForBool(lambda: headBlockNum(nodes[-1]) >= lastBlock, timeout=args.timeout, sleepTime=1), \
+        f"last node did not reach block {lastBlock}"
+    elapsed = time.time() - start
+
+    metrics = [scrapeMetrics(nodeId) for nodeId in range(args.nodes)]
+    times = [receivedTimes(nodeId) for nodeId in range(args.nodes)]
+
+    report = {"blocks": lastBlock, "nodes": args.nodes, "elapsed_sec": round(elapsed, 3), "hops": [], "nodes_stats": []}
+    for nodeId in range(1, args.nodes - 1):
+        down = times[nodeId + 1]
+        deltas = [(down[n] - t).total_seconds() * 1000 for n, t in times[nodeId].items() if n in down]
+        report["hops"].append({"from": nodeId, "to": nodeId + 1, "latency_ms": distribution(deltas)})
+    origin, last = times[1], times[-1]
+    report["end_to_end_latency_ms"] = distribution([(last[n] - t).total_seconds() * 1000 for n, t in origin.items() if n in last])
+
+    for nodeId in range(1, args.nodes):
+        m = metrics[nodeId]
+        received = max(1, m.get("signed_block_received", 0))
+        report["nodes_stats"].append({
+            "node": nodeId,
+            "bytes_per_block": round(m.get("signed_block_received_bytes", 0) / received, 1),
+            "cpu_us_per_block": round(m.get("signed_block_cpu_us", 0) / received, 3),
+            "cpu_us": {k[:-len("_cpu_us")]: v for k, v in m.items() if k.endswith("_cpu_us")},
+            "received": {k[:-len("_received")]: v for k, v in m.items() if k.endswith("_received")}
+        })
+
+    Print(json.dumps(report, indent=2))
+    if args.report_file is not None:
+        with open(args.report_file, "w") as f:
+            json.dump(report, f, indent=2)
+    testSuccessful = True
+finally:
+    if not args.leave_running:
+        for node in nodes:
+            node.kill(signal.SIGTERM)
+    if testSuccessful and not args.keep_logs:
+        for nodeId in range(args.nodes):
+            shutil.rmtree(Utils.getNodeDataDir(nodeId), ignore_errors=True)
+            shutil.rmtree(Utils.getNodeConfigDir(nodeId), ignore_errors=True)
+
+exitCode = 0 if testSuccessful else 1
+exit(exitCode)
@@ -228,11 +228,14 @@ def scrapeLog(data: chainData, path):
         for fork in forks:
             data.forkedBlocks.append(int(fork[1]) - int(fork[3]) + 1)
 
-def scrapeTrxGenLog(trxSent, path):
+def scrapeTrxGenLog(trxSent, path, trxSentShard=None):
     #trxGenLogs/trx_data_output_*.txt
     selectedopen = selectedOpen(path)
     with selectedopen(path, 'rt') as f:
-        trxSent.update(dict([(x[0], x[1]) for x in (line.rstrip('\n').split(',') for line in f)]))
+        for x in (line.rstrip('\n').split(',') for line in f):
+            trxSent[x[0]] = x[1]
+            if trxSentShard is not None and len(x) > 2:
+                trxSentShard[x[0]] = x[2]
 
 def scrapeBlockTrxDataLog(trxDict, path, nodeosVers):
     #blockTrxData.txt
@@ -249,11 +252,11 @@ def scrapeBlockDataLog(blockDict, path):
     with selectedopen(path, 'rt') as f:
         blockDict.update(dict([(x[0], blkData(x[1], x[2], x[3], x[4])) for x in (line.rstrip('\n').split(',') for line in f)]))
 
-def scrapeTrxGenTrxSentDataLogs(trxSent, trxGenLogDirPath, quiet):
+def scrapeTrxGenTrxSentDataLogs(trxSent, trxGenLogDirPath, quiet, trxSentShard=None):
     filesScraped = []
     for fileName in trxGenLogDirPath.glob("trx_data_output_*.txt"):
         filesScraped.append(fileName)
-        scrapeTrxGenLog(trxSent, fileName)
+        scrapeTrxGenLog(trxSent, fileName, trxSentShard)
 
     if not quiet:
         print(f"Transaction Log Files Scraped: {filesScraped}")
@@ -265,6 +268,19 @@ def populateTrxSentTimestamp(trxSent: dict, trxDict: dict, notFound):
         else:
             notFound.append(sentTrxId)
 
+def calcShardStats(trxSentShard: dict, trxDict: dict, testDurationSec) -> dict:
+    """Per shard sent, dropped (sent but not found in a block), failure rate and achieved TPS of the generated transactions"""
+    shardStats = {}
+    for trxId, shard in trxSentShard.items():
+        stat = shardStats.setdefault(shard, {'sent': 0, 'dropped': 0})
+        stat['sent'] += 1
+        if trxId not in trxDict:
+            stat['dropped'] += 1
+    for stat in shardStats.values():
+        stat['failureRate'] = stat['dropped'] / stat['sent']
+        stat['achievedTps'] = (stat['sent'] - stat['dropped']) / testDurationSec if testDurationSec else 0
+    return shardStats
+
 def populateTrxLatencies(blockDict: dict, trxDict: dict):
     for trxId, data in trxDict.items():
         if data.calcdTimeEpoch != 0:
@@ -436,7 +452,7 @@ def calcTrxLatencyCpuNetStats(trxDict : dict, blockDict: dict):
 
 def createReport(guide: chainBlocksGuide, tpsTestConfig: TpsTestConfig, tpsStats: stats, blockSizeStats: stats, trxLatencyStats: basicStats, trxCpuStats: basicStats,
                  trxNetStats: basicStats, forkedBlocks, droppedBlocks, prodWindows: productionWindows, notFound: dict, testStart: datetime, testFinish: datetime,
-                 argsDict: dict, completedRun: bool, nodeosVers: str) -> dict:
+                 argsDict: dict, completedRun: bool, nodeosVers: str, shardStats: dict=None) -> dict:
     report = {}
     report['completedRun'] = completedRun
     report['testStart'] = testStart
@@ -460,6 +476,8 @@ def createReport(guide: chainBlocksGuide, tpsTestConfig: TpsTestConfig, tpsStats
     report['Analysis']['ProductionWindowsMissed'] = prodWindows.missedWindows
     report['Analysis']['ForkedBlocks'] = forkedBlocks
     report['Analysis']['ForksCount'] = len(forkedBlocks)
+    if shardStats:
+        report['Analysis']['Shards'] = shardStats
     report['args'] =  argsDict
     report['env'] = {'system': system(), 'os': os.name, 'release': release(), 'logical_cpu_count': os.cpu_count()}
     report['nodeosVersion'] = nodeosVers
@@ -491,7 +509,8 @@ def calcAndReport(data: chainData, tpsTestConfig: TpsTestConfig, artifacts: Arti
     scrapeLog(data, artifacts.nodeosLogPath)
 
     trxSent = {}
-    scrapeTrxGenTrxSentDataLogs(trxSent, artifacts.trxGenLogDirPath, tpsTestConfig.quiet)
+    trxSentShard = {}
+    scrapeTrxGenTrxSentDataLogs(trxSent, artifacts.trxGenLogDirPath, tpsTestConfig.quiet, trxSentShard)
 
     trxDict = {}
     scrapeBlockTrxDataLog(trxDict, artifacts.blockTrxDataPath, nodeosVers)
@@ -517,6 +536,7 @@ def calcAndReport(data: chainData, tpsTestConfig: TpsTestConfig, artifacts: Arti
     tpsStats = scoreTransfersPerSecond(data, guide)
     blkSizeStats = calcBlockSizeStats(data, guide)
     prodWindows = calcProductionWindows(prodDict)
+    shardStats = calcShardStats(trxSentShard, trxDict, tpsTestConfig.testDurationSec)
 
     if not tpsTestConfig.quiet:
         print(f"Blocks Guide: {guide}\nTPS: {tpsStats}\nBlock Size: {blkSizeStats}\nTrx Latency: {trxLatencyStats}\nTrx CPU: {trxCpuStats}\nTrx Net: {trxNetStats}")
@@ -530,7 +550,7 @@ def calcAndReport(data: chainData, tpsTestConfig: TpsTestConfig, artifacts: Arti
     report = createReport(guide=guide, tpsTestConfig=tpsTestConfig, tpsStats=tpsStats, blockSizeStats=blkSizeStats, trxLatencyStats=trxLatencyStats,
                           trxCpuStats=trxCpuStats, trxNetStats=trxNetStats, forkedBlocks=data.forkedBlocks, droppedBlocks=data.droppedBlocks,
                           prodWindows=prodWindows, notFound=notFound, testStart=start, testFinish=finish, argsDict=argsDict, completedRun=completedRun,
-                          nodeosVers=nodeosVers)
+                          nodeosVers=nodeosVers, shardStats=shardStats)
     return report
 
 def exportReportAsJSON(report: json, exportPath):
@@ -27,6 +27,7 @@ int main(int argc, char** argv) {
    et::user_specified_trx_config user_trx_config;
    et::accounts_config accts_config;
    et::trx_tps_tester_config tester_config;
+   et::shard_config shards_config;
 
    const int64_t trx_expiration_max = 3600;
    const uint16_t generator_id_max = 960;
@@ -37,6 +38,7 @@ int main(int argc, char** argv) {
    std::string lib_id_str;
    std::string accts;
    std::string p_keys;
+   std::string shards;
    int64_t spinup_time_us = 1000000;
    uint32_t max_lag_per = 5;
    int64_t max_lag_duration_us = 1000000;
@@ -62,6 +64,9 @@ int main(int argc, char** argv) {
          ("abi-file", bpo::value<std::string>(&user_trx_config._abi_data_file_path), "The path to the contract abi file to use for the supplied transaction action data")
          ("actions-data", bpo::value<std::string>(&user_trx_config._actions_data_json_file_or_str), "The json actions data file or json actions data description string to use")
          ("actions-auths", bpo::value<std::string>(&user_trx_config._actions_auths_json_file_or_str), "The json actions auth file or json actions auths description string to use, containting authAcctName to activePrivateKey pairs.")
+         ("shards", bpo::value<std::string>(&shards), "comma-separated list of shards to spread the transfer accounts across, round robin. Each trx carries the transaction shard extension of its sender's shard. Defaults to none, no shard extension.")
+         ("shard-skew", bpo::value<double>(&shards_config._skew)->default_value(0), "Skew of the load across shards, the i-th of shards receives load proportional to 1/i^shard-skew. Defaults to 0, even load.")
+         ("xshard-ratio", bpo::value<double>(&shards_config._xshard_ratio)->default_value(0), "Ratio (0-1) of trxs that are xshout transfers from the sender's shard to the next of shards. Requires at least 2 shards. Defaults to 0.")
          ("peer-endpoint", bpo::value<std::string>(&provider_config._peer_endpoint)->default_value("127.0.0.1"), "set the peer endpoint to send transactions to")
          ("port", bpo::value<uint16_t>(&provider_config._port)->default_value(9876), "set the peer endpoint port to send transactions to")
          ("help,h", "print this list")
@@ -141,6 +146,37 @@ int main(int argc, char** argv) {
          }
       }
 
+      if(!shards.empty()) {
+         if(transaction_specified) {
+            ilog("Initialization error: shards only apply to auto transfer transaction generation.");
+            cli.print(std::cerr);
+            return INITIALIZE_FAIL;
+         }
+         std::vector<std::string> shard_str_vector;
+         boost::split(shard_str_vector, shards, boost::is_any_of(","));
+         for(const std::string& shard_name: shard_str_vector) {
+            shards_config._shard_names.emplace_back(shard_name);
+         }
+      }
+
+      if(shards_config._skew < 0) {
+         ilog("Initialization error: shard-skew cannot be negative");
+         cli.print(std::cerr);
+         return INITIALIZE_FAIL;
+      }
+
+      if(shards_config._xshard_ratio < 0 || shards_config._xshard_ratio > 1) {
+         ilog("Initialization error: xshard-ratio must be between 0 and 1");
+         cli.print(std::cerr);
+         return INITIALIZE_FAIL;
+      }
+
+      if(shards_config._xshard_ratio > 0 && shards_config._shard_names.size() < 2) {
+         ilog("Initialization error: xshard-ratio requires at least 2 shards");
+         cli.print(std::cerr);
+         return INITIALIZE_FAIL;
+      }
+
       if(trx_gen_base_config._generator_id > generator_id_max) {
          ilog("Initialization error: Exceeded max value for generator id. Value must be less than ${max}.", ("max", generator_id_max));
          cli.print(std::cerr);
@@ -182,6 +218,9 @@ int main(int argc, char** argv) {
    ilog("Initial Provider config: ${config}", ("config", provider_config.to_string()));
    ilog("Initial Accounts config: ${config}", ("config", accts_config.to_string()));
    ilog("Transaction TPS Tester config: ${config}", ("config", tester_config.to_string()));
+   if (shards_config.enabled()) {
+      ilog("Shards config: ${config}", ("config", shards_config.to_string()));
+   }
 
    if (transaction_specified) {
       ilog("User Transaction Specified: ${config}", ("config", user_trx_config.to_string()));
@@ -198,7 +237,7 @@ int main(int argc, char** argv) {
          return OTHER_FAIL;
       }
    } else {
-      auto generator = std::make_shared<et::transfer_trx_generator>(trx_gen_base_config, provider_config, accts_config);
+      auto generator = std::make_shared<et::transfer_trx_generator>(trx_gen_base_config, provider_config, accts_config, shards_config);
 
       monitor = std::make_shared<et::tps_performance_monitor>(spinup_time_us, max_lag_per, max_lag_duration_us);
       et::trx_tps_tester<et::transfer_trx_generator, et::tps_performance_monitor> tester{generator, monitor, tester_config};
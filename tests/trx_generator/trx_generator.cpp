@@ -5,9 +5,11 @@
 #include <boost/algorithm/string.hpp>
 #include <eosio/chain/chain_id_type.hpp>
 #include <eosio/chain/name.hpp>
+#include <eosio/chain/contract_types.hpp>
 #include <fc/bitutil.hpp>
 #include <fc/io/raw.hpp>
 #include <regex>
+#include <cmath>
 
 namespace eosio::testing {
    using namespace chain::literals;
@@ -24,9 +26,13 @@ namespace eosio::testing {
 
    signed_transaction_w_signer trx_generator_base::create_trx_w_actions_and_signer(std::vector<chain::action>&& acts, const fc::crypto::private_key& priv_key,
                                                                                    uint64_t& nonce_prefix, uint64_t& nonce, const fc::microseconds& trx_expiration,
-                                                                                   const chain::chain_id_type& chain_id, const chain::block_id_type& last_irr_block_id) {
+                                                                                   const chain::chain_id_type& chain_id, const chain::block_id_type& last_irr_block_id,
+                                                                                   const std::optional<chain::shard_name>& shard) {
       chain::signed_transaction trx;
       set_transaction_headers(trx, last_irr_block_id, trx_expiration);
+      if (shard) {
+         trx.set_shard(*shard);
+      }
       trx.actions = std::move(acts);
       trx.context_free_actions.emplace_back(std::vector<chain::permission_level>(), chain::config::null_account_name, chain::name("nonce"),
          fc::raw::pack(std::to_string(_config._generator_id) + ":" + std::to_string(nonce_prefix) + ":" + std::to_string(++nonce) + ":" + std::to_string(fc::time_point::now().time_since_epoch().count())));
@@ -66,6 +72,12 @@ namespace eosio::testing {
                            account, "transfer"_n, make_transfer_data(from, to, quantity, std::move(memo)));
    }
 
+   chain::action transfer_trx_generator::make_xshout_action(chain::name owner, chain::shard_name to_shard, chain::asset quantity, std::string memo) {
+      chain::xshout xsh_out{ .owner = owner, .to_shard = to_shard, .contract = _config._contract_owner_account, .action_type = "xtransfer"_n,
+                             .action_data = fc::raw::pack(quantity, memo) };
+      return chain::action(std::vector<chain::permission_level>{{owner, chain::config::active_name}}, xsh_out);
+   }
+
    void transfer_trx_generator::create_initial_transfer_actions(const std::string& salt, const uint64_t& period) {
 
       for (size_t i = 0; i < _accts_config._acct_name_vec.size(); ++i) {
@@ -87,12 +99,74 @@ namespace eosio::testing {
       ilog("create_initial_transfer_actions: total action pairs created: ${pairs}", ("pairs", _action_pairs_vector.size()));
    }
 
+   std::vector<double> shard_weights(size_t num_shards, double skew) {
+      std::vector<double> weights(num_shards);
+      for (size_t i = 0; i < num_shards; ++i) {
+         weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), skew);
+      }
+      return weights;
+   }
+
+   bool transfer_trx_generator::create_shard_transactions(const std::string& salt, uint64_t& nonce_prefix, uint64_t& nonce) {
+      const auto& shards = _shard_config._shard_names;
+      const auto& accts = _accts_config._acct_name_vec;
+      const auto& keys = _accts_config._priv_keys_vec;
+      const auto quantity = chain::asset::from_string("1.0000 CUR");
+      const bool xshard = shards.size() > 1 && _shard_config._xshard_ratio > 0;
+      const bool local = _shard_config._xshard_ratio < 1;
+
+      _shard_loads.clear();
+      _shard_loads.resize(shards.size());
+      for (size_t s = 0; s < shards.size(); ++s) {
+         shard_load& load = _shard_loads[s];
+         load._name = shards[s];
+
+         std::vector<size_t> members;
+         for (size_t i = s; i < accts.size(); i += shards.size()) {
+            members.push_back(i);
+         }
+         if (members.empty() || (local && members.size() < 2)) {
+            elog("create_shard_transactions: shard ${s} has ${n} accounts, transfers within a shard require at least 2 accounts per shard",
+                 ("s", load._name)("n", members.size()));
+            return false;
+         }
+
+         for (size_t i = 0; i < members.size(); ++i) {
+            const size_t a = members[i];
+            if (local) {
+               for (size_t j = i + 1; j < members.size(); ++j) {
+                  const size_t b = members[j];
+                  load._trxs.push_back(create_trx_w_actions_and_signer({make_transfer_action(_config._contract_owner_account, accts.at(a), accts.at(b), quantity, salt)},
+                                                                       keys.at(a), nonce_prefix, nonce, _config._trx_expiration_us, _config._chain_id,
+                                                                       _config._last_irr_block_id, load._name));
+                  load._trxs.push_back(create_trx_w_actions_and_signer({make_transfer_action(_config._contract_owner_account, accts.at(b), accts.at(a), quantity, salt)},
+                                                                       keys.at(b), nonce_prefix, nonce, _config._trx_expiration_us, _config._chain_id,
+                                                                       _config._last_irr_block_id, load._name));
+               }
+            }
+            if (xshard) {
+               const chain::shard_name& to_shard = shards[(s + 1) % shards.size()];
+               load._xshard_trxs.push_back(create_trx_w_actions_and_signer({make_xshout_action(accts.at(a), to_shard, quantity, salt)},
+                                                                           keys.at(a), nonce_prefix, nonce, _config._trx_expiration_us, _config._chain_id,
+                                                                           _config._last_irr_block_id, load._name));
+            }
+         }
+         ilog("create_shard_transactions: shard ${s}: accounts ${a}, transfer trxs ${t}, xshout trxs ${x}",
+              ("s", load._name)("a", members.size())("t", load._trxs.size())("x", load._xshard_trxs.size()));
+      }
+
+      const auto weights = shard_weights(shards.size(), _shard_config._skew);
+      _shard_dist = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+      _xshard_dist = std::bernoulli_distribution(xshard ? _shard_config._xshard_ratio : 0);
+      return true;
+   }
+
    trx_generator_base::trx_generator_base(const trx_generator_base_config& trx_gen_base_config, const provider_base_config& provider_config)
        : _config(trx_gen_base_config), _provider(provider_config) {}
 
    transfer_trx_generator::transfer_trx_generator(const trx_generator_base_config& trx_gen_base_config, const provider_base_config& provider_config,
-                                                  const accounts_config& accts_config)
-       : trx_generator_base(trx_gen_base_config, provider_config), _accts_config(accts_config) {}
+                                                  const accounts_config& accts_config, const shard_config& shard_config)
+       : trx_generator_base(trx_gen_base_config, provider_config), _accts_config(accts_config), _shard_config(shard_config), _rng(trx_gen_base_config._generator_id) {}
 
    bool transfer_trx_generator::setup() {
       const std::string salt = std::to_string(getpid());
@@ -103,11 +177,18 @@ namespace eosio::testing {
       ilog("Stop Generation (form potential ongoing generation in preparation for starting new generation run).");
       stop_generation();
 
-      ilog("Create All Initial Transfer Action/Reaction Pairs (acct 1 -> acct 2, acct 2 -> acct 1) between all provided accounts.");
-      create_initial_transfer_actions(salt, period);
+      if (_shard_config.enabled()) {
+         ilog("Create Transfer Transactions between the accounts of each shard and xshout transactions to the next shard.");
+         if (!create_shard_transactions(salt, ++_nonce_prefix, _nonce)) {
+            return false;
+         }
+      } else {
+         ilog("Create All Initial Transfer Action/Reaction Pairs (acct 1 -> acct 2, acct 2 -> acct 1) between all provided accounts.");
+         create_initial_transfer_actions(salt, period);
 
-      ilog("Create All Initial Transfer Transactions (one for each created action).");
-      create_initial_transfer_transactions(++_nonce_prefix, _nonce);
+         ilog("Create All Initial Transfer Transactions (one for each created action).");
+         create_initial_transfer_transactions(++_nonce_prefix, _nonce);
+      }
 
       ilog("Setup p2p transaction provider");
 
@@ -312,6 +393,62 @@ namespace eosio::testing {
       return true;
    }
 
+   bool transfer_trx_generator::generate_and_send() {
+      if (!_shard_config.enabled()) {
+         return trx_generator_base::generate_and_send();
+      }
+
+      if (_txcount == 0) {
+         _gen_start = fc::time_point::now();
+      }
+      shard_load& load = _shard_loads.at(_shard_dist(_rng));
+      const bool xshard = _xshard_dist(_rng);
+      auto& trxs = xshard ? load._xshard_trxs : load._trxs;
+      auto& index = xshard ? load._xshard_index : load._trx_index;
+      try {
+         push_transaction(_provider, trxs.at(index++ % trxs.size()), ++_nonce_prefix, _nonce, _config._trx_expiration_us, _config._chain_id,
+                          _config._last_irr_block_id);
+         ++_txcount;
+         ++(xshard ? load._xshard_sent : load._sent);
+      } catch (const std::exception &e) {
+         elog("shard ${s}: ${e}", ("s", load._name)("e", e.what()));
+         ++load._failed;
+         return false;
+      } catch (...) {
+         elog("shard ${s}: unknown exception", ("s", load._name));
+         ++load._failed;
+         return false;
+      }
+
+      return true;
+   }
+
+   void transfer_trx_generator::log_shard_stats(const std::string& log_dir) {
+      const double elapsed_sec = std::max<int64_t>((fc::time_point::now() - _gen_start).count(), 1) / 1'000'000.0;
+
+      std::ostringstream fileName;
+      fileName << log_dir << "/shard_stats_" << getpid() << ".txt";
+      std::ofstream out(fileName.str());
+
+      for (const shard_load& load : _shard_loads) {
+         const uint64_t sent = load._sent + load._xshard_sent;
+         const uint64_t attempted = sent + load._failed;
+         const double tps = sent / elapsed_sec;
+         const double failure_rate = attempted ? static_cast<double>(load._failed) / attempted : 0;
+         ilog("Shard ${s}: sent ${n} (xshout ${x}), failed ${f}, achieved tps ${tps}, failure rate ${r}",
+              ("s", load._name)("n", sent)("x", load._xshard_sent)("f", load._failed)("tps", tps)("r", failure_rate));
+         out << load._name.to_string() << "," << sent << "," << load._xshard_sent << "," << load._failed << "," << tps << "," << failure_rate << "\n";
+      }
+      out.close();
+   }
+
+   bool transfer_trx_generator::tear_down() {
+      if (_shard_config.enabled()) {
+         log_shard_stats(_config._log_dir);
+      }
+      return trx_generator_base::tear_down();
+   }
+
    void trx_generator_base::log_first_trx(const std::string& log_dir, const chain::signed_transaction& trx) {
       std::ostringstream fileName;
       fileName << log_dir << "/first_trx_" << getpid() << ".txt";
@@ -2,6 +2,7 @@
 #include <trx_provider.hpp>
 #include <string>
 #include <vector>
+#include <random>
 #include <boost/program_options.hpp>
 #include <eosio/chain/transaction.hpp>
 #include <eosio/chain/asset.hpp>
@@ -158,6 +159,43 @@ namespace eosio::testing {
       };
    };
 
+   struct shard_config {
+      // accounts are assigned to the shards round robin, empty sends every trx without a shard extension
+      std::vector<eosio::chain::shard_name> _shard_names;
+      // load of the i-th shard is proportional to 1/i^_skew, 0 spreads the load evenly
+      double _skew = 0;
+      // ratio of trxs that are xshout transfers from the sender's shard to the next shard
+      double _xshard_ratio = 0;
+
+      bool enabled() const { return !_shard_names.empty(); }
+
+      std::string to_string() const {
+         std::ostringstream ss;
+         ss << "Shards Specified: shards: [ ";
+         for(size_t i = 0; i < _shard_names.size(); ++i) {
+               ss << _shard_names.at(i);
+               if(i < _shard_names.size() - 1) {
+                  ss << ", ";
+               }
+         }
+         ss << " ] skew: " << _skew << " xshard ratio: " << _xshard_ratio;
+         return std::move(ss).str();
+      };
+   };
+
+   struct shard_load {
+      eosio::chain::shard_name _name;
+      std::vector<signed_transaction_w_signer> _trxs;        // transfers between accounts of this shard
+      std::vector<signed_transaction_w_signer> _xshard_trxs; // xshout of accounts of this shard to the next shard
+      uint64_t _trx_index = 0;
+      uint64_t _xshard_index = 0;
+      uint64_t _sent = 0;
+      uint64_t _xshard_sent = 0;
+      uint64_t _failed = 0;
+   };
+
+   std::vector<double> shard_weights(size_t num_shards, double skew);
+
    struct trx_generator_base {
       const trx_generator_base_config& _config;
       p2p_trx_provider _provider;
@@ -187,27 +225,41 @@ namespace eosio::testing {
 
       signed_transaction_w_signer create_trx_w_actions_and_signer(std::vector<eosio::chain::action>&& act, const fc::crypto::private_key& priv_key, uint64_t& nonce_prefix,
                                                                   uint64_t& nonce, const fc::microseconds& trx_expiration, const eosio::chain::chain_id_type& chain_id,
-                                                                  const eosio::chain::block_id_type& last_irr_block_id);
+                                                                  const eosio::chain::block_id_type& last_irr_block_id,
+                                                                  const std::optional<eosio::chain::shard_name>& shard = {});
 
       void log_first_trx(const std::string& log_dir, const eosio::chain::signed_transaction& trx);
 
-      bool generate_and_send();
-      bool tear_down();
+      virtual bool generate_and_send();
+      virtual bool tear_down();
       void stop_generation();
       bool stop_on_trx_fail();
    };
 
    struct transfer_trx_generator : public trx_generator_base {
       accounts_config _accts_config;
+      shard_config _shard_config;
+
+      std::vector<shard_load> _shard_loads;
+      std::mt19937_64 _rng;
+      std::discrete_distribution<size_t> _shard_dist;
+      std::bernoulli_distribution _xshard_dist;
+      fc::time_point _gen_start;
 
-      transfer_trx_generator(const trx_generator_base_config& trx_gen_base_config, const provider_base_config& provider_config, const accounts_config& accts_config);
+      transfer_trx_generator(const trx_generator_base_config& trx_gen_base_config, const provider_base_config& provider_config, const accounts_config& accts_config,
+                             const shard_config& shard_config = {});
 
       void create_initial_transfer_transactions(uint64_t& nonce_prefix, uint64_t& nonce);
       eosio::chain::bytes make_transfer_data(const eosio::chain::name& from, const eosio::chain::name& to, const eosio::chain::asset& quantity, const std::string& memo);
       auto make_transfer_action(eosio::chain::name account, eosio::chain::name from, eosio::chain::name to, eosio::chain::asset quantity, std::string memo);
+      eosio::chain::action make_xshout_action(eosio::chain::name owner, eosio::chain::shard_name to_shard, eosio::chain::asset quantity, std::string memo);
       void create_initial_transfer_actions(const std::string& salt, const uint64_t& period);
+      bool create_shard_transactions(const std::string& salt, uint64_t& nonce_prefix, uint64_t& nonce);
+      void log_shard_stats(const std::string& log_dir);
 
       bool setup();
+      bool generate_and_send() override;
+      bool tear_down() override;
    };
 
    void locate_key_words_in_action_mvo(std::vector<std::string>& acct_gen_fields_out, const fc::mutable_variant_object& action_mvo, const std::string& key_word);
@@ -331,6 +331,59 @@ BOOST_AUTO_TEST_CASE(trx_generator_constructor)
    auto generator = trx_generator(tg_config, p_config, trx_config);
 }
 
+BOOST_AUTO_TEST_CASE(shard_weights_tests)
+{
+   auto even = shard_weights(3, 0);
+   BOOST_REQUIRE_EQUAL(even.size(), 3u);
+   BOOST_REQUIRE_EQUAL(even[0], 1.0);
+   BOOST_REQUIRE_EQUAL(even[2], 1.0);
+
+   auto skewed = shard_weights(4, 1);
+   BOOST_REQUIRE_EQUAL(skewed[0], 1.0);
+   BOOST_REQUIRE_EQUAL(skewed[1], 0.5);
+   BOOST_REQUIRE_EQUAL(skewed[3], 0.25);
+}
+
+BOOST_AUTO_TEST_CASE(transfer_trx_generator_shards)
+{
+   trx_generator_base_config tg_config{1, chain::chain_id_type("999"), chain::name("flon.token"), fc::seconds(3600),
+                                       fc::variant("00000062989f69fd251df3e0b274c3364ffc2f4fce73de3f1c7b5e11a4c92f21").as<chain::block_id_type>(), ".", true};
+   provider_base_config p_config{"127.0.0.1", 9876};
+   const fc::crypto::private_key key("5KQwrPbwdL6PhXujxW37FSSQZ1JiwsST4cqQzDeyXtP79zkvFD3");
+   accounts_config accts_config{{"acct1"_n, "acct2"_n, "acct3"_n, "acct4"_n, "acct5"_n}, {key, key, key, key, key}};
+   shard_config shards{{"shard1"_n, "shard2"_n}, 1, 0.5};
+
+   auto generator = transfer_trx_generator(tg_config, p_config, accts_config, shards);
+   uint64_t nonce_prefix = 0, nonce = 0;
+   BOOST_REQUIRE(generator.create_shard_transactions("salt", nonce_prefix, nonce));
+   BOOST_REQUIRE_EQUAL(generator._shard_loads.size(), 2u);
+
+   // acct1, acct3, acct5 on shard1 and acct2, acct4 on shard2
+   const auto& shard1 = generator._shard_loads[0];
+   BOOST_REQUIRE_EQUAL(shard1._trxs.size(), 6u);
+   BOOST_REQUIRE_EQUAL(shard1._xshard_trxs.size(), 3u);
+   const auto& shard2 = generator._shard_loads[1];
+   BOOST_REQUIRE_EQUAL(shard2._trxs.size(), 2u);
+   BOOST_REQUIRE_EQUAL(shard2._xshard_trxs.size(), 2u);
+
+   for (const auto& t : shard1._trxs) {
+      BOOST_REQUIRE(t._trx.has_shard_extension());
+      BOOST_REQUIRE_EQUAL(t._trx.get_shard_name(), "shard1"_n);
+   }
+   const auto& xsh_trx = shard2._xshard_trxs[0]._trx;
+   BOOST_REQUIRE_EQUAL(xsh_trx.get_shard_name(), "shard2"_n);
+   BOOST_REQUIRE_EQUAL(xsh_trx.actions.at(0).name, chain::xshout::get_name());
+   auto xsh_out = xsh_trx.actions.at(0).data_as<chain::xshout>();
+   BOOST_REQUIRE_EQUAL(xsh_out.owner, "acct2"_n);
+   BOOST_REQUIRE_EQUAL(xsh_out.to_shard, "shard1"_n);
+   BOOST_REQUIRE_EQUAL(xsh_out.contract, "flon.token"_n);
+
+   // transfers within a shard need 2 accounts on the shard
+   accounts_config too_few{{"acct1"_n, "acct2"_n, "acct3"_n}, {key, key, key}};
+   auto generator2 = transfer_trx_generator(tg_config, p_config, too_few, shards);
+   BOOST_REQUIRE(!generator2.create_shard_transactions("salt", nonce_prefix, nonce));
+}
+
 BOOST_AUTO_TEST_CASE(account_name_generator_tests)
 {
    auto acct_gen = account_name_generator();
@@ -63,7 +63,7 @@ namespace eosio::testing {
    void p2p_trx_provider::send(const chain::signed_transaction& trx) {
       chain::packed_transaction pt(trx);
       _peer_connection.send_transaction(pt);
-      _sent_trx_data.push_back(logged_trx_data(trx.id()));
+      _sent_trx_data.push_back(logged_trx_data(trx.id(), trx.get_shard_name()));
    }
 
    void p2p_trx_provider::send(const std::vector<chain::signed_transaction>& trxs) {
@@ -78,7 +78,7 @@ namespace eosio::testing {
       std::ofstream out(fileName.str());
 
       for (logged_trx_data data : _sent_trx_data) {
-         out << std::string(data._trx_id) << ","<< std::string(data._sent_timestamp) << "\n";
+         out << std::string(data._trx_id) << ","<< std::string(data._sent_timestamp) << "," << data._shard_name.to_string() << "\n";
       }
       out.close();
    }
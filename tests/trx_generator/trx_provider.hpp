@@ -17,9 +17,10 @@ namespace eosio::testing {
    struct logged_trx_data {
       eosio::chain::transaction_id_type _trx_id;
       fc::time_point _sent_timestamp;
+      eosio::chain::shard_name _shard_name;
 
-      logged_trx_data(eosio::chain::transaction_id_type trx_id, fc::time_point sent=fc::time_point::now()) :
-         _trx_id(trx_id), _sent_timestamp(sent) {}
+      logged_trx_data(eosio::chain::transaction_id_type trx_id, eosio::chain::shard_name shard_name, fc::time_point sent=fc::time_point::now()) :
+         _trx_id(trx_id), _sent_timestamp(sent), _shard_name(shard_name) {}
    };
 
    struct provider_base_config {
@@ -209,6 +209,28 @@ BOOST_AUTO_TEST_CASE(untrusted_producer_test)
    }) ;
 }
 
+BOOST_AUTO_TEST_CASE(block_report_stage_times)
+{
+   tester main;
+   main.create_account("newacc"_n);
+   auto b = main.produce_block();
+
+   tester validator;
+   auto bsf = validator.control->create_block_state_future( b->calculate_id(), b );
+   validator.control->abort_block();
+   controller::block_report br;
+   validator.control->push_block( br, bsf.get(), forked_branch_callback{}, trx_meta_cache_lookup{} );
+   BOOST_REQUIRE_EQUAL( validator.control->head_block_id(), b->calculate_id() );
+
+   // every shard with transactions in the block reports its execution time, bounded by the shard critical path
+   const auto& stages = br.stages;
+   BOOST_REQUIRE_EQUAL( stages.shard_execution.size(), 1u );
+   BOOST_CHECK( stages.shard_execution.count( config::main_shard_name ) );
+   BOOST_CHECK( stages.shard_execution.begin()->second <= stages.shard_critical_path );
+   BOOST_CHECK( stages.shard_critical_path <= br.total_time );
+   BOOST_CHECK( stages.merkle + stages.xshard + stages.commit + stages.signals <= br.total_time );
+}
+
 /**
  * Ensure that the block broadcasted by producing node and receiving node is identical
  */
@@ -0,0 +1,421 @@
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+
+#include <boost/test/unit_test.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/compile_queue.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/hot_codes.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/profiler.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/io/raw.hpp>
+
+#include <fstream>
+
+#include <iterator>
+#include <map>
+#include <string>
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::chain::eosvmoc;
+
+namespace {
+
+// reads back the parts of a protobuf message the pprof encoding tests look at
+struct pb_reader {
+   const char* pos;
+   const char* end;
+
+   uint64_t varint() {
+      uint64_t v = 0;
+      for(unsigned shift = 0; pos != end; shift += 7) {
+         const uint8_t b = *pos++;
+         v |= uint64_t(b & 0x7f) << shift;
+         if(!(b & 0x80))
+            return v;
+      }
+      BOOST_FAIL("truncated varint");
+      return v;
+   }
+
+   /// field number -> values of varint fields and bytes of length delimited fields, in order
+   std::multimap<uint32_t, std::string> fields() {
+      std::multimap<uint32_t, std::string> r;
+      while(pos != end) {
+         const uint64_t tag = varint();
+         const uint32_t field = tag >> 3;
+         if((tag & 7) == 0) {
+            r.emplace(field, std::to_string(varint()));
+         } else {
+            BOOST_REQUIRE_EQUAL(tag & 7, 2u);
+            const uint64_t n = varint();
+            BOOST_REQUIRE_LE(n, uint64_t(end - pos));
+            r.emplace(field, std::string(pos, n));
+            pos += n;
+         }
+      }
+      return r;
+   }
+
+   static std::multimap<uint32_t, std::string> parse(const std::string& m) {
+      return pb_reader{m.data(), m.data() + m.size()}.fields();
+   }
+
+   static std::vector<uint64_t> packed(const std::string& m) {
+      pb_reader r{m.data(), m.data() + m.size()};
+      std::vector<uint64_t> values;
+      while(r.pos != r.end)
+         values.push_back(r.varint());
+      return values;
+   }
+};
+
+code_tuple make_code(uint64_t n) {
+   return code_tuple{digest_type::hash(n), 0};
+}
+
+void use(hot_codes& hot, const code_tuple& ct, uint64_t times) {
+   for(uint64_t i = 0; i < times; ++i)
+      hot.record_use(ct);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(eosvmoc_tests)
+
+BOOST_AUTO_TEST_CASE(function_table_function_at) { try {
+   function_table table;
+   BOOST_CHECK_EQUAL(table.function_at(0), -1);
+
+   table.offsets = {16, 64, 200};
+   table.indices = {3, 4, 7};
+
+   // before the first function, e.g. in the code's prologue
+   BOOST_CHECK_EQUAL(table.function_at(0), -1);
+   BOOST_CHECK_EQUAL(table.function_at(15), -1);
+   // the first byte of a function belongs to it, the byte before to the previous one
+   BOOST_CHECK_EQUAL(table.function_at(16), 3);
+   BOOST_CHECK_EQUAL(table.function_at(63), 3);
+   BOOST_CHECK_EQUAL(table.function_at(64), 4);
+   BOOST_CHECK_EQUAL(table.function_at(199), 4);
+   BOOST_CHECK_EQUAL(table.function_at(200), 7);
+   // the last function extends to the end of the code
+   BOOST_CHECK_EQUAL(table.function_at(UINT32_MAX - 1), 7);
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(sampling_profiler_report) { try {
+   sampling_profiler profiler;
+   const digest_type code_a = digest_type::hash(std::string("a"));
+   const digest_type code_b = digest_type::hash(std::string("b"));
+   profiler.set_function_table(code_a, 0, function_table{{0, 100}, {2, 5}});
+
+   const uint32_t host = sampling_profiler::host_pc_offset;
+   const uint32_t samples_a[] = {10, 150, 150, 99, host, 150};
+   profiler.aggregate(code_a, 0, "alice"_n, "transfer"_n, samples_a, std::size(samples_a), 3);
+   // no function table for code_b: everything is attributed to -1
+   const uint32_t samples_b[] = {10, 20};
+   profiler.aggregate(code_b, 0, "bob"_n, "issue"_n, samples_b, std::size(samples_b), 0);
+   // a table of another vm_version does not apply
+   profiler.aggregate(code_a, 1, "alice"_n, "transfer"_n, samples_b, 1, 0);
+
+   profile_report r = profiler.report(0, false);
+   BOOST_CHECK_EQUAL(r.total_samples, 9u);
+   BOOST_CHECK_EQUAL(r.dropped_samples, 3u);
+   BOOST_REQUIRE_EQUAL(r.entries.size(), 4u);
+   // most samples first
+   BOOST_CHECK_EQUAL(r.entries[0].receiver, "alice"_n);
+   BOOST_CHECK_EQUAL(r.entries[0].code_hash, code_a);
+   BOOST_CHECK_EQUAL(r.entries[0].function_index, 5);
+   BOOST_CHECK_EQUAL(r.entries[0].samples, 3u);
+   for(size_t i = 1; i < r.entries.size(); ++i)
+      BOOST_CHECK_GE(r.entries[i - 1].samples, r.entries[i].samples);
+
+   std::map<std::tuple<account_name, digest_type, int64_t>, uint64_t> by_function;
+   for(const profile_entry& e : r.entries)
+      by_function[{e.receiver, e.code_hash, e.function_index}] = e.samples;
+   // offsets 10 and 99 are in function 2, the host sample is -1, and the vm_version 1 sample has no table
+   BOOST_CHECK_EQUAL((by_function[{"alice"_n, code_a, 2}]), 2u);
+   BOOST_CHECK_EQUAL((by_function[{"alice"_n, code_a, -1}]), 2u);
+   BOOST_CHECK_EQUAL((by_function[{"bob"_n, code_b, -1}]), 2u);
+
+   BOOST_CHECK_EQUAL(profiler.report(2, false).entries.size(), 2u);
+
+   // an erased table no longer resolves functions
+   profiler.erase_function_table(code_a, 0);
+   profiler.report(0, true);
+   profiler.aggregate(code_a, 0, "alice"_n, "transfer"_n, samples_a, 1, 0);
+   r = profiler.report(0, true);
+   BOOST_CHECK_EQUAL(r.total_samples, 1u);
+   BOOST_CHECK_EQUAL(r.dropped_samples, 0u);
+   BOOST_REQUIRE_EQUAL(r.entries.size(), 1u);
+   BOOST_CHECK_EQUAL(r.entries[0].function_index, -1);
+
+   BOOST_CHECK_EQUAL(profiler.report(0, false).entries.size(), 0u);
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(sampling_profiler_pprof) { try {
+   sampling_profiler profiler;
+   const digest_type code = digest_type::hash(std::string("code"));
+   profiler.set_function_table(code, 0, function_table{{0}, {3}});
+
+   const uint32_t samples[] = {8, 8, sampling_profiler::host_pc_offset};
+   profiler.aggregate(code, 0, "alice"_n, "transfer"_n, samples, std::size(samples), 0);
+
+   const std::vector<char> encoded = profiler.pprof(true);
+   const auto profile = pb_reader::parse(std::string(encoded.begin(), encoded.end()));
+
+   std::vector<std::string> strings;
+   for(auto [it, end] = profile.equal_range(6); it != end; ++it)
+      strings.push_back(it->second);
+   BOOST_REQUIRE(!strings.empty());
+   BOOST_CHECK_EQUAL(strings[0], ""); // the string table starts with the empty string
+   auto string_at = [&](const std::string& id) {
+      const size_t i = std::stoull(id);
+      BOOST_REQUIRE_LT(i, strings.size());
+      return strings[i];
+   };
+
+   // sample types: samples/count and cpu/nanoseconds
+   BOOST_REQUIRE_EQUAL(profile.count(1), 2u);
+   {
+      auto vt = pb_reader::parse(profile.find(1)->second);
+      BOOST_CHECK_EQUAL(string_at(vt.find(1)->second), "samples");
+      BOOST_CHECK_EQUAL(string_at(vt.find(2)->second), "count");
+   }
+
+   // functions by id
+   std::map<uint64_t, std::pair<std::string, std::string>> functions;
+   for(auto [it, end] = profile.equal_range(5); it != end; ++it) {
+      auto f = pb_reader::parse(it->second);
+      functions[std::stoull(f.find(1)->second)] = {string_at(f.find(2)->second), string_at(f.find(4)->second)};
+   }
+   BOOST_CHECK_EQUAL(functions.size(), 3u);
+   // one location per function, with the same id
+   BOOST_CHECK_EQUAL(profile.count(4), functions.size());
+
+   // every sample is a two frame stack, leaf first
+   std::map<std::string, uint64_t> samples_by_leaf;
+   for(auto [it, end] = profile.equal_range(2); it != end; ++it) {
+      auto s = pb_reader::parse(it->second);
+      const auto locations = pb_reader::packed(s.find(1)->second);
+      const auto values = pb_reader::packed(s.find(2)->second);
+      BOOST_REQUIRE_EQUAL(locations.size(), 2u);
+      BOOST_REQUIRE_EQUAL(values.size(), 2u);
+      BOOST_CHECK_EQUAL(functions[locations[1]].first, "alice::transfer");
+      BOOST_CHECK_EQUAL(functions[locations[0]].second, code.str());
+      samples_by_leaf[functions[locations[0]].first] += values[0];
+   }
+   BOOST_CHECK_EQUAL(samples_by_leaf.size(), 2u);
+   BOOST_CHECK_EQUAL(samples_by_leaf["wasm-function[3]"], 2u);
+   BOOST_CHECK_EQUAL(samples_by_leaf["[host]"], 1u);
+
+   // reset by the previous call
+   const std::vector<char> empty = profiler.pprof(false);
+   BOOST_CHECK_EQUAL(pb_reader::parse(std::string(empty.begin(), empty.end())).count(2), 0u);
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(hot_codes_is_hot) { try {
+   hot_codes hot(2);
+   const code_tuple a = make_code(1), b = make_code(2), c = make_code(3);
+   BOOST_CHECK(!hot.is_hot(a));
+
+   // while no more codes than the hot ones are used all of them are hot
+   use(hot, a, 5);
+   use(hot, b, 3);
+   BOOST_CHECK(hot.is_hot(a));
+   BOOST_CHECK(hot.is_hot(b));
+   // one more code makes the least used one not hot
+   use(hot, c, 1);
+   BOOST_CHECK(hot.is_hot(a));
+   BOOST_CHECK(hot.is_hot(b));
+   BOOST_CHECK(!hot.is_hot(c));
+   BOOST_CHECK_EQUAL(hot.uses(a), 5u);
+   BOOST_CHECK_EQUAL(hot.uses(make_code(4)), 0u);
+
+   // a code used more takes its place once the threshold is refreshed
+   use(hot, c, hot_codes::refresh_interval);
+   BOOST_CHECK(hot.is_hot(c));
+   BOOST_CHECK(hot.is_hot(a));
+   BOOST_CHECK(!hot.is_hot(b));
+
+   const auto most_used = hot.most_used();
+   BOOST_REQUIRE_EQUAL(most_used.size(), 2u);
+   BOOST_CHECK(most_used[0].first == c);
+   BOOST_CHECK(most_used[1].first == a);
+   BOOST_CHECK_EQUAL(most_used[1].second, 5u);
+
+   // no hot codes configured
+   hot_codes none(0);
+   use(none, a, 10);
+   BOOST_CHECK(!none.is_hot(a));
+   BOOST_CHECK(none.most_used().empty());
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(hot_codes_bounded) { try {
+   hot_codes hot(4);
+   const code_tuple popular = make_code(0);
+   use(hot, popular, 100);
+   // every code used once, e.g. a new code per setcode
+   for(uint64_t n = 1; n <= 3 * hot.max_tracked(); ++n) {
+      use(hot, make_code(n), 1);
+      BOOST_REQUIRE_LE(hot.size(), hot.max_tracked());
+   }
+   BOOST_CHECK_EQUAL(hot.uses(popular), 100u);
+   BOOST_CHECK(hot.is_hot(popular));
+   BOOST_CHECK(hot.most_used()[0].first == popular);
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(hot_codes_inherit) { try {
+   hot_codes hot(1);
+   const code_tuple old_code = make_code(1), other = make_code(2), new_code = make_code(3);
+   use(hot, old_code, 10);
+   use(hot, other, 2);
+   BOOST_REQUIRE(hot.is_hot(old_code));
+
+   // a setcode of the hot code: the new code is hot before its first use, the old one keeps its count in case the
+   // setcode is rolled back
+   hot.inherit(old_code, new_code);
+   BOOST_CHECK_EQUAL(hot.uses(new_code), 10u);
+   BOOST_CHECK_EQUAL(hot.uses(old_code), 10u);
+   BOOST_CHECK(hot.is_hot(new_code));
+
+   // a code already used more keeps its count
+   use(hot, new_code, 5);
+   hot.inherit(old_code, new_code);
+   BOOST_CHECK_EQUAL(hot.uses(new_code), 15u);
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(hot_codes_persistence) { try {
+   fc::temp_directory dir;
+   const auto file = dir.path() / "code_cache_hot.bin";
+
+   hot_codes hot(3);
+   for(uint64_t n = 1; n <= 5; ++n)
+      use(hot, make_code(n), n * 10);
+   hot.save(file);
+
+   // the warm-up order: the hot codes of the last run, most used first
+   hot_codes restarted(3);
+   const std::vector<code_tuple> loaded = restarted.load(file);
+   BOOST_REQUIRE_EQUAL(loaded.size(), 3u);
+   BOOST_CHECK(loaded[0] == make_code(5));
+   BOOST_CHECK(loaded[1] == make_code(4));
+   BOOST_CHECK(loaded[2] == make_code(3));
+   BOOST_CHECK_EQUAL(restarted.uses(make_code(5)), 50u);
+   BOOST_CHECK_EQUAL(restarted.uses(make_code(1)), 0u);
+   BOOST_CHECK(restarted.is_hot(make_code(3)));
+
+   // fewer hot codes configured than saved keeps the most used
+   hot_codes fewer(1);
+   BOOST_REQUIRE_EQUAL(fewer.load(file).size(), 1u);
+   BOOST_CHECK_EQUAL(fewer.size(), 1u);
+   BOOST_CHECK_EQUAL(fewer.uses(make_code(5)), 50u);
+
+   // a missing file or one of another version loads nothing
+   BOOST_CHECK(hot_codes(3).load(dir.path() / "missing.bin").empty());
+   {
+      std::ofstream ofs(file.generic_string(), std::ofstream::binary | std::ofstream::trunc);
+      const auto data = fc::raw::pack(uint64_t(42));
+      ofs.write(data.data(), data.size());
+   }
+   hot_codes unknown(3);
+   BOOST_CHECK(unknown.load(file).empty());
+   BOOST_CHECK_EQUAL(unknown.size(), 0u);
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(compile_queue_order) { try {
+   compile_queue q;
+   const fc::time_point t0 = fc::time_point::now();
+   const code_tuple warm1 = make_code(1), warm2 = make_code(2), trx1 = make_code(3), trx2 = make_code(4),
+                    blk = make_code(5), in_use = make_code(6);
+
+   // warm-up codes at the back in list order, speculative and block codes at the front as they are used
+   q.push(warm1, compile_priority::ahead_of_use, t0, false);
+   q.push(warm2, compile_priority::ahead_of_use, t0, false);
+   q.push(trx1, compile_priority::transaction, t0, true);
+   q.push(trx2, compile_priority::transaction, t0, true);
+   q.push(in_use, compile_priority::ahead_of_use, t0, true);
+   q.push(blk, compile_priority::block, t0, true);
+   BOOST_CHECK_EQUAL(q.size(), 6u);
+   BOOST_CHECK(q.contains(warm1));
+
+   compile_stats stats{};
+   q.count_queued(stats);
+   BOOST_CHECK_EQUAL(stats[size_t(compile_priority::block)].queued, 1u);
+   BOOST_CHECK_EQUAL(stats[size_t(compile_priority::transaction)].queued, 2u);
+   BOOST_CHECK_EQUAL(stats[size_t(compile_priority::ahead_of_use)].queued, 3u);
+
+   // most urgent priority first, within a priority the front most recently queued first, then the back in order
+   const code_tuple expected[] = {blk, trx2, trx1, in_use, warm1, warm2};
+   for(const code_tuple& ct : expected) {
+      BOOST_REQUIRE(!q.empty());
+      BOOST_CHECK(q.top().code == ct);
+      BOOST_CHECK(q.pop().code == ct);
+   }
+   BOOST_CHECK(q.empty());
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(compile_queue_raise_priority) { try {
+   compile_queue q;
+   const fc::time_point t0 = fc::time_point::now();
+   const fc::time_point t1 = t0 + fc::seconds(1);
+   const code_tuple warm = make_code(1), trx = make_code(2), other = make_code(3);
+
+   q.push(warm, compile_priority::ahead_of_use, t0, false);
+   q.push(trx, compile_priority::transaction, t0, true);
+   q.push(other, compile_priority::ahead_of_use, t0, false);
+
+   // a warm-up code executed by a block before its compile started moves ahead of everything else and keeps the
+   // time of its first request
+   q.push(warm, compile_priority::block, t1, true);
+   BOOST_CHECK_EQUAL(q.size(), 3u);
+   BOOST_CHECK(q.top().code == warm);
+   BOOST_CHECK(q.top().priority == compile_priority::block);
+   BOOST_CHECK(q.top().requested == t0);
+
+   // requesting it again at a lower priority does not lower it
+   q.push(warm, compile_priority::ahead_of_use, t1, false);
+   BOOST_CHECK(q.top().code == warm);
+   BOOST_CHECK(q.top().priority == compile_priority::block);
+
+   // a freed code is no longer compiled
+   q.erase(warm);
+   BOOST_CHECK(!q.contains(warm));
+   BOOST_CHECK(q.pop().code == trx);
+   BOOST_CHECK(q.pop().code == other);
+   BOOST_CHECK(q.empty());
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(compile_queue_can_launch) { try {
+   for(compile_priority p : {compile_priority::block, compile_priority::transaction, compile_priority::ahead_of_use}) {
+      // a single thread is shared by all priorities
+      BOOST_CHECK(compile_queue::can_launch(p, 0, 1));
+      BOOST_CHECK(!compile_queue::can_launch(p, 1, 1));
+      // all threads busy
+      BOOST_CHECK(!compile_queue::can_launch(p, 4, 4));
+      BOOST_CHECK(compile_queue::can_launch(p, 2, 4));
+   }
+   // the last free thread is reserved for block execution
+   BOOST_CHECK(compile_queue::can_launch(compile_priority::block, 3, 4));
+   BOOST_CHECK(!compile_queue::can_launch(compile_priority::transaction, 3, 4));
+   BOOST_CHECK(!compile_queue::can_launch(compile_priority::ahead_of_use, 3, 4));
+   BOOST_CHECK(compile_queue::can_launch(compile_priority::block, 1, 2));
+   BOOST_CHECK(!compile_queue::can_launch(compile_priority::transaction, 1, 2));
+   BOOST_CHECK(compile_queue::can_launch(compile_priority::transaction, 0, 2));
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(compile_latency_histogram) { try {
+   compile_tier_stats tier;
+   const auto& bounds = compile_tier_stats::latency_bounds_us;
+   tier.observe_latency(fc::microseconds(0));
+   tier.observe_latency(fc::microseconds(bounds[0]));      // a bound belongs to its bucket
+   tier.observe_latency(fc::microseconds(bounds[0] + 1));
+   tier.observe_latency(fc::microseconds(bounds.back() + 1));
+   BOOST_CHECK_EQUAL(tier.latency_counts[0], 2u);
+   BOOST_CHECK_EQUAL(tier.latency_counts[1], 1u);
+   BOOST_CHECK_EQUAL(tier.latency_counts.back(), 1u);
+   BOOST_CHECK_EQUAL(tier.total_latency.count(), 2 * bounds[0] + 1 + bounds.back() + 1);
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -234,6 +234,10 @@ BOOST_AUTO_TEST_CASE( forking ) try {
    }
    wlog( "end push c2 blocks to c1" );
    idump((c.control->head_block_num())(c.control->head_block_producer()));
+   const auto& fork_switch_stats = c.control->get_fork_switch_stats();
+   BOOST_CHECK_GT( fork_switch_stats.switches, 0u );
+   BOOST_CHECK_GT( fork_switch_stats.blocks_applied, 0u );
+   BOOST_CHECK( fork_switch_stats.max_time >= fork_switch_stats.last_time );
    c.produce_block();
 
    wlog( "c1 blocks:" );
@@ -793,5 +797,38 @@ BOOST_AUTO_TEST_CASE( push_block_returns_forked_transactions ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_AUTO_TEST_CASE( fork_db_journal_survives_crash ) try {
+   tester c;
+   c.produce_blocks(10);
+   c.create_account("alice"_n);
+   c.produce_blocks(5);
+
+   // the journal as left by a crash of the running node, nothing else is written at shutdown
+   fc::temp_directory crashed;
+   const auto journal = crashed.path() / config::forkdb_journal_filename;
+   boost::filesystem::copy_file( c.get_config().blocks_dir / config::reversible_blocks_dir_name / config::forkdb_journal_filename,
+                                 journal );
+
+   auto check_fork_db = [&]() {
+      fork_database fork_db( crashed.path() );
+      fork_db.open( []( block_timestamp_type, const flat_set<digest_type>&, const vector<digest_type>& ) {} );
+      BOOST_REQUIRE( fork_db.head() );
+      BOOST_CHECK_EQUAL( fork_db.head()->id, c.control->head_block_id() );
+      BOOST_CHECK_EQUAL( fork_db.root()->block_num, c.control->last_irreversible_block_num() );
+      BOOST_CHECK_EQUAL( fork_db.fetch_branch( fork_db.head()->id ).size(),
+                         c.control->head_block_num() - c.control->last_irreversible_block_num() );
+   };
+   check_fork_db();
+
+   // a record interrupted by the crash is dropped
+   const auto journal_size = boost::filesystem::file_size( journal );
+   {
+      std::ofstream out( journal.generic_string(), std::ios::binary | std::ios::app );
+      out.write( "\x02\xff\xff", 3 );
+   }
+   check_fork_db();
+   BOOST_CHECK_EQUAL( boost::filesystem::file_size( journal ), journal_size );
+} FC_LOG_AND_RETHROW()
+
 
 BOOST_AUTO_TEST_SUITE_END()
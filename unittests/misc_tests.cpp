@@ -1,9 +1,15 @@
 #include <eosio/chain/asset.hpp>
 #include <eosio/chain/authority.hpp>
 #include <eosio/chain/authority_checker.hpp>
+#include <eosio/chain/incremental_merkle.hpp>
+#include <eosio/chain/merkle.hpp>
 #include <eosio/chain/types.hpp>
 #include <eosio/chain/thread_utils.hpp>
+#include <eosio/chain/signature_recovery_cache.hpp>
+#include <eosio/chain/contract_table_context.hpp>
+#include <eosio/chain/iterator_cache_storage.hpp>
 #include <eosio/testing/tester.hpp>
+#include <eosio/testing/chainbase_fixture.hpp>
 
 #include <fc/io/json.hpp>
 #include <fc/log/logger_config.hpp>
@@ -763,12 +769,14 @@ BOOST_AUTO_TEST_CASE(transaction_test) { try {
    BOOST_CHECK_EQUAL(1u, keys.size());
    BOOST_CHECK_EQUAL(public_key, *keys.begin());
    keys.clear();
-   auto cpu_time2 = pkt.get_signed_transaction().get_signature_keys(test.control->get_chain_id(), fc::time_point::maximum(), keys);
+   const auto sig_cache_hits = signature_recovery_cache::instance().get_stats().hits;
+   pkt.get_signed_transaction().get_signature_keys(test.control->get_chain_id(), fc::time_point::maximum(), keys);
    BOOST_CHECK_EQUAL(1u, keys.size());
    BOOST_CHECK_EQUAL(public_key, *keys.begin());
 
    BOOST_CHECK(cpu_time1 > fc::microseconds(0));
-   BOOST_CHECK(cpu_time2 > fc::microseconds(0));
+   // the second recovery is served from the signature recovery cache
+   BOOST_CHECK_EQUAL(sig_cache_hits + 1, signature_recovery_cache::instance().get_stats().hits);
 
    // pack
    uint32_t pack_size = fc::raw::pack_size( pkt );
@@ -1271,6 +1279,237 @@ BOOST_AUTO_TEST_CASE(public_key_from_hash) {
    ilog( "public key with no known private key: ${k}", ("k", eos_unknown_pk) );
 }
 
+BOOST_AUTO_TEST_CASE(merkle_batched_matches_pairwise) {
+   // reference: one digest_type::hash per node
+   auto pairwise_merkle = []( deque<digest_type> ids ) {
+      while( ids.size() > 1 ) {
+         if( ids.size() % 2 )
+            ids.push_back(ids.back());
+         for( size_t i = 0; i < ids.size() / 2; ++i )
+            ids[i] = digest_type::hash(make_canonical_pair(ids[2 * i], ids[(2 * i) + 1]));
+         ids.resize(ids.size() / 2);
+      }
+      return ids.front();
+   };
+
+   BOOST_CHECK_EQUAL( merkle( deque<digest_type>{} ), digest_type() );
+
+   deque<digest_type> ids;
+   incremental_merkle incremental;
+   for( uint32_t n = 1; n <= 70; ++n ) {
+      ids.push_back( digest_type::hash( n ) );
+      incremental.append( ids.back() );
+      const auto root = merkle( ids );
+      BOOST_CHECK_EQUAL( root, pairwise_merkle( ids ) );
+      BOOST_CHECK_EQUAL( root, incremental.get_root() );
+   }
+}
+
+BOOST_AUTO_TEST_CASE(merkle_segments_match_merkle) {
+   BOOST_CHECK_EQUAL( merkle( vector<merkle_segment>{} ), digest_type() );
+   BOOST_CHECK_EQUAL( merkle( vector<merkle_segment>{ make_merkle_segment( {}, 0 ) } ), digest_type() );
+
+   boost::random::mt19937 gen(38);
+   for( uint32_t round = 0; round < 500; ++round ) {
+      deque<digest_type> ids;
+      const uint32_t n = boost::random::uniform_int_distribution<uint32_t>(0, 100)(gen);
+      for( uint32_t i = 0; i < n; ++i )
+         ids.push_back( digest_type::hash( round * 1000 + i ) );
+
+      // split into up to 6 consecutive segments, some of them empty, the way shards of a block split their digests
+      vector<merkle_segment> segments;
+      uint64_t offset = 0;
+      const uint32_t num_segments = boost::random::uniform_int_distribution<uint32_t>(1, 6)(gen);
+      for( uint32_t s = 0; s < num_segments; ++s ) {
+         const uint64_t end = s + 1 == num_segments ? n : boost::random::uniform_int_distribution<uint64_t>(offset, n)(gen);
+         segments.emplace_back( make_merkle_segment( deque<digest_type>( ids.begin() + offset, ids.begin() + end ), offset ) );
+         offset = end;
+      }
+
+      BOOST_CHECK_EQUAL( merkle( std::move( segments ) ), merkle( ids ) );
+   }
+
+   // segments must be contiguous
+   BOOST_CHECK_THROW( merkle( vector<merkle_segment>{ make_merkle_segment( { digest_type::hash( 1 ) }, 1 ) } ), fc::exception );
+}
+
+BOOST_AUTO_TEST_CASE(signature_recovery_cache_test) {
+   const auto priv = private_key_type::regenerate<fc::ecc::private_key_shim>(fc::sha256::hash(std::string("sigcache")));
+   const auto sign = [&]( uint64_t i ) {
+      const digest_type digest = digest_type::hash( i );
+      return std::make_pair( digest, priv.sign( digest ) );
+   };
+
+   signature_recovery_cache cache( 32 );
+   const auto [digest, sig] = sign( 0 );
+   BOOST_CHECK_EQUAL( cache.recover( sig, digest ), priv.get_public_key() );
+   BOOST_CHECK_EQUAL( cache.recover( sig, digest ), priv.get_public_key() );
+   auto stats = cache.get_stats();
+   BOOST_CHECK_EQUAL( stats.hits, 1u );
+   BOOST_CHECK_EQUAL( stats.misses, 1u );
+   BOOST_CHECK_EQUAL( stats.size, 1u );
+
+   // the same signature over another digest recovers another key and is not a hit
+   const digest_type other = digest_type::hash( 1 );
+   BOOST_CHECK_EQUAL( cache.recover( sig, other ), public_key_type( sig, other ) );
+   BOOST_CHECK_EQUAL( cache.get_stats().misses, 2u );
+
+   // bounded, evicting least recently used
+   for( uint64_t i = 2; i < 200; ++i ) {
+      const auto [d, s] = sign( i );
+      BOOST_CHECK_EQUAL( cache.recover( s, d ), priv.get_public_key() );
+   }
+   BOOST_CHECK_LE( cache.get_stats().size, 32u );
+
+   cache.set_max_entries( 0 );
+   BOOST_CHECK_EQUAL( cache.get_stats().size, 0u );
+   const auto hits = cache.get_stats().hits;
+   BOOST_CHECK_EQUAL( cache.recover( sig, digest ), priv.get_public_key() );
+   BOOST_CHECK_EQUAL( cache.recover( sig, digest ), priv.get_public_key() );
+   BOOST_CHECK_EQUAL( cache.get_stats().hits, hits );
+   BOOST_CHECK_EQUAL( cache.get_stats().size, 0u );
+}
+
+BOOST_AUTO_TEST_CASE(flat_u64_map_test) {
+   boost::random::mt19937 gen(42);
+   // a small key space keeps probe sequences long and crossing the end of the slot array
+   boost::random::uniform_int_distribution<uint64_t> key_dist(0, 300);
+   boost::random::uniform_int_distribution<int> op_dist(0, 9);
+
+   for( int round = 0; round < 20; ++round ) {
+      // every round takes the slots the previous map gave back to the pool
+      flat_u64_map<int> m;
+      std::map<uint64_t, int> expected;
+      // fill up to 250 keys to grow from 32 slots, or hover around 20, then drain
+      const size_t target = round % 2 ? 250 : 20;
+      for( int i = 0; i < 4000; ++i ) {
+         const uint64_t key = key_dist(gen);
+         const int op = op_dist(gen);
+         const bool filling = i < 2000;
+         if( op < (filling ? 5 : 2) && (!filling || expected.size() < target) ) {
+            auto [value, inserted] = m.emplace( key, i );
+            auto [itr, expected_inserted] = expected.emplace( key, i );
+            BOOST_REQUIRE_EQUAL( inserted, expected_inserted );
+            BOOST_REQUIRE_EQUAL( *value, itr->second );
+         } else if( op < 8 ) {
+            m.erase( key );
+            expected.erase( key );
+         } else {
+            const int* value = m.find( key );
+            auto itr = expected.find( key );
+            BOOST_REQUIRE_EQUAL( value != nullptr, itr != expected.end() );
+            if( value )
+               BOOST_REQUIRE_EQUAL( *value, itr->second );
+         }
+         BOOST_REQUIRE_EQUAL( m.size(), expected.size() );
+         if( i % 500 == 0 ) {
+            for( uint64_t k = 0; k <= 300; ++k ) {
+               const int* value = m.find( k );
+               auto itr = expected.find( k );
+               BOOST_REQUIRE_EQUAL( value != nullptr, itr != expected.end() );
+               if( value )
+                  BOOST_REQUIRE_EQUAL( *value, itr->second );
+            }
+         }
+      }
+      // keys spread like object addresses
+      for( uint64_t k = 0; k < 100; ++k )
+         m.emplace( 0x7f0000000000ull + k * 112, -1 );
+      for( uint64_t k = 0; k < 100; k += 3 )
+         m.erase( 0x7f0000000000ull + k * 112 );
+      for( uint64_t k = 0; k < 100; ++k )
+         BOOST_REQUIRE_EQUAL( m.find( 0x7f0000000000ull + k * 112 ) == nullptr, k % 3 == 0 );
+      for( const auto& [k, v] : expected )
+         BOOST_REQUIRE_EQUAL( *m.find( k ), v );
+   }
+}
+
+// iterator ids are visible to contracts, the flat iterator_cache must hand out the same ones as the map based one did
+BOOST_FIXTURE_TEST_CASE(iterator_cache_ids_test, eosio::testing::chainbase_fixture<8*1024*1024>) { try {
+   _db->add_index<table_id_multi_index>();
+   _db->add_index<key_value_index>();
+
+   std::vector<const table_id_object*> tables;
+   for( uint64_t t = 0; t < 12; ++t ) {
+      tables.push_back( &_db->create<table_id_object>( [&]( table_id_object& o ) {
+         o.code  = "test"_n;
+         o.scope = name( t );
+         o.table = "rows"_n;
+      } ) );
+   }
+   std::vector<const key_value_object*> rows;
+   for( uint64_t pk = 0; pk < 200; ++pk ) {
+      rows.push_back( &_db->create<key_value_object>( [&]( key_value_object& o ) {
+         o.t_id        = tables[pk % tables.size()]->id;
+         o.primary_key = pk;
+      } ) );
+   }
+
+   // the iterator_cache before the flat storage
+   struct map_cache {
+      std::map<table_id, std::pair<const table_id_object*, int>> table_cache;
+      std::vector<const table_id_object*>                        end_iterator_to_table;
+      std::vector<const key_value_object*>                       iterator_to_object;
+      std::map<const key_value_object*, int>                     object_to_iterator;
+
+      int cache_table( const table_id_object& tobj ) {
+         auto itr = table_cache.find( tobj.id );
+         if( itr != table_cache.end() )
+            return itr->second.second;
+         int ei = -int( end_iterator_to_table.size() ) - 2;
+         end_iterator_to_table.push_back( &tobj );
+         table_cache.emplace( tobj.id, std::make_pair( &tobj, ei ) );
+         return ei;
+      }
+      int add( const key_value_object& obj ) {
+         auto itr = object_to_iterator.find( &obj );
+         if( itr != object_to_iterator.end() )
+            return itr->second;
+         iterator_to_object.push_back( &obj );
+         object_to_iterator[&obj] = iterator_to_object.size() - 1;
+         return iterator_to_object.size() - 1;
+      }
+      void remove( int iterator ) {
+         auto obj = iterator_to_object[iterator];
+         if( !obj ) return;
+         iterator_to_object[iterator] = nullptr;
+         object_to_iterator.erase( obj );
+      }
+   };
+
+   boost::random::mt19937 gen(7);
+   boost::random::uniform_int_distribution<int> op_dist(0, 9);
+   for( int action = 0; action < 10; ++action ) {
+      contract_table_context_base<contract_tables>::iterator_cache<key_value_object> cache;
+      map_cache expected;
+      for( int i = 0; i < 2000; ++i ) {
+         const int op = op_dist(gen);
+         if( op < 2 ) {
+            const table_id_object& t = *tables[boost::random::uniform_int_distribution<size_t>(0, tables.size() - 1)(gen)];
+            const int ei = cache.cache_table( t );
+            BOOST_REQUIRE_EQUAL( ei, expected.cache_table( t ) );
+            BOOST_REQUIRE_EQUAL( cache.get_end_iterator_by_table_id( t.id ), ei );
+            BOOST_REQUIRE_EQUAL( cache.find_table_by_end_iterator( ei ), &t );
+            BOOST_REQUIRE_EQUAL( &cache.get_table( t.id ), &t );
+         } else if( op < 7 ) {
+            const key_value_object& r = *rows[boost::random::uniform_int_distribution<size_t>(0, rows.size() - 1)(gen)];
+            BOOST_REQUIRE_EQUAL( cache.add( r ), expected.add( r ) );
+         } else if( !expected.iterator_to_object.empty() ) {
+            const int itr = boost::random::uniform_int_distribution<int>(0, expected.iterator_to_object.size() - 1)(gen);
+            if( expected.iterator_to_object[itr] )
+               BOOST_REQUIRE_EQUAL( &cache.get( itr ), expected.iterator_to_object[itr] );
+            else
+               BOOST_REQUIRE_THROW( cache.get( itr ), table_operation_not_permitted );
+            if( op < 9 ) {
+               cache.remove( itr );
+               expected.remove( itr );
+            }
+         }
+      }
+      BOOST_REQUIRE( cache.find_table_by_end_iterator( -int( expected.end_iterator_to_table.size() ) - 2 ) == nullptr );
+   }
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace eosio
@@ -11,6 +11,7 @@
 #include <boost/iostreams/device/mapped_file.hpp>
 #include <contracts.hpp>
 #include <fc/io/cfile.hpp>
+#include <fc/io/fstream.hpp>
 #include <snapshots.hpp>
 
 BOOST_AUTO_TEST_SUITE(partitioned_block_log_tests)
@@ -528,4 +529,200 @@ BOOST_AUTO_TEST_CASE(test_blocklog_split_then_merge) {
    BOOST_CHECK(bfs::exists(dest_dir.path() / "blocks-101-150.index"));
 }
 
+BOOST_AUTO_TEST_CASE(test_mapped_read_while_appending) {
+   using namespace eosio::chain;
+   eosio::testing::tester chain;
+   chain.produce_blocks(60);
+   chain.close();
+
+   // the blocks as written by the chain, replayed below into block logs of every layout
+   std::vector<signed_block_ptr> blocks;
+   {
+      block_log source(chain.get_config().blocks_dir);
+      for (uint32_t n = 1; auto b = source.read_block_by_num(n); ++n)
+         blocks.push_back(b);
+   }
+   BOOST_REQUIRE(blocks.size() > 50);
+
+   const std::vector<block_log_config> configs = {
+      basic_blocklog_config{},
+      partitioned_blocklog_config{ .stride = 10, .max_retained_files = 10 },
+      prune_blocklog_config{ .prune_blocks = 16, .prune_threshold = 1024 } };
+
+   for (const auto& config : configs) {
+      fc::temp_directory temp_dir;
+      block_log          blog(temp_dir.path(), config);
+      blog.reset(genesis_state{}, blocks[0]);
+
+      for (size_t i = 1; i < blocks.size(); ++i) {
+         // every read remaps the block log as it grows, is split or has its pruned trailer overwritten
+         blog.append(blocks[i], blocks[i]->calculate_id());
+         const uint32_t head_num = blocks[i]->block_num();
+         BOOST_REQUIRE_EQUAL(blog.read_block_by_num(head_num)->calculate_id(), blocks[i]->calculate_id());
+         BOOST_REQUIRE_EQUAL(blog.read_block_id_by_num(head_num - 1), blocks[i - 1]->calculate_id());
+         BOOST_REQUIRE(!blog.read_block_by_num(head_num + 1));
+      }
+
+      const uint32_t head_num = blocks.back()->block_num();
+      blog.advise_sequential_read(blog.first_block_num(), head_num);
+      for (uint32_t n = blog.first_block_num(); n <= head_num; ++n)
+         BOOST_REQUIRE_EQUAL(blog.read_block_by_num(n)->calculate_id(), blocks[n - 1]->calculate_id());
+   }
+}
+
+BOOST_AUTO_TEST_CASE(test_compressed_block_log) {
+   namespace bfs = boost::filesystem;
+   using namespace eosio::chain;
+   fc::temp_directory temp_dir;
+
+   eosio::testing::tester chain;
+   chain.produce_blocks(50);
+   chain.close();
+
+   const auto blocks_dir     = chain.get_config().blocks_dir;
+   const auto compressed_dir = temp_dir.path() / "compressed";
+   block_log::compress_blocklog(blocks_dir, compressed_dir);
+   BOOST_CHECK_EXCEPTION(block_log::compress_blocklog(compressed_dir, temp_dir.path() / "twice"), block_log_exception,
+                         eosio::testing::fc_exception_message_contains("already compressed"));
+
+   // positions are still trailing each entry, the index can be rebuilt and validated as for an uncompressed log
+   block_log::smoke_test(compressed_dir, 1);
+   block_log::construct_index(compressed_dir / "blocks.log", temp_dir.path() / "blocks.index");
+   std::string index, rebuilt_index;
+   fc::read_file_contents(compressed_dir / "blocks.index", index);
+   fc::read_file_contents(temp_dir.path() / "blocks.index", rebuilt_index);
+   BOOST_CHECK(index == rebuilt_index);
+
+   uint32_t head_num = 0;
+   {
+      block_log original(blocks_dir);
+      block_log compressed(compressed_dir);
+      BOOST_REQUIRE_EQUAL(compressed.head_id(), original.head_id());
+      head_num = block_header::num_from_id(original.head_id());
+      for (uint32_t n = 1; n <= head_num; ++n) {
+         BOOST_REQUIRE_EQUAL(compressed.read_block_by_num(n)->calculate_id(), original.read_block_id_by_num(n));
+         BOOST_REQUIRE_EQUAL(compressed.read_block_id_by_num(n), original.read_block_id_by_num(n));
+      }
+   }
+
+   // run the chain on the compressed log, appended blocks are compressed too
+   bfs::copy_file(compressed_dir / "blocks.log", blocks_dir / "blocks.log", bfs::copy_option::overwrite_if_exists);
+   bfs::copy_file(compressed_dir / "blocks.index", blocks_dir / "blocks.index", bfs::copy_option::overwrite_if_exists);
+   chain.open();
+   chain.produce_blocks(20);
+   BOOST_CHECK_EQUAL(chain.control->fetch_block_by_number(head_num)->block_num(), head_num);
+   chain.close();
+
+   block_log::smoke_test(blocks_dir, 1);
+   block_log compressed(blocks_dir);
+   BOOST_CHECK_EXCEPTION(block_log::compress_blocklog(blocks_dir, temp_dir.path() / "twice"), block_log_exception,
+                         eosio::testing::fc_exception_message_contains("already compressed"));
+   const uint32_t new_head_num = block_header::num_from_id(compressed.head_id());
+   BOOST_REQUIRE(new_head_num > head_num);
+   for (uint32_t n = 1; n <= new_head_num; ++n)
+      BOOST_REQUIRE_EQUAL(compressed.read_block_by_num(n)->block_num(), n);
+}
+
+BOOST_AUTO_TEST_CASE(test_parallel_index_and_validation) {
+   namespace bfs = boost::filesystem;
+   using namespace eosio::chain;
+   fc::temp_directory temp_dir;
+
+   eosio::testing::tester chain;
+   for (int i = 0; i < 20; ++i) {
+      chain.create_account(name("par" + std::string(1, 'a' + i)));
+      chain.produce_blocks(10);
+   }
+   chain.close();
+
+   const auto blocks_dir     = chain.get_config().blocks_dir;
+   const auto compressed_dir = temp_dir.path() / "compressed";
+   block_log::compress_blocklog(blocks_dir, compressed_dir);
+
+   for (const auto& dir : { blocks_dir, compressed_dir }) {
+      std::string index;
+      fc::read_file_contents(dir / "blocks.index", index);
+      for (uint32_t threads : { 1, 2, 7 }) {
+         const auto rebuilt_path = temp_dir.path() / "blocks.index";
+         block_log::construct_index(dir / "blocks.log", rebuilt_path, threads);
+         std::string rebuilt_index;
+         fc::read_file_contents(rebuilt_path, rebuilt_index);
+         BOOST_CHECK(index == rebuilt_index);
+         BOOST_CHECK_NO_THROW(block_log::full_validate(dir, threads));
+      }
+   }
+
+   // corrupt the transaction_mroot of a block in the middle of the log, which changes its id but not its number
+   const auto corrupted_dir = temp_dir.path() / "corrupted";
+   fc::create_directories(corrupted_dir);
+   bfs::copy_file(blocks_dir / "blocks.log", corrupted_dir / "blocks.log");
+   bfs::copy_file(blocks_dir / "blocks.index", corrupted_dir / "blocks.index");
+   {
+      block_log blog(corrupted_dir);
+      const uint64_t pos = blog.get_block_pos(100);
+      fc::cfile      f;
+      f.set_file_path(corrupted_dir / "blocks.log");
+      f.open(fc::cfile::update_rw_mode);
+      const uint64_t mroot_pos = pos + 4 + 8 + 2 + 32; // timestamp, producer, confirmed, previous
+      f.seek(mroot_pos);
+      char c;
+      f.read(&c, 1);
+      f.seek(mroot_pos);
+      c = ~c;
+      f.write(&c, 1);
+   }
+   BOOST_CHECK_NO_THROW(block_log::smoke_test(corrupted_dir, 1));
+   BOOST_CHECK_THROW(block_log::full_validate(corrupted_dir, 4), block_log_exception);
+}
+
+BOOST_AUTO_TEST_CASE(test_parallel_split_extract_merge) {
+   namespace bfs = boost::filesystem;
+   using namespace eosio::chain;
+   fc::temp_directory temp_dir;
+
+   eosio::testing::tester chain;
+   chain.produce_blocks(120);
+   chain.close();
+
+   const auto blocks_dir     = chain.get_config().blocks_dir;
+   const auto compressed_dir = temp_dir.path() / "compressed";
+   block_log::compress_blocklog(blocks_dir, compressed_dir);
+
+   for (const auto& dir : { blocks_dir, compressed_dir }) {
+      std::string log, index;
+      fc::read_file_contents(dir / "blocks.log", log);
+      fc::read_file_contents(dir / "blocks.index", index);
+      const std::string head_num = std::to_string(block_header::num_from_id(block_log(dir).head_id()));
+
+      // splitting then merging back gives the original files, as the first part keeps the original preamble
+      const auto split_dir  = temp_dir.path() / "split";
+      const auto merged_dir = temp_dir.path() / "merged";
+      block_log::split_blocklog(dir, split_dir, 25, 4);
+      BOOST_CHECK(bfs::exists(split_dir / "blocks-26-50.log"));
+      block_log::merge_blocklogs(split_dir, merged_dir, 3);
+      bfs::rename(merged_dir / ("blocks-1-" + head_num + ".log"), merged_dir / "blocks.log");
+      bfs::rename(merged_dir / ("blocks-1-" + head_num + ".index"), merged_dir / "blocks.index");
+      std::string merged_log, merged_index;
+      fc::read_file_contents(merged_dir / "blocks.log", merged_log);
+      fc::read_file_contents(merged_dir / "blocks.index", merged_index);
+      BOOST_CHECK(log == merged_log);
+      BOOST_CHECK(index == merged_index);
+
+      const auto extract_dir = temp_dir.path() / "extracted";
+      block_log::extract_block_range(dir, extract_dir, 30, 90, 5);
+      bfs::rename(extract_dir / "blocks-30-90.log", extract_dir / "blocks.log");
+      bfs::rename(extract_dir / "blocks-30-90.index", extract_dir / "blocks.index");
+      BOOST_CHECK_NO_THROW(block_log::full_validate(extract_dir, 2));
+      {
+         block_log original(dir);
+         block_log extracted(extract_dir);
+         for (uint32_t n = 30; n <= 90; ++n)
+            BOOST_REQUIRE_EQUAL(extracted.read_block_id_by_num(n), original.read_block_id_by_num(n));
+      }
+
+      for (const auto& d : { split_dir, merged_dir, extract_dir })
+         bfs::remove_all(d);
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
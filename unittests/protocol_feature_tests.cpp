@@ -1947,4 +1947,263 @@ BOOST_AUTO_TEST_CASE( set_parameters_packed_test ) { try {
                        c.error("alice does not have permission to call this API"));
 } FC_LOG_AND_RETHROW() }
 
+static const char bulk_table_scan_wast[] = R"=====(
+(module
+ (import "env" "db_store_i64" (func $db_store_i64 (param i64 i64 i64 i64 i32 i32) (result i32)))
+ (import "env" "db_lowerbound_i64" (func $db_lowerbound_i64 (param i64 i64 i64 i64) (result i32)))
+ (import "env" "db_next_batch_i64" (func $db_next_batch_i64 (param i32 i32 i32 i32) (result i32)))
+ (import "env" "db_idx64_store" (func $db_idx64_store (param i64 i64 i64 i64 i32) (result i32)))
+ (import "env" "db_idx64_lowerbound" (func $db_idx64_lowerbound (param i64 i64 i64 i32 i32) (result i32)))
+ (import "env" "db_idx64_next_batch" (func $db_idx64_next_batch (param i32 i32 i32 i32) (result i32)))
+ (import "env" "eosio_assert" (func $eosio_assert (param i32 i32)))
+ (memory $0 1)
+ (export "apply" (func $apply))
+ (func $apply (param $0 i64) (param $1 i64) (param $2 i64)
+  (local $itr i32)
+  (drop (call $db_store_i64 (get_local 0) (get_local 0) (get_local 0) (i64.const 1) (i32.const 0) (i32.const 3)))
+  (drop (call $db_store_i64 (get_local 0) (get_local 0) (get_local 0) (i64.const 2) (i32.const 0) (i32.const 3)))
+  (drop (call $db_store_i64 (get_local 0) (get_local 0) (get_local 0) (i64.const 3) (i32.const 0) (i32.const 3)))
+
+  ;; rows 1 and 2, each primary key, value size and value
+  (set_local $itr (call $db_lowerbound_i64 (get_local 0) (get_local 0) (get_local 0) (i64.const 0)))
+  (set_local $itr (call $db_next_batch_i64 (get_local $itr) (i32.const 2) (i32.const 1024) (i32.const 256)))
+  (call $eosio_assert (i32.eq (i32.load (i32.const 1024)) (i32.const 2)) (i32.const 64))
+  (call $eosio_assert (i64.eq (i64.load (i32.const 1028)) (i64.const 1)) (i32.const 64))
+  (call $eosio_assert (i32.eq (i32.load (i32.const 1036)) (i32.const 3)) (i32.const 64))
+  (call $eosio_assert (i32.eq (i32.load8_u (i32.const 1040)) (i32.const 97)) (i32.const 64))
+  (call $eosio_assert (i64.eq (i64.load (i32.const 1043)) (i64.const 2)) (i32.const 64))
+  (call $eosio_assert (i32.ge_s (get_local $itr) (i32.const 0)) (i32.const 64))
+
+  ;; row 3 does not fit in 8 bytes
+  (call $eosio_assert (i32.eq (call $db_next_batch_i64 (get_local $itr) (i32.const 10) (i32.const 1024) (i32.const 8)) (get_local $itr)) (i32.const 64))
+  (call $eosio_assert (i32.eq (i32.load (i32.const 1024)) (i32.const 0)) (i32.const 64))
+
+  ;; row 3 and the end of the table
+  (set_local $itr (call $db_next_batch_i64 (get_local $itr) (i32.const 10) (i32.const 1024) (i32.const 256)))
+  (call $eosio_assert (i32.eq (i32.load (i32.const 1024)) (i32.const 1)) (i32.const 64))
+  (call $eosio_assert (i64.eq (i64.load (i32.const 1028)) (i64.const 3)) (i32.const 64))
+  (call $eosio_assert (i32.lt_s (get_local $itr) (i32.const -1)) (i32.const 64))
+
+  ;; secondary index in secondary key order
+  (i64.store (i32.const 16) (i64.const 30))
+  (drop (call $db_idx64_store (get_local 0) (get_local 0) (get_local 0) (i64.const 1) (i32.const 16)))
+  (i64.store (i32.const 16) (i64.const 10))
+  (drop (call $db_idx64_store (get_local 0) (get_local 0) (get_local 0) (i64.const 2) (i32.const 16)))
+  (i64.store (i32.const 16) (i64.const 0))
+  (set_local $itr (call $db_idx64_lowerbound (get_local 0) (get_local 0) (get_local 0) (i32.const 16) (i32.const 24)))
+  (set_local $itr (call $db_idx64_next_batch (get_local $itr) (i32.const 10) (i32.const 1024) (i32.const 256)))
+  (call $eosio_assert (i32.eq (i32.load (i32.const 1024)) (i32.const 2)) (i32.const 64))
+  (call $eosio_assert (i64.eq (i64.load (i32.const 1028)) (i64.const 2)) (i32.const 64))
+  (call $eosio_assert (i64.eq (i64.load (i32.const 1036)) (i64.const 10)) (i32.const 64))
+  (call $eosio_assert (i64.eq (i64.load (i32.const 1044)) (i64.const 1)) (i32.const 64))
+  (call $eosio_assert (i64.eq (i64.load (i32.const 1052)) (i64.const 30)) (i32.const 64))
+  (call $eosio_assert (i32.lt_s (get_local $itr) (i32.const -1)) (i32.const 64))
+ )
+ (data (i32.const 0) "abc")
+ (data (i32.const 64) "unexpected batch\00")
+)
+)=====";
+
+BOOST_AUTO_TEST_CASE( bulk_table_scan_test ) { try {
+   tester c( setup_policy::preactivate_feature_and_new_bios );
+
+   const auto& pfm = c.control->get_protocol_feature_manager();
+   const auto& d = pfm.get_builtin_digest(builtin_protocol_feature_t::bulk_table_scan);
+   BOOST_REQUIRE(d);
+
+   const auto& alice_account = account_name("alice");
+   c.create_accounts( {alice_account} );
+   c.produce_block();
+
+   BOOST_CHECK_EXCEPTION(  c.set_code( alice_account, bulk_table_scan_wast ),
+                           wasm_exception,
+                           fc_exception_message_is( "env.db_next_batch_i64 unresolveable" ) );
+
+   c.preactivate_protocol_features( {*d} );
+   c.produce_block();
+
+   c.set_code( alice_account, bulk_table_scan_wast );
+   c.produce_block();
+   BOOST_REQUIRE_EQUAL(c.push_action(action({{ alice_account, permission_name("active") }}, alice_account, action_name(), {} ), alice_account.to_uint64_t()), c.success());
+} FC_LOG_AND_RETHROW() }
+
+// with action data (first primary key, number of rows) stores that many empty rows, without it keeps scanning the
+// whole table in single calls of db_next_batch_i64 with unlimited max_rows
+static const char bulk_table_scan_deadline_wast[] = R"=====(
+(module
+ (import "env" "db_store_i64" (func $db_store_i64 (param i64 i64 i64 i64 i32 i32) (result i32)))
+ (import "env" "db_lowerbound_i64" (func $db_lowerbound_i64 (param i64 i64 i64 i64) (result i32)))
+ (import "env" "db_next_batch_i64" (func $db_next_batch_i64 (param i32 i32 i32 i32) (result i32)))
+ (import "env" "read_action_data" (func $read_action_data (param i32 i32) (result i32)))
+ (import "env" "action_data_size" (func $action_data_size (result i32)))
+ (memory $0 64)
+ (export "apply" (func $apply))
+ (func $apply (param $0 i64) (param $1 i64) (param $2 i64)
+  (if (call $action_data_size) (then
+   (drop (call $read_action_data (i32.const 16) (i32.const 12)))
+   (loop
+    (drop (call $db_store_i64 (get_local 0) (get_local 0) (get_local 0) (i64.load (i32.const 16)) (i32.const 0) (i32.const 0)))
+    (i64.store (i32.const 16) (i64.add (i64.load (i32.const 16)) (i64.const 1)))
+    (i32.store (i32.const 24) (i32.sub (i32.load (i32.const 24)) (i32.const 1)))
+    (br_if 0 (i32.load (i32.const 24)))
+   )
+   (return)
+  ))
+  (loop
+   (drop (call $db_next_batch_i64 (call $db_lowerbound_i64 (get_local 0) (get_local 0) (get_local 0) (i64.const 0))
+                                  (i32.const -1) (i32.const 65536) (i32.const 4128768)))
+   (br 0)
+  )
+ )
+)
+)=====";
+
+BOOST_AUTO_TEST_CASE( bulk_table_scan_deadline_test ) { try {
+   tester c( setup_policy::preactivate_feature_and_new_bios );
+
+   const auto& pfm = c.control->get_protocol_feature_manager();
+   const auto& d = pfm.get_builtin_digest(builtin_protocol_feature_t::bulk_table_scan);
+   BOOST_REQUIRE(d);
+   c.preactivate_protocol_features( {*d} );
+   c.produce_block();
+
+   const auto& scan_account = account_name("scan");
+   c.create_accounts( {scan_account} );
+   c.set_code( scan_account, bulk_table_scan_deadline_wast );
+   c.produce_block();
+
+   constexpr uint32_t rows_per_trx = 5000;
+   for( uint64_t first = 0; first < 40000; first += rows_per_trx ) {
+      BOOST_REQUIRE_EQUAL(c.push_action(action({{ scan_account, config::active_name }}, scan_account, action_name(),
+                                               fc::raw::pack( first, rows_per_trx ) ), scan_account.to_uint64_t()), c.success());
+      c.produce_block();
+   }
+
+   // every call copies far more rows than config::table_scan_checktime_rows, the deadline is checked inside them
+   signed_transaction trx;
+   trx.actions.emplace_back( vector<permission_level>{{scan_account, config::active_name}}, scan_account, action_name(), bytes{} );
+   c.set_transaction_headers( trx );
+   trx.max_cpu_usage_ms = 20;
+   trx.sign( c.get_private_key( scan_account, "active" ), c.control->get_chain_id() );
+   BOOST_CHECK_THROW( c.push_transaction( trx ), deadline_exception );
+} FC_LOG_AND_RETHROW() }
+
+static const char batched_crypto_wast[] = R"=====(
+(module
+ (import "env" "sha256_batch" (func $sha256_batch (param i32 i32 i32 i32) (result i32)))
+ (import "env" "recover_key_batch" (func $recover_key_batch (param i32 i32 i32 i32) (result i32)))
+ (import "env" "verify_signature_batch" (func $verify_signature_batch (param i32 i32) (result i32)))
+ (import "env" "read_action_data" (func $read_action_data (param i32 i32) (result i32)))
+ (import "env" "action_data_size" (func $action_data_size (result i32)))
+ (import "env" "eosio_assert" (func $eosio_assert (param i32 i32)))
+ (memory $0 1)
+ (export "apply" (func $apply))
+ (func $apply (param $0 i64) (param $1 i64) (param $2 i64)
+  ;; "abc" and 64 zero bytes
+  (call $eosio_assert (i32.eq (call $sha256_batch (i32.const 0) (i32.const 75) (i32.const 256) (i32.const 64)) (i32.const 2)) (i32.const 128))
+  (call $eosio_assert (i64.eq (i64.load (i32.const 256)) (i64.const 0xeacf018fbf1678ba)) (i32.const 128))
+  (call $eosio_assert (i64.eq (i64.load (i32.const 288)) (i64.const 0x30206ad142fda5f5)) (i32.const 128))
+  ;; no room for the second digest, truncated input
+  (call $eosio_assert (i32.eq (call $sha256_batch (i32.const 0) (i32.const 75) (i32.const 256) (i32.const 32)) (i32.const -1)) (i32.const 128))
+  (call $eosio_assert (i32.eq (call $sha256_batch (i32.const 0) (i32.const 74) (i32.const 256) (i32.const 64)) (i32.const -1)) (i32.const 128))
+
+  ;; an empty batch packs to its size alone
+  (call $eosio_assert (i32.eq (call $recover_key_batch (i32.const 512) (i32.const 1) (i32.const 600) (i32.const 16)) (i32.const 1)) (i32.const 128))
+
+  ;; action data: expected number of verified signatures followed by the requests
+  (drop (call $read_action_data (i32.const 2048) (call $action_data_size)))
+  (call $eosio_assert (i32.eq (call $verify_signature_batch (i32.const 2052) (i32.sub (call $action_data_size) (i32.const 4)))
+                              (i32.load (i32.const 2048))) (i32.const 128))
+ )
+ (data (i32.const 0) "\03\00\00\00abc\40\00\00\00")
+ (data (i32.const 128) "unexpected batch result\00")
+)
+)=====";
+
+// action data: capacity of the output buffer followed by the requests; prints the returned size and the output buffer
+static const char recover_key_batch_wast[] = R"=====(
+(module
+ (import "env" "recover_key_batch" (func $recover_key_batch (param i32 i32 i32 i32) (result i32)))
+ (import "env" "read_action_data" (func $read_action_data (param i32 i32) (result i32)))
+ (import "env" "action_data_size" (func $action_data_size (result i32)))
+ (import "env" "printui" (func $printui (param i64)))
+ (import "env" "prints" (func $prints (param i32)))
+ (import "env" "printhex" (func $printhex (param i32 i32)))
+ (memory $0 1)
+ (export "apply" (func $apply))
+ (func $apply (param $0 i64) (param $1 i64) (param $2 i64)
+  (drop (call $read_action_data (i32.const 2048) (call $action_data_size)))
+  (call $printui (i64.extend_u/i32 (call $recover_key_batch (i32.const 2052) (i32.sub (call $action_data_size) (i32.const 4))
+                                                            (i32.const 8192) (i32.load (i32.const 2048)))))
+  (call $prints (i32.const 0))
+  (call $printhex (i32.const 8192) (i32.load (i32.const 2048)))
+ )
+ (data (i32.const 0) " \00")
+)
+)=====";
+
+BOOST_AUTO_TEST_CASE( batched_crypto_test ) { try {
+   tester c( setup_policy::preactivate_feature_and_new_bios );
+
+   const auto& pfm = c.control->get_protocol_feature_manager();
+   const auto& d = pfm.get_builtin_digest(builtin_protocol_feature_t::batched_crypto);
+   BOOST_REQUIRE(d);
+
+   const auto& alice_account = account_name("alice");
+   c.create_accounts( {alice_account} );
+   c.produce_block();
+
+   BOOST_CHECK_EXCEPTION(  c.set_code( alice_account, batched_crypto_wast ),
+                           wasm_exception,
+                           fc_exception_message_is( "env.sha256_batch unresolveable" ) );
+
+   c.preactivate_protocol_features( {*d} );
+   c.produce_block();
+
+   c.set_code( alice_account, batched_crypto_wast );
+   c.produce_block();
+
+   // the second signature is checked against the key of another account
+   const auto alice_key = c.get_private_key( alice_account, "active" );
+   const auto bob_key   = c.get_private_key( "bob"_n, "active" );
+   const auto digest    = fc::sha256::hash( std::string("batched") );
+   bytes data = fc::raw::pack( uint32_t(1), fc::unsigned_int(2),
+                               digest, alice_key.sign(digest), alice_key.get_public_key(),
+                               digest, alice_key.sign(digest), bob_key.get_public_key() );
+   BOOST_REQUIRE_EQUAL(c.push_action(action({{ alice_account, permission_name("active") }}, alice_account, action_name(), data ), alice_account.to_uint64_t()), c.success());
+
+   const auto& recover_account = account_name("recover");
+   c.create_accounts( {recover_account} );
+   c.set_code( recover_account, recover_key_batch_wast );
+   c.produce_block();
+
+   // returns what the contract printed for recovering the keys of both signatures into a buffer of capacity bytes
+   auto recover = [&]( uint32_t capacity ) {
+      signed_transaction trx;
+      trx.actions.emplace_back( vector<permission_level>{{recover_account, config::active_name}}, recover_account, action_name(),
+                                fc::raw::pack( capacity, fc::unsigned_int(2), digest, alice_key.sign(digest), digest, bob_key.sign(digest) ) );
+      c.set_transaction_headers( trx );
+      trx.sign( c.get_private_key( recover_account, "active" ), c.control->get_chain_id() );
+      return c.push_transaction( trx )->action_traces.at(0).console;
+   };
+
+   const std::vector<public_key_type> expected{ alice_key.get_public_key(), bob_key.get_public_key() };
+   const uint32_t packed_size = fc::raw::pack_size( expected );
+
+   std::string console = recover( packed_size );
+   const auto sep = console.find( ' ' );
+   BOOST_REQUIRE( sep != std::string::npos );
+   BOOST_CHECK_EQUAL( console.substr( 0, sep ), std::to_string( packed_size ) );
+   bytes pubs( packed_size );
+   BOOST_REQUIRE_EQUAL( fc::from_hex( console.substr( sep + 1 ), pubs.data(), pubs.size() ), pubs.size() );
+   const auto recovered = fc::raw::unpack<std::vector<public_key_type>>( pubs );
+   BOOST_REQUIRE_EQUAL( recovered.size(), expected.size() );
+   BOOST_CHECK( recovered[0] == alice_key.get_public_key() );
+   BOOST_CHECK( recovered[1] == bob_key.get_public_key() );
+
+   // one byte short: only the required size is returned, nothing is written
+   console = recover( packed_size - 1 );
+   BOOST_CHECK_EQUAL( console, std::to_string( packed_size ) + " " + std::string( 2 * (packed_size - 1), '0' ) );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -166,6 +166,34 @@ BOOST_AUTO_TEST_CASE(test_restart_from_block_log) {
    BOOST_REQUIRE_NO_THROW(from_block_log_chain.get_account("replay3"_n));
 }
 
+BOOST_AUTO_TEST_CASE(test_restart_from_block_log_prefetch) {
+   tester chain;
+
+   for( uint64_t i = 1; i <= 20; ++i ) {
+      chain.create_account(name("replay" + std::to_string(i % 5 + 1) + std::string(i / 5, 'a')));
+      chain.produce_blocks(1);
+   }
+   const auto head_id = chain.control->head_block_id();
+   chain.close();
+
+   auto genesis = chain::block_log::extract_genesis_state(chain.get_config().blocks_dir);
+   BOOST_REQUIRE(genesis);
+
+   // prefetch queue smaller than the number of blocks, with and without recovering keys ahead, and no prefetch
+   for( auto [prefetch, force_all_checks] : { std::pair{2u, false}, std::pair{2u, true}, std::pair{0u, false} } ) {
+      controller::config copied_config = chain.get_config();
+      copied_config.replay_prefetch_blocks = prefetch;
+      copied_config.force_all_checks = force_all_checks;
+      remove_existing_states(copied_config);
+
+      tester from_block_log_chain(copied_config, *genesis);
+      BOOST_CHECK_EQUAL(from_block_log_chain.control->head_block_id(), head_id);
+      BOOST_REQUIRE_NO_THROW(from_block_log_chain.get_account("replay2"_n));
+      BOOST_REQUIRE_NO_THROW(from_block_log_chain.get_account("replay5aaa"_n));
+      from_block_log_chain.close();
+   }
+}
+
 BOOST_AUTO_TEST_CASE(test_light_validation_restart_from_block_log) {
    tester chain(setup_policy::full);
 
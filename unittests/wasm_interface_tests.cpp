@@ -0,0 +1,152 @@
+#ifdef EOSIO_EOS_VM_RUNTIME_ENABLED
+
+#include <eosio/chain/wasm_interface_private.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/config.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include <fc/filesystem.hpp>
+
+#include <atomic>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+using namespace eosio;
+using namespace eosio::chain;
+
+namespace {
+
+// stands in for an instantiated module, records executions on two threads at once and modules freed while executing
+struct stub_module : wasm_instantiated_module_interface {
+   static constexpr uint64_t alive = 0x616c697665;
+   inline static std::atomic<int64_t> live{0};
+   inline static std::atomic<int64_t> violations{0};
+
+   std::atomic<bool> executing{false};
+   uint64_t          magic = alive;
+
+   stub_module() { ++live; }
+   ~stub_module() override {
+      if(executing)
+         ++violations;
+      magic = 0;
+      --live;
+   }
+
+   void apply(apply_context&) override {}
+
+   void execute() {
+      if(magic != alive || executing.exchange(true))
+         ++violations;
+      std::this_thread::yield();
+      if(magic != alive)
+         ++violations;
+      executing = false;
+   }
+};
+
+using module_lease = wasm_interface_impl::module_lease;
+
+struct wasm_interface_fixture {
+   fc::temp_directory  dir;
+   wasm_interface_impl impl{wasm_interface::vm_type::eos_vm, false, dir.path(), eosvmoc::config{}, false};
+
+   wasm_interface_fixture() { stub_module::violations = 0; }
+
+   // what acquire_instantiated_module does, with a stub standing in for the instantiation
+   module_lease acquire(const digest_type& code, std::atomic<int64_t>& instantiated) {
+      auto module = impl.take_idle_module(code, 0, 0);
+      if(!module) {
+         module = std::make_unique<stub_module>();
+         ++instantiated;
+      }
+      return { impl, code, 0, 0, std::move(module) };
+   }
+
+   static stub_module& module(const module_lease& lease) { return static_cast<stub_module&>(*lease.operator->()); }
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(wasm_interface_tests)
+
+BOOST_FIXTURE_TEST_CASE(module_lease_reuse_and_eviction, wasm_interface_fixture) { try {
+   const digest_type code = digest_type::hash(std::string("code"));
+   const int64_t live_before = stub_module::live;
+   std::atomic<int64_t> instantiated{0};
+
+   BOOST_CHECK(!impl.is_code_cached(code, 0, 0));
+   {
+      module_lease a = acquire(code, instantiated);
+      BOOST_CHECK(impl.is_code_cached(code, 0, 0));
+      // a leased module is not handed out again, a second execution gets its own
+      module_lease b = acquire(code, instantiated);
+      BOOST_CHECK(&module(a) != &module(b));
+      BOOST_CHECK_EQUAL(instantiated.load(), 2);
+   }
+   // both back in the cache and reused
+   BOOST_CHECK_EQUAL(stub_module::live.load() - live_before, 2);
+   {
+      module_lease a = acquire(code, instantiated);
+      module_lease b = acquire(code, instantiated);
+      BOOST_CHECK_EQUAL(instantiated.load(), 2);
+   }
+
+   {
+      module_lease a = acquire(code, instantiated);
+      impl.code_block_num_last_used(code, 0, 0, 10);
+      // used after the LIB, kept
+      impl.current_lib(9);
+      BOOST_CHECK(impl.is_code_cached(code, 0, 0));
+      // evicted while executing: the idle module is freed, the leased one only once it is released
+      impl.current_lib(10);
+      BOOST_CHECK(!impl.is_code_cached(code, 0, 0));
+      BOOST_CHECK_EQUAL(stub_module::live.load() - live_before, 1);
+      module(a).execute();
+   }
+   BOOST_CHECK_EQUAL(stub_module::live.load(), live_before);
+   BOOST_CHECK_EQUAL(stub_module::violations.load(), 0);
+} FC_LOG_AND_RETHROW() }
+
+BOOST_FIXTURE_TEST_CASE(module_lease_concurrent, wasm_interface_fixture) { try {
+   const digest_type codes[] = { digest_type::hash(std::string("a")), digest_type::hash(std::string("b")) };
+   const int64_t live_before = stub_module::live;
+   constexpr size_t num_threads = 8;
+   constexpr size_t executions_per_thread = 2000;
+   std::atomic<int64_t> instantiated{0};
+   std::atomic<size_t> running{num_threads};
+
+   std::vector<std::thread> threads;
+   for(size_t t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&, t]() {
+         for(size_t i = 0; i < executions_per_thread; ++i) {
+            module_lease lease = acquire(codes[(t + i) % std::size(codes)], instantiated);
+            module(lease).execute();
+         }
+         --running;
+      });
+   }
+
+   // the main thread keeps marking the codes used and evicting them, as blocks become irreversible
+   uint32_t block_num = 0;
+   while(running) {
+      ++block_num;
+      for(const digest_type& code : codes)
+         impl.code_block_num_last_used(code, 0, 0, block_num);
+      impl.current_lib(block_num - (block_num % 2));
+      std::this_thread::yield();
+   }
+   for(std::thread& t : threads)
+      t.join();
+
+   BOOST_CHECK_EQUAL(stub_module::violations.load(), 0);
+   BOOST_CHECK_GT(instantiated.load(), 0);
+   BOOST_CHECK_LT(instantiated.load(), int64_t(num_threads * executions_per_thread));
+
+   impl.current_lib(UINT32_MAX);
+   BOOST_CHECK_EQUAL(stub_module::live.load(), live_before);
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -6,7 +6,9 @@
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/wasm_eosio_constraints.hpp>
+#include <eosio/chain/wasm_interface.hpp>
 #include <eosio/chain/wast_to_wasm.hpp>
+#include <eosio/chain/webassembly/wasm_allocator_pool.hpp>
 #include <eosio/testing/tester.hpp>
 
 #include <Inline/Serialization.h>
@@ -2307,4 +2309,63 @@ BOOST_FIXTURE_TEST_CASE(weighted_net_usage_tests, tester ) try {
 } FC_LOG_AND_RETHROW()
 #endif
 
+#if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
+BOOST_AUTO_TEST_CASE(wasm_allocator_pool_reuse) try {
+   wasm_allocator_pool pool;
+   vm::wasm_allocator& one = pool.get(1);
+   vm::wasm_allocator& two = pool.get(2);
+   BOOST_TEST(&one != &two);
+   BOOST_TEST(&pool.get(1) == &one);
+   BOOST_TEST(&pool.get(2) == &two);
+   BOOST_TEST(pool.memories_created() == 2u);
+
+   // fill the pool, 1 stays the most recently used so the next new size releases the memory of 2
+   for (uint32_t pages = 3; pages <= wasm_allocator_pool::max_memories; ++pages) {
+      pool.get(pages);
+      BOOST_TEST(&pool.get(1) == &one);
+   }
+   BOOST_TEST(pool.memories_created() == wasm_allocator_pool::max_memories);
+   pool.get(100);
+   BOOST_TEST(pool.memories_created() == wasm_allocator_pool::max_memories + 1);
+   BOOST_TEST(&pool.get(1) == &one);
+   pool.get(2);
+   BOOST_TEST(pool.memories_created() == wasm_allocator_pool::max_memories + 2);
+} FC_LOG_AND_RETHROW()
+#endif
+
+BOOST_AUTO_TEST_CASE(wasm_validation_cache_lru) try {
+   wasm_validation_cache cache(2);
+   const auto a = fc::sha256::hash(std::string("a"));
+   const auto b = fc::sha256::hash(std::string("b"));
+   const auto c = fc::sha256::hash(std::string("c"));
+   BOOST_TEST(!cache.contains(a));
+   cache.insert(a);
+   cache.insert(b);
+   BOOST_TEST(cache.contains(a));
+   // b is now the least recently used
+   cache.insert(c);
+   BOOST_TEST(cache.size() == 2u);
+   BOOST_TEST(cache.contains(a));
+   BOOST_TEST(!cache.contains(b));
+   BOOST_TEST(cache.contains(c));
+   BOOST_TEST(cache.hits() == 3u);
+   BOOST_TEST(cache.misses() == 2u);
+} FC_LOG_AND_RETHROW()
+
+// identical code deployed to a second account is not validated again, invalid code keeps failing
+BOOST_FIXTURE_TEST_CASE(setcode_validation_cache, TESTER) try {
+   create_accounts( {"first"_n, "second"_n} );
+   produce_block();
+
+   auto& cache = wasm_interface::validation_cache();
+   set_code("first"_n, test_contracts::asserter_wasm());
+   const uint64_t hits = cache.hits();
+   set_code("second"_n, test_contracts::asserter_wasm());
+   BOOST_TEST(cache.hits() > hits);
+   produce_block();
+
+   BOOST_CHECK_THROW(set_code("first"_n, too_big_table), eosio::chain::wasm_exception);
+   BOOST_CHECK_THROW(set_code("second"_n, too_big_table), eosio::chain::wasm_exception);
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()